@@ -87,6 +87,26 @@ intptr_t DartUtils::GetIntegerField(Dart_Handle handle,
 }
 
 
+bool DartUtils::AcquireByteArrayData(Dart_Handle list, uint8_t** data) {
+  if (!Dart_IsByteArray(list)) {
+    return false;
+  }
+  intptr_t length = 0;
+  if (Dart_IsError(Dart_ListLength(list, &length))) {
+    return false;
+  }
+  intptr_t byte_length = 0;
+  if (Dart_IsError(Dart_ByteArrayAcquireData(list, data, &byte_length))) {
+    return false;
+  }
+  if (byte_length != length) {
+    Dart_ByteArrayReleaseData(list);
+    return false;
+  }
+  return true;
+}
+
+
 void DartUtils::SetStringField(Dart_Handle handle,
                                const char* name,
                                const char* val) {
@@ -89,6 +89,11 @@ class DartUtils {
   static bool PostNull(Dart_Port port_id);
   static bool PostInt32(Dart_Port port_id, int32_t value);
 
+  // Gives direct access to the bytes of 'list' if it is a byte array with
+  // one byte per element, see Dart_ByteArrayAcquireData. The caller must
+  // then call Dart_ByteArrayReleaseData before any other Dart API call.
+  static bool AcquireByteArrayData(Dart_Handle list, uint8_t** data);
+
   // Create a new Dart OSError object with the current OS error.
   static Dart_Handle NewDartOSError();
   // Create a new Dart OSError object with the provided OS error.
@@ -202,15 +202,26 @@ void FUNCTION_NAME(File_ReadList)(Dart_NativeArguments args) {
       Dart_PropagateError(result);
     }
     ASSERT((offset + length) <= array_len);
-    uint8_t* buffer = new uint8_t[length];
-    int bytes_read = file->Read(reinterpret_cast<void*>(buffer), length);
-    if (bytes_read >= 0) {
-      result =
-          Dart_ListSetAsBytes(buffer_obj, offset, buffer, bytes_read);
-      if (Dart_IsError(result)) {
-        delete[] buffer;
-        Dart_PropagateError(result);
+    int bytes_read = 0;
+    uint8_t* data = NULL;
+    if (DartUtils::AcquireByteArrayData(buffer_obj, &data)) {
+      // Read straight into the byte array.
+      bytes_read = file->Read(reinterpret_cast<void*>(data + offset), length);
+      Dart_ByteArrayReleaseData(buffer_obj);
+    } else {
+      uint8_t* buffer = new uint8_t[length];
+      bytes_read = file->Read(reinterpret_cast<void*>(buffer), length);
+      if (bytes_read > 0) {
+        result =
+            Dart_ListSetAsBytes(buffer_obj, offset, buffer, bytes_read);
+        if (Dart_IsError(result)) {
+          delete[] buffer;
+          Dart_PropagateError(result);
+        }
       }
+      delete[] buffer;
+    }
+    if (bytes_read >= 0) {
       Dart_SetReturnValue(args, Dart_NewInteger(bytes_read));
     } else {
       Dart_Handle err = DartUtils::NewDartOSError();
@@ -219,7 +230,6 @@ void FUNCTION_NAME(File_ReadList)(Dart_NativeArguments args) {
       }
       Dart_SetReturnValue(args, err);
     }
-    delete[] buffer;
   }
   Dart_ExitScope();
 }
@@ -243,13 +253,23 @@ void FUNCTION_NAME(File_WriteList)(Dart_NativeArguments args) {
       Dart_PropagateError(result);
     }
     ASSERT((offset + length) <= buffer_len);
-    uint8_t* buffer = new uint8_t[length];
-    result = Dart_ListGetAsBytes(buffer_obj, offset, buffer, length);
-    if (Dart_IsError(result)) {
+    int bytes_written = 0;
+    uint8_t* data = NULL;
+    if (DartUtils::AcquireByteArrayData(buffer_obj, &data)) {
+      // Write straight from the byte array.
+      bytes_written =
+          file->Write(reinterpret_cast<void*>(data + offset), length);
+      Dart_ByteArrayReleaseData(buffer_obj);
+    } else {
+      uint8_t* buffer = new uint8_t[length];
+      result = Dart_ListGetAsBytes(buffer_obj, offset, buffer, length);
+      if (Dart_IsError(result)) {
+        delete[] buffer;
+        Dart_PropagateError(result);
+      }
+      bytes_written = file->Write(reinterpret_cast<void*>(buffer), length);
       delete[] buffer;
-      Dart_PropagateError(result);
     }
-    int bytes_written = file->Write(reinterpret_cast<void*>(buffer), length);
     if (bytes_written >= 0) {
       Dart_SetReturnValue(args, Dart_NewInteger(bytes_written));
     } else {
@@ -259,7 +279,6 @@ void FUNCTION_NAME(File_WriteList)(Dart_NativeArguments args) {
       }
       Dart_SetReturnValue(args, err);
     }
-    delete[] buffer;
   }
   Dart_ExitScope();
 }
@@ -351,6 +370,62 @@ void FUNCTION_NAME(File_Length)(Dart_NativeArguments args) {
 }
 
 
+// Peer of the external byte array holding a mapped file.
+struct FileMapping {
+  void* address;
+  intptr_t length;
+};
+
+
+static void UnmapFile(void* peer) {
+  FileMapping* mapping = reinterpret_cast<FileMapping*>(peer);
+  File::Unmap(mapping->address, mapping->length);
+  delete mapping;
+}
+
+
+void FUNCTION_NAME(File_Map)(Dart_NativeArguments args) {
+  Dart_EnterScope();
+  intptr_t value =
+      DartUtils::GetIntegerValue(Dart_GetNativeArgument(args, 0));
+  File* file = reinterpret_cast<File*>(value);
+  if (file != NULL) {
+    off_t length = file->Length();
+    Dart_Handle result;
+    if (length < 0) {
+      result = DartUtils::NewDartOSError();
+    } else if (length == 0) {
+      // Empty files cannot be mapped.
+      result = Dart_NewByteArray(0);
+    } else if (static_cast<int64_t>(length) > kIntptrMax) {
+      OSError os_error(-1, "File too large to map", OSError::kUnknown);
+      result = DartUtils::NewDartOSError(&os_error);
+    } else {
+      void* address = file->Map(length);
+      if (address == NULL) {
+        result = DartUtils::NewDartOSError();
+      } else {
+        // The bytes stay outside of the Dart heap and are unmapped when the
+        // byte array is collected.
+        FileMapping* mapping = new FileMapping();
+        mapping->address = address;
+        mapping->length = length;
+        result = Dart_NewExternalByteArray(
+            reinterpret_cast<uint8_t*>(address), length, mapping, UnmapFile);
+        if (Dart_IsError(result)) {
+          UnmapFile(mapping);
+        }
+      }
+    }
+    if (Dart_IsError(result)) {
+      Dart_PropagateError(result);
+    }
+    Dart_SetReturnValue(args, result);
+  }
+  Dart_ExitScope();
+}
+
+
 void FUNCTION_NAME(File_LengthFromName)(Dart_NativeArguments args) {
   Dart_EnterScope();
   const char* name =
@@ -105,6 +105,13 @@ class File {
   // Flush contents of file.
   bool Flush();
 
+  // Map the first length bytes of the file into memory. The mapping is
+  // private, so writes to it never reach the file. Returns NULL if the
+  // file cannot be mapped. The mapping stays valid after the file is
+  // closed until it is released with Unmap.
+  void* Map(intptr_t length);
+  static void Unmap(void* address, intptr_t length);
+
   // Returns whether the file has been closed.
   bool IsClosed();
 
@@ -293,6 +293,7 @@ class _FileUtils {
   static setPosition(int id, int position) native "File_SetPosition";
   static truncate(int id, int length) native "File_Truncate";
   static length(int id) native "File_Length";
+  static map(int id) native "File_Map";
   static flush(int id) native "File_Flush";
   static int openStdio(int fd) native "File_OpenStdio";
   static SendPort newServicePort() native "File_NewServicePort";
@@ -648,6 +649,20 @@ class _File extends _FileBase implements File {
     return result;
   }
 
+  List<int> mapAsBytesSync() {
+    var opened = openSync();
+    var result;
+    try {
+      result = _FileUtils.map(opened._id);
+    } finally {
+      opened.closeSync();
+    }
+    if (result is OSError) {
+      throw new FileIOException("Cannot map file '$_name'", result);
+    }
+    return result;
+  }
+
   Future<String> readAsText([Encoding encoding = Encoding.UTF_8]) {
     _ensureFileService();
     var decoder = _StringDecoders.decoder(encoding);
@@ -6,6 +6,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <libgen.h>
@@ -101,6 +102,25 @@ off_t File::Length() {
 }
 
 
+void* File::Map(intptr_t length) {
+  ASSERT(handle_->fd() >= 0);
+  ASSERT(length > 0);
+  void* address = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                       handle_->fd(), 0);
+  if (address == MAP_FAILED) {
+    return NULL;
+  }
+  return address;
+}
+
+
+void File::Unmap(void* address, intptr_t length) {
+  int result = munmap(address, length);
+  ASSERT(result == 0);
+  USE(result);
+}
+
+
 File* File::Open(const char* name, FileOpenMode mode) {
   // Report errors for non-regular files.
   struct stat st;
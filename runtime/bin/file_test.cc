@@ -57,3 +57,29 @@ UNIT_TEST_CASE(FilePosition) {
   EXPECT_EQ(18, file->Position());
   delete file;
 }
+
+
+UNIT_TEST_CASE(FileMap) {
+  const char* kContents = "This file should contain exactly 42 bytes.";
+  const char* kFilename =
+      GetFileName("runtime/tests/vm/data/fixed_length_file");
+  File* file = File::Open(kFilename, File::kRead);
+  EXPECT(file != NULL);
+  const intptr_t length = file->Length();
+  EXPECT_EQ(42, length);
+  char* bytes = reinterpret_cast<char*>(file->Map(length));
+  EXPECT(bytes != NULL);
+  // The mapping stays valid after the file is closed.
+  delete file;
+  EXPECT_EQ(0, memcmp(kContents, bytes, length));
+  // Writes to the mapping do not reach the file.
+  bytes[0] = 't';
+  EXPECT_EQ('t', bytes[0]);
+  File::Unmap(bytes, length);
+  char buf[42];
+  file = File::Open(kFilename, File::kRead);
+  EXPECT(file != NULL);
+  EXPECT(file->ReadFully(buf, length));
+  EXPECT_EQ(0, memcmp(kContents, buf, length));
+  delete file;
+}
@@ -98,6 +98,29 @@ off_t File::Length() {
 }
 
 
+void* File::Map(intptr_t length) {
+  ASSERT(handle_->fd() >= 0);
+  ASSERT(length > 0);
+  HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(handle_->fd()));
+  HANDLE mapping =
+      CreateFileMapping(handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  if (mapping == NULL) {
+    return NULL;
+  }
+  void* address = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, length);
+  // The view keeps the mapping object alive.
+  CloseHandle(mapping);
+  return address;
+}
+
+
+void File::Unmap(void* address, intptr_t length) {
+  BOOL result = UnmapViewOfFile(address);
+  ASSERT(result);
+  USE(result);
+}
+
+
 File* File::Open(const char* name, FileOpenMode mode) {
   int flags = O_RDONLY | O_BINARY;
   if ((mode & kWrite) != 0) {
@@ -70,17 +70,25 @@ void FUNCTION_NAME(Socket_ReadList)(Dart_NativeArguments args) {
     length = (length + 1) / 2;
   }
 
-  uint8_t* buffer = new uint8_t[length];
-  intptr_t bytes_read = Socket::Read(socket, buffer, length);
-  if (bytes_read > 0) {
-    Dart_Handle result =
-        Dart_ListSetAsBytes(buffer_obj, offset, buffer, bytes_read);
-    if (Dart_IsError(result)) {
-      delete[] buffer;
-      Dart_PropagateError(result);
+  intptr_t bytes_read = 0;
+  uint8_t* data = NULL;
+  if (DartUtils::AcquireByteArrayData(buffer_obj, &data)) {
+    // Read straight into the byte array.
+    bytes_read = Socket::Read(socket, data + offset, length);
+    Dart_ByteArrayReleaseData(buffer_obj);
+  } else {
+    uint8_t* buffer = new uint8_t[length];
+    bytes_read = Socket::Read(socket, buffer, length);
+    if (bytes_read > 0) {
+      Dart_Handle result =
+          Dart_ListSetAsBytes(buffer_obj, offset, buffer, bytes_read);
+      if (Dart_IsError(result)) {
+        delete[] buffer;
+        Dart_PropagateError(result);
+      }
     }
+    delete[] buffer;
   }
-  delete[] buffer;
   if (bytes_read >= 0) {
     Dart_SetReturnValue(args, Dart_NewInteger(bytes_read));
   } else {
@@ -112,28 +120,40 @@ void FUNCTION_NAME(Socket_WriteList)(Dart_NativeArguments args) {
     length = (length + 1) / 2;
   }
 
-  // Send data in chunks of maximum 16KB.
-  const intptr_t max_chunk_length =
-      dart::Utils::Minimum(length, static_cast<intptr_t>(16 * KB));
-  uint8_t* buffer = new uint8_t[max_chunk_length];
   intptr_t total_bytes_written = 0;
   intptr_t bytes_written = 0;
-  do {
-    intptr_t chunk_length =
-        dart::Utils::Minimum(max_chunk_length, length - total_bytes_written);
-    result = Dart_ListGetAsBytes(buffer_obj,
-                                 offset + total_bytes_written,
-                                 buffer,
-                                 chunk_length);
-    if (Dart_IsError(result)) {
-      delete[] buffer;
-      Dart_PropagateError(result);
-    }
-    bytes_written =
-        Socket::Write(socket, reinterpret_cast<void*>(buffer), chunk_length);
-    total_bytes_written += bytes_written;
-  } while (bytes_written > 0 && total_bytes_written < length);
-  delete[] buffer;
+  uint8_t* data = NULL;
+  if (DartUtils::AcquireByteArrayData(buffer_obj, &data)) {
+    // Write straight from the byte array.
+    do {
+      bytes_written = Socket::Write(socket,
+                                    data + offset + total_bytes_written,
+                                    length - total_bytes_written);
+      total_bytes_written += bytes_written;
+    } while (bytes_written > 0 && total_bytes_written < length);
+    Dart_ByteArrayReleaseData(buffer_obj);
+  } else {
+    // Send data in chunks of maximum 16KB.
+    const intptr_t max_chunk_length =
+        dart::Utils::Minimum(length, static_cast<intptr_t>(16 * KB));
+    uint8_t* buffer = new uint8_t[max_chunk_length];
+    do {
+      intptr_t chunk_length =
+          dart::Utils::Minimum(max_chunk_length, length - total_bytes_written);
+      result = Dart_ListGetAsBytes(buffer_obj,
+                                   offset + total_bytes_written,
+                                   buffer,
+                                   chunk_length);
+      if (Dart_IsError(result)) {
+        delete[] buffer;
+        Dart_PropagateError(result);
+      }
+      bytes_written =
+          Socket::Write(socket, reinterpret_cast<void*>(buffer), chunk_length);
+      total_bytes_written += bytes_written;
+    } while (bytes_written > 0 && total_bytes_written < length);
+    delete[] buffer;
+  }
   if (bytes_written >= 0) {
     Dart_SetReturnValue(args, Dart_NewInteger(total_bytes_written));
   } else {
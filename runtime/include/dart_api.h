@@ -1387,6 +1387,36 @@ DART_EXPORT Dart_Handle Dart_NewExternalByteArray(uint8_t* data,
 DART_EXPORT Dart_Handle Dart_ExternalByteArrayGetPeer(Dart_Handle object,
                                                       void** peer);
 
+/**
+ * Gives direct access to the bytes of a ByteArray, for instance to read
+ * or write them with a system call without copying them.
+ *
+ * The bytes of a ByteArray in the Dart heap move with it when there is a
+ * garbage collection. Until Dart_ByteArrayReleaseData is called on the
+ * array, the caller must not use any Dart API function which may allocate
+ * in the Dart heap, or run Dart code.
+ *
+ * \param array A ByteArray.
+ * \param data Returns the address of the first byte of the array, NULL if
+ *   the array is empty.
+ * \param byte_length Returns the length of the array in bytes.
+ *
+ * \return A valid handle if no error occurs during the operation.
+ */
+DART_EXPORT Dart_Handle Dart_ByteArrayAcquireData(Dart_Handle array,
+                                                  uint8_t** data,
+                                                  intptr_t* byte_length);
+
+/**
+ * Ends the direct access to the bytes of a ByteArray started by
+ * Dart_ByteArrayAcquireData.
+ *
+ * \param array The ByteArray passed to Dart_ByteArrayAcquireData.
+ *
+ * \return A valid handle if no error occurs during the operation.
+ */
+DART_EXPORT Dart_Handle Dart_ByteArrayReleaseData(Dart_Handle array);
+
 /**
  * Gets an int8_t at some byte offset in a ByteArray.
  *
@@ -5,13 +5,19 @@
 #include "platform/assert.h"
 #include "vm/bootstrap_natives.h"
 #include "vm/exceptions.h"
+#include "vm/flags.h"
 #include "vm/native_entry.h"
 #include "vm/object.h"
+#include "vm/regexp_bytecode.h"
 
 #include "lib/regexp_jsc.h"
 
 namespace dart {
 
+DEFINE_FLAG(bool, use_jscre, false,
+            "Match all regular expressions with the jscre library.");
+
+
 static void CheckAndThrowExceptionIfNull(const Instance& obj) {
   if (obj.IsNull()) {
     GrowableArray<const Object*> args;
@@ -29,8 +35,14 @@ DEFINE_NATIVE_ENTRY(JSSyntaxRegExp_factory, 4) {
   GET_NATIVE_ARGUMENT(Instance, handle_ignore_case, arguments->At(3));
   bool ignore_case = handle_ignore_case.raw() == Bool::True();
   bool multi_line = handle_multi_line.raw() == Bool::True();
-  const JSRegExp& new_regex = JSRegExp::Handle(
-      Jscre::Compile(pattern, multi_line, ignore_case));
+  // Patterns the bytecode engine does not support are left to jscre.
+  JSRegExp& new_regex = JSRegExp::Handle();
+  if (!FLAG_use_jscre) {
+    new_regex = BytecodeRegExp::Compile(pattern, multi_line, ignore_case);
+  }
+  if (new_regex.IsNull()) {
+    new_regex = Jscre::Compile(pattern, multi_line, ignore_case);
+  }
   arguments->SetReturn(new_regex);
 }
 
@@ -84,8 +96,12 @@ DEFINE_NATIVE_ENTRY(JSSyntaxRegExp_ExecuteMatch, 3) {
   CheckAndThrowExceptionIfNull(arg1);
   GET_NATIVE_ARGUMENT(String, str, arguments->At(1));
   GET_NATIVE_ARGUMENT(Smi, start_index, arguments->At(2));
-  const Array& result =
-      Array::Handle(Jscre::Execute(regexp, str, start_index.Value()));
+  Array& result = Array::Handle();
+  if (regexp.is_bytecode()) {
+    result = BytecodeRegExp::Execute(regexp, str, start_index.Value());
+  } else {
+    result = Jscre::Execute(regexp, str, start_index.Value());
+  }
   arguments->SetReturn(result);
 }
 
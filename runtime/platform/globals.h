@@ -117,6 +117,17 @@
 #endif  // defined(ARCH_IS_32_BIT)
 #endif  // !defined(PRIxPTR) && defined(TARGET_OS_WINDOWS)
 
+#if !defined(PRIdPTR) && defined(TARGET_OS_WINDOWS)
+#if defined(ARCH_IS_32_BIT)
+#define PRIdPTR "d"
+#else
+#define PRIdPTR "lld"
+#endif  // defined(ARCH_IS_32_BIT)
+#endif  // !defined(PRIdPTR) && defined(TARGET_OS_WINDOWS)
+
+// Printf format for intptr_t, e.g. OS::Print("%" Pd " bytes\n", size).
+#define Pd PRIdPTR
+
 
 // Suffixes for 64-bit integer literals.
 #ifdef _MSC_VER
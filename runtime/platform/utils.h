@@ -79,6 +79,22 @@ class Utils {
   static uint32_t RoundUpToPowerOfTwo(uint32_t x);
   static int CountOneBits(uint32_t x);
 
+  // Returns the index of the lowest set bit in x, which must not be zero.
+  static inline int CountTrailingZeros(uword x) {
+    ASSERT(x != 0);
+#if defined(_MSC_VER)
+    unsigned long result;  // NOLINT
+#if defined(ARCH_IS_64_BIT)
+    _BitScanForward64(&result, x);
+#else
+    _BitScanForward(&result, x);
+#endif
+    return static_cast<int>(result);
+#else
+    return __builtin_ctzl(x);
+#endif
+  }
+
   // Computes a hash value for the given string.
   static uint32_t StringHash(const char* data, int length);
 
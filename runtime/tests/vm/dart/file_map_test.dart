@@ -0,0 +1,92 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Dart test program for mapping files into byte arrays.
+
+#library('file_map_test');
+
+#import('dart:io');
+
+class FileMapTest {
+  static final int kLength = 1000;
+
+  static File createFile(Directory directory, String name, List<int> bytes) {
+    var file = new File("${directory.path}/$name");
+    var opened = file.openSync(FileMode.WRITE);
+    opened.writeListSync(bytes, 0, bytes.length);
+    opened.closeSync();
+    return file;
+  }
+
+  static List<int> testBytes() {
+    var bytes = new List<int>(kLength);
+    for (int i = 0; i < kLength; i++) {
+      bytes[i] = (i * 7) & 0xFF;
+    }
+    return bytes;
+  }
+
+  static testMapAsBytes(Directory directory) {
+    var bytes = testBytes();
+    var file = createFile(directory, "bytes", bytes);
+    var mapped = file.mapAsBytesSync();
+    Expect.isTrue(mapped is List<int>);
+    Expect.equals(kLength, mapped.length);
+    Expect.listEquals(bytes, mapped);
+
+    // The mapping is private: writes to the list do not reach the file.
+    mapped[0] = 42;
+    mapped[kLength - 1] = 43;
+    Expect.equals(42, mapped[0]);
+    Expect.equals(43, mapped[kLength - 1]);
+    Expect.listEquals(bytes, file.readAsBytesSync());
+    Expect.listEquals(bytes, file.mapAsBytesSync());
+  }
+
+  static testMapEmptyFile(Directory directory) {
+    var file = new File("${directory.path}/empty");
+    file.createSync();
+    var mapped = file.mapAsBytesSync();
+    Expect.isTrue(mapped is List<int>);
+    Expect.equals(0, mapped.length);
+    Expect.throws(() { return mapped[0]; },
+                  (e) { return e is IndexOutOfRangeException; });
+  }
+
+  static testMapMissingFile(Directory directory) {
+    var file = new File("${directory.path}/missing");
+    Expect.throws(() { file.mapAsBytesSync(); },
+                  (e) { return e is FileIOException; });
+  }
+
+  static testUnmapCollected(Directory directory) {
+    // Each mapping is released by the finalizer of its list when the list
+    // is collected. Without it, the process runs out of mappings long
+    // before the end of the loop.
+    var file = createFile(directory, "unmap", testBytes());
+    for (int i = 0; i < 100000; i++) {
+      var mapped = file.mapAsBytesSync();
+      Expect.equals(kLength, mapped.length);
+      // Cause scavenges, which collect the unreachable lists.
+      var garbage = new List(100);
+      garbage[0] = mapped;
+    }
+  }
+
+  static testMain() {
+    var directory = new Directory("").createTempSync();
+    try {
+      testMapAsBytes(directory);
+      testMapEmptyFile(directory);
+      testMapMissingFile(directory);
+      testUnmapCollected(directory);
+    } finally {
+      directory.deleteRecursivelySync();
+    }
+  }
+}
+
+main() {
+  FileMapTest.testMain();
+}
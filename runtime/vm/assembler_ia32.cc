@@ -1340,10 +1340,37 @@ void Assembler::CompareObject(Register reg, const Object& object) {
 }
 
 
+// Emits the generational write barrier: when an old object is made to refer
+// to a new object the address of the updated slot is added to the store
+// buffer. Destroys no registers.
 void Assembler::StoreIntoObject(Register object,
                                 const FieldAddress& dest,
                                 Register value) {
-  // TODO(iposva): Add write barrier.
+  ASSERT(object != value);
+  movl(dest, value);
+  Label done;
+  // Smis and old values need not be remembered.
+  testl(value, Immediate(kHeapObjectTag));
+  j(ZERO, &done, Assembler::kNearJump);
+  testl(value, Immediate(kNewObjectAlignmentOffset));
+  j(ZERO, &done, Assembler::kNearJump);
+  // Stores into new objects need not be remembered.
+  testl(object, Immediate(kNewObjectAlignmentOffset));
+  j(NOT_ZERO, &done, Assembler::kNearJump);
+  // Pass the address of the slot on the stack, preserving value.
+  pushl(value);
+  leal(value, dest);
+  pushl(value);
+  call(&StubCode::UpdateStoreBufferLabel());
+  popl(value);
+  popl(value);
+  Bind(&done);
+}
+
+
+void Assembler::StoreIntoObjectNoBarrier(Register object,
+                                         const FieldAddress& dest,
+                                         Register value) {
   movl(dest, value);
 }
 
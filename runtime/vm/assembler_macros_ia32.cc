@@ -44,9 +44,10 @@ void AssemblerMacros::TryAllocate(Assembler* assembler,
     __ movl(Address::Absolute(heap->TopAddress()), instance_reg);
     ASSERT(instance_size >= kHeapObjectTag);
     __ subl(instance_reg, Immediate(instance_size - kHeapObjectTag));
-    __ StoreIntoObject(instance_reg,
-                       FieldAddress(instance_reg, Instance::class_offset()),
-                       class_reg);
+    __ StoreIntoObjectNoBarrier(
+        instance_reg,
+        FieldAddress(instance_reg, Instance::class_offset()),
+        class_reg);
     uword tags = 0;
     tags = RawObject::SizeTag::update(instance_size, tags);
     ASSERT(cls.index() != kIllegalObjectKind);
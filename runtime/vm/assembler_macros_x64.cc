@@ -48,9 +48,10 @@ void AssemblerMacros::TryAllocate(Assembler* assembler,
     __ movq(Address(TMP, 0), instance_reg);
     ASSERT(instance_size >= kHeapObjectTag);
     __ subq(instance_reg, Immediate(instance_size - kHeapObjectTag));
-    __ StoreIntoObject(instance_reg,
-                       FieldAddress(instance_reg, Instance::class_offset()),
-                       class_reg);
+    __ StoreIntoObjectNoBarrier(
+        instance_reg,
+        FieldAddress(instance_reg, Instance::class_offset()),
+        class_reg);
     uword tags = 0;
     tags = RawObject::SizeTag::update(instance_size, tags);
     ASSERT(cls.index() != kIllegalObjectKind);
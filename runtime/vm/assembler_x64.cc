@@ -1300,10 +1300,37 @@ void Assembler::CompareObject(Register reg, const Object& object) {
 }
 
 
+// Emits the generational write barrier: when an old object is made to refer
+// to a new object the address of the updated slot is added to the store
+// buffer. Destroys the TMP register.
 void Assembler::StoreIntoObject(Register object,
                                 const FieldAddress& dest,
                                 Register value) {
-  // TODO(iposva): Add write barrier.
+  ASSERT(object != value);
+  movq(dest, value);
+  Label done;
+  // Smis and old values need not be remembered.
+  testq(value, Immediate(kHeapObjectTag));
+  j(ZERO, &done, Assembler::kNearJump);
+  testq(value, Immediate(kNewObjectAlignmentOffset));
+  j(ZERO, &done, Assembler::kNearJump);
+  // Stores into new objects need not be remembered.
+  testq(object, Immediate(kNewObjectAlignmentOffset));
+  j(NOT_ZERO, &done, Assembler::kNearJump);
+  // Pass the address of the slot on the stack, preserving value.
+  pushq(value);
+  leaq(value, dest);
+  pushq(value);
+  call(&StubCode::UpdateStoreBufferLabel());
+  popq(value);
+  popq(value);
+  Bind(&done);
+}
+
+
+void Assembler::StoreIntoObjectNoBarrier(Register object,
+                                         const FieldAddress& dest,
+                                         Register value) {
   movq(dest, value);
 }
 
@@ -498,6 +498,13 @@ class Assembler : public ValueObject {
                        const FieldAddress& dest,  // Where we are storing into.
                        Register value);  // Value we are storing.
 
+  // Stores into an object without emitting a write barrier. Only to be used
+  // when the value is known not to be a new object or when the object is
+  // known to be a new object, e.g. when initializing a freshly allocated one.
+  void StoreIntoObjectNoBarrier(Register object,
+                                const FieldAddress& dest,
+                                Register value);
+
   void DoubleNegate(XmmRegister d);
   void FloatNegate(XmmRegister f);
 
@@ -0,0 +1,145 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/background_compiler.h"
+
+#include "vm/compiler.h"
+#include "vm/debugger.h"
+#include "vm/flags.h"
+#include "vm/isolate.h"
+#include "vm/object.h"
+#include "vm/os.h"
+#include "vm/visitor.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool, background_compilation, false,
+    "Optimize functions when the isolate is idle instead of when their "
+    "usage counter reaches the threshold.");
+DEFINE_FLAG(bool, trace_background_compilation, false,
+    "Trace queue time and compile time of background compilation.");
+DEFINE_FLAG(int, background_compilation_max_wait, 100,
+    "Compile a queued function synchronously when it reaches the usage "
+    "counter threshold again after waiting longer than this (ms).");
+DECLARE_FLAG(int, deoptimization_counter_threshold);
+
+
+BackgroundCompiler::BackgroundCompiler()
+    : head_(0),
+      length_(0),
+      compiled_(0),
+      rejected_(0),
+      overdue_(0) {
+  for (intptr_t i = 0; i < kCapacity; i++) {
+    functions_[i] = Function::null();
+    enqueue_micros_[i] = 0;
+  }
+}
+
+
+BackgroundCompiler::~BackgroundCompiler() {
+}
+
+
+bool BackgroundCompiler::Enqueue(const Function& function) {
+  ASSERT(!function.IsNull());
+  for (intptr_t i = 0; i < length_; i++) {
+    const intptr_t index = IndexAt(i);
+    if (functions_[index] == function.raw()) {
+      const int64_t queue_micros =
+          OS::GetCurrentTimeMicros() - enqueue_micros_[index];
+      if (queue_micros <= FLAG_background_compilation_max_wait * 1000) {
+        return true;
+      }
+      // The isolate has not been idle since the function was queued.
+      RemoveAt(i);
+      overdue_++;
+      if (FLAG_trace_background_compilation) {
+        OS::Print("Background compilation of '%s' overdue: queued %lld us\n",
+                  function.ToFullyQualifiedCString(),
+                  queue_micros);
+      }
+      return false;
+    }
+  }
+  if (length_ == kCapacity) {
+    rejected_++;
+    if (FLAG_trace_background_compilation) {
+      OS::Print("Background compilation queue full, rejected '%s'\n",
+                function.ToFullyQualifiedCString());
+    }
+    return false;
+  }
+  const intptr_t index = (head_ + length_) % kCapacity;
+  functions_[index] = function.raw();
+  enqueue_micros_[index] = OS::GetCurrentTimeMicros();
+  length_++;
+  return true;
+}
+
+
+void BackgroundCompiler::RemoveAt(intptr_t position) {
+  // Shift the functions queued after position to keep the queue order.
+  for (intptr_t i = position; i < (length_ - 1); i++) {
+    const intptr_t to = IndexAt(i);
+    const intptr_t from = IndexAt(i + 1);
+    functions_[to] = functions_[from];
+    enqueue_micros_[to] = enqueue_micros_[from];
+  }
+  functions_[IndexAt(length_ - 1)] = Function::null();
+  length_--;
+}
+
+
+void BackgroundCompiler::CompileNext() {
+  ASSERT(!IsEmpty());
+  Isolate* isolate = Isolate::Current();
+  ASSERT(isolate != NULL);
+  const intptr_t index = IndexAt(0);
+  const Function& function = Function::Handle(functions_[index]);
+  const int64_t queue_micros =
+      OS::GetCurrentTimeMicros() - enqueue_micros_[index];
+  functions_[index] = Function::null();
+  head_ = (head_ + 1) % kCapacity;
+  length_--;
+
+  if (function.HasOptimizedCode() ||
+      !function.is_optimizable() ||
+      isolate->debugger()->IsActive() ||
+      (function.deoptimization_counter() >=
+       FLAG_deoptimization_counter_threshold)) {
+    // E.g., optimized by on-stack replacement while it was queued.
+    function.set_usage_counter(0);
+    return;
+  }
+  const int64_t start_micros = OS::GetCurrentTimeMicros();
+  const Error& error =
+      Error::Handle(Compiler::CompileOptimizedFunction(function));
+  const int64_t compile_micros = OS::GetCurrentTimeMicros() - start_micros;
+  if (error.IsNull()) {
+    compiled_++;
+  } else {
+    // There is no caller to report the error to. Keep the unoptimized code.
+    function.set_is_optimizable(false);
+  }
+  if (FLAG_trace_background_compilation) {
+    OS::Print("Background compilation of '%s' %s: "
+              "queued %lld us, compiled in %lld us, %d left\n",
+              function.ToFullyQualifiedCString(),
+              error.IsNull() ? "done" : "failed",
+              queue_micros,
+              compile_micros,
+              length_);
+  }
+}
+
+
+void BackgroundCompiler::VisitObjectPointers(ObjectPointerVisitor* visitor) {
+  ASSERT(visitor != NULL);
+  visitor->VisitPointers(reinterpret_cast<RawObject**>(&functions_[0]),
+                         reinterpret_cast<RawObject**>(
+                             &functions_[kCapacity - 1]));
+}
+
+}  // namespace dart
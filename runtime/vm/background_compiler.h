@@ -0,0 +1,84 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef VM_BACKGROUND_COMPILER_H_
+#define VM_BACKGROUND_COMPILER_H_
+
+#include "platform/assert.h"
+#include "vm/globals.h"
+
+namespace dart {
+
+class Function;
+class ObjectPointerVisitor;
+class RawFunction;
+
+// The BackgroundCompiler is a bounded queue of functions waiting for
+// optimized code (see FLAG_background_compilation). Instead of compiling
+// when the usage counter of a function reaches the threshold, the runtime
+// adds the function to the queue and the function keeps running its
+// unoptimized code.
+//
+// The queue is served by the message handler of the isolate, which runs on
+// the thread pool, when there are no messages to handle. No Dart code of the
+// isolate is running then, so the optimized code is installed at a
+// safepoint. Messages posted during a compilation are handled before the
+// next function is compiled.
+//
+// An isolate that does not go idle, e.g., one running a long main loop,
+// never serves the queue. Functions that cannot be queued because the queue
+// is full, or that reach the threshold again after waiting longer than
+// FLAG_background_compilation_max_wait, are compiled by the caller as
+// without background compilation.
+//
+// The queue is only accessed by the thread running the isolate.
+class BackgroundCompiler {
+ public:
+  static const intptr_t kCapacity = 16;
+
+  BackgroundCompiler();
+  ~BackgroundCompiler();
+
+  // Returns false if the caller has to compile the function synchronously:
+  // the queue is full, or the function has been queued for longer than
+  // FLAG_background_compilation_max_wait; it is then removed from the queue.
+  // Otherwise a function already in the queue is not added again.
+  bool Enqueue(const Function& function);
+
+  bool IsEmpty() const { return length_ == 0; }
+  intptr_t length() const { return length_; }
+
+  // Compile the function queued first and install its optimized code.
+  // Must be called with the isolate entered and without Dart frames.
+  void CompileNext();
+
+  intptr_t compiled() const { return compiled_; }
+  intptr_t rejected() const { return rejected_; }
+  intptr_t overdue() const { return overdue_; }
+
+  void VisitObjectPointers(ObjectPointerVisitor* visitor);
+
+ private:
+  intptr_t IndexAt(intptr_t position) const {
+    ASSERT((position >= 0) && (position < length_));
+    return (head_ + position) % kCapacity;
+  }
+
+  void RemoveAt(intptr_t position);
+
+  // A ring buffer of kCapacity functions and the time they were queued.
+  RawFunction* functions_[kCapacity];
+  int64_t enqueue_micros_[kCapacity];
+  intptr_t head_;
+  intptr_t length_;
+  intptr_t compiled_;
+  intptr_t rejected_;
+  intptr_t overdue_;
+
+  DISALLOW_COPY_AND_ASSIGN(BackgroundCompiler);
+};
+
+}  // namespace dart
+
+#endif  // VM_BACKGROUND_COMPILER_H_
@@ -0,0 +1,125 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "platform/assert.h"
+#include "vm/background_compiler.h"
+#include "vm/class_finalizer.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+DECLARE_FLAG(int, background_compilation_max_wait);
+
+static RawFunction* CreateTestFunction(const char* name) {
+  const String& function_name = String::Handle(String::NewSymbol(name));
+  const Function& function = Function::Handle(
+      Function::New(function_name, RawFunction::kFunction, false, false, 0));
+  // Not compiled when it is dequeued.
+  function.set_is_optimizable(false);
+  return function.raw();
+}
+
+
+TEST_CASE(BackgroundCompilerQueue) {
+  BackgroundCompiler* queue = new BackgroundCompiler();
+  EXPECT(queue->IsEmpty());
+  const Function& first = Function::Handle(CreateTestFunction("first"));
+  EXPECT(queue->Enqueue(first));
+  Function& function = Function::Handle();
+  char buffer[32];
+  for (intptr_t i = 1; i < BackgroundCompiler::kCapacity; i++) {
+    OS::SNPrint(buffer, sizeof(buffer), "name%d", i);
+    function = CreateTestFunction(buffer);
+    EXPECT(queue->Enqueue(function));
+  }
+  EXPECT_EQ(BackgroundCompiler::kCapacity, queue->length());
+  // A queued function is not added again.
+  EXPECT(queue->Enqueue(first));
+  EXPECT_EQ(BackgroundCompiler::kCapacity, queue->length());
+  // The queue is bounded.
+  function = CreateTestFunction("last");
+  EXPECT(!queue->Enqueue(function));
+  EXPECT_EQ(1, queue->rejected());
+
+  // Functions that cannot be optimized are dropped.
+  while (!queue->IsEmpty()) {
+    queue->CompileNext();
+  }
+  EXPECT_EQ(0, queue->compiled());
+  EXPECT(queue->Enqueue(function));
+  delete queue;
+}
+
+
+TEST_CASE(BackgroundCompilerOverdue) {
+  const intptr_t saved_max_wait = FLAG_background_compilation_max_wait;
+  FLAG_background_compilation_max_wait = 0;
+  BackgroundCompiler* queue = new BackgroundCompiler();
+  const Function& first = Function::Handle(CreateTestFunction("first"));
+  const Function& second = Function::Handle(CreateTestFunction("second"));
+  const Function& third = Function::Handle(CreateTestFunction("third"));
+  EXPECT(queue->Enqueue(first));
+  EXPECT(queue->Enqueue(second));
+  EXPECT(queue->Enqueue(third));
+  OS::Sleep(2);
+  // The isolate was not idle: the caller compiles the function itself.
+  EXPECT(!queue->Enqueue(second));
+  EXPECT_EQ(1, queue->overdue());
+  EXPECT_EQ(0, queue->rejected());
+  EXPECT_EQ(2, queue->length());
+  // The remaining functions stay queued in order.
+  FLAG_background_compilation_max_wait = saved_max_wait;
+  EXPECT(queue->Enqueue(first));
+  EXPECT(queue->Enqueue(third));
+  EXPECT_EQ(2, queue->length());
+  queue->CompileNext();
+  queue->CompileNext();
+  EXPECT(queue->IsEmpty());
+  EXPECT_EQ(0, queue->compiled());
+  delete queue;
+}
+
+
+// Compiler only implemented on IA32 and X64 now.
+#if defined(TARGET_ARCH_IA32) || defined(TARGET_ARCH_X64)
+
+TEST_CASE(BackgroundCompilerCompileNext) {
+  const char* kScriptChars =
+      "class A {\n"
+      "  static foo(x) { return x + 1; }\n"
+      "}\n";
+  String& url =
+      String::Handle(String::New("dart-test:BackgroundCompiler"));
+  String& source = String::Handle(String::New(kScriptChars));
+  Script& script = Script::Handle(Script::New(url, source, RawScript::kSource));
+  Library& lib = Library::Handle(Library::CoreLibrary());
+  EXPECT(CompilerTest::TestCompileScript(lib, script));
+  EXPECT(ClassFinalizer::FinalizePendingClasses());
+  Class& cls = Class::Handle(
+      lib.LookupClass(String::Handle(String::NewSymbol("A"))));
+  EXPECT(!cls.IsNull());
+  String& name = String::Handle(String::New("foo"));
+  Function& function = Function::Handle(cls.LookupStaticFunction(name));
+  EXPECT(!function.IsNull());
+  EXPECT(CompilerTest::TestCompileFunction(function));
+  EXPECT(!function.HasOptimizedCode());
+
+  BackgroundCompiler* queue = new BackgroundCompiler();
+  EXPECT(queue->Enqueue(function));
+  queue->CompileNext();
+  EXPECT(queue->IsEmpty());
+  EXPECT_EQ(1, queue->compiled());
+  EXPECT(function.HasOptimizedCode());
+
+  // An optimized function is not compiled again.
+  EXPECT(queue->Enqueue(function));
+  queue->CompileNext();
+  EXPECT_EQ(1, queue->compiled());
+  delete queue;
+}
+
+#endif  // TARGET_ARCH_IA32 || TARGET_ARCH_X64
+
+}  // namespace dart
@@ -6,14 +6,25 @@
 
 #include "bin/file.h"
 
+#include "lib/regexp_jsc.h"
+
 #include "platform/assert.h"
 
+#include "vm/bigint_operations.h"
+#include "vm/compiler.h"
 #include "vm/dart_api_impl.h"
+#include "vm/dart_entry.h"
+#include "vm/heap.h"
+#include "vm/regexp_bytecode.h"
+#include "vm/resolver.h"
 #include "vm/stack_frame.h"
 #include "vm/unit_test.h"
 
 namespace dart {
 
+DECLARE_FLAG(int, tenure_age);
+DECLARE_FLAG(bool, use_linear_scan);
+
 Benchmark* Benchmark::first_ = NULL;
 Benchmark* Benchmark::tail_ = NULL;
 const char* Benchmark::executable_ = NULL;
@@ -341,4 +352,468 @@ BENCHMARK(FrameLookup) {
   benchmark->set_score(elapsed_time);
 }
 
+
+// The linear scan register allocator is only implemented on X64.
+#if defined(TARGET_ARCH_X64)
+
+static int64_t TimeOptimizedLoop(const Class& cls,
+                                 const char* name,
+                                 bool use_linear_scan) {
+  const intptr_t kNumIterations = 1000000;
+  const Function& function = Function::Handle(
+      cls.LookupStaticFunction(String::Handle(String::New(name))));
+  EXPECT(!function.IsNull());
+  EXPECT(Error::Handle(Compiler::CompileFunction(function)).IsNull());
+  const bool saved_use_linear_scan = FLAG_use_linear_scan;
+  FLAG_use_linear_scan = use_linear_scan;
+  const Error& error =
+      Error::Handle(Compiler::CompileOptimizedFunction(function));
+  FLAG_use_linear_scan = saved_use_linear_scan;
+  EXPECT(error.IsNull());
+  GrowableArray<const Object*> arguments;
+  const Smi& count = Smi::Handle(Smi::New(kNumIterations));
+  arguments.Add(&count);
+  const Array& kNoArgumentNames = Array::Handle();
+  Timer timer(true, "Optimized loop benchmark");
+  timer.Start();
+  const Object& result = Object::Handle(
+      DartEntry::InvokeStatic(function, arguments, kNoArgumentNames));
+  timer.Stop();
+  EXPECT(result.raw() == count.raw());
+  return timer.TotalElapsedTime();
+}
+
+
+static RawClass* LoadLinearScanLoopClass() {
+  const char* kScriptChars =
+      "class A {\n"
+      "  static loop(n) {\n"
+      "    var x = null;\n"
+      "    var count = 0;\n"
+      "    for (var i = 0; i < n; i = i + 1) {\n"
+      "      var a = x === null;\n"
+      "      var b = !a;\n"
+      "      var c = !b;\n"
+      "      if ((a === c) && (b !== c)) count = count + 1;\n"
+      "    }\n"
+      "    return count;\n"
+      "  }\n"
+      "}\n";
+  Dart_Handle lib = TestCase::LoadTestScript(kScriptChars, NULL);
+  EXPECT_VALID(lib);
+  Library& library = Library::Handle();
+  library ^= Api::UnwrapHandle(lib);
+  const Class& cls = Class::Handle(
+      library.LookupClass(String::Handle(String::NewSymbol("A"))));
+  EXPECT(!cls.IsNull());
+  return cls.raw();
+}
+
+
+//
+// Measure optimized code for a loop of comparisons and local variable
+// updates, with the temporaries on the expression stack.
+//
+BENCHMARK(LinearScanLoopStack) {
+  const Class& cls = Class::Handle(LoadLinearScanLoopClass());
+  benchmark->set_score(TimeOptimizedLoop(cls, "loop", false));
+}
+
+
+//
+// Measure the same loop with the temporaries in registers.
+//
+BENCHMARK(LinearScanLoopRegisters) {
+  const Class& cls = Class::Handle(LoadLinearScanLoopClass());
+  benchmark->set_score(TimeOptimizedLoop(cls, "loop", true));
+}
+
+#endif  // TARGET_ARCH_X64
+
+
+// Effects of a tenuring threshold on the allocation of objects of medium
+// lifetime.
+struct TenureAgeStats {
+  int64_t elapsed_time;  // In micros.
+  intptr_t old_gen_growth;  // In bytes.
+  intptr_t mark_sweeps;
+  intptr_t scavenges;
+};
+
+
+static void MeasureTenureAge(Benchmark* benchmark,
+                             int tenure_age,
+                             TenureAgeStats* stats) {
+  const intptr_t kNumSlots = 16 * 1024;
+  const intptr_t kNumAllocations = 4 * 1024 * 1024;
+  Heap* heap = benchmark->isolate()->heap();
+  int saved_tenure_age = FLAG_tenure_age;
+  FLAG_tenure_age = tenure_age;
+  heap->CollectAllGarbage();
+  const intptr_t old_used_before = heap->Used(Heap::kOld);
+  const int mark_sweeps_before = heap->Collections(Heap::kOld);
+  const int scavenges_before = heap->Collections(Heap::kNew);
+  Timer timer(true, "Tenure age benchmark");
+  timer.Start();
+  // Every array stays alive for kNumSlots allocations.
+  const Array& slots = Array::Handle(Array::New(kNumSlots, Heap::kOld));
+  Array& element = Array::Handle();
+  for (intptr_t j = 0; j < kNumAllocations; j++) {
+    element = Array::New(4);
+    slots.SetAt(j % kNumSlots, element);
+  }
+  timer.Stop();
+  FLAG_tenure_age = saved_tenure_age;
+  stats->elapsed_time = timer.TotalElapsedTime();
+  stats->old_gen_growth = heap->Used(Heap::kOld) - old_used_before;
+  stats->mark_sweeps = heap->Collections(Heap::kOld) - mark_sweeps_before;
+  stats->scavenges = heap->Collections(Heap::kNew) - scavenges_before;
+}
+
+
+//
+// Measure allocating objects of medium lifetime with the given tenuring
+// threshold: the elapsed time, the old gen growth in KB caused by promotion,
+// and the number of mark-sweeps and scavenges.
+//
+#define TENURE_AGE_BENCHMARKS(age)                                             \
+  BENCHMARK(TenureAge##age) {                                                  \
+    TenureAgeStats stats;                                                      \
+    MeasureTenureAge(benchmark, age, &stats);                                  \
+    benchmark->set_score(stats.elapsed_time);                                  \
+  }                                                                            \
+  BENCHMARK(TenureAge##age##OldGenGrowth) {                                    \
+    TenureAgeStats stats;                                                      \
+    MeasureTenureAge(benchmark, age, &stats);                                  \
+    benchmark->set_score(stats.old_gen_growth / KB);                           \
+  }                                                                            \
+  BENCHMARK(TenureAge##age##MarkSweeps) {                                      \
+    TenureAgeStats stats;                                                      \
+    MeasureTenureAge(benchmark, age, &stats);                                  \
+    benchmark->set_score(stats.mark_sweeps);                                   \
+  }                                                                            \
+  BENCHMARK(TenureAge##age##Scavenges) {                                       \
+    TenureAgeStats stats;                                                      \
+    MeasureTenureAge(benchmark, age, &stats);                                  \
+    benchmark->set_score(stats.scavenges);                                     \
+  }
+
+TENURE_AGE_BENCHMARKS(0)
+TENURE_AGE_BENCHMARKS(1)
+TENURE_AGE_BENCHMARKS(2)
+TENURE_AGE_BENCHMARKS(4)
+
+#undef TENURE_AGE_BENCHMARKS
+
+
+// Returns the time in nanoseconds to resolve a dynamic call, as done on an
+// inline cache miss, for a class with the given number of methods.
+static intptr_t TimeResolveDynamic(intptr_t num_methods) {
+  const intptr_t kNumLookups = 100000;
+  const intptr_t kMaxNameLength = 32;
+  // Generate "class C { m0() {} ... m3() {} } main() { new C(); }".
+  const intptr_t script_length = (num_methods + 2) * kMaxNameLength;
+  char* script = reinterpret_cast<char*>(malloc(script_length));
+  intptr_t pos = OS::SNPrint(script, script_length, "class C {");
+  for (intptr_t j = 0; j < num_methods; j++) {
+    pos += OS::SNPrint(script + pos, script_length - pos,
+                       " m%" Pd "() {}", j);
+  }
+  OS::SNPrint(script + pos, script_length - pos,
+              " }\nmain() { new C(); }\n");
+  Dart_Handle lib = TestCase::LoadTestScript(script, NULL);
+  free(script);
+  EXPECT_VALID(Dart_Invoke(lib, Dart_NewString("main"), 0, NULL));
+  Library& library = Library::Handle();
+  library ^= Api::UnwrapHandle(lib);
+  const Class& cls = Class::Handle(
+      library.LookupClass(String::Handle(String::NewSymbol("C"))));
+  EXPECT(!cls.IsNull());
+
+  char name[kMaxNameLength];
+  const Array& names = Array::Handle(Array::New(num_methods));
+  for (intptr_t j = 0; j < num_methods; j++) {
+    OS::SNPrint(name, kMaxNameLength, "m%" Pd, j);
+    names.SetAt(j, String::Handle(String::NewSymbol(name)));
+  }
+  String& function_name = String::Handle();
+  Function& function = Function::Handle();
+  const intptr_t num_iterations = kNumLookups / num_methods;
+  Timer timer(true, "Resolve dynamic benchmark");
+  timer.Start();
+  for (intptr_t k = 0; k < num_iterations; k++) {
+    for (intptr_t j = 0; j < num_methods; j++) {
+      function_name ^= names.At(j);
+      function = Resolver::ResolveDynamicForReceiverClass(
+          cls, function_name, 1, 0);
+      EXPECT(!function.IsNull());
+    }
+  }
+  timer.Stop();
+  return (timer.TotalElapsedTime() * 1000) / (num_iterations * num_methods);
+}
+
+
+//
+// Measure the cost of resolving a dynamic call for classes with an
+// increasing number of methods. Large classes are looked up through a hash
+// table instead of a linear scan.
+//
+BENCHMARK(ResolveDynamic4) {
+  benchmark->set_score(TimeResolveDynamic(4));
+}
+
+
+BENCHMARK(ResolveDynamic16) {
+  benchmark->set_score(TimeResolveDynamic(16));
+}
+
+
+BENCHMARK(ResolveDynamic64) {
+  benchmark->set_score(TimeResolveDynamic(64));
+}
+
+
+BENCHMARK(ResolveDynamic256) {
+  benchmark->set_score(TimeResolveDynamic(256));
+}
+
+
+// Compiler only implemented on IA32 and X64 now.
+#if defined(TARGET_ARCH_IA32) || defined(TARGET_ARCH_X64)
+
+// Optimized numeric kernels on doubles and on 64-bit integers, which are
+// Mints on ia32.
+static const char* kNumericKernelsScriptChars =
+    "class Kernels {\n"
+    "  static polynomial(n) {\n"
+    "    var sum = 0.0;\n"
+    "    for (var i = 0; i < n; i++) {\n"
+    "      var x = i * 0.001;\n"
+    "      sum = sum + ((x * 3.0 + 2.0) * x - 1.0) * x / 7.0;\n"
+    "    }\n"
+    "    return sum;\n"
+    "  }\n"
+    "  static checksum(n) {\n"
+    "    var hash = 0x100000000;\n"
+    "    for (var i = 0; i < n; i++) {\n"
+    "      hash = (hash + i) ^ (hash - 0x7FFFFFFF);\n"
+    "    }\n"
+    "    return hash;\n"
+    "  }\n"
+    "}\n";
+
+
+struct NumericKernelStats {
+  int64_t elapsed_time;  // In micros.
+  intptr_t scavenges;
+};
+
+
+static void MeasureNumericKernel(Benchmark* benchmark,
+                                 const char* kernel,
+                                 NumericKernelStats* stats) {
+  const intptr_t kNumWarmupIterations = 100;
+  const intptr_t kNumIterations = 1000000;
+  Dart_Handle lib = TestCase::LoadTestScript(kNumericKernelsScriptChars, NULL);
+  EXPECT_VALID(lib);
+  Library& library = Library::Handle();
+  library ^= Api::UnwrapHandle(lib);
+  const Class& cls = Class::Handle(
+      library.LookupClass(String::Handle(String::NewSymbol("Kernels"))));
+  EXPECT(!cls.IsNull());
+  const Function& function = Function::Handle(
+      cls.LookupStaticFunction(String::Handle(String::New(kernel))));
+  EXPECT(!function.IsNull());
+  Heap* heap = benchmark->isolate()->heap();
+  const Array& kNoArgumentNames = Array::Handle();
+  GrowableArray<const Object*> arguments;
+  const Smi& warmup_count = Smi::Handle(Smi::New(kNumWarmupIterations));
+  const Smi& count = Smi::Handle(Smi::New(kNumIterations));
+  Object& result = Object::Handle();
+  // Collect type feedback in unoptimized code before optimizing.
+  EXPECT(Error::Handle(Compiler::CompileFunction(function)).IsNull());
+  arguments.Add(&warmup_count);
+  result = DartEntry::InvokeStatic(function, arguments, kNoArgumentNames);
+  EXPECT(!result.IsError());
+  EXPECT(Error::Handle(
+      Compiler::CompileOptimizedFunction(function)).IsNull());
+  heap->CollectAllGarbage();
+  arguments.Clear();
+  arguments.Add(&count);
+  const int scavenges_before = heap->Collections(Heap::kNew);
+  Timer timer(true, "Numeric kernel benchmark");
+  timer.Start();
+  result = DartEntry::InvokeStatic(function, arguments, kNoArgumentNames);
+  timer.Stop();
+  EXPECT(!result.IsError());
+  stats->elapsed_time = timer.TotalElapsedTime();
+  stats->scavenges = heap->Collections(Heap::kNew) - scavenges_before;
+}
+
+
+//
+// Measure an optimized polynomial evaluation on doubles, and the number of
+// scavenges caused by boxing its results.
+//
+BENCHMARK(NumericPolynomial) {
+  NumericKernelStats stats;
+  MeasureNumericKernel(benchmark, "polynomial", &stats);
+  benchmark->set_score(stats.elapsed_time);
+}
+
+
+BENCHMARK(NumericPolynomialScavenges) {
+  NumericKernelStats stats;
+  MeasureNumericKernel(benchmark, "polynomial", &stats);
+  benchmark->set_score(stats.scavenges);
+}
+
+
+//
+// Measure an optimized checksum on 64-bit integers, and the number of
+// scavenges caused by boxing its results.
+//
+BENCHMARK(NumericChecksum) {
+  NumericKernelStats stats;
+  MeasureNumericKernel(benchmark, "checksum", &stats);
+  benchmark->set_score(stats.elapsed_time);
+}
+
+
+BENCHMARK(NumericChecksumScavenges) {
+  NumericKernelStats stats;
+  MeasureNumericKernel(benchmark, "checksum", &stats);
+  benchmark->set_score(stats.scavenges);
+}
+
+#endif  // TARGET_ARCH_IA32 || TARGET_ARCH_X64
+
+
+static uword BenchmarkZoneAllocator(intptr_t size) {
+  Zone* zone = Isolate::Current()->current_zone();
+  return zone->Allocate(size);
+}
+
+
+// Returns the time to multiply, divide and convert to decimal bigints with
+// the given number of decimal digits.
+static int64_t TimeBigintArithmetic(intptr_t length) {
+  char* digits = reinterpret_cast<char*>(BenchmarkZoneAllocator(length + 1));
+  for (intptr_t j = 0; j < length; j++) {
+    digits[j] = '1' + (j * 7) % 9;
+  }
+  digits[length] = '\0';
+  Timer timer(true, "Bigint arithmetic benchmark");
+  timer.Start();
+  const Bigint& a = Bigint::Handle(
+      BigintOperations::FromDecimalCString(digits));
+  const Bigint& b = Bigint::Handle(
+      BigintOperations::FromDecimalCString(digits + length / 2));
+  const Bigint& product = Bigint::Handle(BigintOperations::Multiply(a, a));
+  const Bigint& quotient =
+      Bigint::Handle(BigintOperations::Divide(product, b));
+  const char* str =
+      BigintOperations::ToDecimalCString(quotient, &BenchmarkZoneAllocator);
+  timer.Stop();
+  EXPECT(str != NULL);
+  return timer.TotalElapsedTime();
+}
+
+
+//
+// Measure multiplication, division and decimal conversion of bigints with
+// thousands of digits.
+//
+BENCHMARK(BigintArithmetic1000) {
+  benchmark->set_score(TimeBigintArithmetic(1000));
+}
+
+
+BENCHMARK(BigintArithmetic10000) {
+  benchmark->set_score(TimeBigintArithmetic(10000));
+}
+
+
+BENCHMARK(BigintArithmetic50000) {
+  benchmark->set_score(TimeBigintArithmetic(50000));
+}
+
+
+// Matches regular expressions over log lines with the bytecode engine, which
+// matches the string in place, or with jscre. Returns the elapsed time.
+static int64_t TimeLogMatches(bool use_bytecode) {
+  const char* kPatterns[] = {
+    "ERROR",
+    "(\\d+)-(\\d+)-(\\d+) (\\d+):(\\d+)",
+    "user=(\\w+)",
+    "GET (/[^ ]*) HTTP/1\\.[01]\" (\\d{3})",
+  };
+  const char* kLine =
+      "2012-10-16 12:34:56 INFO [worker-3] user=admin "
+      "\"GET /index.html?page=2 HTTP/1.1\" 200 5120 0.004\n";
+  const intptr_t kLines = 1000;
+  // All patterns but the first match once per line.
+  const intptr_t kExpectedMatches = (ARRAY_SIZE(kPatterns) - 1) * kLines;
+  const intptr_t line_length = strlen(kLine);
+  char* log = reinterpret_cast<char*>(
+      BenchmarkZoneAllocator(kLines * line_length + 1));
+  for (intptr_t i = 0; i < kLines; i++) {
+    memmove(log + i * line_length, kLine, line_length);
+  }
+  log[kLines * line_length] = '\0';
+  const String& subject = String::Handle(String::New(log));
+  JSRegExp& regexp = JSRegExp::Handle();
+  Array& match = Array::Handle();
+  Smi& end = Smi::Handle();
+  intptr_t matches = 0;
+  int64_t elapsed_time = 0;
+  for (size_t i = 0; i < ARRAY_SIZE(kPatterns); i++) {
+    const String& pattern = String::Handle(String::New(kPatterns[i]));
+    if (use_bytecode) {
+      regexp = BytecodeRegExp::Compile(pattern, false, false);
+    } else {
+      regexp = Jscre::Compile(pattern, false, false);
+    }
+    EXPECT(!regexp.IsNull());
+    Timer timer(true, "RegExp match benchmark");
+    timer.Start();
+    intptr_t position = 0;
+    while (true) {
+      if (use_bytecode) {
+        match = BytecodeRegExp::Execute(regexp, subject, position);
+      } else {
+        match = Jscre::Execute(regexp, subject, position);
+      }
+      if (match.IsNull()) {
+        break;
+      }
+      end ^= match.At(1);
+      position = end.Value() + 1;
+      matches++;
+    }
+    timer.Stop();
+    elapsed_time += timer.TotalElapsedTime();
+  }
+  EXPECT_EQ(kExpectedMatches, matches);
+  return elapsed_time;
+}
+
+
+//
+// Measure matching regular expressions over log lines with the bytecode
+// engine.
+//
+BENCHMARK(RegExpMatch) {
+  benchmark->set_score(TimeLogMatches(true));
+}
+
+
+//
+// Measure matching the same regular expressions with jscre.
+//
+BENCHMARK(RegExpMatchJscre) {
+  benchmark->set_score(TimeLogMatches(false));
+}
+
 }  // namespace dart
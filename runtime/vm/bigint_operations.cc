@@ -152,43 +152,71 @@ RawBigint* BigintOperations::FromHexCString(const char* hex_string,
 
 RawBigint* BigintOperations::FromDecimalCString(const char* str,
                                                 Heap::Space space) {
-  // Read 8 digits a time. 10^8 < 2^27.
-  const int kDigitsPerIteration = 8;
-  const Chunk kTenMultiplier = 100000000;
-  ASSERT(kDigitBitSize >= 27);
-
   intptr_t str_length = strlen(str);
-  intptr_t str_pos = 0;
+  // Long strings are split in two halves, the higher one being multiplied
+  // by a power of ten. Compute the powers of ten that are needed.
+  DecimalPowers powers;
+  if (str_length > kDecimalConversionCutoff * kDecimalChunkDigits) {
+    powers.Add(&Bigint::Handle(NewFromInt64(kDecimalChunkDivisor)));
+    while ((kDecimalChunkDigits << powers.length()) < str_length) {
+      const Bigint& last = *powers.Last();
+      powers.Add(&Bigint::Handle(Multiply(last, last)));
+    }
+  }
+  return FromDecimalDigits(str, str_length, powers, powers.length() - 1,
+                           space);
+}
 
-  // Read first digit separately. This avoids a multiplication and addition.
-  // The first digit might also not have kDigitsPerIteration decimal digits.
-  int first_digit_decimal_digits = str_length % kDigitsPerIteration;
-  Chunk digit = 0;
-  for (intptr_t i = 0; i < first_digit_decimal_digits; i++) {
-    char c = str[str_pos++];
-    ASSERT(('0' <= c) && (c <= '9'));
-    digit = digit * 10 + c - '0';
-  }
-  Bigint& result = Bigint::Handle(Bigint::Allocate(1, space));
-  result.SetChunkAt(0, digit);
-  Clamp(result);  // Multiplication requires the inputs to be clamped.
-
-  // Read kDigitsPerIteration at a time, and store it in 'increment'.
-  // Then multiply the temporary result by 10^kDigitsPerIteration and add
-  // 'increment' to the new result.
-  const Bigint& increment = Bigint::Handle(Bigint::Allocate(1, space));
-  while (str_pos < str_length - 1) {
-    Chunk digit = 0;
-    for (intptr_t i = 0; i < kDigitsPerIteration; i++) {
+
+RawBigint* BigintOperations::FromDecimalDigits(const char* str,
+                                               intptr_t length,
+                                               const DecimalPowers& powers,
+                                               intptr_t power_index,
+                                               Heap::Space space) {
+  // Split at the largest power of ten with fewer digits than the string.
+  while ((power_index >= 0) &&
+         ((kDecimalChunkDigits << power_index) >= length)) {
+    power_index--;
+  }
+  if ((power_index >= 0) &&
+      (length > kDecimalConversionCutoff * kDecimalChunkDigits)) {
+    intptr_t low_length = kDecimalChunkDigits << power_index;
+    const Bigint& high = Bigint::Handle(FromDecimalDigits(
+        str, length - low_length, powers, power_index - 1, space));
+    const Bigint& low = Bigint::Handle(FromDecimalDigits(
+        str + length - low_length, low_length, powers, power_index - 1,
+        space));
+    const Bigint& result =
+        Bigint::Handle(Multiply(high, *powers[power_index]));
+    return Add(result, low);
+  }
+
+  // Read kDecimalChunkDigits digits at a time. 10^8 < 2^27, so each group
+  // needs at most one chunk.
+  ASSERT(kDigitBitSize >= 27);
+  intptr_t result_length =
+      (length + kDecimalChunkDigits - 1) / kDecimalChunkDigits;
+  const Bigint& result = Bigint::Handle(Bigint::Allocate(result_length, space));
+  for (intptr_t i = 0; i < result_length; i++) {
+    result.SetChunkAt(i, 0);
+  }
+  // The first group might not have kDecimalChunkDigits decimal digits.
+  intptr_t group_length = length % kDecimalChunkDigits;
+  if (group_length == 0) {
+    group_length = kDecimalChunkDigits;
+  }
+  intptr_t str_pos = 0;
+  while (str_pos < length) {
+    Chunk group = 0;
+    Chunk multiplier = 1;
+    for (intptr_t i = 0; i < group_length; i++) {
       char c = str[str_pos++];
       ASSERT(('0' <= c) && (c <= '9'));
-      digit = digit * 10 + c - '0';
-    }
-    result ^= MultiplyWithDigit(result, kTenMultiplier);
-    if (digit != 0) {
-      increment.SetChunkAt(0, digit);
-      result ^= Add(result, increment);
+      group = group * 10 + c - '0';
+      multiplier *= 10;
     }
+    MultiplyWithDigitInPlace(result, multiplier, group);
+    group_length = kDecimalChunkDigits;
   }
   Clamp(result);
   return result.raw();
@@ -337,10 +365,12 @@ const char* BigintOperations::ToDecimalCString(
   }
 
   // Approximate the size of the resulting string. We prefer overestimating
-  // to not allocating enough.
+  // to not allocating enough. The digits are produced in groups of
+  // kDecimalChunkDigits, before the leading zeroes are removed.
   int64_t bit_length = length * kDigitBitSize;
   ASSERT(bit_length > length);
-  int64_t decimal_length = (bit_length * kLog2Dividend / kLog2Divisor) + 1;
+  int64_t decimal_length =
+      (bit_length * kLog2Dividend / kLog2Divisor) + 1 + kDecimalChunkDigits;
   // Add one byte for the trailing \0 character.
   int64_t required_size = decimal_length + 1;
   if (bigint.IsNegative()) {
@@ -351,39 +381,28 @@ const char* BigintOperations::ToDecimalCString(
   char* result =
       reinterpret_cast<char*>(allocator(static_cast<intptr_t>(required_size)));
   ASSERT(result != NULL);
-  int result_pos = 0;
-
-  // We divide the input into pieces of ~27 bits which can be efficiently
-  // handled.
-  const intptr_t kChunkDivisor = 100000000;
-  const int kChunkDigits = 8;
-  ASSERT(pow(10.0, kChunkDigits) == kChunkDivisor);
-  ASSERT(static_cast<Chunk>(kChunkDivisor) < kDigitMaxValue);
-  ASSERT(Smi::IsValid(kChunkDivisor));
-  const Bigint& divisor = Bigint::Handle(NewFromInt64(kChunkDivisor));
-
-  // Rest contains the remaining bigint that needs to be printed.
-  Bigint& rest = Bigint::Handle(bigint.raw());
-  Bigint& quotient = Bigint::Handle();
-  Bigint& remainder = Bigint::Handle();
-  while (!rest.IsZero()) {
-    DivideRemainder(rest, divisor, &quotient, &remainder);
-    ASSERT(remainder.Length() <= 1);
-    intptr_t part = (remainder.Length() == 1)
-        ? static_cast<intptr_t>(remainder.GetChunkAt(0))
-        : 0;
-    for (int i = 0; i < kChunkDigits; i++) {
-      result[result_pos++] = '0' + (part % 10);
-      part /= 10;
+
+  // Long bigints are split in two halves by dividing them by a power of ten.
+  // Compute the powers of ten that are needed.
+  DecimalPowers powers;
+  if (length >= kDecimalConversionCutoff) {
+    powers.Add(&Bigint::Handle(NewFromInt64(kDecimalChunkDivisor)));
+    while ((2 * powers.Last()->Length() - 1) <= length) {
+      const Bigint& last = *powers.Last();
+      powers.Add(&Bigint::Handle(Multiply(last, last)));
     }
-    ASSERT(part == 0);
-    rest = quotient.raw();
   }
+  intptr_t result_pos =
+      AppendDecimalDigits(bigint, powers, powers.length() - 1, 0, result);
+  ASSERT(result_pos <= decimal_length);
   // Move the resulting position back until we don't have any zeroes anymore.
   // This is done so that we can remove all leading zeroes.
   while (result_pos > 1 && result[result_pos - 1] == '0') {
     result_pos--;
   }
+  if (result_pos == 0) {
+    result[result_pos++] = '0';
+  }
   if (bigint.IsNegative()) {
     result[result_pos++] = '-';
   }
@@ -403,6 +422,57 @@ const char* BigintOperations::ToDecimalCString(
 }
 
 
+intptr_t BigintOperations::AppendDecimalDigits(const Bigint& bigint,
+                                               const DecimalPowers& powers,
+                                               intptr_t power_index,
+                                               intptr_t min_digits,
+                                               char* buffer) {
+  // Split at the largest power of ten with about half the digits of the
+  // bigint.
+  intptr_t length = bigint.Length();
+  while ((power_index >= 0) &&
+         ((2 * powers[power_index]->Length()) > (length + 1))) {
+    power_index--;
+  }
+  if ((power_index >= 0) && (length >= kDecimalConversionCutoff)) {
+    Bigint& quotient = Bigint::Handle();
+    Bigint& remainder = Bigint::Handle();
+    DivideRemainder(bigint, *powers[power_index], &quotient, &remainder);
+    // The remainder has exactly low_digits digits, including its leading
+    // zeroes.
+    intptr_t low_digits = kDecimalChunkDigits << power_index;
+    intptr_t appended = AppendDecimalDigits(
+        remainder, powers, power_index - 1, low_digits, buffer);
+    ASSERT(appended == low_digits);
+    intptr_t high_min_digits = Utils::Maximum<intptr_t>(
+        min_digits - low_digits, 0);
+    return appended + AppendDecimalDigits(
+        quotient, powers, power_index - 1, high_min_digits, buffer + appended);
+  }
+
+  // Divide a copy of the bigint by 10^kDecimalChunkDigits until it is zero.
+  ASSERT(static_cast<Chunk>(kDecimalChunkDivisor) < kDigitMaxValue);
+  const Bigint& rest = Bigint::Handle(Copy(bigint));
+  intptr_t pos = 0;
+  while (!rest.IsZero()) {
+    Chunk part = DivideWithDigitInPlace(rest, kDecimalChunkDivisor);
+    for (int i = 0; i < kDecimalChunkDigits; i++) {
+      buffer[pos++] = '0' + (part % 10);
+      part /= 10;
+    }
+    ASSERT(part == 0);
+  }
+  // Adjust the leading zeroes to min_digits.
+  while ((pos > min_digits) && (buffer[pos - 1] == '0')) {
+    pos--;
+  }
+  while (pos < min_digits) {
+    buffer[pos++] = '0';
+  }
+  return pos;
+}
+
+
 bool BigintOperations::FitsIntoSmi(const Bigint& bigint) {
   intptr_t bigint_length = bigint.Length();
   if (bigint_length == 0) {
@@ -694,6 +764,18 @@ uint64_t BigintOperations::ToUint64(const Bigint& bigint) {
 RawBigint* BigintOperations::Multiply(const Bigint& a, const Bigint& b) {
   ASSERT(IsClamped(a));
   ASSERT(IsClamped(b));
+  if (Utils::Minimum(a.Length(), b.Length()) < kKaratsubaCutoff) {
+    return CombaMultiply(a, b);
+  }
+  const Bigint& result = Bigint::Handle(KaratsubaMultiply(a, b));
+  result.SetSign(a.IsNegative() != b.IsNegative());
+  return result.raw();
+}
+
+
+RawBigint* BigintOperations::CombaMultiply(const Bigint& a, const Bigint& b) {
+  ASSERT(IsClamped(a));
+  ASSERT(IsClamped(b));
 
   intptr_t a_length = a.Length();
   intptr_t b_length = b.Length();
@@ -727,9 +809,9 @@ RawBigint* BigintOperations::Multiply(const Bigint& a, const Bigint& b) {
   const DoubleChunk kDoubleChunkMaxValue = static_cast<DoubleChunk>(-1);
   const DoubleChunk left_over_carry = kDoubleChunkMaxValue >> kDigitBitSize;
   const intptr_t kMaxDigits = (kDoubleChunkMaxValue - left_over_carry) / square;
-  if (Utils::Minimum(a_length, b_length) > kMaxDigits) {
-    UNIMPLEMENTED();
-  }
+  // Longer operands are split by KaratsubaMultiply.
+  ASSERT(kKaratsubaCutoff <= kMaxDigits);
+  ASSERT(Utils::Minimum(a_length, b_length) <= kMaxDigits);
 
   DoubleChunk accumulator = 0;  // Accumulates the result of one column.
   for (intptr_t i = 0; i < result_length; i++) {
@@ -763,6 +845,55 @@ RawBigint* BigintOperations::Multiply(const Bigint& a, const Bigint& b) {
 }
 
 
+RawBigint* BigintOperations::KaratsubaMultiply(const Bigint& a,
+                                               const Bigint& b) {
+  intptr_t a_length = a.Length();
+  intptr_t b_length = b.Length();
+  if (a_length < b_length) {
+    return KaratsubaMultiply(b, a);
+  }
+  // Split the operands at half the digits of the longer one:
+  //   a = a1 * B^half + a0, and b = b1 * B^half + b0.
+  // Then a * b = z2 * B^(2 * half) + z1 * B^half + z0, with
+  //   z0 = a0 * b0,
+  //   z2 = a1 * b1,
+  //   z1 = (a0 + a1) * (b0 + b1) - z0 - z2,
+  // which takes three multiplications of half the length instead of four.
+  intptr_t half = (a_length + 1) / 2;
+  const Bigint& result =
+      Bigint::Handle(Bigint::Allocate(a_length + b_length));
+  for (intptr_t i = 0; i < a_length + b_length; i++) {
+    result.SetChunkAt(i, 0);
+  }
+  const Bigint& a0 = Bigint::Handle(Digits(a, 0, half));
+  const Bigint& a1 = Bigint::Handle(Digits(a, half, a_length - half));
+  Bigint& product = Bigint::Handle();
+  if (b_length <= half) {
+    // b is short: a * b = a1 * b * B^half + a0 * b.
+    const Bigint& b_abs = Bigint::Handle(Digits(b, 0, b_length));
+    product ^= Multiply(a0, b_abs);
+    AddShiftedInPlace(result, product, 0);
+    product ^= Multiply(a1, b_abs);
+    AddShiftedInPlace(result, product, half);
+  } else {
+    const Bigint& b0 = Bigint::Handle(Digits(b, 0, half));
+    const Bigint& b1 = Bigint::Handle(Digits(b, half, b_length - half));
+    const Bigint& z0 = Bigint::Handle(Multiply(a0, b0));
+    const Bigint& z2 = Bigint::Handle(Multiply(a1, b1));
+    const Bigint& a_sum = Bigint::Handle(UnsignedAdd(a0, a1));
+    const Bigint& b_sum = Bigint::Handle(UnsignedAdd(b0, b1));
+    product ^= Multiply(a_sum, b_sum);
+    product ^= UnsignedSubtract(product, z0);
+    product ^= UnsignedSubtract(product, z2);
+    AddShiftedInPlace(result, z0, 0);
+    AddShiftedInPlace(result, product, half);
+    AddShiftedInPlace(result, z2, 2 * half);
+  }
+  Clamp(result);
+  return result.raw();
+}
+
+
 RawBigint* BigintOperations::Divide(const Bigint& a, const Bigint& b) {
   Bigint& quotient = Bigint::Handle();
   Bigint& remainder = Bigint::Handle();
@@ -1442,18 +1573,179 @@ RawBigint* BigintOperations::UnsignedSubtract(const Bigint& a,
 
 RawBigint* BigintOperations::MultiplyWithDigit(
     const Bigint& bigint, Chunk digit) {
-  // TODO(floitsch): implement MultiplyWithDigit.
+  ASSERT(IsClamped(bigint));
+  ASSERT(digit <= kDigitMaxValue);
+  if ((digit == 0) || bigint.IsZero()) return Zero();
+
+  intptr_t length = bigint.Length();
+  const Bigint& result = Bigint::Handle(Bigint::Allocate(length + 1));
+  for (intptr_t i = 0; i < length; i++) {
+    result.SetChunkAt(i, bigint.GetChunkAt(i));
+  }
+  result.SetChunkAt(length, 0);
+  MultiplyWithDigitInPlace(result, digit, 0);
+  result.SetSign(bigint.IsNegative());
+  Clamp(result);
+  return result.raw();
+}
+
+
+void BigintOperations::MultiplyWithDigitInPlace(const Bigint& bigint,
+                                                Chunk digit,
+                                                Chunk addend) {
+  ASSERT(digit <= kDigitMaxValue);
+  ASSERT(addend <= kDigitMaxValue);
+  // (beta - 1) * (beta - 1) + (beta - 1) < beta^2, so the product of two
+  // digits plus the carry fits into a DoubleChunk.
+  DoubleChunk carry = addend;
+  intptr_t length = bigint.Length();
+  for (intptr_t i = 0; i < length; i++) {
+    DoubleChunk product =
+        static_cast<DoubleChunk>(bigint.GetChunkAt(i)) * digit + carry;
+    bigint.SetChunkAt(i, static_cast<Chunk>(product & kDigitMask));
+    carry = product >> kDigitBitSize;
+  }
+  ASSERT(carry == 0);
+}
+
+
+BigintOperations::Chunk BigintOperations::DivideWithDigitInPlace(
+    const Bigint& bigint, Chunk digit) {
+  ASSERT(digit != 0);
   ASSERT(digit <= kDigitMaxValue);
-  if (digit == 0) return Zero();
+  DoubleChunk remainder = 0;
+  for (intptr_t i = bigint.Length() - 1; i >= 0; i--) {
+    DoubleChunk dividend = (remainder << kDigitBitSize) + bigint.GetChunkAt(i);
+    bigint.SetChunkAt(i, static_cast<Chunk>(dividend / digit));
+    remainder = dividend % digit;
+  }
+  Clamp(bigint);
+  return static_cast<Chunk>(remainder);
+}
 
-  Bigint& tmp = Bigint::Handle(Bigint::Allocate(1));
-  tmp.SetChunkAt(0, digit);
-  return Multiply(bigint, tmp);
+
+RawBigint* BigintOperations::Digits(const Bigint& bigint,
+                                    intptr_t start,
+                                    intptr_t length) {
+  ASSERT(start >= 0);
+  ASSERT(start + length <= bigint.Length());
+  const Bigint& result = Bigint::Handle(Bigint::Allocate(length));
+  for (intptr_t i = 0; i < length; i++) {
+    result.SetChunkAt(i, bigint.GetChunkAt(start + i));
+  }
+  Clamp(result);
+  return result.raw();
+}
+
+
+void BigintOperations::AddShiftedInPlace(const Bigint& result,
+                                         const Bigint& value,
+                                         intptr_t digit_shift) {
+  ASSERT(!value.IsNegative());
+  intptr_t value_length = value.Length();
+  intptr_t result_length = result.Length();
+  ASSERT(digit_shift + value_length <= result_length);
+  Chunk carry = 0;
+  intptr_t i = 0;
+  for (; i < value_length; i++) {
+    Chunk sum =
+        result.GetChunkAt(digit_shift + i) + value.GetChunkAt(i) + carry;
+    result.SetChunkAt(digit_shift + i, sum & kDigitMask);
+    carry = sum >> kDigitBitSize;
+  }
+  for (i += digit_shift; carry != 0; i++) {
+    ASSERT(i < result_length);
+    Chunk sum = result.GetChunkAt(i) + carry;
+    result.SetChunkAt(i, sum & kDigitMask);
+    carry = sum >> kDigitBitSize;
+  }
 }
 
 
 void BigintOperations::DivideRemainder(
     const Bigint& a, const Bigint& b, Bigint* quotient, Bigint* remainder) {
+  ASSERT(IsClamped(a));
+  ASSERT(IsClamped(b));
+  ASSERT(!b.IsZero());
+  intptr_t a_length = a.Length();
+  intptr_t b_length = b.Length();
+  if ((b_length >= kNewtonDivisionCutoff) &&
+      ((a_length - b_length) >= kNewtonDivisionCutoff)) {
+    NewtonDivideRemainder(a, b, quotient, remainder);
+  } else {
+    SchoolbookDivideRemainder(a, b, quotient, remainder);
+  }
+}
+
+
+void BigintOperations::NewtonDivideRemainder(
+    const Bigint& a, const Bigint& b, Bigint* quotient, Bigint* remainder) {
+  ASSERT(UnsignedCompare(a, b) > 0);
+  // Compute x ~= B^n / b, where n is the length of a. Then a * x / B^n is
+  // the quotient, give or take a small error that is corrected at the end.
+  const Bigint& dividend = Bigint::Handle(Digits(a, 0, a.Length()));
+  const Bigint& divisor = Bigint::Handle(Digits(b, 0, b.Length()));
+  intptr_t precision = dividend.Length();
+  const Bigint& reciprocal =
+      Bigint::Handle(Reciprocal(divisor, precision));
+  Bigint& q = Bigint::Handle(Multiply(dividend, reciprocal));
+  q ^= ShiftRight(q, precision * kDigitBitSize);
+  Bigint& r = Bigint::Handle(Multiply(q, divisor));
+  r ^= Subtract(dividend, r);
+  const Bigint& one = Bigint::Handle(One());
+  while (r.IsNegative()) {
+    q ^= Subtract(q, one);
+    r ^= Add(r, divisor);
+  }
+  while (UnsignedCompare(r, divisor) >= 0) {
+    q ^= Add(q, one);
+    r ^= Subtract(r, divisor);
+  }
+  if (!q.IsZero()) {
+    q.SetSign(a.IsNegative() != b.IsNegative());
+  }
+  if (!r.IsZero()) {
+    r.SetSign(a.IsNegative());
+  }
+  *quotient ^= q.raw();
+  *remainder ^= r.raw();
+}
+
+
+RawBigint* BigintOperations::Reciprocal(const Bigint& divisor,
+                                        intptr_t precision) {
+  ASSERT(!divisor.IsNegative() && !divisor.IsZero());
+  intptr_t divisor_length = divisor.Length();
+  intptr_t quotient_length = precision - divisor_length;
+  ASSERT(quotient_length >= 0);
+  Bigint& power = Bigint::Handle(One());
+  power ^= DigitsShiftLeft(power, precision);
+  if (quotient_length <= kNewtonDivisionCutoff) {
+    Bigint& quotient = Bigint::Handle();
+    Bigint& remainder = Bigint::Handle();
+    SchoolbookDivideRemainder(power, divisor, &quotient, &remainder);
+    return quotient.raw();
+  }
+  // Compute the reciprocal with half the precision from the leading digits
+  // of the divisor, and refine it with one Newton iteration:
+  //   x' = x + x * (B^precision - divisor * x) / B^precision.
+  intptr_t half = quotient_length / 2 + 1;
+  intptr_t dropped = Utils::Maximum<intptr_t>(divisor_length - (half + 2), 0);
+  const Bigint& leading_digits = Bigint::Handle(
+      Digits(divisor, dropped, divisor_length - dropped));
+  Bigint& x = Bigint::Handle(
+      Reciprocal(leading_digits, half + divisor_length - dropped));
+  x ^= DigitsShiftLeft(x, quotient_length - half);
+  Bigint& error = Bigint::Handle(Multiply(divisor, x));
+  error ^= Subtract(power, error);
+  error ^= Multiply(x, error);
+  error ^= ShiftRight(error, precision * kDigitBitSize);
+  return Add(x, error);
+}
+
+
+void BigintOperations::SchoolbookDivideRemainder(
+    const Bigint& a, const Bigint& b, Bigint* quotient, Bigint* remainder) {
   // TODO(floitsch): This function is very memory-intensive since all
   // intermediate bigint results are allocated in new memory. It would be
   // much more efficient to reuse the space of temporary intermediate variables.
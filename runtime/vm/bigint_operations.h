@@ -5,6 +5,7 @@
 
 #include "platform/utils.h"
 
+#include "vm/growable_array.h"
 #include "vm/object.h"
 
 namespace dart {
@@ -110,6 +111,16 @@ class BigintOperations : public AllStatic {
   static const int kChunkSize = sizeof(Chunk);
   static const int kChunkBitSize = kChunkSize * kBitsPerByte;
   static const int kHexCharsPerDigit = kDigitBitSize / 4;
+  // 10^kDecimalChunkDigits is the largest power of ten that fits into a
+  // digit.
+  static const int kDecimalChunkDigits = 8;
+  static const Chunk kDecimalChunkDivisor = 100000000;
+
+  // Below these lengths (in digits) the quadratic algorithms are faster than
+  // the divide-and-conquer ones.
+  static const intptr_t kKaratsubaCutoff = 40;
+  static const intptr_t kNewtonDivisionCutoff = 60;
+  static const intptr_t kDecimalConversionCutoff = 32;
 
   static RawBigint* Zero() { return Bigint::Allocate(0); }
   static RawBigint* One() {
@@ -133,12 +144,58 @@ class BigintOperations : public AllStatic {
   static RawBigint* UnsignedAdd(const Bigint& a, const Bigint& b);
   static RawBigint* UnsignedSubtract(const Bigint& a, const Bigint& b);
 
+  static RawBigint* CombaMultiply(const Bigint& a, const Bigint& b);
+  // Ignores the signs of a and b, and returns a non-negative product.
+  static RawBigint* KaratsubaMultiply(const Bigint& a, const Bigint& b);
   static RawBigint* MultiplyWithDigit(const Bigint& bigint, Chunk digit);
+  // bigint = bigint * digit + addend. The bigint must have room for the
+  // result, which is not clamped.
+  static void MultiplyWithDigitInPlace(const Bigint& bigint,
+                                       Chunk digit,
+                                       Chunk addend);
+  // bigint = bigint / digit. Returns the remainder.
+  static Chunk DivideWithDigitInPlace(const Bigint& bigint, Chunk digit);
   static RawBigint* DigitsShiftLeft(const Bigint& bigint, intptr_t amount) {
     return ShiftLeft(bigint, amount * kDigitBitSize);
   }
   static void DivideRemainder(const Bigint& a, const Bigint& b,
                               Bigint* quotient, Bigint* remainder);
+  static void SchoolbookDivideRemainder(const Bigint& a, const Bigint& b,
+                                        Bigint* quotient, Bigint* remainder);
+  static void NewtonDivideRemainder(const Bigint& a, const Bigint& b,
+                                    Bigint* quotient, Bigint* remainder);
+  // Returns an approximation of B^precision / divisor, where B is
+  // 2^kDigitBitSize. The divisor must be positive and have at most
+  // 'precision' digits.
+  static RawBigint* Reciprocal(const Bigint& divisor, intptr_t precision);
+
+  // Returns the non-negative bigint made of the 'length' digits of 'bigint'
+  // starting at 'start'.
+  static RawBigint* Digits(const Bigint& bigint,
+                           intptr_t start,
+                           intptr_t length);
+  // Adds the non-negative 'value' shifted left by 'digit_shift' digits to
+  // 'result', which must have room for the sum.
+  static void AddShiftedInPlace(const Bigint& result,
+                                const Bigint& value,
+                                intptr_t digit_shift);
+
+  // powers[i] is 10^(kDecimalChunkDigits * 2^i).
+  typedef GrowableArray<const Bigint*> DecimalPowers;
+  // Parses the first 'length' decimal digits of 'str'.
+  static RawBigint* FromDecimalDigits(const char* str,
+                                      intptr_t length,
+                                      const DecimalPowers& powers,
+                                      intptr_t power_index,
+                                      Heap::Space space);
+  // Appends the decimal digits of the absolute value of 'bigint' to 'buffer',
+  // least significant first, padded with zeroes to 'min_digits' digits.
+  // Returns the number of appended digits.
+  static intptr_t AppendDecimalDigits(const Bigint& bigint,
+                                      const DecimalPowers& powers,
+                                      intptr_t power_index,
+                                      intptr_t min_digits,
+                                      char* buffer);
 
   // Removes leading zero-chunks by adjusting the bigint's length.
   static void Clamp(const Bigint& bigint);
@@ -2231,4 +2231,88 @@ TEST_CASE(BigintDivideRemainder) {
       "01234567890ABCDEE");
 }
 
+
+// Returns prefix, followed by count times c, followed by suffix.
+static const char* RepeatChar(const char* prefix,
+                              char c,
+                              intptr_t count,
+                              const char* suffix) {
+  intptr_t prefix_length = strlen(prefix);
+  intptr_t suffix_length = strlen(suffix);
+  char* result = reinterpret_cast<char*>(
+      ZoneAllocator(prefix_length + count + suffix_length + 1));
+  memmove(result, prefix, prefix_length);
+  memset(result + prefix_length, c, count);
+  memmove(result + prefix_length + count, suffix, suffix_length + 1);
+  return result;
+}
+
+
+#if defined(TARGET_ARCH_IA32) || defined(TARGET_ARCH_X64)
+// Operands long enough for Karatsuba multiplication and Newton division.
+TEST_CASE(BigintLongMultiplyDivide) {
+  const intptr_t kHexLengths[] = { 300, 777, 2500 };
+  for (intptr_t i = 0; i < 3; i++) {
+    const intptr_t n = kHexLengths[i];
+    // (16^n - 1)^2 = 16^(2n) - 2 * 16^n + 1.
+    const char* a = RepeatChar("0x", 'F', n, "");
+    const char* high = RepeatChar("0x", 'F', n - 1, "E");
+    const char* square = RepeatChar(high, '0', n - 1, "1");
+    const char* square_plus_six = RepeatChar(high, '0', n - 1, "7");
+    TestBigintMultiplyDivide(a, a, square);
+    TestBigintDivideRemainder(square_plus_six, a, a, "0x6");
+    // A negative Karatsuba operand.
+    const char* minus_a = RepeatChar("-0x", 'F', n, "");
+    const char* minus_square = RepeatChar("-", '0', 0, square);
+    TestBigintMultiplyDivide(minus_a, a, minus_square);
+    TestBigintMultiplyDivide(minus_a, minus_a, square);
+    // A long operand times a shorter one, k = n / 3:
+    // (16^n - 1) * (16^k + 1) = 16^(n+k) + (16^n - 16^k - 1).
+    const intptr_t k = n / 3;
+    const char* b = RepeatChar("0x1", '0', k - 1, "1");
+    const char* product_high = RepeatChar("0x1", '0', k, "");
+    const char* product_middle = RepeatChar(product_high, 'F', n - k - 1, "E");
+    const char* product = RepeatChar(product_middle, 'F', k, "");
+    TestBigintMultiplyDivide(a, b, product);
+    TestBigintDivideRemainder(product, b, a, "0x0");
+  }
+}
+#endif
+
+
+TEST_CASE(BigintLongDecimalStrings) {
+  const intptr_t kDecimalLengths[] = { 300, 1234, 5000 };
+  for (intptr_t i = 0; i < 3; i++) {
+    const intptr_t n = kDecimalLengths[i];
+    const char* power = RepeatChar("1", '0', n, "");
+    const char* nines = RepeatChar("", '9', n, "");
+    const char* minus_nines = RepeatChar("-", '9', n, "");
+    const Bigint& bigint_power = Bigint::Handle(
+        BigintOperations::NewFromCString(power));
+    const Bigint& bigint_nines = Bigint::Handle(
+        BigintOperations::NewFromCString(nines));
+    const Bigint& bigint_minus_nines = Bigint::Handle(
+        BigintOperations::NewFromCString(minus_nines));
+    EXPECT_STREQ(power,
+        BigintOperations::ToDecimalCString(bigint_power, &ZoneAllocator));
+    EXPECT_STREQ(nines,
+        BigintOperations::ToDecimalCString(bigint_nines, &ZoneAllocator));
+    EXPECT_STREQ(minus_nines,
+        BigintOperations::ToDecimalCString(bigint_minus_nines,
+                                           &ZoneAllocator));
+    // 10^n - (10^n - 1) = 1.
+    const Bigint& one = Bigint::Handle(
+        BigintOperations::Add(bigint_power, bigint_minus_nines));
+    EXPECT_STREQ("0x1", BigintOperations::ToHexCString(one, &ZoneAllocator));
+    // 10^n / 10^(n / 2) = 10^(n - n / 2), computed by the division.
+    const char* divisor = RepeatChar("1", '0', n / 2, "");
+    const Bigint& bigint_divisor = Bigint::Handle(
+        BigintOperations::NewFromCString(divisor));
+    const Bigint& quotient = Bigint::Handle(
+        BigintOperations::Divide(bigint_power, bigint_divisor));
+    EXPECT_STREQ(RepeatChar("1", '0', n - n / 2, ""),
+        BigintOperations::ToDecimalCString(quotient, &ZoneAllocator));
+  }
+}
+
 }  // namespace dart
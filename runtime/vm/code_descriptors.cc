@@ -4,6 +4,8 @@
 
 #include "vm/code_descriptors.h"
 
+#include "vm/compiler_stats.h"
+
 namespace dart {
 
 void DescriptorList::AddDescriptor(PcDescriptors::Kind kind,
@@ -37,21 +39,36 @@ RawPcDescriptors* DescriptorList::FinalizePcDescriptors(uword entry_point) {
 }
 
 
+intptr_t StackmapBuilder::FindMap() const {
+  // Consecutive safepoints usually have the same layout, search backwards.
+  Stackmap& map = Stackmap::Handle();
+  for (intptr_t i = NumMaps() - 1; i >= 0; i--) {
+    map = Map(i);
+    if (map.Equals(builder_)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+
 void StackmapBuilder::AddEntry(intptr_t pc_offset) {
-  stack_map_ = Stackmap::New(pc_offset, builder_);
-  list_.Add(stack_map_);
+  intptr_t map_index = FindMap();
+  if (map_index < 0) {
+    stack_map_ = Stackmap::New(builder_);
+    map_index = NumMaps();
+    list_.Add(stack_map_);
+  }
+  pc_offsets_.Add(pc_offset);
+  map_indices_.Add(map_index);
 }
 
 
 bool StackmapBuilder::Verify() {
   intptr_t num_entries = Length();
-  Stackmap& map1 = Stackmap::Handle();
-  Stackmap& map2 = Stackmap::Handle();
   for (intptr_t i = 1; i < num_entries; i++) {
-    map1 = Map(i - 1);
-    map2 = Map(i);
     // Ensure there are no duplicates and the entries are sorted.
-    if (map1.PC() >= map2.PC()) {
+    if (pc_offsets_[i - 1] >= pc_offsets_[i]) {
       return false;
     }
   }
@@ -59,19 +76,45 @@ bool StackmapBuilder::Verify() {
 }
 
 
-RawArray* StackmapBuilder::FinalizeStackmaps(const Code& code) {
+void StackmapBuilder::FinalizeStackmaps(const Code& code) {
   ASSERT(Verify());
   intptr_t num_entries = Length();
-  uword entry_point = code.EntryPoint();
   if (num_entries == 0) {
-    return Array::Empty();
+    code.set_stackmaps(Array::Handle(Array::Empty()));
+    code.set_stackmap_index(Uint32Array::Handle(Uint32Array::New(0,
+                                                                 Heap::kOld)));
+    return;
   }
+  const Uint32Array& index = Uint32Array::Handle(
+      Uint32Array::New(num_entries * Code::kStackmapIndexEntrySize,
+                       Heap::kOld));
   for (intptr_t i = 0; i < num_entries; i++) {
-    stack_map_ = Map(i);
-    stack_map_.SetPC(entry_point + stack_map_.PC());
-    stack_map_.SetCode(code);
+    intptr_t entry = i * Code::kStackmapIndexEntrySize;
+    index.SetAt(entry + Code::kStackmapPcOffsetEntry, pc_offsets_[i]);
+    index.SetAt(entry + Code::kStackmapMapIndexEntry, map_indices_[i]);
+  }
+  const Array& maps = Array::Handle(Array::MakeArray(list_));
+  code.set_stackmaps(maps);
+  code.set_stackmap_index(index);
+  if (FLAG_compiler_stats) {
+    intptr_t maps_size = 0;
+    intptr_t unshared_size = 0;
+    for (intptr_t i = 0; i < NumMaps(); i++) {
+      stack_map_ = Map(i);
+      maps_size += stack_map_.raw()->Size();
+    }
+    for (intptr_t i = 0; i < num_entries; i++) {
+      stack_map_ = Map(map_indices_[i]);
+      unshared_size += stack_map_.raw()->Size();
+    }
+    CompilerStats::num_stackmap_entries += num_entries;
+    CompilerStats::num_stackmaps += NumMaps();
+    CompilerStats::stackmap_size +=
+        maps_size + maps.raw()->Size() + index.raw()->Size();
+    // A stack map object per safepoint, held in an array.
+    CompilerStats::stackmap_unshared_size +=
+        unshared_size + Array::InstanceSize(num_entries);
   }
-  return Array::MakeArray(list_);
 }
 
 
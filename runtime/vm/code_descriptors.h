@@ -63,10 +63,11 @@ class StackmapBuilder : public ZoneAllocated {
  public:
   StackmapBuilder() :
       builder_(new BitmapBuilder()),
-      code_(Code::ZoneHandle()),
       stack_map_(Stackmap::ZoneHandle()),
       list_(GrowableObjectArray::ZoneHandle(
-          GrowableObjectArray::New(Heap::kOld))) { }
+          GrowableObjectArray::New(Heap::kOld))),
+      pc_offsets_(),
+      map_indices_() { }
   ~StackmapBuilder() { }
 
   // Gets state of stack slot (object or regular value).
@@ -95,20 +96,28 @@ class StackmapBuilder : public ZoneAllocated {
     builder_->SetRange(min_stack_slot, max_stack_slot, false);
   }
 
+  // Records the current stack layout for the safepoint at 'pc_offset'.
+  // Safepoints with the same layout share a single stack map.
   void AddEntry(intptr_t pc_offset);
 
   bool Verify();
 
-  RawArray* FinalizeStackmaps(const Code& code);
+  // Sets the distinct stack maps and the stack map index of 'code'.
+  void FinalizeStackmaps(const Code& code);
+
+  // Number of safepoints and of distinct stack maps.
+  intptr_t Length() const { return pc_offsets_.length(); }
+  intptr_t NumMaps() const { return list_.Length(); }
 
  private:
-  intptr_t Length() const { return list_.Length(); }
   RawStackmap* Map(int index) const;
+  intptr_t FindMap() const;
 
   BitmapBuilder* builder_;
-  Code& code_;
   Stackmap& stack_map_;
-  GrowableObjectArray& list_;
+  GrowableObjectArray& list_;  // Distinct stack maps.
+  GrowableArray<intptr_t> pc_offsets_;
+  GrowableArray<intptr_t> map_indices_;  // Index into list_ per safepoint.
   DISALLOW_COPY_AND_ASSIGN(StackmapBuilder);
 };
 
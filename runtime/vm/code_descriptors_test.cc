@@ -74,14 +74,16 @@ CODEGEN_TEST_GENERATE(StackmapCodegen, test) {
     }
     builder->SetSlotAsObject(10);
     builder->AddEntry(3);  // Add a stack map entry at pc offset 3.
+    builder->AddEntry(5);  // Same layout as the entry at pc offset 3.
+    EXPECT_EQ(5, builder->Length());
+    EXPECT_EQ(4, builder->NumMaps());
 
     const Error& error =
         Error::Handle(Compiler::CompileParsedFunction(parsed_function));
     EXPECT(error.IsNull());
     const Code& code = Code::Handle(function.CurrentCode());
 
-    const Array& stack_maps = Array::Handle(builder->FinalizeStackmaps(code));
-    code.set_stackmaps(stack_maps);
+    builder->FinalizeStackmaps(code);
     const Array& stack_map_list = Array::Handle(code.stackmaps());
     EXPECT(!stack_map_list.IsNull());
     Stackmap& stack_map = Stackmap::Handle();
@@ -124,6 +126,21 @@ CODEGEN_TEST_GENERATE(StackmapCodegen, test) {
     EXPECT(stack_map.IsObject(10));
     EXPECT_EQ(0, stack_map.MinimumBitOffset());
     EXPECT_EQ(10, stack_map.MaximumBitOffset());
+
+    // Safepoints are found by PC, a PC between two safepoints uses the
+    // stack map of the preceding one.
+    Uint32Array& index = Uint32Array::Handle();
+    Array& maps = Array::Handle();
+    Stackmap& map = Stackmap::Handle();
+    uword entry = code.EntryPoint();
+    map = code.GetStackmap(entry + 1, &index, &maps, &map);
+    EXPECT(map.raw() == stack_map_list.At(1));
+    map = code.GetStackmap(entry + 3, &index, &maps, &map);
+    EXPECT(map.raw() == stack_map_list.At(3));
+    map = code.GetStackmap(entry + 4, &index, &maps, &map);
+    EXPECT(map.raw() == stack_map_list.At(3));
+    map = code.GetStackmap(entry + 5, &index, &maps, &map);
+    EXPECT(map.raw() == stack_map_list.At(3));
     retval = true;
   } else {
     retval = false;
@@ -201,8 +218,7 @@ TEST_CASE(StackmapGC) {
   builder->SetSlotAsObject(4);  // var s3.
   builder->AddEntry(0);  // Add a stack map entry at pc offset 0.
   const Code& code = Code::Handle(function_foo.unoptimized_code());
-  const Array& stack_maps = Array::Handle(builder->FinalizeStackmaps(code));
-  code.set_stackmaps(stack_maps);
+  builder->FinalizeStackmaps(code);
 
   // Now invoke 'A.moo' and it will trigger a GC when the native function
   // is called, this should then cause the stack map of function 'A.foo'
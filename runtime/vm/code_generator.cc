@@ -9,6 +9,7 @@
 #include "vm/dart_api_impl.h"
 #include "vm/dart_entry.h"
 #include "vm/debugger.h"
+#include "vm/deopt_instructions.h"
 #include "vm/exceptions.h"
 #include "vm/object_store.h"
 #include "vm/message.h"
@@ -27,6 +28,11 @@ DEFINE_FLAG(bool, trace_patching, false, "Trace patching of code.");
 DEFINE_FLAG(bool, trace_runtime_calls, false, "Trace runtime calls.");
 DEFINE_FLAG(int, optimization_counter_threshold, 2000,
     "function's usage-counter value before it is optimized, -1 means never.");
+DEFINE_FLAG(bool, use_osr, false,
+    "Count loop iterations in unoptimized code and continue hot loops in "
+    "optimized code.");
+DEFINE_FLAG(bool, trace_osr, false, "Trace on-stack replacement.");
+DECLARE_FLAG(bool, background_compilation);
 DECLARE_FLAG(bool, enable_type_checks);
 DECLARE_FLAG(bool, trace_type_checks);
 DECLARE_FLAG(bool, report_usage_count);
@@ -141,7 +147,8 @@ DEFINE_RUNTIME_ENTRY(AllocateArray, 2) {
 DEFINE_RUNTIME_ENTRY(AllocateObject, 3) {
   ASSERT(arguments.Count() == kAllocateObjectRuntimeEntry.argument_count());
   const Class& cls = Class::CheckedHandle(arguments.At(0));
-  const Instance& instance = Instance::Handle(Instance::New(cls));
+  const Instance& instance = Instance::Handle(
+      Instance::New(cls, isolate->heap()->SpaceForAllocation(cls.index())));
   arguments.SetReturn(instance);
   if (!cls.HasTypeArguments()) {
     // No type arguments required for a non-parameterized type.
@@ -200,7 +207,8 @@ DEFINE_RUNTIME_ENTRY(AllocateObjectWithBoundsCheck, 4) {
   ASSERT(arguments.Count() ==
          kAllocateObjectWithBoundsCheckRuntimeEntry.argument_count());
   const Class& cls = Class::CheckedHandle(arguments.At(1));
-  const Instance& instance = Instance::Handle(Instance::New(cls));
+  const Instance& instance = Instance::Handle(
+      Instance::New(cls, isolate->heap()->SpaceForAllocation(cls.index())));
   arguments.SetReturn(instance);
   ASSERT(cls.HasTypeArguments());
   AbstractTypeArguments& type_arguments =
@@ -808,17 +816,17 @@ RawCode* ResolveCompileInstanceCallTarget(Isolate* isolate,
   } else {
     receiver_class = receiver.clazz();
   }
-  FunctionsCache functions_cache(receiver_class);
-  Code& code = Code::Handle();
-      code = functions_cache.LookupCode(function_name,
-                                        num_arguments,
-                                        num_named_arguments);
-  if (!code.IsNull()) {
-    // Function's code found in the cache.
-    return code.raw();
+  MegamorphicCacheTable* table = isolate->megamorphic_cache_table();
+  Function& function = Function::Handle();
+  function = table->Lookup(receiver_class,
+                           function_name,
+                           num_arguments,
+                           num_named_arguments);
+  if (!function.IsNull()) {
+    // Function found in the megamorphic cache.
+    return function.CurrentCode();
   }
 
-  Function& function = Function::Handle();
   function = Resolver::ResolveDynamic(receiver,
                                       function_name,
                                       num_arguments,
@@ -832,9 +840,11 @@ RawCode* ResolveCompileInstanceCallTarget(Isolate* isolate,
         Exceptions::PropagateError(error);
       }
     }
-    functions_cache.AddCompiledFunction(function,
-                                        num_arguments,
-                                        num_named_arguments);
+    table->Insert(receiver_class,
+                  function_name,
+                  num_arguments,
+                  num_named_arguments,
+                  function);
     return function.CurrentCode();
   }
 }
@@ -859,6 +869,7 @@ DEFINE_RUNTIME_ENTRY(ResolveCompileInstanceFunction, 1) {
   ASSERT(arguments.Count() ==
          kResolveCompileInstanceFunctionRuntimeEntry.argument_count());
   const Instance& receiver = Instance::CheckedHandle(arguments.At(0));
+  isolate->megamorphic_cache_table()->RecordMiss();
   const Code& code = Code::Handle(
       ResolveCompileInstanceCallTarget(isolate, receiver));
   arguments.SetReturn(Code::Handle(code.raw()));
@@ -1339,7 +1350,13 @@ DEFINE_RUNTIME_ENTRY(OptimizeInvokedFunction, 1) {
     function.set_usage_counter(0);
     return;
   }
-  if (function.is_optimizable()) {
+  if (function.is_optimizable() &&
+      FLAG_background_compilation &&
+      isolate->background_compiler()->Enqueue(function)) {
+    // Keep running unoptimized code until the isolate is idle. A function
+    // that cannot be queued, or waited too long, is compiled below.
+    function.set_usage_counter(0);
+  } else if (function.is_optimizable()) {
     ASSERT(!function.HasOptimizedCode());
     const Code& unoptimized_code = Code::Handle(function.unoptimized_code());
     // Compilation patches the entry of unoptimized code.
@@ -1358,6 +1375,72 @@ DEFINE_RUNTIME_ENTRY(OptimizeInvokedFunction, 1) {
 }
 
 
+// Only unoptimized code counts loop iterations (see FLAG_use_osr). Once the
+// usage counter of the function reaches the threshold in a loop, the loop
+// calls this function. Optimize the function and continue the loop in the
+// optimized code at the entry recorded for the same loop.
+// Since both unoptimized and optimized code have the same frame layout and
+// an empty expression stack at that point, we need only to patch the pc of
+// the Dart frame.
+DEFINE_RUNTIME_ENTRY(OnStackReplacement, 0) {
+  ASSERT(arguments.Count() ==
+         kOnStackReplacementRuntimeEntry.argument_count());
+  DartFrameIterator iterator;
+  StackFrame* caller_frame = iterator.NextFrame();
+  ASSERT(caller_frame != NULL);
+  const Code& unoptimized_code = Code::Handle(caller_frame->LookupDartCode());
+  ASSERT(!unoptimized_code.IsNull() && !unoptimized_code.is_optimized());
+  const Function& function = Function::Handle(unoptimized_code.function());
+  ASSERT(!function.IsNull());
+  if (isolate->debugger()->IsActive() ||
+      !function.is_optimizable() ||
+      (function.deoptimization_counter() >=
+       FLAG_deoptimization_counter_threshold)) {
+    function.set_usage_counter(0);
+    return;
+  }
+  const PcDescriptors& descriptors =
+      PcDescriptors::Handle(unoptimized_code.pc_descriptors());
+  ASSERT(!descriptors.IsNull());
+  // Locate the node id of the loop at the call inside unoptimized code.
+  intptr_t loop_node_id = AstNode::kNoId;
+  for (int i = 0; i < descriptors.Length(); i++) {
+    if (static_cast<uword>(descriptors.PC(i)) == caller_frame->pc()) {
+      loop_node_id = descriptors.NodeId(i);
+      break;
+    }
+  }
+  ASSERT(loop_node_id != AstNode::kNoId);
+  if (!function.HasOptimizedCode()) {
+    // Compilation patches the entry of unoptimized code.
+    const Error& error =
+        Error::Handle(Compiler::CompileOptimizedFunction(function));
+    if (!error.IsNull()) {
+      Exceptions::PropagateError(error);
+    }
+  }
+  const Code& optimized_code = Code::Handle(function.CurrentCode());
+  uword osr_entry_pc = 0;
+  if (optimized_code.is_optimized()) {
+    osr_entry_pc = optimized_code.GetOsrEntryPcAtNodeId(loop_node_id);
+  }
+  if (FLAG_trace_osr) {
+    OS::Print("On-stack replacement at pc 0x%x id %d '%s' -> 0x%x\n",
+        caller_frame->pc(),
+        loop_node_id,
+        function.ToFullyQualifiedCString(),
+        osr_entry_pc);
+  }
+  if (osr_entry_pc == 0) {
+    // Continue in unoptimized code, e.g., the loop is inside a finally block
+    // that is compiled more than once.
+    function.set_usage_counter(0);
+    return;
+  }
+  caller_frame->set_pc(osr_entry_pc);
+}
+
+
 // The caller must be a static call in a Dart frame, or an entry frame.
 // Patch static call to point to 'new_entry_point'.
 DEFINE_RUNTIME_ENTRY(FixCallersTarget, 1) {
@@ -1392,57 +1475,114 @@ DEFINE_RUNTIME_ENTRY(FixCallersTarget, 1) {
 }
 
 
-// The top Dart frame belongs to the optimized method that needs to be
-// deoptimized. The pc of the Dart frame points to the deoptimization point.
-// Find the node id of the deoptimization point and find the continuation
-// pc in the unoptimized code.
-// Since both unoptimized and optimized code have the same layout, we need only
-// to patch the pc of the Dart frame and to disable/enable appropriate code.
-DEFINE_RUNTIME_ENTRY(Deoptimize, 1) {
-  ASSERT(arguments.Count() == kDeoptimizeRuntimeEntry.argument_count());
-  const Smi& deoptimization_reason_id = Smi::CheckedHandle(arguments.At(0));
-  DartFrameIterator iterator;
+// The Deoptimize stub saves the CPU registers below its frame pointer,
+// register number r at index r, followed by the XMM registers.
+#if defined(TARGET_ARCH_ARM)
+static const intptr_t kNumberOfSavedCpuRegisters = kNumberOfCoreRegisters;
+static const intptr_t kNumberOfSavedXmmRegisters = 0;
+#else
+static const intptr_t kNumberOfSavedCpuRegisters = kNumberOfCpuRegisters;
+static const intptr_t kNumberOfSavedXmmRegisters = kNumberOfXmmRegisters;
+#endif
+
+
+// The top Dart frame belongs to the optimized function that needs to be
+// deoptimized, its pc is the return address of the call to the Deoptimize
+// stub at a deoptimization point. Copy the unoptimized frame described by
+// the deoptimization instructions of the point (see DeoptFrameCopy) and
+// return its size in words below the frame pointer, so that the stub can
+// make room for it on the stack.
+// The optimized frame and the saved registers may hold untagged values, so
+// this must not allocate in the Dart heap.
+DEFINE_RUNTIME_ENTRY(DeoptimizeCopyFrame, 0) {
+  ASSERT(arguments.Count() ==
+         kDeoptimizeCopyFrameRuntimeEntry.argument_count());
+  NoGCScope no_gc;
+  StackFrameIterator iterator(StackFrameIterator::kDontValidateFrames);
+  StackFrame* stub_frame = iterator.NextFrame();
+  while ((stub_frame != NULL) && stub_frame->IsExitFrame()) {
+    stub_frame = iterator.NextFrame();
+  }
+  ASSERT((stub_frame != NULL) && stub_frame->IsStubFrame());
   StackFrame* caller_frame = iterator.NextFrame();
-  ASSERT(caller_frame != NULL);
+  ASSERT((caller_frame != NULL) && caller_frame->IsDartFrame());
   const Code& optimized_code = Code::Handle(caller_frame->LookupDartCode());
-  const Function& function = Function::Handle(optimized_code.function());
-  ASSERT(!function.IsNull());
-  const Code& unoptimized_code = Code::Handle(function.unoptimized_code());
   ASSERT(!optimized_code.IsNull() && optimized_code.is_optimized());
-  ASSERT(!unoptimized_code.IsNull() && !unoptimized_code.is_optimized());
-  const PcDescriptors& descriptors =
-      PcDescriptors::Handle(optimized_code.pc_descriptors());
-  ASSERT(!descriptors.IsNull());
-  // Locate node id at deoptimization point inside optimized code.
-  intptr_t deopt_node_id = AstNode::kNoId;
-  intptr_t deopt_token_index = 0;
-  for (int i = 0; i < descriptors.Length(); i++) {
-    if (static_cast<uword>(descriptors.PC(i)) == caller_frame->pc()) {
-      deopt_node_id = descriptors.NodeId(i);
-      deopt_token_index = descriptors.TokenIndex(i);
-      break;
+  const intptr_t deopt_index =
+      optimized_code.GetDeoptIndexAtPc(caller_frame->pc());
+  ASSERT(deopt_index >= 0);
+  const Array& deopt_table =
+      Array::Handle(optimized_code.deopt_info_array());
+  Array& instructions = Array::Handle();
+  instructions ^=
+      deopt_table.At(deopt_index + Code::kDeoptInstructionsEntry);
+  Array& object_table = Array::Handle();
+  object_table ^= deopt_table.At(deopt_index + Code::kDeoptObjectTableEntry);
+  const uword saved_registers =
+      stub_frame->fp() - (kNumberOfSavedCpuRegisters * kWordSize);
+  const intptr_t* cpu_registers =
+      reinterpret_cast<intptr_t*>(saved_registers);
+  const double* xmm_registers = reinterpret_cast<double*>(
+      saved_registers - (kNumberOfSavedXmmRegisters * sizeof(double)));
+  ASSERT(isolate->deopt_frame_copy() == NULL);
+  DeoptFrameCopy* copy = new DeoptFrameCopy(instructions,
+                                            object_table,
+                                            caller_frame->fp(),
+                                            caller_frame->sp(),
+                                            cpu_registers,
+                                            xmm_registers);
+  isolate->set_deopt_frame_copy(copy);
+  if (FLAG_trace_deopt) {
+    Smi& reason = Smi::Handle();
+    reason ^= deopt_table.At(deopt_index + Code::kDeoptReasonEntry);
+    OS::Print("Deoptimizing (reason %d) at pc 0x%x id %d: "
+              "unoptimized frame of %d words\n",
+              reason.Value(),
+              caller_frame->pc(),
+              copy->node_id(),
+              copy->size());
+  }
+  arguments.SetReturn(Smi::Handle(Smi::New(copy->size())));
+}
+
+
+// The Deoptimize stub has replaced the optimized frame with room for the
+// unoptimized frame copied by DeoptimizeCopyFrame, and called this from a
+// new stub frame. Return from the stub into the unoptimized frame, fill the
+// frame, and reenable the unoptimized code of the function.
+DEFINE_RUNTIME_ENTRY(DeoptimizeFillFrame, 0) {
+  ASSERT(arguments.Count() ==
+         kDeoptimizeFillFrameRuntimeEntry.argument_count());
+  DeoptFrameCopy* copy = isolate->deopt_frame_copy();
+  ASSERT(copy != NULL);
+  isolate->set_deopt_frame_copy(NULL);
+  const Function& function = Function::Handle(copy->function());
+  ASSERT(!function.IsNull());
+  uword fp = 0;
+  {
+    NoGCScope no_gc;
+    StackFrameIterator iterator(StackFrameIterator::kDontValidateFrames);
+    StackFrame* stub_frame = iterator.NextFrame();
+    while ((stub_frame != NULL) && stub_frame->IsExitFrame()) {
+      stub_frame = iterator.NextFrame();
     }
+    ASSERT((stub_frame != NULL) && stub_frame->IsStubFrame());
+    // The stub frame links to the frame pointer of the optimized frame,
+    // which is kept by the unoptimized frame, and its return address is a
+    // placeholder.
+    uword* saved_fp = reinterpret_cast<uword*>(stub_frame->fp());
+    uword* return_address = saved_fp + 1;
+    fp = *saved_fp;
+    *return_address = copy->continue_pc();
   }
-  ASSERT(deopt_node_id != AstNode::kNoId);
-  uword continue_at_pc =
-      unoptimized_code.GetDeoptPcAtNodeId(deopt_node_id);
-  ASSERT(continue_at_pc != 0);
+  copy->Fill(fp);
   if (FLAG_trace_deopt) {
-    OS::Print("Deoptimizing (reason %d) at pc 0x%x id %d '%s' "
-        "-> continue at 0x%x \n",
-        deoptimization_reason_id.Value(),
-        caller_frame->pc(),
-        deopt_node_id,
-        function.ToFullyQualifiedCString(),
-        continue_at_pc);
-    const Class& cls = Class::Handle(function.owner());
-    const Script& script = Script::Handle(cls.script());
-    intptr_t line, column;
-    script.GetTokenLocation(deopt_token_index, &line, &column);
-    OS::Print("  Line: %d Column: %d ", line, column);
-    OS::Print(">>  %s\n", String::Handle(script.GetLine(line)).ToCString());
+    OS::Print("  '%s' -> continue at 0x%x\n",
+              function.ToFullyQualifiedCString(),
+              copy->continue_pc());
   }
-  caller_frame->set_pc(continue_at_pc);
+  delete copy;
+
   // Clear invocation counter so that the function gets optimized after
   // types/classes have been collected.
   function.set_usage_counter(0);
@@ -1459,98 +1599,6 @@ DEFINE_RUNTIME_ENTRY(Deoptimize, 1) {
       Exceptions::PropagateError(error);
     }
   }
-  // TODO(srdjan): Handle better complex cases, e.g. when an older optimized
-  // code is alive on frame and gets deoptimized after the function was
-  // optimized a second time.
-  if (FLAG_trace_deopt) {
-    OS::Print("After patching ->0x%x:\n", continue_at_pc);
-  }
-}
-
-
-// We are entering function name for a valid argument count.
-void FunctionsCache::EnterFunctionAt(int i,
-                                     const Array& cache,
-                                     const Function& function,
-                                     int num_arguments,
-                                     int num_named_arguments) {
-  ASSERT((i % kNumEntries) == 0);
-  ASSERT(function.AreValidArgumentCounts(num_arguments, num_named_arguments));
-  cache.SetAt(i + FunctionsCache::kFunctionName,
-      String::Handle(function.name()));
-  cache.SetAt(i + FunctionsCache::kArgCount,
-      Smi::Handle(Smi::New(num_arguments)));
-  cache.SetAt(i + FunctionsCache::kNamedArgCount,
-      Smi::Handle(Smi::New(num_named_arguments)));
-  cache.SetAt(i + FunctionsCache::kFunction, function);
-}
-
-
-void FunctionsCache::AddCompiledFunction(const Function& function,
-                                         int num_arguments,
-                                         int num_named_arguments) {
-// TODO(srdjan): Evaluate if populating the function cache is needed.
-// It is turned off currently because we do not populate code objects
-// in snapshot and hence end up in an inconsistent state as function
-// cache is populated but there are no code objects.
-#if 0
-  ASSERT(function.HasCode());
-  Array& cache = Array::Handle(class_.functions_cache());
-  // Search for first free slot. Last entry is always NULL object.
-  for (intptr_t i = 0; i < (cache.Length() - kNumEntries); i += kNumEntries) {
-    if (Object::Handle(cache.At(i)).IsNull()) {
-      EnterFunctionAt(i,
-                      cache,
-                      function,
-                      num_arguments,
-                      num_named_arguments);
-      return;
-    }
-  }
-  intptr_t ix = cache.Length() - kNumEntries;
-  // Grow by 8 entries.
-  cache = Array::Grow(cache, cache.Length() + (8 * kNumEntries));
-  class_.set_functions_cache(cache);
-  EnterFunctionAt(ix,
-                  cache,
-                  function,
-                  num_arguments,
-                  num_named_arguments);
-#endif
-}
-
-
-// Only the number of named arguments is checked, but not the actual names.
-RawCode* FunctionsCache::LookupCode(const String& function_name,
-                                    int num_arguments,
-                                    int num_named_arguments) {
-  const Array& cache = Array::Handle(class_.functions_cache());
-  String& test_name = String::Handle();
-  for (intptr_t i = 0; i < cache.Length(); i += kNumEntries) {
-    test_name ^= cache.At(i + FunctionsCache::kFunctionName);
-    if (test_name.IsNull()) {
-      // Found NULL, no more entries to check, abort lookup.
-      return Code::null();
-    }
-    if (function_name.Equals(test_name)) {
-      Smi& smi = Smi::Handle();
-      smi ^= cache.At(i + FunctionsCache::kArgCount);
-      if (num_arguments == smi.Value()) {
-        smi ^= cache.At(i + FunctionsCache::kNamedArgCount);
-        if (num_named_arguments == smi.Value()) {
-          Function& result = Function::Handle();
-          result ^= cache.At(i + FunctionsCache::kFunction);
-          ASSERT(!result.IsNull());
-          ASSERT(result.HasCode());
-          return result.CurrentCode();
-        }
-      }
-    }
-  }
-  // The cache is null terminated, therefore the loop above should never
-  // terminate by itself.
-  UNREACHABLE();
-  return Code::null();
 }
 
 }  // namespace dart
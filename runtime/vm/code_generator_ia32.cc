@@ -29,6 +29,7 @@ DEFINE_FLAG(bool, trace_functions, false, "Trace entry of each function.");
 DEFINE_FLAG(bool, print_ic_in_optimized, false,
     "Debugging helper to identify potential performance pitfalls.");
 DECLARE_FLAG(int, optimization_counter_threshold);
+DECLARE_FLAG(bool, use_osr);
 DECLARE_FLAG(bool, enable_type_checks);
 DECLARE_FLAG(bool, trace_compiler);
 DECLARE_FLAG(bool, intrinsify);
@@ -245,9 +246,8 @@ void CodeGenerator::FinalizeStackmaps(const Code& code) {
     // The unoptimizing compiler has no stack maps.
     code.set_stackmaps(Array::Handle());
   } else {
-    // Finalize the stack map array and add it to the code object.
-    code.set_stackmaps(
-        Array::Handle(stackmap_builder_->FinalizeStackmaps(code)));
+    // Finalize the stack maps and add them to the code object.
+    stackmap_builder_->FinalizeStackmaps(code);
   }
 }
 
@@ -956,10 +956,12 @@ void CodeGenerator::VisitArrayNode(ArrayNode* node) {
                &StubCode::AllocateArrayLabel(),
                PcDescriptors::kOther);
 
-  // Pop the element values from the stack into the array.
-  __ leal(ECX, FieldAddress(EAX, Array::data_offset()));
+  // Pop the element values from the stack into the array. The array may have
+  // been allocated in old space, hence the stores need a write barrier.
   for (int i = node->length() - 1; i >= 0; i--) {
-    __ popl(Address(ECX, i * kWordSize));
+    __ popl(ECX);
+    __ StoreIntoObject(
+        EAX, FieldAddress(EAX, Array::data_offset() + i * kWordSize), ECX);
   }
 
   if (IsResultNeeded(node)) {
@@ -2005,6 +2007,27 @@ void CodeGenerator::HandleBackwardBranch(
                       token_index,
                       kStackOverflowRuntimeEntry);
   __ Bind(&no_stack_overflow);
+  if (!FLAG_use_osr) return;
+  if (IsOptimizing()) {
+    // Unoptimized code of the loop continues here after on-stack
+    // replacement. The expression stack is empty between statements.
+    AddCurrentDescriptor(PcDescriptors::kOsrEntry, loop_id, token_index);
+  } else if (CodeGenerator::CanOptimize()) {
+    // Count loop iterations in the usage counter of the function.
+    const Function& function =
+          Function::ZoneHandle(parsed_function_.function().raw());
+    __ LoadObject(EBX, function);
+    __ incl(FieldAddress(EBX, Function::usage_counter_offset()));
+    __ cmpl(FieldAddress(EBX, Function::usage_counter_offset()),
+        Immediate(FLAG_optimization_counter_threshold));
+    Label not_yet_hot;
+    __ j(LESS_EQUAL, &not_yet_hot, Assembler::kNearJump);
+    // May return to the optimized code of the function instead.
+    GenerateCallRuntime(loop_id,
+                        token_index,
+                        kOnStackReplacementRuntimeEntry);
+    __ Bind(&not_yet_hot);
+  }
 }
 
 
@@ -0,0 +1,69 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/code_index_table.h"
+
+#include "vm/object.h"
+
+namespace dart {
+
+CodeIndexTable::CodeIndexTable()
+    : entries_(NULL),
+      length_(0),
+      capacity_(kInitialCapacity) {
+  entries_ = reinterpret_cast<Entry*>(malloc(capacity_ * sizeof(Entry)));
+}
+
+
+CodeIndexTable::~CodeIndexTable() {
+  free(entries_);
+}
+
+
+intptr_t CodeIndexTable::FindIndex(uword pc) const {
+  intptr_t low = 0;
+  intptr_t high = length_ - 1;
+  while (low <= high) {
+    intptr_t mid = low + ((high - low) / 2);
+    if (entries_[mid].start <= pc) {
+      low = mid + 1;
+    } else {
+      high = mid - 1;
+    }
+  }
+  return high;
+}
+
+
+void CodeIndexTable::AddInstructions(const Instructions& instructions) {
+  ASSERT(!instructions.IsNull());
+  if (length_ == capacity_) {
+    capacity_ = capacity_ * 2;
+    entries_ = reinterpret_cast<Entry*>(
+        realloc(entries_, capacity_ * sizeof(Entry)));
+  }
+  uword start = instructions.EntryPoint();
+  // Instructions are mostly allocated at increasing addresses, in which case
+  // the new entry is appended without moving any of the existing ones.
+  intptr_t index = FindIndex(start) + 1;
+  ASSERT((index == 0) || (entries_[index - 1].end <= start));
+  memmove(&entries_[index + 1],
+          &entries_[index],
+          (length_ - index) * sizeof(Entry));
+  entries_[index].start = start;
+  entries_[index].end = start + instructions.size();
+  entries_[index].instructions = instructions.raw();
+  length_++;
+}
+
+
+RawInstructions* CodeIndexTable::LookupInstructions(uword pc) const {
+  intptr_t index = FindIndex(pc);
+  if ((index >= 0) && (pc < entries_[index].end)) {
+    return entries_[index].instructions;
+  }
+  return Instructions::null();
+}
+
+}  // namespace dart
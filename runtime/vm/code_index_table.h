@@ -0,0 +1,58 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef VM_CODE_INDEX_TABLE_H_
+#define VM_CODE_INDEX_TABLE_H_
+
+#include "platform/assert.h"
+#include "vm/globals.h"
+
+namespace dart {
+
+class Instructions;
+class RawInstructions;
+
+// The CodeIndexTable maps a pc to the instructions object in the code space
+// of an isolate which contains it. The ranges of all instructions objects are
+// kept sorted by address so that a lookup is a binary search instead of a
+// walk over the code heap.
+//
+// Instructions are registered when they are allocated. They are never moved
+// and, as they are premarked, never freed by a collection of the code space,
+// hence the table does not need to be updated by the garbage collector.
+class CodeIndexTable {
+ public:
+  CodeIndexTable();
+  ~CodeIndexTable();
+
+  void AddInstructions(const Instructions& instructions);
+
+  // Returns the instructions containing 'pc' or Instructions::null().
+  // Does not allocate, it is safe to call while a GC is in progress.
+  RawInstructions* LookupInstructions(uword pc) const;
+
+  intptr_t Length() const { return length_; }
+
+ private:
+  static const intptr_t kInitialCapacity = 256;
+
+  struct Entry {
+    uword start;  // First pc of the instructions.
+    uword end;  // First pc after the instructions.
+    RawInstructions* instructions;
+  };
+
+  // Index of the last entry starting at or before 'pc', -1 if there is none.
+  intptr_t FindIndex(uword pc) const;
+
+  Entry* entries_;
+  intptr_t length_;
+  intptr_t capacity_;
+
+  DISALLOW_COPY_AND_ASSIGN(CodeIndexTable);
+};
+
+}  // namespace dart
+
+#endif  // VM_CODE_INDEX_TABLE_H_
@@ -0,0 +1,48 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "platform/assert.h"
+#include "vm/assembler.h"
+#include "vm/code_index_table.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+// Assembler only implemented on IA32 and x64 now.
+#if defined(TARGET_ARCH_IA32) || defined(TARGET_ARCH_X64)
+
+TEST_CASE(CodeIndexTable) {
+  CodeIndexTable* table = Isolate::Current()->code_index_table();
+  intptr_t length = table->Length();
+  const intptr_t kNumCodes = 100;
+  const Array& all = Array::Handle(Array::New(kNumCodes));
+  const Function& function = Function::Handle();
+  Code& code = Code::Handle();
+  for (intptr_t i = 0; i < kNumCodes; i++) {
+    Assembler assembler;
+    for (intptr_t j = 0; j < (16 + i); j++) {
+      assembler.int3();
+    }
+    code = Code::FinalizeCode(function, &assembler);
+    all.SetAt(i, code);
+  }
+  EXPECT_EQ(length + kNumCodes, table->Length());
+  for (intptr_t i = 0; i < kNumCodes; i++) {
+    code ^= all.At(i);
+    uword start = code.EntryPoint();
+    uword end = start + code.Size();
+    EXPECT(table->LookupInstructions(start) == code.instructions());
+    EXPECT(table->LookupInstructions(start + 8) == code.instructions());
+    EXPECT(table->LookupInstructions(end - 1) == code.instructions());
+    EXPECT(table->LookupInstructions(end) != code.instructions());
+  }
+  EXPECT(table->LookupInstructions(0) == Instructions::null());
+  uword stack_pc = reinterpret_cast<uword>(&length);
+  EXPECT(table->LookupInstructions(stack_pc) == Instructions::null());
+}
+
+#endif  // TARGET_ARCH_IA32 || TARGET_ARCH_X64
+
+}  // namespace dart
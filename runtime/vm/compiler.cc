@@ -83,8 +83,7 @@ static void ExtractTypeFeedback(const Code& code,
 }
 
 
-// Returns an array indexed by computation id, containing the extracted ICData.
-static RawArray* ExtractTypeFeedbackArray(const Code& code) {
+RawArray* Compiler::ExtractTypeFeedbackArray(const Code& code) {
   ASSERT(!code.IsNull() && !code.is_optimized());
   GrowableArray<intptr_t> computation_ids;
   const GrowableObjectArray& ic_data_objs =
@@ -93,8 +92,9 @@ static RawArray* ExtractTypeFeedbackArray(const Code& code) {
       code.ExtractIcDataArraysAtCalls(&computation_ids, ic_data_objs);
   const Array& result = Array::Handle(Array::New(max_id + 1));
   for (intptr_t i = 0; i < computation_ids.length(); i++) {
-    ASSERT(result.At(i) == Object::null());
-    result.SetAt(i, Object::Handle(ic_data_objs.At(i)));
+    const intptr_t cid = computation_ids[i];
+    ASSERT(result.At(cid) == Object::null());
+    result.SetAt(cid, Object::Handle(ic_data_objs.At(i)));
   }
   return result.raw();
 }
@@ -158,6 +158,7 @@ static bool CompileWithNewCompiler(
   isolate->set_long_jump_base(&bailout_jump);
   if (setjmp(*bailout_jump.Set()) == 0) {
     GrowableArray<BlockEntryInstr*> block_order;
+    intptr_t inlined_local_count = 0;
     // TimerScope needs an isolate to be properly terminated in case of a
     // LongJump.
     {
@@ -178,11 +179,12 @@ static bool CompileWithNewCompiler(
           const Code& unoptimized_code =
               Code::Handle(parsed_function.function().unoptimized_code());
           isolate->set_ic_data_array(
-              ExtractTypeFeedbackArray(unoptimized_code));
+              Compiler::ExtractTypeFeedbackArray(unoptimized_code));
         }
       }
       FlowGraphBuilder graph_builder(parsed_function);
       graph_builder.BuildGraph(optimized);
+      inlined_local_count = graph_builder.inlined_local_count();
 
       // The non-optimizing compiler compiles blocks in reverse postorder,
       // because it is a 'natural' order for the human reader of the
@@ -196,6 +198,7 @@ static bool CompileWithNewCompiler(
     Assembler assembler;
     FlowGraphCompiler graph_compiler(&assembler, parsed_function,
                                      block_order, optimized);
+    graph_compiler.set_inlined_local_count(inlined_local_count);
     {
       TimerScope timer(FLAG_compiler_stats,
                        &CompilerStats::graphcompiler_timer,
@@ -276,6 +279,7 @@ static void CompileWithOldCompiler(
       code_gen.FinalizePcDescriptors(code);
       code_gen.FinalizeStackmaps(code);
       code_gen.FinalizeExceptionHandlers(code);
+      code_gen.FinalizeDeoptInfo(code);
       function.SetCode(code);
       CodePatcher::PatchEntry(Code::Handle(function.unoptimized_code()));
     }
@@ -13,9 +13,11 @@ namespace dart {
 
 // Forward declarations.
 class Class;
+class Code;
 class Function;
 class Library;
 class ParsedFunction;
+class RawArray;
 class RawInstance;
 class Script;
 class SequenceNode;
@@ -54,6 +56,10 @@ class Compiler : public AllStatic {
   // on compilation failure.
   static RawObject* ExecuteOnce(SequenceNode* fragment);
 
+  // Returns an array indexed by computation id, containing the ICData of
+  // the instance calls in the unoptimized code.
+  static RawArray* ExtractTypeFeedbackArray(const Code& code);
+
   // Eagerly compiles all functions in a class.
   //
   // Returns Error::null() if there is no compilation error.
@@ -40,11 +40,28 @@ Timer CompilerStats::codefinalizer_timer(true, "code finalization timer");
 intptr_t CompilerStats::num_tokens_total = 0;
 intptr_t CompilerStats::num_literal_tokens_total = 0;
 intptr_t CompilerStats::num_ident_tokens_total = 0;
+intptr_t CompilerStats::num_token_literals_total = 0;
+intptr_t CompilerStats::token_stream_size = 0;
+intptr_t CompilerStats::token_stream_unpacked_size = 0;
 intptr_t CompilerStats::num_tokens_consumed = 0;
 intptr_t CompilerStats::num_token_checks = 0;
 intptr_t CompilerStats::num_tokens_rewind = 0;
 intptr_t CompilerStats::num_tokens_lookahead = 0;
 
+intptr_t CompilerStats::num_stackmap_entries = 0;
+intptr_t CompilerStats::num_stackmaps = 0;
+intptr_t CompilerStats::stackmap_size = 0;
+intptr_t CompilerStats::stackmap_unshared_size = 0;
+intptr_t CompilerStats::num_stackmap_lookups = 0;
+intptr_t CompilerStats::num_stackmap_probes = 0;
+intptr_t CompilerStats::num_stackmap_linear_probes = 0;
+intptr_t CompilerStats::num_inlined_calls = 0;
+intptr_t CompilerStats::num_rejected_inlining_calls = 0;
+intptr_t CompilerStats::num_propagated_constants = 0;
+intptr_t CompilerStats::num_propagated_copies = 0;
+intptr_t CompilerStats::num_eliminated_subexpressions = 0;
+intptr_t CompilerStats::num_eliminated_dead_instructions = 0;
+
 void CompilerStats::Print() {
   if (!FLAG_compiler_stats) {
     return;
@@ -53,6 +70,9 @@ void CompilerStats::Print() {
   OS::Print("Number of tokens:   %ld\n", num_tokens_total);
   OS::Print("  Literal tokens:   %ld\n", num_literal_tokens_total);
   OS::Print("  Ident tokens:     %ld\n", num_ident_tokens_total);
+  OS::Print("  Literal pool:     %ld\n", num_token_literals_total);
+  OS::Print("Token stream size:  %ld KB  (%ld KB with a word per token)\n",
+            token_stream_size / KB, token_stream_unpacked_size / KB);
   OS::Print("Tokens consumed:    %ld  (%.2f times number of tokens)\n",
             num_tokens_consumed,
             (1.0 * num_tokens_consumed) / num_tokens_total);
@@ -85,6 +105,29 @@ void CompilerStats::Print() {
             code_allocated / 1024);
   OS::Print("Code density:       %ld tokens per KB\n",
             num_tokens_total * 1024 / code_allocated);
+  if (num_stackmap_entries > 0) {
+    OS::Print("Stack maps:         %ld safepoints, %ld distinct maps\n",
+              num_stackmap_entries, num_stackmaps);
+    OS::Print("  Stack map size:   %ld bytes (%ld bytes unshared)\n",
+              stackmap_size, stackmap_unshared_size);
+  }
+  if (num_stackmap_lookups > 0) {
+    OS::Print("Stack map lookups:  %ld  (%.2f probes, %.2f linear probes)\n",
+              num_stackmap_lookups,
+              (1.0 * num_stackmap_probes) / num_stackmap_lookups,
+              (1.0 * num_stackmap_linear_probes) / num_stackmap_lookups);
+  }
+  if ((num_inlined_calls + num_rejected_inlining_calls) > 0) {
+    OS::Print("Inlined calls:      %ld  (%ld not inlined)\n",
+              num_inlined_calls, num_rejected_inlining_calls);
+  }
+  if ((num_propagated_constants + num_propagated_copies +
+       num_eliminated_subexpressions + num_eliminated_dead_instructions) > 0) {
+    OS::Print("SSA optimizations:  %ld constants, %ld copies, "
+              "%ld subexpressions, %ld dead instructions\n",
+              num_propagated_constants, num_propagated_copies,
+              num_eliminated_subexpressions, num_eliminated_dead_instructions);
+  }
 }
 
 }  // namespace dart
@@ -21,11 +21,30 @@ class CompilerStats : AllStatic {
   static intptr_t num_tokens_total;
   static intptr_t num_literal_tokens_total;
   static intptr_t num_ident_tokens_total;
+  static intptr_t num_token_literals_total;     // Distinct literals.
+  static intptr_t token_stream_size;            // Bytes of token streams.
+  static intptr_t token_stream_unpacked_size;   // Bytes with a word per token.
   static intptr_t num_tokens_consumed;
   static intptr_t num_token_checks;
   static intptr_t num_tokens_rewind;
   static intptr_t num_tokens_lookahead;
 
+  static intptr_t num_stackmap_entries;      // Safepoints with a stack map.
+  static intptr_t num_stackmaps;             // Distinct stack maps.
+  static intptr_t stackmap_size;             // Bytes of stack maps and index.
+  static intptr_t stackmap_unshared_size;    // Bytes with a map per safepoint.
+  static intptr_t num_stackmap_lookups;
+  static intptr_t num_stackmap_probes;         // Binary search probes.
+  static intptr_t num_stackmap_linear_probes;  // Probes of a linear scan.
+
+  static intptr_t num_inlined_calls;            // Calls replaced by callee.
+  static intptr_t num_rejected_inlining_calls;  // Calls not inlined.
+
+  static intptr_t num_propagated_constants;  // Inputs and values folded.
+  static intptr_t num_propagated_copies;     // Loads of a copy redirected.
+  static intptr_t num_eliminated_subexpressions;
+  static intptr_t num_eliminated_dead_instructions;
+
   static intptr_t src_length;        // Total number of characters in source.
   static intptr_t code_allocated;    // Bytes allocated for generated code.
   static Timer parser_timer;         // Cumulative runtime of parser.
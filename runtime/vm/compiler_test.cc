@@ -5,11 +5,20 @@
 #include "platform/assert.h"
 #include "vm/class_finalizer.h"
 #include "vm/compiler.h"
+#include "vm/compiler_stats.h"
+#include "vm/dart_entry.h"
+#include "vm/flags.h"
 #include "vm/object.h"
 #include "vm/unit_test.h"
 
 namespace dart {
 
+DECLARE_FLAG(int, optimization_counter_threshold);
+DECLARE_FLAG(bool, use_inlining);
+DECLARE_FLAG(bool, use_linear_scan);
+DECLARE_FLAG(bool, use_osr);
+DECLARE_FLAG(bool, use_ssa);
+
 // Compiler only implemented on IA32 and X64 now.
 #if defined(TARGET_ARCH_IA32) || defined(TARGET_ARCH_X64)
 
@@ -60,6 +69,302 @@ TEST_CASE(CompileFunction) {
   EXPECT(function_moo.HasCode());
 }
 
+
+TEST_CASE(CompileFunctionOnStackReplacement) {
+  const char* kScriptChars =
+      "class A {\n"
+      "  static foo(n) {\n"
+      "    var sum = 0;\n"
+      "    for (var i = 0; i < n; i++) { sum += i; }\n"
+      "    return sum;\n"
+      "  }\n"
+      "}\n";
+  String& url =
+      String::Handle(String::New("dart-test:OnStackReplacement"));
+  String& source = String::Handle(String::New(kScriptChars));
+  Script& script = Script::Handle(Script::New(url, source, RawScript::kSource));
+  Library& lib = Library::Handle(Library::CoreLibrary());
+  EXPECT(CompilerTest::TestCompileScript(lib, script));
+  EXPECT(ClassFinalizer::FinalizePendingClasses());
+  Class& cls = Class::Handle(
+      lib.LookupClass(String::Handle(String::NewSymbol("A"))));
+  EXPECT(!cls.IsNull());
+  String& name = String::Handle(String::New("foo"));
+  Function& function = Function::Handle(cls.LookupStaticFunction(name));
+  EXPECT(!function.IsNull());
+
+  // The flags are read when generating code.
+  const bool saved_use_osr = FLAG_use_osr;
+  const intptr_t saved_threshold = FLAG_optimization_counter_threshold;
+  FLAG_use_osr = true;
+  FLAG_optimization_counter_threshold = 100;
+  EXPECT(CompilerTest::TestCompileFunction(function));
+  EXPECT(!function.HasOptimizedCode());
+
+  // The single invocation is optimized in the middle of the loop.
+  GrowableArray<const Object*> arguments;
+  const Smi& n = Smi::Handle(Smi::New(1000));
+  arguments.Add(&n);
+  const Array& kNoArgumentNames = Array::Handle();
+  Smi& retval = Smi::Handle();
+  retval ^= DartEntry::InvokeStatic(function, arguments, kNoArgumentNames);
+  FLAG_use_osr = saved_use_osr;
+  FLAG_optimization_counter_threshold = saved_threshold;
+  EXPECT_EQ(Smi::New(499500), retval.raw());
+  EXPECT(function.HasOptimizedCode());
+}
+
+
+// Runs 'A.name(x, y)' in unoptimized code, to collect type feedback, then
+// in optimized code.  Both must return the same result.
+static RawObject* InvokeOptimizedTwice(const Class& cls,
+                                       const char* name,
+                                       const Object& x,
+                                       const Object& y) {
+  const Function& function = Function::Handle(
+      cls.LookupStaticFunction(String::Handle(String::New(name))));
+  EXPECT(!function.IsNull());
+  EXPECT(CompilerTest::TestCompileFunction(function));
+  GrowableArray<const Object*> arguments;
+  arguments.Add(&x);
+  arguments.Add(&y);
+  const Array& kNoArgumentNames = Array::Handle();
+  Instance& unoptimized_result = Instance::Handle();
+  unoptimized_result ^=
+      DartEntry::InvokeStatic(function, arguments, kNoArgumentNames);
+  const Error& error =
+      Error::Handle(Compiler::CompileOptimizedFunction(function));
+  EXPECT(error.IsNull());
+  EXPECT(function.HasOptimizedCode());
+  Instance& result = Instance::Handle();
+  result ^= DartEntry::InvokeStatic(function, arguments, kNoArgumentNames);
+  EXPECT(result.Equals(unoptimized_result));
+  return result.raw();
+}
+
+
+TEST_CASE(CompileOptimizedFunctionNumbers) {
+  const char* kScriptChars =
+      "class A {\n"
+      "  static dbl(x, y) {\n"
+      "    var r = (x * y + x) * (y - 0.5) / 2.0;\n"
+      "    return (x < y * 2.0) ? r + 1.0 : r;\n"
+      "  }\n"
+      "  static mint(x, y) { return (x + y) ^ (x - y); }\n"
+      "}\n";
+  String& url = String::Handle(String::New("dart-test:Numbers"));
+  String& source = String::Handle(String::New(kScriptChars));
+  Script& script = Script::Handle(Script::New(url, source, RawScript::kSource));
+  Library& lib = Library::Handle(Library::CoreLibrary());
+  EXPECT(CompilerTest::TestCompileScript(lib, script));
+  EXPECT(ClassFinalizer::FinalizePendingClasses());
+  Class& cls = Class::Handle(
+      lib.LookupClass(String::Handle(String::NewSymbol("A"))));
+  EXPECT(!cls.IsNull());
+
+  Double& dbl = Double::Handle();
+  dbl ^= InvokeOptimizedTwice(cls,
+                              "dbl",
+                              Double::Handle(Double::New(1.5)),
+                              Double::Handle(Double::New(2.0)));
+  EXPECT_EQ(4.375, dbl.value());
+
+  // A Mint on ia32.
+  const Integer& x = Integer::Handle(Integer::New(DART_INT64_C(0x100000000)));
+  Integer& mint = Integer::Handle();
+  mint ^= InvokeOptimizedTwice(cls, "mint", x, Smi::Handle(Smi::New(5)));
+  EXPECT_EQ(DART_INT64_C(0x1FFFFFFFE), mint.AsInt64Value());
+}
+
+
+// The SSA optimizations only run in the optimizing compiler on x64.
+#if defined(TARGET_ARCH_X64)
+TEST_CASE(CompileOptimizedFunctionSSA) {
+  // a and b are copies of x whose stores become dead, d and e compare the
+  // same values and k === 1 is constant.
+  const char* kScriptChars =
+      "class A {\n"
+      "  static foo(x) {\n"
+      "    var a = x;\n"
+      "    var b = a;\n"
+      "    var c = 0;\n"
+      "    for (var i = 0; i < 3; i = i + 1) { c = c + b; }\n"
+      "    var d = b === x;\n"
+      "    var e = a === x;\n"
+      "    var k = 1;\n"
+      "    if (k === 1) return (d === e) ? c : 0;\n"
+      "    return 0;\n"
+      "  }\n"
+      "}\n";
+  String& url =
+      String::Handle(String::New("dart-test:CompileOptimizedFunctionSSA"));
+  String& source = String::Handle(String::New(kScriptChars));
+  Script& script = Script::Handle(Script::New(url, source, RawScript::kSource));
+  Library& lib = Library::Handle(Library::CoreLibrary());
+  EXPECT(CompilerTest::TestCompileScript(lib, script));
+  EXPECT(ClassFinalizer::FinalizePendingClasses());
+  Class& cls = Class::Handle(
+      lib.LookupClass(String::Handle(String::NewSymbol("A"))));
+  EXPECT(!cls.IsNull());
+  String& name = String::Handle(String::New("foo"));
+  Function& function = Function::Handle(cls.LookupStaticFunction(name));
+  EXPECT(!function.IsNull());
+  EXPECT(CompilerTest::TestCompileFunction(function));
+
+  const bool saved_use_ssa = FLAG_use_ssa;
+  const bool saved_compiler_stats = FLAG_compiler_stats;
+  FLAG_use_ssa = true;
+  FLAG_compiler_stats = true;
+  const intptr_t constants_before = CompilerStats::num_propagated_constants;
+  const intptr_t copies_before = CompilerStats::num_propagated_copies;
+  const intptr_t subexpressions_before =
+      CompilerStats::num_eliminated_subexpressions;
+  const intptr_t dead_before = CompilerStats::num_eliminated_dead_instructions;
+  const Error& error =
+      Error::Handle(Compiler::CompileOptimizedFunction(function));
+  FLAG_use_ssa = saved_use_ssa;
+  FLAG_compiler_stats = saved_compiler_stats;
+  EXPECT(error.IsNull());
+  EXPECT(function.HasOptimizedCode());
+  EXPECT(CompilerStats::num_propagated_constants > constants_before);
+  EXPECT(CompilerStats::num_propagated_copies > copies_before);
+  EXPECT(CompilerStats::num_eliminated_subexpressions > subexpressions_before);
+  EXPECT(CompilerStats::num_eliminated_dead_instructions > dead_before);
+
+  GrowableArray<const Object*> arguments;
+  const Smi& x = Smi::Handle(Smi::New(1));
+  arguments.Add(&x);
+  const Array& kNoArgumentNames = Array::Handle();
+  const Smi& retval = Smi::Handle(
+      reinterpret_cast<RawSmi*>(DartEntry::InvokeStatic(function,
+                                                        arguments,
+                                                        kNoArgumentNames)));
+  EXPECT_EQ(Smi::New(3), retval.raw());
+}
+
+TEST_CASE(CompileOptimizedFunctionLinearScan) {
+  const char* kScriptChars =
+      "class A {\n"
+      "  static foo(x, y) {\n"
+      "    var a = x === y;\n"
+      "    var b = !a;\n"
+      "    var c = (a === b) ? 1 : 2;\n"
+      "    if (b) return c + 10;\n"
+      "    return c;\n"
+      "  }\n"
+      "}\n";
+  String& url =
+      String::Handle(String::New("dart-test:LinearScan"));
+  String& source = String::Handle(String::New(kScriptChars));
+  Script& script = Script::Handle(Script::New(url, source, RawScript::kSource));
+  Library& lib = Library::Handle(Library::CoreLibrary());
+  EXPECT(CompilerTest::TestCompileScript(lib, script));
+  EXPECT(ClassFinalizer::FinalizePendingClasses());
+  Class& cls = Class::Handle(
+      lib.LookupClass(String::Handle(String::NewSymbol("A"))));
+  EXPECT(!cls.IsNull());
+  String& name = String::Handle(String::New("foo"));
+  Function& function = Function::Handle(cls.LookupStaticFunction(name));
+  EXPECT(!function.IsNull());
+  EXPECT(CompilerTest::TestCompileFunction(function));
+
+  const bool saved_use_linear_scan = FLAG_use_linear_scan;
+  FLAG_use_linear_scan = true;
+  const Error& error =
+      Error::Handle(Compiler::CompileOptimizedFunction(function));
+  FLAG_use_linear_scan = saved_use_linear_scan;
+  EXPECT(error.IsNull());
+  EXPECT(function.HasOptimizedCode());
+
+  GrowableArray<const Object*> arguments;
+  const Smi& one = Smi::Handle(Smi::New(1));
+  const Smi& two = Smi::Handle(Smi::New(2));
+  arguments.Add(&one);
+  arguments.Add(&two);
+  const Array& kNoArgumentNames = Array::Handle();
+  Smi& retval = Smi::Handle();
+  retval ^= DartEntry::InvokeStatic(function, arguments, kNoArgumentNames);
+  EXPECT_EQ(Smi::New(12), retval.raw());
+  arguments[1] = &one;
+  retval ^= DartEntry::InvokeStatic(function, arguments, kNoArgumentNames);
+  EXPECT_EQ(Smi::New(2), retval.raw());
+}
+
+TEST_CASE(CompileOptimizedFunctionInlining) {
+  const char* kScriptChars =
+      "class B { get v() { return 1; } }\n"
+      "class C { get v() { return 2; } }\n"
+      "class D { get v() { return 3; } }\n"
+      "class A {\n"
+      "  static twice(x) { return x + x; }\n"
+      "  static foo(n, d) {\n"
+      "    var b = new B();\n"
+      "    var c = new C();\n"
+      "    var o = b;\n"
+      "    var sum = 0;\n"
+      "    for (var i = 0; i < n; i++) {\n"
+      "      sum += o.v + twice(1);\n"
+      "      o = (o === b) ? c : ((o === c) ? d : b);\n"
+      "    }\n"
+      "    return sum;\n"
+      "  }\n"
+      "}\n";
+  String& url =
+      String::Handle(String::New("dart-test:Inlining"));
+  String& source = String::Handle(String::New(kScriptChars));
+  Script& script = Script::Handle(Script::New(url, source, RawScript::kSource));
+  Library& lib = Library::Handle(Library::CoreLibrary());
+  EXPECT(CompilerTest::TestCompileScript(lib, script));
+  EXPECT(ClassFinalizer::FinalizePendingClasses());
+  Class& cls = Class::Handle(
+      lib.LookupClass(String::Handle(String::NewSymbol("A"))));
+  EXPECT(!cls.IsNull());
+  String& name = String::Handle(String::New("foo"));
+  Function& function = Function::Handle(cls.LookupStaticFunction(name));
+  EXPECT(!function.IsNull());
+  EXPECT(CompilerTest::TestCompileFunction(function));
+
+  // Record B and C at the getter call.  A B is passed for d.
+  GrowableArray<const Object*> arguments;
+  const Smi& n = Smi::Handle(Smi::New(10));
+  const Instance& b = Instance::Handle(
+      Instance::New(Class::Handle(
+          lib.LookupClass(String::Handle(String::NewSymbol("B"))))));
+  arguments.Add(&n);
+  arguments.Add(&b);
+  const Array& kNoArgumentNames = Array::Handle();
+  Smi& retval = Smi::Handle();
+  retval ^= DartEntry::InvokeStatic(function, arguments, kNoArgumentNames);
+  EXPECT_EQ(Smi::New(33), retval.raw());
+
+  const bool saved_use_inlining = FLAG_use_inlining;
+  const bool saved_compiler_stats = FLAG_compiler_stats;
+  FLAG_use_inlining = true;
+  FLAG_compiler_stats = true;
+  const intptr_t inlined_calls_before = CompilerStats::num_inlined_calls;
+  const Error& error =
+      Error::Handle(Compiler::CompileOptimizedFunction(function));
+  const intptr_t inlined_calls =
+      CompilerStats::num_inlined_calls - inlined_calls_before;
+  FLAG_use_inlining = saved_use_inlining;
+  FLAG_compiler_stats = saved_compiler_stats;
+  EXPECT(error.IsNull());
+  EXPECT(function.HasOptimizedCode());
+  // At least the getter call and the call to twice are inlined.
+  EXPECT(inlined_calls >= 2);
+
+  retval ^= DartEntry::InvokeStatic(function, arguments, kNoArgumentNames);
+  EXPECT_EQ(Smi::New(33), retval.raw());
+  // A D is not checked for and takes the call.
+  const Instance& d = Instance::Handle(
+      Instance::New(Class::Handle(
+          lib.LookupClass(String::Handle(String::NewSymbol("D"))))));
+  arguments[1] = &d;
+  retval ^= DartEntry::InvokeStatic(function, arguments, kNoArgumentNames);
+  EXPECT_EQ(Smi::New(39), retval.raw());
+}
+#endif  // TARGET_ARCH_X64
+
 #endif  // TARGET_ARCH_IA32 || TARGET_ARCH_X64
 
 }  // namespace dart
@@ -2063,6 +2063,43 @@ DART_EXPORT Dart_Handle Dart_ExternalByteArrayGetPeer(Dart_Handle object,
 }
 
 
+DART_EXPORT Dart_Handle Dart_ByteArrayAcquireData(Dart_Handle array,
+                                                  uint8_t** data,
+                                                  intptr_t* byte_length) {
+  Isolate* isolate = Isolate::Current();
+  DARTSCOPE(isolate);
+  const ByteArray& array_obj = Api::UnwrapByteArrayHandle(isolate, array);
+  if (array_obj.IsNull()) {
+    RETURN_TYPE_ERROR(isolate, array, ByteArray);
+  }
+  if (data == NULL) {
+    return Api::NewError("%s expects argument 'data' to be non-null.",
+                         CURRENT_FUNC);
+  }
+  if (byte_length == NULL) {
+    return Api::NewError("%s expects argument 'byte_length' to be non-null.",
+                         CURRENT_FUNC);
+  }
+  *data = array_obj.DataAddr();
+  *byte_length = array_obj.ByteLength();
+  // Checks in debug mode that nothing allocates until the data is released.
+  isolate->IncrementNoGCScopeDepth();
+  return Api::Success(isolate);
+}
+
+
+DART_EXPORT Dart_Handle Dart_ByteArrayReleaseData(Dart_Handle array) {
+  Isolate* isolate = Isolate::Current();
+  CHECK_ISOLATE(isolate);
+  const ByteArray& array_obj = Api::UnwrapByteArrayHandle(isolate, array);
+  if (array_obj.IsNull()) {
+    RETURN_TYPE_ERROR(isolate, array, ByteArray);
+  }
+  isolate->DecrementNoGCScopeDepth();
+  return Api::Success(isolate);
+}
+
+
 template<typename T>
 Dart_Handle ByteArrayGetAt(T* value, Dart_Handle array, intptr_t offset) {
   Isolate* isolate = Isolate::Current();
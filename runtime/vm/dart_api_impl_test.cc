@@ -855,6 +855,57 @@ TEST_CASE(ByteArrayAccess) {
 }
 
 
+TEST_CASE(ByteArrayAcquireData) {
+  Dart_Handle byte_array = Dart_NewByteArray(10);
+  EXPECT_VALID(byte_array);
+  for (intptr_t i = 0; i < 10; ++i) {
+    EXPECT_VALID(Dart_ByteArraySetUint8At(byte_array, i, i));
+  }
+
+  // Read and write the bytes in place.
+  uint8_t* data = NULL;
+  intptr_t byte_length = 0;
+  EXPECT_VALID(Dart_ByteArrayAcquireData(byte_array, &data, &byte_length));
+  EXPECT(data != NULL);
+  EXPECT_EQ(10, byte_length);
+  for (intptr_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, data[i]);
+    data[i] = 10 - i;
+  }
+  EXPECT_VALID(Dart_ByteArrayReleaseData(byte_array));
+  for (intptr_t i = 0; i < 10; ++i) {
+    uint8_t value = 0xFF;
+    EXPECT_VALID(Dart_ByteArrayGetUint8At(byte_array, i, &value));
+    EXPECT_EQ(10 - i, value);
+  }
+
+  // An empty array has no data.
+  Dart_Handle empty_array = Dart_NewByteArray(0);
+  EXPECT_VALID(Dart_ByteArrayAcquireData(empty_array, &data, &byte_length));
+  EXPECT(data == NULL);
+  EXPECT_EQ(0, byte_length);
+  EXPECT_VALID(Dart_ByteArrayReleaseData(empty_array));
+
+  // The data of an external array is its external data.
+  uint8_t external_data[] = { 0, 11, 22 };
+  Dart_Handle external_array =
+      Dart_NewExternalByteArray(external_data, 3, NULL, NULL);
+  EXPECT_VALID(Dart_ByteArrayAcquireData(external_array, &data, &byte_length));
+  EXPECT(data == external_data);
+  EXPECT_EQ(3, byte_length);
+  EXPECT_VALID(Dart_ByteArrayReleaseData(external_array));
+
+  // Other lists have no data to acquire.
+  Dart_Handle list = Dart_NewList(10);
+  Dart_Handle result = Dart_ByteArrayAcquireData(list, &data, &byte_length);
+  EXPECT(Dart_IsError(result));
+  EXPECT_STREQ("Dart_ByteArrayAcquireData expects argument 'array' to be "
+               "of type ByteArray.", Dart_GetError(result));
+  result = Dart_ByteArrayAcquireData(byte_array, NULL, &byte_length);
+  EXPECT(Dart_IsError(result));
+}
+
+
 TEST_CASE(ByteArrayAlignedMultiByteAccess) {
   intptr_t length = 16;
   Dart_Handle byte_array = Dart_NewByteArray(length);
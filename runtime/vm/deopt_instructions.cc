@@ -0,0 +1,267 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/deopt_instructions.h"
+
+#include "vm/ast.h"
+#include "vm/heap.h"
+
+namespace dart {
+
+const char* DeoptInstr::KindToCString(Kind kind) {
+  switch (kind) {
+    case kFrame: return "frame";
+    case kContinueAt: return "continue-at";
+    case kCopyStackSlot: return "copy-stack-slot";
+    case kCopyStackToSp: return "copy-stack-to-sp";
+    case kCopyRegister: return "copy-register";
+    case kMaterializeDouble: return "materialize-double";
+    case kConstant: return "constant";
+    default:
+      UNREACHABLE();
+      return "";
+  }
+}
+
+
+void DeoptInfoBuilder::AddFrame(const Function& function, intptr_t node_id) {
+  ASSERT(!function.IsNull());
+  Add(DeoptInstr::kFrame, AddObject(function));
+  Add(DeoptInstr::kContinueAt, node_id);
+}
+
+
+void DeoptInfoBuilder::AddCopyStackSlot(intptr_t fp_index) {
+  Add(DeoptInstr::kCopyStackSlot, fp_index);
+}
+
+
+void DeoptInfoBuilder::AddCopyStackToSp(intptr_t fp_index) {
+  Add(DeoptInstr::kCopyStackToSp, fp_index);
+}
+
+
+void DeoptInfoBuilder::AddCopyRegister(intptr_t reg) {
+  Add(DeoptInstr::kCopyRegister, reg);
+}
+
+
+void DeoptInfoBuilder::AddMaterializeDouble(intptr_t xmm_reg) {
+  Add(DeoptInstr::kMaterializeDouble, xmm_reg);
+}
+
+
+void DeoptInfoBuilder::AddConstant(const Object& value) {
+  Add(DeoptInstr::kConstant, AddObject(value));
+}
+
+
+intptr_t DeoptInfoBuilder::AddObject(const Object& value) {
+  for (intptr_t i = 0; i < objects_.length(); i++) {
+    if (objects_[i]->raw() == value.raw()) {
+      return i;
+    }
+  }
+  objects_.Add(&Object::ZoneHandle(value.raw()));
+  return objects_.length() - 1;
+}
+
+
+RawArray* DeoptInfoBuilder::CreateInstructions() const {
+  ASSERT(instructions_.length() > 0);
+  ASSERT(DeoptInstr::DecodeKind(instructions_[0]) == DeoptInstr::kFrame);
+  const Array& result =
+      Array::Handle(Array::New(instructions_.length(), Heap::kOld));
+  Smi& instruction = Smi::Handle();
+  for (intptr_t i = 0; i < instructions_.length(); i++) {
+    instruction = Smi::New(instructions_[i]);
+    result.SetAt(i, instruction);
+  }
+  return result.raw();
+}
+
+
+RawArray* DeoptInfoBuilder::CreateObjectTable() const {
+  if (objects_.is_empty()) {
+    return Array::null();
+  }
+  const Array& result =
+      Array::Handle(Array::New(objects_.length(), Heap::kOld));
+  for (intptr_t i = 0; i < objects_.length(); i++) {
+    result.SetAt(i, *objects_[i]);
+  }
+  return result.raw();
+}
+
+
+void DeoptTableBuilder::AddDeoptInfo(intptr_t pc_offset,
+                                     const DeoptInfoBuilder& info,
+                                     intptr_t reason) {
+  DeoptEntry entry;
+  entry.pc_offset = pc_offset;
+  entry.instructions = &Array::ZoneHandle(info.CreateInstructions());
+  entry.object_table = &Array::ZoneHandle(info.CreateObjectTable());
+  entry.reason = reason;
+  list_.Add(entry);
+}
+
+
+void DeoptTableBuilder::FinalizeDeoptTable(const Code& code) const {
+  if (list_.is_empty()) {
+    code.set_deopt_info_array(Array::Handle());
+    return;
+  }
+  const Array& table = Array::Handle(
+      Array::New(list_.length() * Code::kDeoptEntrySize, Heap::kOld));
+  Smi& value = Smi::Handle();
+  for (intptr_t i = 0; i < list_.length(); i++) {
+    const intptr_t index = i * Code::kDeoptEntrySize;
+    value = Smi::New(list_[i].pc_offset);
+    table.SetAt(index + Code::kDeoptPcOffsetEntry, value);
+    table.SetAt(index + Code::kDeoptInstructionsEntry,
+                *list_[i].instructions);
+    table.SetAt(index + Code::kDeoptObjectTableEntry,
+                *list_[i].object_table);
+    value = Smi::New(list_[i].reason);
+    table.SetAt(index + Code::kDeoptReasonEntry, value);
+  }
+  code.set_deopt_info_array(table);
+}
+
+
+intptr_t DeoptFrameCopy::CountStackToSp(intptr_t fp_index,
+                                        uword fp,
+                                        uword sp) {
+  const uword first = fp + (fp_index * kWordSize);
+  if (first < sp) {
+    return 0;
+  }
+  return ((first - sp) / kWordSize) + 1;
+}
+
+
+DeoptFrameCopy::DeoptFrameCopy(const Array& instructions,
+                               const Array& object_table,
+                               uword fp,
+                               uword sp,
+                               const intptr_t* cpu_registers,
+                               const double* xmm_registers)
+    : size_(0),
+      slots_(NULL),
+      double_count_(0),
+      doubles_(NULL),
+      function_(Function::null()),
+      node_id_(AstNode::kNoId),
+      continue_pc_(0) {
+  ASSERT(!instructions.IsNull() && (instructions.Length() > 0));
+  ASSERT(sp <= fp);
+  const intptr_t length = instructions.Length();
+  Smi& instruction = Smi::Handle();
+
+  // Size the copy.
+  for (intptr_t i = 0; i < length; i++) {
+    instruction ^= instructions.At(i);
+    const intptr_t payload = DeoptInstr::DecodePayload(instruction.Value());
+    switch (DeoptInstr::DecodeKind(instruction.Value())) {
+      case DeoptInstr::kFrame:
+        // Frames of inlined calls are not supported.
+        ASSERT(i == 0);
+        break;
+      case DeoptInstr::kContinueAt:
+        break;
+      case DeoptInstr::kCopyStackToSp:
+        size_ += CountStackToSp(payload, fp, sp);
+        break;
+      case DeoptInstr::kMaterializeDouble:
+        double_count_++;
+        size_++;
+        break;
+      default:
+        size_++;
+        break;
+    }
+  }
+  slots_ = new intptr_t[size_ > 0 ? size_ : 1];
+  doubles_ = new DoubleSlot[double_count_ > 0 ? double_count_ : 1];
+
+  // Copy the slots.
+  intptr_t slot_index = 0;
+  intptr_t double_index = 0;
+  const Object& placeholder = Object::Handle(Smi::New(0));
+  Function& function = Function::Handle();
+  Object& value = Object::Handle();
+  for (intptr_t i = 0; i < length; i++) {
+    instruction ^= instructions.At(i);
+    const intptr_t payload = DeoptInstr::DecodePayload(instruction.Value());
+    switch (DeoptInstr::DecodeKind(instruction.Value())) {
+      case DeoptInstr::kFrame:
+        function ^= object_table.At(payload);
+        function_ = function.raw();
+        break;
+      case DeoptInstr::kContinueAt:
+        node_id_ = payload;
+        break;
+      case DeoptInstr::kCopyStackSlot:
+        slots_[slot_index++] =
+            *reinterpret_cast<intptr_t*>(fp + (payload * kWordSize));
+        break;
+      case DeoptInstr::kCopyStackToSp: {
+        const intptr_t count = CountStackToSp(payload, fp, sp);
+        for (intptr_t j = 0; j < count; j++) {
+          slots_[slot_index++] =
+              *reinterpret_cast<intptr_t*>(fp + ((payload - j) * kWordSize));
+        }
+        break;
+      }
+      case DeoptInstr::kCopyRegister:
+        slots_[slot_index++] = cpu_registers[payload];
+        break;
+      case DeoptInstr::kMaterializeDouble:
+        doubles_[double_index].index = slot_index;
+        doubles_[double_index].value = xmm_registers[payload];
+        double_index++;
+        // A valid object until the double is boxed.
+        slots_[slot_index++] = reinterpret_cast<intptr_t>(placeholder.raw());
+        break;
+      case DeoptInstr::kConstant:
+        value = object_table.At(payload);
+        slots_[slot_index++] = reinterpret_cast<intptr_t>(value.raw());
+        break;
+      default:
+        UNREACHABLE();
+        break;
+    }
+  }
+  ASSERT(slot_index == size_);
+  ASSERT(double_index == double_count_);
+
+  // Find the continuation in unoptimized code.
+  ASSERT(!function.IsNull() && (node_id_ != AstNode::kNoId));
+  const Code& code = Code::Handle(function.unoptimized_code());
+  ASSERT(!code.IsNull());
+  continue_pc_ = code.GetDeoptPcAtNodeId(node_id_);
+  ASSERT(continue_pc_ != 0);
+}
+
+
+DeoptFrameCopy::~DeoptFrameCopy() {
+  delete[] slots_;
+  delete[] doubles_;
+}
+
+
+void DeoptFrameCopy::Fill(uword fp) const {
+  for (intptr_t i = 0; i < size_; i++) {
+    *reinterpret_cast<intptr_t*>(SlotAddress(i, fp)) = slots_[i];
+  }
+  // All slots hold objects now, allocation is safe.
+  Double& value = Double::Handle();
+  for (intptr_t i = 0; i < double_count_; i++) {
+    value = Double::New(doubles_[i].value);
+    *reinterpret_cast<RawObject**>(SlotAddress(doubles_[i].index, fp)) =
+        value.raw();
+  }
+}
+
+}  // namespace dart
@@ -0,0 +1,190 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef VM_DEOPT_INSTRUCTIONS_H_
+#define VM_DEOPT_INSTRUCTIONS_H_
+
+#include "vm/allocation.h"
+#include "vm/globals.h"
+#include "vm/growable_array.h"
+#include "vm/object.h"
+
+namespace dart {
+
+// Optimized code describes, at each of its deoptimization points, how to
+// build the unoptimized frame that continues the execution from the
+// optimized frame. The description is a list of instructions, each encoded
+// in a Smi, and a table of the objects they refer to.
+//
+// The instructions start with kFrame and kContinueAt, followed by one
+// instruction per slot of the unoptimized frame below its frame pointer,
+// from the first local to the top of the expression stack.
+// Only the frame of the optimized function is described: no optimizing
+// code generator that deoptimizes inlines calls yet.
+class DeoptInstr : public AllStatic {
+ public:
+  enum Kind {
+    // Payload: index of the function in the object table.
+    kFrame = 0,
+    // Payload: node id of the deoptimization point of the continuation in
+    // unoptimized code.
+    kContinueAt,
+    // Payload: frame pointer relative index of an optimized slot.
+    kCopyStackSlot,
+    // Payload: frame pointer relative index of the first of the optimized
+    // slots down to the stack pointer at the deoptimization point. Used when
+    // the height of the expression stack is not known when compiling.
+    kCopyStackToSp,
+    // Payload: number of a CPU register.
+    kCopyRegister,
+    // Payload: number of an XMM register holding an unboxed double, which is
+    // boxed in a new Double.
+    kMaterializeDouble,
+    // Payload: index of the value in the object table.
+    kConstant,
+    kNumberOfKinds
+  };
+
+  static const intptr_t kKindBits = 3;
+  static const intptr_t kKindMask = (1 << kKindBits) - 1;
+
+  static intptr_t Encode(Kind kind, intptr_t payload) {
+    ASSERT(kind < kNumberOfKinds);
+    ASSERT(Smi::IsValid(payload << kKindBits));
+    return (payload << kKindBits) | kind;
+  }
+  static Kind DecodeKind(intptr_t instruction) {
+    return static_cast<Kind>(instruction & kKindMask);
+  }
+  static intptr_t DecodePayload(intptr_t instruction) {
+    return instruction >> kKindBits;
+  }
+
+  static const char* KindToCString(Kind kind);
+};
+
+
+// Builds the deoptimization instructions of one deoptimization point.
+class DeoptInfoBuilder : public ValueObject {
+ public:
+  DeoptInfoBuilder() : instructions_(8), objects_(4) { }
+
+  void AddFrame(const Function& function, intptr_t node_id);
+  void AddCopyStackSlot(intptr_t fp_index);
+  void AddCopyStackToSp(intptr_t fp_index);
+  void AddCopyRegister(intptr_t reg);
+  void AddMaterializeDouble(intptr_t xmm_reg);
+  void AddConstant(const Object& value);
+
+  RawArray* CreateInstructions() const;
+  // Returns null if no object is referenced.
+  RawArray* CreateObjectTable() const;
+
+ private:
+  void Add(DeoptInstr::Kind kind, intptr_t payload) {
+    instructions_.Add(DeoptInstr::Encode(kind, payload));
+  }
+  intptr_t AddObject(const Object& value);
+
+  GrowableArray<intptr_t> instructions_;
+  GrowableArray<const Object*> objects_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeoptInfoBuilder);
+};
+
+
+// Collects the deoptimization points of a function being compiled, and adds
+// them to its code (see Code::deopt_info_array).
+class DeoptTableBuilder : public ZoneAllocated {
+ public:
+  DeoptTableBuilder() : list_(4) { }
+
+  void AddDeoptInfo(intptr_t pc_offset,
+                    const DeoptInfoBuilder& info,
+                    intptr_t reason);
+
+  intptr_t Length() const { return list_.length(); }
+
+  void FinalizeDeoptTable(const Code& code) const;
+
+ private:
+  struct DeoptEntry {
+    intptr_t pc_offset;
+    const Array* instructions;
+    const Array* object_table;
+    intptr_t reason;
+  };
+
+  GrowableArray<DeoptEntry> list_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeoptTableBuilder);
+};
+
+
+// Translates an optimized frame stopped at a deoptimization point into an
+// unoptimized frame. The unoptimized frame replaces the optimized one in
+// place and is usually larger, so the translation is done in two steps,
+// with the Deoptimize stub moving the stack pointer in between:
+//  - The constructor reads the slots of the optimized frame and the
+//    registers saved by the stub, and computes the slots of the unoptimized
+//    frame. It does not allocate in the Dart heap: the optimized frame may
+//    hold values that are not tagged.
+//  - Fill writes the unoptimized frame below the frame pointer of the
+//    optimized frame, and then boxes the unoptimized doubles, which may
+//    cause a GC.
+// The copy lives in the C++ heap, as the two steps run in different runtime
+// calls.
+class DeoptFrameCopy {
+ public:
+  // 'fp' and 'sp' are the frame and stack pointers of the optimized frame
+  // at the deoptimization point. 'cpu_registers' and 'xmm_registers' hold
+  // the registers at the deoptimization point, indexed by their number.
+  DeoptFrameCopy(const Array& instructions,
+                 const Array& object_table,
+                 uword fp,
+                 uword sp,
+                 const intptr_t* cpu_registers,
+                 const double* xmm_registers);
+  ~DeoptFrameCopy();
+
+  // Number of words of the unoptimized frame below 'fp'.
+  intptr_t size() const { return size_; }
+
+  // The optimized function and the node id of the deoptimization point.
+  RawFunction* function() const { return function_; }
+  intptr_t node_id() const { return node_id_; }
+
+  // The pc in unoptimized code the Deoptimize stub returns to.
+  uword continue_pc() const { return continue_pc_; }
+
+  // Writes the unoptimized frame below 'fp', which must have room for
+  // size() words. Can cause a GC, the frame must then be walkable.
+  void Fill(uword fp) const;
+
+ private:
+  struct DoubleSlot {
+    intptr_t index;
+    double value;
+  };
+
+  static intptr_t CountStackToSp(intptr_t fp_index, uword fp, uword sp);
+
+  uword SlotAddress(intptr_t index, uword fp) const {
+    return fp - ((index + 1) * kWordSize);
+  }
+
+  intptr_t size_;
+  intptr_t* slots_;
+  intptr_t double_count_;
+  DoubleSlot* doubles_;
+  RawFunction* function_;
+  intptr_t node_id_;
+  uword continue_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeoptFrameCopy);
+};
+
+}  // namespace dart
+
+#endif  // VM_DEOPT_INSTRUCTIONS_H_
@@ -0,0 +1,132 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "platform/assert.h"
+#include "vm/ast.h"
+#include "vm/class_finalizer.h"
+#include "vm/code_generator.h"
+#include "vm/deopt_instructions.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+TEST_CASE(DeoptInstrEncoding) {
+  for (intptr_t kind = 0; kind < DeoptInstr::kNumberOfKinds; kind++) {
+    const intptr_t payloads[] = { 0, 1, -1, 4096, -4096 };
+    for (intptr_t i = 0; i < 5; i++) {
+      const intptr_t instruction = DeoptInstr::Encode(
+          static_cast<DeoptInstr::Kind>(kind), payloads[i]);
+      EXPECT(Smi::IsValid(instruction));
+      EXPECT_EQ(kind, DeoptInstr::DecodeKind(instruction));
+      EXPECT_EQ(payloads[i], DeoptInstr::DecodePayload(instruction));
+    }
+  }
+}
+
+
+// Only the ia32 optimizing compiler deoptimizes now.
+#if defined(TARGET_ARCH_IA32)
+
+// Returns the node id of the first descriptor of 'kind' in the code.
+static intptr_t FindNodeId(const Code& code, PcDescriptors::Kind kind) {
+  const PcDescriptors& descriptors =
+      PcDescriptors::Handle(code.pc_descriptors());
+  for (intptr_t i = 0; i < descriptors.Length(); i++) {
+    if ((descriptors.DescriptorKind(i) == kind) &&
+        (descriptors.NodeId(i) != AstNode::kNoId)) {
+      return descriptors.NodeId(i);
+    }
+  }
+  return AstNode::kNoId;
+}
+
+
+TEST_CASE(DeoptFrameCopy) {
+  const char* kScriptChars =
+      "class A {\n"
+      "  static foo(a, b) { return a + b; }\n"
+      "}\n";
+  String& url = String::Handle(String::New("dart-test:DeoptFrameCopy"));
+  String& source = String::Handle(String::New(kScriptChars));
+  Script& script = Script::Handle(Script::New(url, source, RawScript::kSource));
+  Library& lib = Library::Handle(Library::CoreLibrary());
+  EXPECT(CompilerTest::TestCompileScript(lib, script));
+  EXPECT(ClassFinalizer::FinalizePendingClasses());
+  Class& cls = Class::Handle(
+      lib.LookupClass(String::Handle(String::NewSymbol("A"))));
+  EXPECT(!cls.IsNull());
+  const Function& foo = Function::Handle(
+      cls.LookupStaticFunction(String::Handle(String::New("foo"))));
+  EXPECT(CompilerTest::TestCompileFunction(foo));
+  const Code& foo_code = Code::Handle(foo.unoptimized_code());
+  // 'foo' deoptimizes at 'a + b'.
+  const intptr_t deopt_id = FindNodeId(foo_code, PcDescriptors::kDeopt);
+  EXPECT(deopt_id != AstNode::kNoId);
+
+  DeoptInfoBuilder builder;
+  builder.AddFrame(foo, deopt_id);
+  builder.AddCopyStackSlot(-1);
+  builder.AddCopyRegister(1);
+  builder.AddConstant(Smi::Handle(Smi::New(7)));
+  builder.AddCopyStackToSp(-2);
+  builder.AddMaterializeDouble(1);
+
+  // The deoptimization info is found at the return address of its call.
+  DeoptTableBuilder* table = new DeoptTableBuilder();
+  table->AddDeoptInfo(8, builder, kDeoptUnknown);
+  table->FinalizeDeoptTable(foo_code);
+  EXPECT_EQ(0, foo_code.GetDeoptIndexAtPc(foo_code.EntryPoint() + 8));
+  EXPECT_EQ(-1, foo_code.GetDeoptIndexAtPc(foo_code.EntryPoint() + 4));
+  const Array& deopt_table = Array::Handle(foo_code.deopt_info_array());
+  Array& instructions = Array::Handle();
+  instructions ^= deopt_table.At(Code::kDeoptInstructionsEntry);
+  Array& object_table = Array::Handle();
+  object_table ^= deopt_table.At(Code::kDeoptObjectTableEntry);
+  foo_code.set_deopt_info_array(Array::Handle());
+
+  // An optimized frame with three slots below the frame pointer.
+  intptr_t optimized_stack[8];
+  for (intptr_t i = 0; i < 8; i++) {
+    optimized_stack[i] = reinterpret_cast<intptr_t>(Smi::New(100 + i));
+  }
+  const uword fp = reinterpret_cast<uword>(&optimized_stack[6]);
+  const uword sp = reinterpret_cast<uword>(&optimized_stack[3]);
+  intptr_t cpu_registers[4];
+  double xmm_registers[2];
+  for (intptr_t i = 0; i < 4; i++) {
+    cpu_registers[i] = reinterpret_cast<intptr_t>(Smi::New(200 + i));
+  }
+  xmm_registers[0] = 0.5;
+  xmm_registers[1] = 2.5;
+
+  DeoptFrameCopy* copy = new DeoptFrameCopy(
+      instructions, object_table, fp, sp, cpu_registers, xmm_registers);
+  EXPECT_EQ(6, copy->size());
+  EXPECT(copy->function() == foo.raw());
+  EXPECT_EQ(deopt_id, copy->node_id());
+  EXPECT_EQ(foo_code.GetDeoptPcAtNodeId(deopt_id), copy->continue_pc());
+
+  // The copy does not depend on the optimized frame any more.
+  for (intptr_t i = 0; i < 8; i++) {
+    optimized_stack[i] = 0;
+  }
+  intptr_t unoptimized_stack[10];
+  const uword new_fp = reinterpret_cast<uword>(&unoptimized_stack[8]);
+  copy->Fill(new_fp);
+  // Local, register, constant, expression stack down to sp, double.
+  EXPECT_EQ(reinterpret_cast<intptr_t>(Smi::New(105)), unoptimized_stack[7]);
+  EXPECT_EQ(reinterpret_cast<intptr_t>(Smi::New(201)), unoptimized_stack[6]);
+  EXPECT_EQ(reinterpret_cast<intptr_t>(Smi::New(7)), unoptimized_stack[5]);
+  EXPECT_EQ(reinterpret_cast<intptr_t>(Smi::New(104)), unoptimized_stack[4]);
+  EXPECT_EQ(reinterpret_cast<intptr_t>(Smi::New(103)), unoptimized_stack[3]);
+  Double& value = Double::Handle();
+  value ^= reinterpret_cast<RawObject*>(unoptimized_stack[2]);
+  EXPECT_EQ(2.5, value.value());
+  delete copy;
+}
+
+#endif  // TARGET_ARCH_IA32
+
+}  // namespace dart
@@ -0,0 +1,307 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/flow_graph_allocator.h"
+
+#include "vm/flags.h"
+#include "vm/os.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool, use_linear_scan, false,
+    "Keep temporaries in registers in optimized code.");
+DEFINE_FLAG(bool, trace_linear_scan, false,
+    "Print the number of temporaries kept in registers.");
+
+
+FlowGraphAllocator::FlowGraphAllocator(
+    const GrowableArray<BlockEntryInstr*>& block_order,
+    intptr_t register_count)
+    : block_order_(block_order),
+      register_count_(register_count),
+      block_start_(block_order.length()),
+      block_end_(block_order.length()),
+      block_mark_(block_order.length()),
+      calls_before_(),
+      intervals_(),
+      active_(register_count),
+      free_registers_(register_count) { }
+
+
+// True if the instruction may call out of the function.  Calls clobber all
+// registers and may collect garbage.  The computations listed here only
+// use the fixed scratch registers of the flow graph compiler, and their
+// write barrier preserves all other registers.
+bool FlowGraphAllocator::CanCall(Instruction* instr) {
+  Computation* comp = instr->computation();
+  if (comp == NULL) {
+    return !(instr->IsBlockEntry() || instr->IsReturn() || instr->IsBranch());
+  }
+  return !(comp->IsUse() ||
+           comp->IsConstant() ||
+           comp->IsCurrentContext() ||
+           comp->IsStoreContext() ||
+           comp->IsLoadLocal() ||
+           comp->IsStoreLocal() ||
+           comp->IsStrictCompare() ||
+           comp->IsBooleanNegate() ||
+           comp->IsLoadInstanceField() ||
+           comp->IsStoreInstanceField() ||
+           comp->IsLoadStaticField() ||
+           comp->IsStoreStaticField() ||
+           comp->IsNativeLoadField() ||
+           comp->IsLoadClass() ||
+           comp->IsChainContext());
+}
+
+
+// True if the flow graph compiler reads the input with LoadValue before any
+// call, rather than popping it from the stack or passing it on the stack.
+bool FlowGraphAllocator::CanUseRegister(Instruction* instr, Value* input) {
+  Computation* comp = instr->computation();
+  if (comp == NULL) {
+    if (instr->IsReturn()) return input == instr->AsReturn()->value();
+    if (instr->IsBranch()) return input == instr->AsBranch()->value();
+    if (instr->IsThrow()) return input == instr->AsThrow()->exception();
+    // The exception is pushed before the stack trace is read.
+    if (instr->IsReThrow()) {
+      return input == instr->AsReThrow()->stack_trace();
+    }
+    return false;
+  }
+  if (comp->IsUse()) return true;
+  if (comp->IsAssertAssignable()) {
+    return input == comp->AsAssertAssignable()->value();
+  }
+  if (comp->IsInstanceOf()) return input == comp->AsInstanceOf()->value();
+  if (comp->IsCreateArray()) {
+    return input == comp->AsCreateArray()->element_type();
+  }
+  return comp->IsAssertBoolean() ||
+         comp->IsStoreContext() ||
+         comp->IsStoreLocal() ||
+         comp->IsStrictCompare() ||
+         comp->IsEqualityCompare() ||
+         comp->IsBooleanNegate() ||
+         comp->IsLoadInstanceField() ||
+         comp->IsStoreInstanceField() ||
+         comp->IsStoreStaticField() ||
+         comp->IsLoadClass();
+}
+
+
+int FlowGraphAllocator::CompareStart(LiveInterval* const* a,
+                                     LiveInterval* const* b) {
+  return (*a)->start - (*b)->start;
+}
+
+
+intptr_t FlowGraphAllocator::AllocateRegisters() {
+  if (!NumberInstructions()) return 0;
+  ComputeLiveness();
+  GrowableArray<LiveInterval*> candidates(intervals_.length());
+  for (intptr_t i = 0; i < intervals_.length(); ++i) {
+    LiveInterval* interval = intervals_[i];
+    if (interval->can_use_register && !IsLiveAcrossCall(interval)) {
+      candidates.Add(interval);
+    }
+  }
+  LinearScan(&candidates);
+  intptr_t count = 0;
+  for (intptr_t i = 0; i < intervals_.length(); ++i) {
+    if (intervals_[i]->bind->register_index() >= 0) count++;
+  }
+  if (FLAG_trace_linear_scan) {
+    OS::Print("Linear scan: %d of %d temporaries in registers\n",
+              count, intervals_.length());
+  }
+  return count;
+}
+
+
+// Number the instructions in block order, name the Binds, and record the
+// definition and use of each temporary.  Returns false if the graph
+// addresses temporaries by stack slot, which only works if all of them are
+// on the stack.
+bool FlowGraphAllocator::NumberInstructions() {
+  for (intptr_t i = 0; i < block_order_.length(); ++i) {
+    block_start_.Add(-1);
+    block_end_.Add(-1);
+    block_mark_.Add(-1);
+  }
+  intptr_t pos = 0;
+  intptr_t call_count = 0;
+  for (intptr_t i = 0; i < block_order_.length(); ++i) {
+    BlockEntryInstr* block = block_order_[i];
+    block_start_[block->postorder_number()] = pos;
+    for (Instruction* current = block;
+         current != NULL;
+         current = current->NextInBlock()) {
+      if (current->IsPickTemp() || current->IsTuckTemp()) return false;
+      calls_before_.Add(call_count);
+      if (CanCall(current)) call_count++;
+      Computation* comp = current->computation();
+      if ((comp != NULL) && comp->IsUse()) {
+        RecordUse(current, comp->AsUse(), pos, block);
+      } else {
+        for (intptr_t j = 0; j < current->InputCount(); ++j) {
+          RecordUse(current, current->InputAt(j), pos, block);
+        }
+      }
+      BindInstr* bind = current->AsBind();
+      if (bind != NULL) {
+        bind->set_ssa_temp_index(intervals_.length());
+        bind->set_register_index(-1);
+        LiveInterval* interval = new LiveInterval();
+        interval->bind = bind;
+        interval->start = pos;
+        interval->end = -1;
+        interval->def_block = block->postorder_number();
+        interval->use_block = -1;
+        interval->can_use_register = false;
+        intervals_.Add(interval);
+      }
+      pos++;
+    }
+    block_end_[block->postorder_number()] = pos - 1;
+  }
+  calls_before_.Add(call_count);
+  return true;
+}
+
+
+void FlowGraphAllocator::RecordUse(Instruction* instr,
+                                   Value* input,
+                                   intptr_t pos,
+                                   BlockEntryInstr* block) {
+  if (!input->IsUse()) return;
+  BindInstr* bind = input->AsUse()->definition()->AsBind();
+  // The definition dominates the use, so it has already been named.
+  if ((bind == NULL) ||
+      (bind->ssa_temp_index() < 0) ||
+      (bind->ssa_temp_index() >= intervals_.length()) ||
+      (intervals_[bind->ssa_temp_index()]->bind != bind)) {
+    return;
+  }
+  LiveInterval* interval = intervals_[bind->ssa_temp_index()];
+  interval->end = pos;
+  interval->use_block = block->postorder_number();
+  interval->can_use_register = CanUseRegister(instr, input);
+}
+
+
+// A temporary is live from its definition to its use.  If they are in
+// different blocks, it is also live through every block on a path from the
+// definition to the use, which need not lie between them in block order.
+void FlowGraphAllocator::ComputeLiveness() {
+  for (intptr_t i = 0; i < intervals_.length(); ++i) {
+    LiveInterval* interval = intervals_[i];
+    if (interval->end < 0) {
+      // The use is unreachable, e.g., after a throw.  The value is pushed
+      // and never popped.
+      interval->can_use_register = false;
+    } else if (interval->use_block != interval->def_block) {
+      ExtendLiveThroughBlocks(interval);
+    }
+  }
+}
+
+
+// Walk the predecessors backwards from the use to the definition.  The
+// blocks are marked with the SSA temp index to visit each at most once.
+void FlowGraphAllocator::ExtendLiveThroughBlocks(LiveInterval* interval) {
+  const intptr_t mark = interval->bind->ssa_temp_index();
+  GrowableArray<BlockEntryInstr*> worklist;
+  BlockEntryInstr* use_block =
+      block_order_[block_order_.length() - interval->use_block - 1];
+  ASSERT(use_block->postorder_number() == interval->use_block);
+  block_mark_[interval->use_block] = mark;
+  worklist.Add(use_block);
+  while (!worklist.is_empty()) {
+    BlockEntryInstr* block = worklist.Last();
+    worklist.RemoveLast();
+    const intptr_t number = block->postorder_number();
+    if (block_start_[number] < interval->start) {
+      interval->start = block_start_[number];
+    }
+    for (intptr_t i = 0; i < block->PredecessorCount(); ++i) {
+      const intptr_t pred = block->PredecessorAt(i)->postorder_number();
+      if (block_end_[pred] > interval->end) {
+        interval->end = block_end_[pred];
+      }
+      if ((pred != interval->def_block) && (block_mark_[pred] != mark)) {
+        block_mark_[pred] = mark;
+        worklist.Add(block->PredecessorAt(i));
+      }
+    }
+  }
+}
+
+
+// The value is read before a call at its use and written after a call at
+// its definition, so only the calls strictly inside the interval matter.
+bool FlowGraphAllocator::IsLiveAcrossCall(LiveInterval* interval) const {
+  if (interval->end <= interval->start + 1) return false;
+  return calls_before_[interval->end] > calls_before_[interval->start + 1];
+}
+
+
+void FlowGraphAllocator::LinearScan(GrowableArray<LiveInterval*>* intervals) {
+  intervals->Sort(CompareStart);
+  for (intptr_t i = register_count_ - 1; i >= 0; --i) {
+    free_registers_.Add(i);
+  }
+  for (intptr_t i = 0; i < intervals->length(); ++i) {
+    LiveInterval* current = (*intervals)[i];
+    ExpireOldIntervals(current->start);
+    if (!free_registers_.is_empty()) {
+      current->bind->set_register_index(free_registers_.Last());
+      free_registers_.RemoveLast();
+      AddActive(current);
+      continue;
+    }
+    // Spill the interval that ends last.
+    LiveInterval* spill = active_.Last();
+    if (spill->end > current->end) {
+      current->bind->set_register_index(spill->bind->register_index());
+      spill->bind->set_register_index(-1);
+      active_.RemoveLast();
+      AddActive(current);
+    }
+  }
+}
+
+
+// Free the registers of the intervals ending at or before the position.
+// An interval ending at a position is read there before an interval
+// starting there is written.
+void FlowGraphAllocator::ExpireOldIntervals(intptr_t position) {
+  intptr_t expired = 0;
+  while ((expired < active_.length()) &&
+         (active_[expired]->end <= position)) {
+    free_registers_.Add(active_[expired]->bind->register_index());
+    expired++;
+  }
+  if (expired == 0) return;
+  const intptr_t length = active_.length();
+  for (intptr_t i = expired; i < length; ++i) {
+    active_[i - expired] = active_[i];
+  }
+  for (intptr_t i = 0; i < expired; ++i) {
+    active_.RemoveLast();
+  }
+}
+
+
+void FlowGraphAllocator::AddActive(LiveInterval* interval) {
+  active_.Add(interval);
+  intptr_t i = active_.length() - 1;
+  while ((i > 0) && (active_[i - 1]->end > interval->end)) {
+    active_[i] = active_[i - 1];
+    i--;
+  }
+  active_[i] = interval;
+}
+
+}  // namespace dart
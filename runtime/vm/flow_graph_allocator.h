@@ -0,0 +1,87 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef VM_FLOW_GRAPH_ALLOCATOR_H_
+#define VM_FLOW_GRAPH_ALLOCATOR_H_
+
+#include "vm/allocation.h"
+#include "vm/growable_array.h"
+#include "vm/intermediate_language.h"
+
+namespace dart {
+
+// Linear scan register allocation (Poletto and Sarkar) of the temporaries
+// of a flow graph.
+//
+// The flow graph compiler pushes the value of a Bind on the expression
+// stack and its only use pops it.  The allocator instead assigns some of
+// these values one of 'register_count' registers for their whole lifetime,
+// so the value is moved into the register by the Bind and read from it by
+// the use.  The temporaries that stay on the stack remain properly nested,
+// since a value and its use are removed from the stack together.
+//
+// Every call clobbers all registers and is a GC safepoint, so a value live
+// across a call is spilled: it is kept on the expression stack, where the
+// GC sees it.  A value whose use pops it directly, e.g., an argument of a
+// call, is never allocated a register.
+class FlowGraphAllocator : public ValueObject {
+ public:
+  // The block order is the order in which the blocks are compiled.
+  FlowGraphAllocator(const GrowableArray<BlockEntryInstr*>& block_order,
+                     intptr_t register_count);
+
+  // Set the register index of each Bind.  Returns the number of values kept
+  // in registers.
+  intptr_t AllocateRegisters();
+
+ private:
+  // The live range of a temporary, from its definition to its use, in
+  // linear instruction positions.
+  struct LiveInterval : public ZoneAllocated {
+    BindInstr* bind;
+    intptr_t start;
+    intptr_t end;
+    intptr_t def_block;  // Postorder numbers.
+    intptr_t use_block;
+    bool can_use_register;
+  };
+
+  static bool CanCall(Instruction* instr);
+  static bool CanUseRegister(Instruction* instr, Value* input);
+  static int CompareStart(LiveInterval* const* a, LiveInterval* const* b);
+
+  bool NumberInstructions();
+  void RecordUse(Instruction* instr, Value* input, intptr_t pos,
+                 BlockEntryInstr* block);
+  void ComputeLiveness();
+  void ExtendLiveThroughBlocks(LiveInterval* interval);
+  bool IsLiveAcrossCall(LiveInterval* interval) const;
+  void LinearScan(GrowableArray<LiveInterval*>* intervals);
+  void ExpireOldIntervals(intptr_t position);
+  void AddActive(LiveInterval* interval);
+
+  const GrowableArray<BlockEntryInstr*>& block_order_;
+  const intptr_t register_count_;
+
+  // Indexed by postorder block number.
+  GrowableArray<intptr_t> block_start_;
+  GrowableArray<intptr_t> block_end_;
+  GrowableArray<intptr_t> block_mark_;
+
+  // Indexed by instruction position: the number of calls before it.
+  GrowableArray<intptr_t> calls_before_;
+
+  // Indexed by SSA temp index.
+  GrowableArray<LiveInterval*> intervals_;
+
+  // Intervals holding a register, sorted by increasing end.
+  GrowableArray<LiveInterval*> active_;
+  GrowableArray<intptr_t> free_registers_;
+
+  DISALLOW_COPY_AND_ASSIGN(FlowGraphAllocator);
+};
+
+}  // namespace dart
+
+#endif  // VM_FLOW_GRAPH_ALLOCATOR_H_
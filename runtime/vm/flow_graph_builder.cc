@@ -8,19 +8,25 @@
 #include "vm/code_descriptors.h"
 #include "vm/dart_entry.h"
 #include "vm/flags.h"
+#include "vm/flow_graph_inliner.h"
+#include "vm/flow_graph_optimizer.h"
 #include "vm/intermediate_language.h"
 #include "vm/longjump.h"
 #include "vm/object_store.h"
 #include "vm/os.h"
 #include "vm/parser.h"
 #include "vm/resolver.h"
+#include "vm/scopes.h"
 #include "vm/stub_code.h"
 
 namespace dart {
 
 DEFINE_FLAG(bool, print_flow_graph, false, "Print the IR flow graph.");
 DECLARE_FLAG(bool, enable_type_checks);
+DECLARE_FLAG(bool, use_inlining);
 DEFINE_FLAG(bool, print_ast, false, "Print abstract syntax tree.");
+DEFINE_FLAG(bool, use_ssa, false,
+    "Put the flow graph in SSA form and optimize it in optimized code.");
 
 
 FlowGraphBuilder::FlowGraphBuilder(const ParsedFunction& parsed_function)
@@ -30,7 +36,14 @@ FlowGraphBuilder::FlowGraphBuilder(const ParsedFunction& parsed_function)
     context_level_(0),
     last_used_try_index_(CatchClauseNode::kInvalidTryIndex),
     try_index_(CatchClauseNode::kInvalidTryIndex),
-    catch_entries_() {}
+    catch_entries_(),
+    ssa_variables_(),
+    ssa_version_variables_(),
+    ssa_temp_count_(0),
+    is_inlining_(false),
+    inlined_exits_(),
+    inlined_return_values_(),
+    inlined_local_count_(0) {}
 
 
 void FlowGraphBuilder::AddCatchEntry(intptr_t try_index, Instruction* entry) {
@@ -38,6 +51,14 @@ void FlowGraphBuilder::AddCatchEntry(intptr_t try_index, Instruction* entry) {
 }
 
 
+void FlowGraphBuilder::AddInlinedReturn(Instruction* exit, Value* value) {
+  ASSERT(is_inlining());
+  ASSERT(exit != NULL);
+  inlined_exits_.Add(exit);
+  inlined_return_values_.Add(value);
+}
+
+
 void EffectGraphVisitor::Append(const EffectGraphVisitor& other_fragment) {
   ASSERT(is_open());
   if (other_fragment.is_empty()) return;
@@ -110,7 +131,8 @@ void EffectGraphVisitor::Join(const TestGraphVisitor& test_fragment,
 }
 
 
-void EffectGraphVisitor::TieLoop(const TestGraphVisitor& test_fragment,
+void EffectGraphVisitor::TieLoop(intptr_t loop_id,
+                                 const TestGraphVisitor& test_fragment,
                                  const EffectGraphVisitor& body_fragment) {
   // We have: a test graph fragment with zero, one, or two available exits;
   // and an effect graph fragment with zero or one available exits.  We want
@@ -132,6 +154,7 @@ void EffectGraphVisitor::TieLoop(const TestGraphVisitor& test_fragment,
     Append(test_fragment);
   } else {
     JoinEntryInstr* join = new JoinEntryInstr();
+    join->set_loop_id(loop_id);
     AddInstruction(join);
     join->SetSuccessor(test_fragment.entry());
     body_exit->SetSuccessor(join);
@@ -224,6 +247,15 @@ void EffectGraphVisitor::VisitReturnNode(ReturnNode* node) {
     }
   }
 
+  if (owner()->is_inlining()) {
+    // Inlined functions do not allocate contexts.  The inliner stores the
+    // value in the result of the call.
+    ASSERT(owner()->context_level() == 0);
+    owner()->AddInlinedReturn(exit(), return_value);
+    CloseFragment();
+    return;
+  }
+
   intptr_t current_context_level = owner()->context_level();
   ASSERT(current_context_level >= 0);
   if (owner()->parsed_function().saved_context_var() != NULL) {
@@ -983,7 +1015,7 @@ void EffectGraphVisitor::VisitWhileNode(WhileNode* node) {
   if (lbl->join_for_continue() != NULL) {
     AddInstruction(lbl->join_for_continue());
   }
-  TieLoop(for_test, for_body);
+  TieLoop(node->id(), for_test, for_body);
   if (lbl->join_for_break() != NULL) {
     AddInstruction(lbl->join_for_break());
   }
@@ -1011,6 +1043,7 @@ void EffectGraphVisitor::VisitDoWhileNode(DoWhileNode* node) {
 
   // Tie do-while loop (test is after the body).
   JoinEntryInstr* body_entry_join = new JoinEntryInstr();
+  body_entry_join->set_loop_id(node->id());
   AddInstruction(body_entry_join);
   body_entry_join->SetSuccessor(for_body.entry());
   Instruction* body_exit =
@@ -1096,6 +1129,7 @@ void EffectGraphVisitor::VisitForNode(ForNode* node) {
   // body is not open, i.e., no backward branch exists.
   if (loop_increment_end != NULL) {
     JoinEntryInstr* loop_start = new JoinEntryInstr();
+    loop_start->set_loop_id(node->id());
     AddInstruction(loop_start);
     loop_increment_end->SetSuccessor(loop_start);
   }
@@ -2056,9 +2090,11 @@ void EffectGraphVisitor::VisitInlinedFinallyNode(InlinedFinallyNode* node) {
 // Graph printing.
 class FlowGraphPrinter : public FlowGraphVisitor {
  public:
+  // The phase, if not NULL, is printed after the function name.
   FlowGraphPrinter(const Function& function,
-                   const GrowableArray<BlockEntryInstr*>& block_order)
-      : FlowGraphVisitor(block_order), function_(function) { }
+                   const GrowableArray<BlockEntryInstr*>& block_order,
+                   const char* phase)
+      : FlowGraphVisitor(block_order), function_(function), phase_(phase) { }
 
   virtual ~FlowGraphPrinter() {}
 
@@ -2085,13 +2121,18 @@ class FlowGraphPrinter : public FlowGraphVisitor {
 
  private:
   const Function& function_;
+  const char* phase_;
 
   DISALLOW_COPY_AND_ASSIGN(FlowGraphPrinter);
 };
 
 
 void FlowGraphPrinter::VisitBlocks() {
-  OS::Print("==== %s\n", function_.ToFullyQualifiedCString());
+  if (phase_ == NULL) {
+    OS::Print("==== %s\n", function_.ToFullyQualifiedCString());
+  } else {
+    OS::Print("==== %s (%s)\n", function_.ToFullyQualifiedCString(), phase_);
+  }
 
   for (intptr_t i = 0; i < block_order_.length(); ++i) {
     // Print the block entry.
@@ -2199,13 +2240,20 @@ void FlowGraphPrinter::VisitStaticCall(StaticCallComp* comp) {
 
 
 void FlowGraphPrinter::VisitLoadLocal(LoadLocalComp* comp) {
-  OS::Print("LoadLocal(%s lvl:%d)",
-      comp->local().name().ToCString(), comp->context_level());
+  OS::Print("LoadLocal(%s", comp->local().name().ToCString());
+  if (comp->ssa_index() >= 0) {
+    OS::Print(":v%d", comp->ssa_index());
+  }
+  OS::Print(" lvl:%d)", comp->context_level());
 }
 
 
 void FlowGraphPrinter::VisitStoreLocal(StoreLocalComp* comp) {
-  OS::Print("StoreLocal(%s, ", comp->local().name().ToCString());
+  OS::Print("StoreLocal(%s", comp->local().name().ToCString());
+  if (comp->ssa_index() >= 0) {
+    OS::Print(":v%d", comp->ssa_index());
+  }
+  OS::Print(", ");
   comp->value()->Accept(this);
   OS::Print(", lvl: %d)", comp->context_level());
 }
@@ -2346,6 +2394,13 @@ void FlowGraphPrinter::VisitNativeLoadField(NativeLoadFieldComp* comp) {
 }
 
 
+void FlowGraphPrinter::VisitLoadClass(LoadClassComp* comp) {
+  OS::Print("LoadClass(");
+  comp->object()->Accept(this);
+  OS::Print(")");
+}
+
+
 void FlowGraphPrinter::VisitInstantiateTypeArguments(
     InstantiateTypeArgumentsComp* comp) {
   const String& type_args = String::Handle(comp->type_arguments().Name());
@@ -2409,6 +2464,24 @@ void FlowGraphPrinter::VisitStoreContext(StoreContextComp* comp) {
 
 void FlowGraphPrinter::VisitJoinEntry(JoinEntryInstr* instr) {
   OS::Print("%2d: [join]", reverse_index(instr->postorder_number()));
+  ZoneGrowableArray<PhiInstr*>* phis = instr->phis();
+  if (phis != NULL) {
+    for (intptr_t i = 0; i < phis->length(); ++i) {
+      OS::Print("\n");
+      (*phis)[i]->Accept(this);
+    }
+  }
+}
+
+
+void FlowGraphPrinter::VisitPhi(PhiInstr* instr) {
+  OS::Print("    %s:v%d <- phi(",
+            instr->local().name().ToCString(), instr->ssa_index());
+  for (intptr_t i = 0; i < instr->InputVersionCount(); ++i) {
+    if (i > 0) OS::Print(", ");
+    OS::Print("v%d", instr->InputVersionAt(i));
+  }
+  OS::Print(")");
 }
 
 
@@ -2484,12 +2557,20 @@ void FlowGraphBuilder::BuildGraph(bool for_optimized) {
   Isolate* isolate = Isolate::Current();
   const intptr_t prev_cid = isolate->computation_id();
   isolate->set_computation_id(0);
-  const Function& function = parsed_function().function();
   EffectGraphVisitor for_effect(this, 0);
   for_effect.AddInstruction(new TargetEntryInstr());
   parsed_function().node_sequence()->Visit(&for_effect);
   // Check that the graph is properly terminated.
   ASSERT(!for_effect.is_open());
+  if (for_optimized && FLAG_use_inlining) {
+    // Inline before the blocks are discovered, the inliner adds blocks.
+    FlowGraphInliner inliner(this);
+    inliner.InlineCalls(for_effect.entry());
+    for (intptr_t i = 0; i < catch_entries_.length(); i++) {
+      inliner.InlineCalls(catch_entries_[i]);
+    }
+    inliner.Finish();
+  }
   GrowableArray<intptr_t> parent;
   for (intptr_t i = 0; i < catch_entries_.length(); i++) {
     Instruction* entry = catch_entries_[i];
@@ -2512,19 +2593,54 @@ void FlowGraphBuilder::BuildGraph(bool for_optimized) {
       ComputeDominators(&preorder_block_entries_, &parent);
     }
   }
+  // Catch entries are additional roots of the graph, which SSA
+  // construction does not handle.
+  bool is_optimized_ssa = false;
+  if (for_optimized &&
+      FLAG_use_ssa &&
+      (for_effect.entry() != NULL) &&
+      catch_entries_.is_empty() &&
+      ComputeSSA()) {
+    if (FLAG_print_flow_graph) {
+      PrintFlowGraph("before optimization");
+    }
+    // The optimizer creates instructions, so it runs before the
+    // computation id is restored.
+    FlowGraphOptimizer optimizer(*this);
+    optimizer.Optimize();
+    is_optimized_ssa = true;
+  }
   isolate->set_computation_id(prev_cid);
   if (FLAG_print_flow_graph) {
-    intptr_t length = postorder_block_entries_.length();
-    GrowableArray<BlockEntryInstr*> reverse_postorder(length);
-    for (intptr_t i = length - 1; i >= 0; --i) {
-      reverse_postorder.Add(postorder_block_entries_[i]);
-    }
-    FlowGraphPrinter printer(function, reverse_postorder);
-    printer.VisitBlocks();
+    PrintFlowGraph(is_optimized_ssa ? "after optimization" : NULL);
   }
 }
 
 
+TargetEntryInstr* FlowGraphBuilder::BuildInlinedGraph(intptr_t temp_index) {
+  is_inlining_ = true;
+  TargetEntryInstr* entry = new TargetEntryInstr();
+  EffectGraphVisitor for_effect(this, temp_index);
+  for_effect.AddInstruction(entry);
+  parsed_function().node_sequence()->Visit(&for_effect);
+  ASSERT(!for_effect.is_open());
+  return entry;
+}
+
+
+void FlowGraphBuilder::PrintFlowGraph(const char* phase) const {
+  intptr_t length = postorder_block_entries_.length();
+  GrowableArray<BlockEntryInstr*> reverse_postorder(length);
+  for (intptr_t i = length - 1; i >= 0; --i) {
+    reverse_postorder.Add(postorder_block_entries_[i]);
+  }
+  FlowGraphPrinter printer(parsed_function().function(),
+                           reverse_postorder,
+                           phase);
+  printer.VisitBlocks();
+}
+
+
 void FlowGraphBuilder::ComputeDominators(
     GrowableArray<BlockEntryInstr*>* preorder,
     GrowableArray<intptr_t>* parent) {
@@ -2612,6 +2728,223 @@ void FlowGraphBuilder::CompressPath(intptr_t start_index,
 }
 
 
+// Put the locals of the graph in SSA form.  Temporaries are already
+// defined and used exactly once, but a local can be stored any number of
+// times.  Each StoreLocal and each phi defines a new version of its local,
+// and each LoadLocal and phi input is annotated with the version reaching
+// it.  Phis are placed on the iterated dominance frontiers of the stores
+// as in Cytron et al., "Efficiently Computing Static Single Assignment
+// Form and the Control Dependence Graph".  Captured locals live in the
+// context and are not renamed.  Requires dominators.  Returns false,
+// without changing the graph, if it contains temporaries that are not in
+// SSA form, i.e., PickTemp and TuckTemp.
+bool FlowGraphBuilder::ComputeSSA() {
+  const intptr_t block_count = preorder_block_entries_.length();
+
+  // 1. Collect the renamed locals and, for each of them, the preorder
+  // numbers of the blocks storing to it.
+  GrowableArray<ZoneGrowableArray<intptr_t>*> stores;
+  for (intptr_t i = 0; i < block_count; ++i) {
+    BlockEntryInstr* block = preorder_block_entries_[i];
+    for (Instruction* current = block->NextInBlock();
+         current != NULL;
+         current = current->NextInBlock()) {
+      if (current->IsPickTemp() || current->IsTuckTemp()) return false;
+      Computation* comp = current->computation();
+      if (comp == NULL) continue;
+      const LocalVariable* local = NULL;
+      if (comp->IsLoadLocal()) {
+        local = &comp->AsLoadLocal()->local();
+      } else if (comp->IsStoreLocal()) {
+        local = &comp->AsStoreLocal()->local();
+      }
+      if ((local == NULL) || local->is_captured()) continue;
+      intptr_t index = SSAVariableIndex(*local);
+      if (index < 0) {
+        index = ssa_variables_.length();
+        ssa_variables_.Add(local);
+        stores.Add(new ZoneGrowableArray<intptr_t>());
+      }
+      if (comp->IsStoreLocal() &&
+          (stores[index]->is_empty() || (stores[index]->Last() != i))) {
+        stores[index]->Add(i);
+      }
+    }
+  }
+
+  // 2. Record the dominator tree.
+  for (intptr_t i = 1; i < block_count; ++i) {
+    BlockEntryInstr* block = preorder_block_entries_[i];
+    block->dominator()->AddDominatedBlock(block);
+  }
+
+  // 3. Insert phis.
+  GrowableArray<ZoneGrowableArray<intptr_t>*> frontiers(block_count);
+  ComputeDominanceFrontiers(&frontiers);
+  InsertPhis(frontiers, stores);
+
+  // 4. Rename.  The initial versions of the locals are their values on
+  // entry.
+  GrowableArray<intptr_t> env(ssa_variables_.length());
+  for (intptr_t i = 0; i < ssa_variables_.length(); ++i) {
+    env.Add(NewSSAVersion(i));
+  }
+  RenameVariables(preorder_block_entries_[0], &env);
+  return true;
+}
+
+
+// Compute the dominance frontier of each block as a list of preorder block
+// numbers, using the algorithm of Cooper, Harvey, and Kennedy's "A Simple,
+// Fast Dominance Algorithm": a join is in the frontier of each block on
+// the dominator tree paths from its predecessors up to (but excluding) its
+// immediate dominator.
+void FlowGraphBuilder::ComputeDominanceFrontiers(
+    GrowableArray<ZoneGrowableArray<intptr_t>*>* frontiers) {
+  const intptr_t block_count = preorder_block_entries_.length();
+  for (intptr_t i = 0; i < block_count; ++i) {
+    frontiers->Add(new ZoneGrowableArray<intptr_t>());
+  }
+  for (intptr_t block_index = 0; block_index < block_count; ++block_index) {
+    BlockEntryInstr* block = preorder_block_entries_[block_index];
+    if (block->PredecessorCount() < 2) continue;
+    for (intptr_t i = 0; i < block->PredecessorCount(); ++i) {
+      BlockEntryInstr* runner = block->PredecessorAt(i);
+      while (runner != block->dominator()) {
+        // Joins are handled one at a time, so a duplicate is always last.
+        ZoneGrowableArray<intptr_t>* frontier =
+            (*frontiers)[runner->preorder_number()];
+        if (frontier->is_empty() || (frontier->Last() != block_index)) {
+          frontier->Add(block_index);
+        }
+        runner = runner->dominator();
+      }
+    }
+  }
+}
+
+
+void FlowGraphBuilder::InsertPhis(
+    const GrowableArray<ZoneGrowableArray<intptr_t>*>& frontiers,
+    const GrowableArray<ZoneGrowableArray<intptr_t>*>& stores) {
+  // Both arrays map preorder block numbers to the last local for which the
+  // block got a phi and for which it was added to the worklist.
+  const intptr_t block_count = preorder_block_entries_.length();
+  GrowableArray<intptr_t> has_phi(block_count);
+  GrowableArray<intptr_t> has_work(block_count);
+  for (intptr_t i = 0; i < block_count; ++i) {
+    has_phi.Add(-1);
+    has_work.Add(-1);
+  }
+  GrowableArray<intptr_t> worklist;
+  for (intptr_t var = 0; var < ssa_variables_.length(); ++var) {
+    for (intptr_t i = 0; i < stores[var]->length(); ++i) {
+      intptr_t block_index = (*stores[var])[i];
+      has_work[block_index] = var;
+      worklist.Add(block_index);
+    }
+    while (!worklist.is_empty()) {
+      ZoneGrowableArray<intptr_t>* frontier = frontiers[worklist.Last()];
+      worklist.RemoveLast();
+      for (intptr_t i = 0; i < frontier->length(); ++i) {
+        intptr_t block_index = (*frontier)[i];
+        if (has_phi[block_index] == var) continue;
+        has_phi[block_index] = var;
+        // Only joins have several predecessors.
+        JoinEntryInstr* join =
+            preorder_block_entries_[block_index]->AsJoinEntry();
+        ASSERT(join != NULL);
+        join->InsertPhi(
+            new PhiInstr(*ssa_variables_[var], join->PredecessorCount()));
+        if (has_work[block_index] != var) {
+          has_work[block_index] = var;
+          worklist.Add(block_index);
+        }
+      }
+    }
+  }
+}
+
+
+// Rename the locals in the dominator subtree rooted at the block.  The
+// environment maps each local to its current version and is updated by
+// the block.
+void FlowGraphBuilder::RenameVariables(BlockEntryInstr* block,
+                                       GrowableArray<intptr_t>* env) {
+  JoinEntryInstr* join = block->AsJoinEntry();
+  if ((join != NULL) && (join->phis() != NULL)) {
+    ZoneGrowableArray<PhiInstr*>* phis = join->phis();
+    for (intptr_t i = 0; i < phis->length(); ++i) {
+      PhiInstr* phi = (*phis)[i];
+      intptr_t var = SSAVariableIndex(phi->local());
+      phi->set_ssa_index(NewSSAVersion(var));
+      (*env)[var] = phi->ssa_index();
+    }
+  }
+
+  for (Instruction* current = block->NextInBlock();
+       current != NULL;
+       current = current->NextInBlock()) {
+    if (current->IsBind()) {
+      current->AsBind()->set_ssa_temp_index(ssa_temp_count_++);
+    }
+    Computation* comp = current->computation();
+    if (comp == NULL) continue;
+    LoadLocalComp* load = comp->AsLoadLocal();
+    if ((load != NULL) && !load->local().is_captured()) {
+      load->set_ssa_index((*env)[SSAVariableIndex(load->local())]);
+    }
+    StoreLocalComp* store = comp->AsStoreLocal();
+    if ((store != NULL) && !store->local().is_captured()) {
+      intptr_t var = SSAVariableIndex(store->local());
+      store->set_ssa_index(NewSSAVersion(var));
+      (*env)[var] = store->ssa_index();
+    }
+  }
+
+  // Fill in the inputs of the successors' phis for the edges from this
+  // block.
+  for (intptr_t i = 0; i < block->SuccessorCount(); ++i) {
+    BlockEntryInstr* successor = block->SuccessorAt(i);
+    JoinEntryInstr* successor_join = successor->AsJoinEntry();
+    if ((successor_join == NULL) || (successor_join->phis() == NULL)) continue;
+    intptr_t pred_index = successor_join->IndexOfPredecessor(block);
+    ZoneGrowableArray<PhiInstr*>* phis = successor_join->phis();
+    for (intptr_t j = 0; j < phis->length(); ++j) {
+      PhiInstr* phi = (*phis)[j];
+      phi->SetInputVersionAt(pred_index,
+                             (*env)[SSAVariableIndex(phi->local())]);
+    }
+  }
+
+  // Each child in the dominator tree starts from this block's environment.
+  const GrowableArray<BlockEntryInstr*>& children = block->dominated_blocks();
+  for (intptr_t i = 0; i < children.length(); ++i) {
+    GrowableArray<intptr_t> child_env(env->length());
+    for (intptr_t j = 0; j < env->length(); ++j) {
+      child_env.Add((*env)[j]);
+    }
+    RenameVariables(children[i], &child_env);
+  }
+}
+
+
+// Locals are identified by their frame slot: locals of sibling scopes, and
+// the parameters of the functions inlined at a call, share a slot.
+intptr_t FlowGraphBuilder::SSAVariableIndex(const LocalVariable& local) const {
+  for (intptr_t i = 0; i < ssa_variables_.length(); ++i) {
+    if (ssa_variables_[i]->index() == local.index()) return i;
+  }
+  return -1;
+}
+
+
+intptr_t FlowGraphBuilder::NewSSAVersion(intptr_t variable_index) {
+  ssa_version_variables_.Add(variable_index);
+  return ssa_version_variables_.length() - 1;
+}
+
+
 void FlowGraphBuilder::Bailout(const char* reason) {
   const char* kFormat = "FlowGraphBuilder Bailout: %s %s";
   const char* function_name = parsed_function_.function().ToCString();
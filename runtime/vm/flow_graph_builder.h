@@ -13,6 +13,7 @@
 namespace dart {
 
 class Instruction;
+class LocalVariable;
 class ParsedFunction;
 
 // Build a flow graph from a parsed function's AST.
@@ -22,12 +23,33 @@ class FlowGraphBuilder: public ValueObject {
 
   void BuildGraph(bool for_optimized);
 
+  // Build the graph of a function inlined at a call (see FlowGraphInliner).
+  // The graph starts with a target entry, and its temporaries are numbered
+  // from temp_index.  The returns are left open and recorded with their
+  // value, for the inliner to continue them after the call.
+  TargetEntryInstr* BuildInlinedGraph(intptr_t temp_index);
+
   const ParsedFunction& parsed_function() const { return parsed_function_; }
 
+  const GrowableArray<BlockEntryInstr*>& preorder_block_entries() const {
+    return preorder_block_entries_;
+  }
   const GrowableArray<BlockEntryInstr*>& postorder_block_entries() const {
     return postorder_block_entries_;
   }
 
+  // SSA form, only computed for optimized compilation with --use_ssa.
+  // The renamed locals, and for each SSA version the index of its local in
+  // ssa_variables().  Versions 0 to n-1 are the values of the n locals on
+  // entry to the function.
+  const GrowableArray<const LocalVariable*>& ssa_variables() const {
+    return ssa_variables_;
+  }
+  const GrowableArray<intptr_t>& ssa_version_variables() const {
+    return ssa_version_variables_;
+  }
+  intptr_t ssa_temp_count() const { return ssa_temp_count_; }
+
   void Bailout(const char* reason);
 
   void set_context_level(intptr_t value) { context_level_ = value; }
@@ -42,6 +64,22 @@ class FlowGraphBuilder: public ValueObject {
 
   void AddCatchEntry(intptr_t try_index, Instruction* entry);
 
+  bool is_inlining() const { return is_inlining_; }
+  void AddInlinedReturn(Instruction* exit, Value* value);
+  const GrowableArray<Instruction*>& inlined_exits() const {
+    return inlined_exits_;
+  }
+  const GrowableArray<Value*>& inlined_return_values() const {
+    return inlined_return_values_;
+  }
+
+  // The number of frame slots, after the locals of this function, holding
+  // the parameters and locals of the functions inlined into it.
+  intptr_t inlined_local_count() const { return inlined_local_count_; }
+  void set_inlined_local_count(intptr_t value) {
+    inlined_local_count_ = value;
+  }
+
  private:
   void ComputeDominators(GrowableArray<BlockEntryInstr*>* preorder,
                          GrowableArray<intptr_t>* parent);
@@ -50,6 +88,17 @@ class FlowGraphBuilder: public ValueObject {
                     GrowableArray<intptr_t>* parent,
                     GrowableArray<intptr_t>* label);
 
+  bool ComputeSSA();
+  void ComputeDominanceFrontiers(
+      GrowableArray<ZoneGrowableArray<intptr_t>*>* frontiers);
+  void InsertPhis(const GrowableArray<ZoneGrowableArray<intptr_t>*>& frontiers,
+                  const GrowableArray<ZoneGrowableArray<intptr_t>*>& stores);
+  void RenameVariables(BlockEntryInstr* block, GrowableArray<intptr_t>* env);
+  intptr_t SSAVariableIndex(const LocalVariable& local) const;
+  intptr_t NewSSAVersion(intptr_t variable_index);
+
+  void PrintFlowGraph(const char* phase) const;
+
   const ParsedFunction& parsed_function_;
   GrowableArray<BlockEntryInstr*> preorder_block_entries_;
   GrowableArray<BlockEntryInstr*> postorder_block_entries_;
@@ -57,6 +106,13 @@ class FlowGraphBuilder: public ValueObject {
   intptr_t last_used_try_index_;
   intptr_t try_index_;
   GrowableArray<Instruction*> catch_entries_;
+  GrowableArray<const LocalVariable*> ssa_variables_;
+  GrowableArray<intptr_t> ssa_version_variables_;
+  intptr_t ssa_temp_count_;
+  bool is_inlining_;
+  GrowableArray<Instruction*> inlined_exits_;
+  GrowableArray<Value*> inlined_return_values_;
+  intptr_t inlined_local_count_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(FlowGraphBuilder);
 };
@@ -108,8 +164,10 @@ class EffectGraphVisitor : public AstNodeVisitor {
 
   // Append a 'while loop' test and back edge to this graph, depending on
   // which parts are reachable.  Afterward, the graph exit is the false
-  // successor of the loop condition.
-  void TieLoop(const TestGraphVisitor& test_fragment,
+  // successor of the loop condition.  The target of the back edge is
+  // marked with 'loop_id'.
+  void TieLoop(intptr_t loop_id,
+               const TestGraphVisitor& test_fragment,
                const EffectGraphVisitor& body_fragment);
 
  protected:
@@ -35,6 +35,8 @@ class FlowGraphCompiler : public FlowGraphVisitor {
 
   void CompileGraph();
 
+  void set_inlined_local_count(intptr_t count) { }
+
   // Infrastructure copied from class CodeGenerator or stubbed out.
   void FinalizePcDescriptors(const Code& code);
   void FinalizeStackmaps(const Code& code);
@@ -13,6 +13,7 @@
 #include "vm/code_generator.h"
 #include "vm/debugger.h"
 #include "vm/disassembler.h"
+#include "vm/flow_graph_allocator.h"
 #include "vm/intrinsifier.h"
 #include "vm/longjump.h"
 #include "vm/object_store.h"
@@ -25,9 +26,18 @@ DEFINE_FLAG(bool, print_scopes, false, "Print scopes of local variables.");
 DEFINE_FLAG(bool, trace_functions, false, "Trace entry of each function.");
 DECLARE_FLAG(bool, enable_type_checks);
 DECLARE_FLAG(bool, intrinsify);
-DECLARE_FLAG(bool, optimization_counter_threshold);
+DECLARE_FLAG(int, optimization_counter_threshold);
+DECLARE_FLAG(bool, use_osr);
 DECLARE_FLAG(bool, print_ast);
 DECLARE_FLAG(bool, report_usage_count);
+DECLARE_FLAG(bool, use_linear_scan);
+
+
+// Registers that the code for an instruction only clobbers if it calls out.
+static const Register kAllocatableRegisters[] =
+    { RSI, RDI, R8, R9, R12, R13, R14 };
+static const intptr_t kNumberOfAllocatableRegisters =
+    ARRAY_SIZE(kAllocatableRegisters);
 
 
 FlowGraphCompiler::FlowGraphCompiler(
@@ -42,7 +52,9 @@ FlowGraphCompiler::FlowGraphCompiler(
       current_block_(NULL),
       pc_descriptors_list_(NULL),
       exception_handlers_list_(NULL),
-      is_optimizing_(is_optimizing) {
+      stackmap_builder_(NULL),
+      is_optimizing_(is_optimizing),
+      inlined_local_count_(0) {
 }
 
 
@@ -68,7 +80,8 @@ FlowGraphCompiler::~FlowGraphCompiler() {
 
 intptr_t FlowGraphCompiler::StackSize() const {
   return parsed_function_.stack_local_count() +
-      parsed_function_.copied_parameter_count();
+      parsed_function_.copied_parameter_count() +
+      inlined_local_count_;
 }
 
 
@@ -366,7 +379,12 @@ void FlowGraphCompiler::LoadValue(Register dst, Value* value) {
     }
   } else {
     ASSERT(value->IsUse());
-    __ popq(dst);
+    const intptr_t index = value->AsUse()->definition()->register_index();
+    if (index < 0) {
+      __ popq(dst);
+    } else if (kAllocatableRegisters[index] != dst) {
+      __ movq(dst, kAllocatableRegisters[index]);
+    }
   }
 }
 
@@ -479,6 +497,7 @@ void FlowGraphCompiler::EmitInstanceCall(intptr_t cid,
   ExternalLabel target_label("InlineCache", label_address);
   __ call(&target_label);
   AddCurrentDescriptor(PcDescriptors::kIcCall, cid, token_index, try_index);
+  RecordSafepoint();
   __ addq(RSP, Immediate(argument_count * kWordSize));
 }
 
@@ -917,15 +936,16 @@ void FlowGraphCompiler::VisitCreateArray(CreateArrayComp* comp) {
                &StubCode::AllocateArrayLabel(),
                PcDescriptors::kOther);
 
-  // 2. Initialize the array in RAX with the element values.
-  __ leaq(RCX, FieldAddress(RAX, Array::data_offset()));
+  // 2. Initialize the array in RAX with the element values. The array may
+  // have been allocated in old space, hence the stores need a write barrier.
   for (int i = comp->ElementCount() - 1; i >= 0; --i) {
     if (comp->ElementAt(i)->IsUse()) {
-      __ popq(Address(RCX, i * kWordSize));
+      __ popq(RDX);
     } else {
       LoadValue(RDX, comp->ElementAt(i));
-      __ movq(Address(RCX, i * kWordSize), RDX);
     }
+    __ StoreIntoObject(
+        RAX, FieldAddress(RAX, Array::data_offset() + i * kWordSize), RDX);
   }
 }
 
@@ -954,6 +974,19 @@ void FlowGraphCompiler::VisitNativeLoadField(NativeLoadFieldComp* comp) {
 }
 
 
+void FlowGraphCompiler::VisitLoadClass(LoadClassComp* comp) {
+  LoadValue(RAX, comp->object());
+  Label load_smi_class, done;
+  __ testq(RAX, Immediate(kSmiTagMask));
+  __ j(ZERO, &load_smi_class, Assembler::kNearJump);
+  __ movq(RAX, FieldAddress(RAX, Object::class_offset()));
+  __ jmp(&done, Assembler::kNearJump);
+  __ Bind(&load_smi_class);
+  __ LoadObject(RAX, Class::ZoneHandle(Smi::Class()));
+  __ Bind(&done);
+}
+
+
 void FlowGraphCompiler::VisitInstantiateTypeArguments(
     InstantiateTypeArgumentsComp* comp) {
   __ popq(RAX);  // Instantiator.
@@ -1178,6 +1211,42 @@ void FlowGraphCompiler::VisitBlocks() {
 
 void FlowGraphCompiler::VisitJoinEntry(JoinEntryInstr* instr) {
   __ Bind(&block_info_[instr->postorder_number()]->label);
+  if (FLAG_use_osr && (instr->loop_id() != AstNode::kNoId)) {
+    EmitLoopHeaderCheck(instr->loop_id());
+  }
+}
+
+
+// The loop header is entered by the back edges of the loop and by the
+// code before it, with an empty expression stack.  Unoptimized code counts
+// the iterations in the usage counter of the function, and optimized code
+// records where unoptimized code continues after on-stack replacement.
+void FlowGraphCompiler::EmitLoopHeaderCheck(intptr_t loop_id) {
+  if (is_optimizing()) {
+    // Unoptimized code cannot continue here if the frame has slots for
+    // inlined functions.
+    if (inlined_local_count_ > 0) return;
+    AddCurrentDescriptor(PcDescriptors::kOsrEntry,
+                         loop_id,
+                         0,  // No token index.
+                         CatchClauseNode::kInvalidTryIndex);
+    return;
+  }
+  if (!CodeGenerator::CanOptimize()) return;
+  const Function& function =
+        Function::ZoneHandle(parsed_function_.function().raw());
+  __ LoadObject(RCX, function);
+  __ incq(FieldAddress(RCX, Function::usage_counter_offset()));
+  __ cmpl(FieldAddress(RCX, Function::usage_counter_offset()),
+      Immediate(FLAG_optimization_counter_threshold));
+  Label not_yet_hot;
+  __ j(LESS_EQUAL, &not_yet_hot, Assembler::kNearJump);
+  // May return to the optimized code of the function instead.
+  GenerateCallRuntime(loop_id,
+                      0,  // No token index.
+                      CatchClauseNode::kInvalidTryIndex,
+                      kOnStackReplacementRuntimeEntry);
+  __ Bind(&not_yet_hot);
 }
 
 
@@ -1190,6 +1259,13 @@ void FlowGraphCompiler::VisitTargetEntry(TargetEntryInstr* instr) {
 }
 
 
+void FlowGraphCompiler::VisitPhi(PhiInstr* instr) {
+  // Phis are only used by the optimizer and are not part of the
+  // instruction list.
+  UNREACHABLE();
+}
+
+
 void FlowGraphCompiler::VisitPickTemp(PickTempInstr* instr) {
   // Semantics is to copy a stack-allocated temporary to the top of stack.
   // Destination index d is assumed the new top of stack after the
@@ -1219,7 +1295,11 @@ void FlowGraphCompiler::VisitDo(DoInstr* instr) {
 
 void FlowGraphCompiler::VisitBind(BindInstr* instr) {
   instr->computation()->Accept(this);
-  __ pushq(RAX);
+  if (instr->register_index() < 0) {
+    __ pushq(RAX);
+  } else {
+    __ movq(kAllocatableRegisters[instr->register_index()], RAX);
+  }
 }
 
 
@@ -1596,7 +1676,9 @@ void FlowGraphCompiler::CompileGraph() {
 
   const int parameter_count = function.num_fixed_parameters();
   const int num_copied_params = parsed_function_.copied_parameter_count();
-  const int local_count = parsed_function_.stack_local_count();
+  // Slots of inlined functions follow the locals.
+  const int local_count =
+      parsed_function_.stack_local_count() + inlined_local_count_;
   __ EnterFrame(StackSize() * kWordSize);
 
   // We check the number of passed arguments when we have to copy them due to
@@ -1661,6 +1743,18 @@ void FlowGraphCompiler::CompileGraph() {
     AstPrinter::PrintFunctionScope(parsed_function_);
   }
 
+  if (is_optimizing() && FLAG_use_linear_scan) {
+    FlowGraphAllocator allocator(block_order_, kNumberOfAllocatableRegisters);
+    allocator.AllocateRegisters();
+    // Values in registers are never live across a call, and the
+    // expression stack below the locals only holds objects.  Describe the
+    // locals at each safepoint.
+    if (StackSize() > 0) {
+      stackmap_builder_ = new StackmapBuilder();
+      stackmap_builder_->SetSlotRangeAsObject(0, StackSize() - 1);
+    }
+  }
+
   VisitBlocks();
 
   __ int3();
@@ -1682,6 +1776,7 @@ void FlowGraphCompiler::GenerateCall(intptr_t token_index,
                                      PcDescriptors::Kind kind) {
   __ call(label);
   AddCurrentDescriptor(kind, AstNode::kNoId, token_index, try_index);
+  RecordSafepoint();
 }
 
 
@@ -1691,6 +1786,15 @@ void FlowGraphCompiler::GenerateCallRuntime(intptr_t cid,
                                             const RuntimeEntry& entry) {
   __ CallRuntime(entry);
   AddCurrentDescriptor(PcDescriptors::kOther, cid, token_index, try_index);
+  RecordSafepoint();
+}
+
+
+// Record the stack map for the return address of the call just emitted.
+void FlowGraphCompiler::RecordSafepoint() {
+  if (stackmap_builder_ != NULL) {
+    stackmap_builder_->AddEntry(assembler_->CodeSize());
+  }
 }
 
 
@@ -1717,8 +1821,12 @@ void FlowGraphCompiler::FinalizePcDescriptors(const Code& code) {
 
 
 void FlowGraphCompiler::FinalizeStackmaps(const Code& code) {
-  // TODO(srdjan): Compute stack maps for optimizing compiler.
-  code.set_stackmaps(Array::Handle());
+  if (stackmap_builder_ == NULL) {
+    // The GC visits all slots of the frame as tagged objects.
+    code.set_stackmaps(Array::Handle());
+  } else {
+    stackmap_builder_->FinalizeStackmaps(code);
+  }
 }
 
 
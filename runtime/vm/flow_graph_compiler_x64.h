@@ -32,6 +32,11 @@ class FlowGraphCompiler : public FlowGraphVisitor {
 
   void CompileGraph();
 
+  // Frame slots after the locals, used by inlined functions.
+  void set_inlined_local_count(intptr_t count) {
+    inlined_local_count_ = count;
+  }
+
   // Infrastructure copied from class CodeGenerator or stubbed out.
   void FinalizePcDescriptors(const Code& code);
   void FinalizeStackmaps(const Code& code);
@@ -105,6 +110,10 @@ class FlowGraphCompiler : public FlowGraphVisitor {
                             intptr_t cid,
                             intptr_t token_index,
                             intptr_t try_index);
+  void RecordSafepoint();
+
+  // Count loop iterations or record the entry for on-stack replacement.
+  void EmitLoopHeaderCheck(intptr_t loop_id);
 
   void GenerateInlineInstanceof(const AbstractType& type,
                                 Label* is_instance,
@@ -141,7 +150,9 @@ class FlowGraphCompiler : public FlowGraphVisitor {
   BlockEntryInstr* current_block_;
   DescriptorList* pc_descriptors_list_;
   ExceptionHandlerList* exception_handlers_list_;
+  StackmapBuilder* stackmap_builder_;
   const bool is_optimizing_;
+  intptr_t inlined_local_count_;
 
   DISALLOW_COPY_AND_ASSIGN(FlowGraphCompiler);
 };
@@ -0,0 +1,480 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/flow_graph_inliner.h"
+
+#include "vm/ast.h"
+#include "vm/compiler.h"
+#include "vm/compiler_stats.h"
+#include "vm/flags.h"
+#include "vm/flow_graph_builder.h"
+#include "vm/intermediate_language.h"
+#include "vm/isolate.h"
+#include "vm/object.h"
+#include "vm/os.h"
+#include "vm/parser.h"
+#include "vm/scopes.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool, use_inlining, false,
+    "Inline small functions at their calls in optimized code.");
+DEFINE_FLAG(int, inlining_size_threshold, 25,
+    "Only inline functions with at most this many AST nodes.");
+DEFINE_FLAG(int, inlining_depth_threshold, 3,
+    "Only inline calls nested at most this deep in inlined functions.");
+DEFINE_FLAG(bool, trace_inlining, false, "Trace inlining decisions.");
+DECLARE_FLAG(bool, compiler_stats);
+
+// An instance call with more receiver classes is not inlined.
+static const intptr_t kMaxInlinedReceiverClasses = 4;
+
+
+FlowGraphInliner::FlowGraphInliner(FlowGraphBuilder* builder)
+    : builder_(builder),
+      depth_(0),
+      first_frame_index_(builder->parsed_function().first_stack_local_index() -
+                         builder->parsed_function().stack_local_count()),
+      next_frame_index_(first_frame_index_),
+      inlined_functions_(),
+      inlined_count_(0),
+      rejected_count_(0) {
+  inlined_functions_.Add(&builder->parsed_function().function());
+}
+
+
+static void AddUnvisited(Instruction* block,
+                         GrowableArray<Instruction*>* visited,
+                         GrowableArray<Instruction*>* worklist) {
+  for (intptr_t i = 0; i < visited->length(); ++i) {
+    if ((*visited)[i] == block) {
+      return;
+    }
+  }
+  visited->Add(block);
+  worklist->Add(block);
+}
+
+
+// The blocks are not discovered yet: follow the successors from the entry.
+void FlowGraphInliner::CollectCalls(
+    Instruction* entry,
+    GrowableArray<Instruction*>* previous,
+    GrowableArray<Instruction*>* calls) const {
+  GrowableArray<Instruction*> visited;
+  GrowableArray<Instruction*> worklist;
+  AddUnvisited(entry, &visited, &worklist);
+  while (!worklist.is_empty()) {
+    Instruction* prev = worklist.Last();
+    worklist.RemoveLast();
+    Instruction* current = prev->StraightLineSuccessor();
+    while ((current != NULL) && !current->IsBlockEntry()) {
+      Computation* comp = current->computation();
+      if ((comp != NULL) && (comp->IsInstanceCall() || comp->IsStaticCall())) {
+        previous->Add(prev);
+        calls->Add(current);
+      }
+      prev = current;
+      current = current->StraightLineSuccessor();
+    }
+    if (current != NULL) {
+      AddUnvisited(current, &visited, &worklist);
+    } else if (prev->IsBranch()) {
+      AddUnvisited(prev->AsBranch()->true_successor(), &visited, &worklist);
+      AddUnvisited(prev->AsBranch()->false_successor(), &visited, &worklist);
+    }
+  }
+}
+
+
+void FlowGraphInliner::InlineCalls(Instruction* entry) {
+  GrowableArray<Instruction*> previous;
+  GrowableArray<Instruction*> calls;
+  CollectCalls(entry, &previous, &calls);
+  // Inline the last call first: the instruction before a call may be an
+  // earlier call, which is removed if its value is unused.
+  for (intptr_t i = calls.length() - 1; i >= 0; --i) {
+    TryInlineCall(previous[i], calls[i]);
+  }
+}
+
+
+void FlowGraphInliner::TryInlineCall(Instruction* previous, Instruction* call) {
+  Computation* comp = call->computation();
+  InstanceCallComp* instance_call = comp->AsInstanceCall();
+  StaticCallComp* static_call = comp->AsStaticCall();
+  const intptr_t try_index = (instance_call != NULL) ?
+      instance_call->try_index() : static_call->try_index();
+  const Array& argument_names = (instance_call != NULL) ?
+      instance_call->argument_names() : static_call->argument_names();
+  GrowableArray<const Class*> classes;
+  GrowableArray<const Function*> targets;
+  const char* reason = NULL;
+  if (depth_ >= FLAG_inlining_depth_threshold) {
+    reason = "too deep";
+  } else if (try_index != CatchClauseNode::kInvalidTryIndex) {
+    // The handlers are found by the try index of the call.
+    reason = "in try block";
+  } else if (!argument_names.IsNull()) {
+    reason = "named arguments";
+  } else if (instance_call != NULL) {
+    CollectReceiverTargets(instance_call, &classes, &targets, &reason);
+  } else {
+    classes.Add(NULL);
+    targets.Add(&static_call->function());
+  }
+
+  // The result, then the arguments, in the next frame slots.
+  const intptr_t result_index = next_frame_index_;
+  const intptr_t argument_count = comp->InputCount();
+  const intptr_t temp_index = (argument_count > 0) ?
+      comp->InputAt(0)->AsUse()->definition()->temp_index() :
+      ((call->AsBind() != NULL) ? call->AsBind()->temp_index() : 0);
+  intptr_t frame_end = result_index - 1 - argument_count;
+  GrowableArray<InlinedTarget*> inlined;
+  for (intptr_t i = 0; i < targets.length(); ++i) {
+    InlinedTarget* target = TryInlineTarget(*targets[i],
+                                            argument_count,
+                                            result_index - 1,
+                                            temp_index,
+                                            &reason);
+    if (target != NULL) {
+      target->receiver_class = classes[i];
+      inlined.Add(target);
+      // The targets are inlined on different paths and share the slots.
+      if (next_frame_index_ < frame_end) {
+        frame_end = next_frame_index_;
+      }
+    }
+    next_frame_index_ = result_index;
+  }
+  if (inlined.is_empty()) {
+    ASSERT(reason != NULL);
+    rejected_count_++;
+    Trace(call, reason);
+    return;
+  }
+  // Other receivers of an instance call still call it, see ReplaceCall.
+  const bool keep_call = (instance_call != NULL);
+  ReplaceCall(previous, call, inlined, keep_call, result_index, temp_index);
+  next_frame_index_ = frame_end;
+  inlined_count_++;
+  if (FLAG_trace_inlining) {
+    char message[64];
+    OS::SNPrint(message, sizeof(message),
+                "inlined %d of %d targets", inlined.length(), targets.length());
+    Trace(call, message);
+  }
+}
+
+
+bool FlowGraphInliner::CollectReceiverTargets(
+    InstanceCallComp* call,
+    GrowableArray<const Class*>* classes,
+    GrowableArray<const Function*>* targets,
+    const char** reason) const {
+  const ICData* ic_data = call->ic_data();
+  if ((ic_data == NULL) ||
+      ic_data->IsNull() ||
+      (ic_data->NumberOfChecks() == 0) ||
+      !String::Handle(ic_data->target_name()).Equals(call->function_name())) {
+    *reason = "no type feedback";
+    return false;
+  }
+  GrowableArray<const Class*> check_classes;
+  for (intptr_t i = 0; i < ic_data->NumberOfChecks(); ++i) {
+    Function& target = Function::ZoneHandle();
+    ic_data->GetCheckAt(i, &check_classes, &target);
+    // Checks of other arguments may repeat the receiver class.
+    const Class* receiver_class = check_classes[0];
+    bool is_new = true;
+    for (intptr_t j = 0; j < classes->length(); ++j) {
+      if ((*classes)[j]->raw() == receiver_class->raw()) {
+        is_new = false;
+      }
+    }
+    if (is_new) {
+      classes->Add(receiver_class);
+      targets->Add(&target);
+    }
+  }
+  if (classes->length() > kMaxInlinedReceiverClasses) {
+    classes->Clear();
+    targets->Clear();
+    *reason = "megamorphic";
+    return false;
+  }
+  return true;
+}
+
+
+static bool IsInlinableKind(const Function& function) {
+  switch (function.kind()) {
+    case RawFunction::kFunction:
+    case RawFunction::kGetterFunction:
+    case RawFunction::kSetterFunction:
+    case RawFunction::kImplicitGetter:
+    case RawFunction::kImplicitSetter:
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+FlowGraphInliner::InlinedTarget* FlowGraphInliner::TryInlineTarget(
+    const Function& target,
+    intptr_t argument_count,
+    intptr_t first_frame_index,
+    intptr_t temp_index,
+    const char** reason) {
+  if (!IsInlinableKind(target)) {
+    *reason = "not a function, getter, or setter";
+    return NULL;
+  }
+  if ((target.num_fixed_parameters() != argument_count) ||
+      (target.num_optional_parameters() != 0)) {
+    *reason = "optional parameters";
+    return NULL;
+  }
+  const Code& unoptimized_code = Code::Handle(target.unoptimized_code());
+  if (unoptimized_code.IsNull()) {
+    *reason = "not compiled";
+    return NULL;
+  }
+  for (intptr_t i = 0; i < inlined_functions_.length(); ++i) {
+    if (inlined_functions_[i]->raw() == target.raw()) {
+      *reason = "recursive";
+      return NULL;
+    }
+  }
+
+  ParsedFunction parsed_function(target);
+  Parser::ParseFunction(&parsed_function);
+  GrowableArray<AstNode*> nodes;
+  parsed_function.node_sequence()->CollectAllNodes(&nodes);
+  if (nodes.length() > FLAG_inlining_size_threshold) {
+    *reason = "too big";
+    return NULL;
+  }
+  for (intptr_t i = 0; i < nodes.length(); ++i) {
+    AstNode* node = nodes[i];
+    if (node->IsTryCatchNode()) {
+      *reason = "try block";
+      return NULL;
+    }
+    if (node->IsClosureNode()) {
+      *reason = "closure";
+      return NULL;
+    }
+    if (node->IsNativeBodyNode()) {
+      *reason = "native";
+      return NULL;
+    }
+  }
+  const intptr_t slot_count =
+      parsed_function.AllocateInlinedVariables(first_frame_index);
+  if (slot_count < 0) {
+    *reason = "captured variables";
+    return NULL;
+  }
+
+  // The computation ids of the target continue the ids of the caller.
+  // Shift the type feedback of the target accordingly, unless the caller
+  // does not use type feedback.
+  Isolate* isolate = Isolate::Current();
+  const Array& caller_feedback = Array::Handle(isolate->ic_data_array());
+  if (!caller_feedback.IsNull()) {
+    const Array& feedback = Array::Handle(
+        Compiler::ExtractTypeFeedbackArray(unoptimized_code));
+    const intptr_t first_cid = isolate->computation_id();
+    const Array& shifted =
+        Array::Handle(Array::New(first_cid + feedback.Length()));
+    Object& ic_data = Object::Handle();
+    for (intptr_t i = 0; i < feedback.Length(); ++i) {
+      ic_data = feedback.At(i);
+      shifted.SetAt(first_cid + i, ic_data);
+    }
+    isolate->set_ic_data_array(shifted.raw());
+  }
+  FlowGraphBuilder target_builder(parsed_function);
+  InlinedTarget* result = new InlinedTarget();
+  result->receiver_class = NULL;
+  result->entry = target_builder.BuildInlinedGraph(temp_index);
+  isolate->set_ic_data_array(caller_feedback.raw());
+
+  // The calls in the target use the slots after its locals.
+  inlined_functions_.Add(&target);
+  depth_++;
+  next_frame_index_ = first_frame_index - slot_count;
+  InlineCalls(result->entry);
+  depth_--;
+  inlined_functions_.RemoveLast();
+
+  const intptr_t exit_count = target_builder.inlined_exits().length();
+  result->exits = new ZoneGrowableArray<Instruction*>(exit_count);
+  result->return_values = new ZoneGrowableArray<Value*>(exit_count);
+  for (intptr_t i = 0; i < exit_count; ++i) {
+    result->exits->Add(target_builder.inlined_exits()[i]);
+    result->return_values->Add(target_builder.inlined_return_values()[i]);
+  }
+  return result;
+}
+
+
+static void Append(Instruction** exit, Instruction* instr) {
+  (*exit)->ReplaceSuccessor(instr);
+  *exit = instr;
+}
+
+
+static BindInstr* AppendBind(Instruction** exit,
+                             Computation* comp,
+                             intptr_t temp_index) {
+  BindInstr* bind = new BindInstr(comp);
+  bind->set_temp_index(temp_index);
+  Append(exit, bind);
+  return bind;
+}
+
+
+// Replace
+//
+//   previous; [Bind|Do](Call(a0, ..., an-1)); next
+//
+// by
+//
+//   previous; StoreLocal(an-1) ... StoreLocal(a0);
+//   Branch(StrictCompare(LoadClass(a0), C1)) to body1 or else
+//   ...
+//   Branch(StrictCompare(LoadClass(a0), Ck)) to bodyk or else
+//   Call(LoadLocal(a0), ..., LoadLocal(an-1)); StoreLocal(result);
+//   Join; [Bind(LoadLocal(result))]; next
+//
+// where each body stores its return values in the result and continues at
+// the join.  A static call is replaced by the body of its target.
+//
+// A receiver of another class calls the target instead of deoptimizing:
+// deoptimization only rebuilds the unoptimized frame of the optimized
+// function (see DeoptFrameCopy), which has no frame for an inlined body.
+void FlowGraphInliner::ReplaceCall(Instruction* previous,
+                                   Instruction* call,
+                                   const GrowableArray<InlinedTarget*>& targets,
+                                   bool keep_call,
+                                   intptr_t result_index,
+                                   intptr_t temp_index) {
+  Computation* comp = call->computation();
+  const intptr_t argument_count = comp->InputCount();
+  const Type& dynamic_type = Type::ZoneHandle(Type::DynamicType());
+  LocalVariable* result = new LocalVariable(
+      0,  // Token index.
+      String::ZoneHandle(String::NewSymbol(":inlined_result")),
+      dynamic_type);
+  result->set_index(result_index);
+  // The inlined functions allocate their parameters in the same slots.
+  const String& argument_name =
+      String::ZoneHandle(String::NewSymbol(":inlined_argument"));
+  GrowableArray<LocalVariable*> arguments(argument_count);
+  for (intptr_t i = 0; i < argument_count; ++i) {
+    LocalVariable* argument =
+        new LocalVariable(0, argument_name, dynamic_type);
+    argument->set_index(result_index - 1 - i);
+    arguments.Add(argument);
+  }
+
+  Instruction* exit = previous;
+  for (intptr_t i = argument_count - 1; i >= 0; --i) {
+    Append(&exit, new DoInstr(
+        new StoreLocalComp(*arguments[i], comp->InputAt(i), 0)));
+  }
+  JoinEntryInstr* join = new JoinEntryInstr();
+  for (intptr_t i = 0; i < targets.length(); ++i) {
+    InlinedTarget* target = targets[i];
+    if (target->receiver_class == NULL) {
+      ASSERT(!keep_call);
+      Append(&exit, target->entry->StraightLineSuccessor());
+      exit = NULL;
+    } else {
+      BindInstr* receiver =
+          AppendBind(&exit, new LoadLocalComp(*arguments[0], 0), temp_index);
+      BindInstr* receiver_class = AppendBind(
+          &exit, new LoadClassComp(new UseVal(receiver)), temp_index);
+      BindInstr* expected_class = AppendBind(
+          &exit, new ConstantVal(*target->receiver_class), temp_index + 1);
+      BindInstr* compare = AppendBind(
+          &exit,
+          new StrictCompareComp(Token::kEQ_STRICT,
+                                new UseVal(receiver_class),
+                                new UseVal(expected_class)),
+          temp_index);
+      BranchInstr* branch = new BranchInstr(new UseVal(compare));
+      Append(&exit, branch);
+      *branch->true_successor_address() = target->entry;
+      TargetEntryInstr* other_class = new TargetEntryInstr();
+      *branch->false_successor_address() = other_class;
+      exit = other_class;
+    }
+    for (intptr_t j = 0; j < target->exits->length(); ++j) {
+      Instruction* return_exit = (*target->exits)[j];
+      Append(&return_exit, new DoInstr(
+          new StoreLocalComp(*result, (*target->return_values)[j], 0)));
+      Append(&return_exit, join);
+    }
+  }
+  if (keep_call) {
+    for (intptr_t i = 0; i < argument_count; ++i) {
+      BindInstr* argument = AppendBind(
+          &exit, new LoadLocalComp(*arguments[i], 0), temp_index + i);
+      comp->SetInputAt(i, new UseVal(argument));
+    }
+    BindInstr* value = AppendBind(&exit, comp, temp_index);
+    Append(&exit, new DoInstr(
+        new StoreLocalComp(*result, new UseVal(value), 0)));
+    Append(&exit, join);
+  }
+
+  // The Bind of the call stays in place for its use.
+  BindInstr* bind = call->AsBind();
+  if (bind != NULL) {
+    bind->set_computation(new LoadLocalComp(*result, 0));
+    join->SetSuccessor(bind);
+  } else if (call->StraightLineSuccessor() != NULL) {
+    join->SetSuccessor(call->StraightLineSuccessor());
+  }
+}
+
+
+void FlowGraphInliner::Trace(Instruction* call, const char* message) const {
+  if (!FLAG_trace_inlining) {
+    return;
+  }
+  Computation* comp = call->computation();
+  const char* name = comp->IsInstanceCall() ?
+      comp->AsInstanceCall()->function_name().ToCString() :
+      comp->AsStaticCall()->function().ToCString();
+  OS::Print("%*s'%s' in '%s': %s\n",
+            static_cast<int>(2 * depth_), "",
+            name,
+            inlined_functions_.Last()->ToFullyQualifiedCString(),
+            message);
+}
+
+
+void FlowGraphInliner::Finish() {
+  builder_->set_inlined_local_count(first_frame_index_ - next_frame_index_);
+  if (FLAG_compiler_stats) {
+    CompilerStats::num_inlined_calls += inlined_count_;
+    CompilerStats::num_rejected_inlining_calls += rejected_count_;
+  }
+  if (FLAG_trace_inlining) {
+    OS::Print("Inlining in '%s': %" Pd " calls inlined, %" Pd " rejected, "
+              "%" Pd " frame slots\n",
+              builder_->parsed_function().function().ToFullyQualifiedCString(),
+              inlined_count_,
+              rejected_count_,
+              builder_->inlined_local_count());
+  }
+}
+
+}  // namespace dart
@@ -0,0 +1,105 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef VM_FLOW_GRAPH_INLINER_H_
+#define VM_FLOW_GRAPH_INLINER_H_
+
+#include "vm/allocation.h"
+#include "vm/growable_array.h"
+
+namespace dart {
+
+class Class;
+class FlowGraphBuilder;
+class Function;
+class InstanceCallComp;
+class Instruction;
+class TargetEntryInstr;
+class Value;
+
+// Inline small functions at their calls in the flow graph of a function
+// being compiled to optimized code (see FLAG_use_inlining).  Runs while the
+// graph is built, before its blocks are discovered.
+//
+// A static call is replaced by the graph of its target.  An instance call
+// is replaced by a check of the receiver class for each class recorded in
+// the ICData of the call, each followed by the graph of the target for
+// that class, and by the call itself for the other receivers.
+//
+// The arguments of the call are stored in frame slots after the locals of
+// the function, where the inlined function allocates its parameters and
+// locals.  Its returns store the result in another slot, which is loaded
+// in place of the call.  Calls in inlined functions are inlined in turn,
+// up to FLAG_inlining_depth_threshold.
+class FlowGraphInliner : public ValueObject {
+ public:
+  explicit FlowGraphInliner(FlowGraphBuilder* builder);
+
+  // Inline the calls in the graph reachable from the entry.
+  void InlineCalls(Instruction* entry);
+
+  // Record the frame slots used by inlined functions in the builder, and
+  // report the number of inlined and rejected calls.
+  void Finish();
+
+  intptr_t inlined_count() const { return inlined_count_; }
+  intptr_t rejected_count() const { return rejected_count_; }
+
+ private:
+  // The graph of a target inlined at a call, and the receiver class it is
+  // inlined for (NULL at a static call).
+  struct InlinedTarget : public ZoneAllocated {
+    const Class* receiver_class;
+    TargetEntryInstr* entry;
+    ZoneGrowableArray<Instruction*>* exits;
+    ZoneGrowableArray<Value*>* return_values;
+  };
+
+  void CollectCalls(Instruction* entry,
+                    GrowableArray<Instruction*>* previous,
+                    GrowableArray<Instruction*>* calls) const;
+
+  void TryInlineCall(Instruction* previous, Instruction* call);
+
+  // Returns false if the receiver classes of the call are unknown or too
+  // many to inline.
+  bool CollectReceiverTargets(InstanceCallComp* call,
+                              GrowableArray<const Class*>* classes,
+                              GrowableArray<const Function*>* targets,
+                              const char** reason) const;
+
+  // Build the graph of the target with its parameters and locals from
+  // first_frame_index.  Returns NULL if the target cannot be inlined.
+  InlinedTarget* TryInlineTarget(const Function& target,
+                                 intptr_t argument_count,
+                                 intptr_t first_frame_index,
+                                 intptr_t temp_index,
+                                 const char** reason);
+
+  void ReplaceCall(Instruction* previous,
+                   Instruction* call,
+                   const GrowableArray<InlinedTarget*>& targets,
+                   bool keep_call,
+                   intptr_t result_index,
+                   intptr_t temp_index);
+
+  void Trace(Instruction* call, const char* message) const;
+
+  FlowGraphBuilder* builder_;
+  intptr_t depth_;
+  // Frame indices decrease: inlined functions use the slots from
+  // first_frame_index_ down to next_frame_index_ + 1.
+  const intptr_t first_frame_index_;
+  intptr_t next_frame_index_;
+  // The functions being inlined, to reject recursive calls.
+  GrowableArray<const Function*> inlined_functions_;
+  intptr_t inlined_count_;
+  intptr_t rejected_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(FlowGraphInliner);
+};
+
+}  // namespace dart
+
+#endif  // VM_FLOW_GRAPH_INLINER_H_
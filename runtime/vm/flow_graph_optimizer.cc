@@ -0,0 +1,804 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/flow_graph_optimizer.h"
+
+#include "vm/compiler_stats.h"
+#include "vm/flags.h"
+#include "vm/flow_graph_builder.h"
+#include "vm/object.h"
+#include "vm/scopes.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool, propagate_constants, true,
+    "Propagate constants in the SSA flow graph.");
+DEFINE_FLAG(bool, propagate_copies, true,
+    "Propagate copies of locals in the SSA flow graph.");
+DEFINE_FLAG(bool, cse, true,
+    "Eliminate common subexpressions in the SSA flow graph.");
+DEFINE_FLAG(bool, eliminate_dead_code, true,
+    "Eliminate dead code in the SSA flow graph.");
+
+// Value numbers of constants are keyed by this operator, other keys use
+// the token kind of the computation.
+static const intptr_t kConstantOperator = -1;
+
+static const intptr_t kInitialValueNumberTableSize = 64;
+
+
+// Unlike NextInBlock, also returns the unreachable instructions following
+// a throw.  They are never compiled, but they were emitted by the builder
+// with a consistent stack of temporaries, which must be preserved.
+static Instruction* NextInChain(Instruction* instr) {
+  Instruction* next = instr->StraightLineSuccessor();
+  return ((next == NULL) || next->IsBlockEntry()) ? NULL : next;
+}
+
+
+FlowGraphOptimizer::FlowGraphOptimizer(const FlowGraphBuilder& builder)
+    : preorder_(builder.preorder_block_entries()),
+      postorder_(builder.postorder_block_entries()),
+      variables_(builder.ssa_variables()),
+      version_variables_(builder.ssa_version_variables()),
+      temp_count_(builder.ssa_temp_count()),
+      non_constant_(&Object::ZoneHandle()),
+      bool_true_(Bool::ZoneHandle(Bool::True())),
+      bool_false_(Bool::ZoneHandle(Bool::False())),
+      temp_values_(builder.ssa_temp_count()),
+      version_values_(builder.ssa_version_variables().length()),
+      value_number_count_(0),
+      temp_numbers_(builder.ssa_temp_count()),
+      version_numbers_(builder.ssa_version_variables().length()),
+      holder_heads_(),
+      holder_next_(builder.ssa_version_variables().length()),
+      table_keys_(),
+      table_(kInitialValueNumberTableSize),
+      changed_(false),
+      propagated_constants_(0),
+      propagated_copies_(0),
+      eliminated_subexpressions_(0),
+      eliminated_dead_instructions_(0) { }
+
+
+void FlowGraphOptimizer::Optimize() {
+  if (FLAG_propagate_constants) {
+    PropagateConstants();
+  }
+  if (FLAG_propagate_copies) {
+    PropagateCopies();
+  }
+  if (FLAG_cse) {
+    EliminateCommonSubexpressions();
+  }
+  if (FLAG_eliminate_dead_code) {
+    EliminateDeadCode();
+  }
+  if (changed_) {
+    ComputeTempIndices();
+  }
+  if (FLAG_compiler_stats) {
+    CompilerStats::num_propagated_constants += propagated_constants_;
+    CompilerStats::num_propagated_copies += propagated_copies_;
+    CompilerStats::num_eliminated_subexpressions += eliminated_subexpressions_;
+    CompilerStats::num_eliminated_dead_instructions +=
+        eliminated_dead_instructions_;
+  }
+}
+
+
+// ==== Constant propagation.
+//
+// The lattice has three levels: unknown (NULL), a constant (a handle to
+// it), and not constant (non_constant_).  Values only move down, so
+// iterating to a fixed point terminates.
+
+const Object* FlowGraphOptimizer::Meet(const Object* a, const Object* b) const {
+  if (a == NULL) {
+    return b;
+  }
+  if (b == NULL) {
+    return a;
+  }
+  if ((a == non_constant_) || (b == non_constant_)) {
+    return non_constant_;
+  }
+  return (a->raw() == b->raw()) ? a : non_constant_;
+}
+
+
+bool FlowGraphOptimizer::IsConstant(const Object* value) const {
+  return (value != NULL) && (value != non_constant_);
+}
+
+
+// Lower the value in the slot to its meet with the given value.  Returns
+// true if it changed.
+bool FlowGraphOptimizer::UpdateValue(const Object** slot, const Object* value) {
+  const Object* new_value = Meet(*slot, value);
+  if (new_value == *slot) {
+    return false;
+  }
+  *slot = new_value;
+  return true;
+}
+
+
+const Object* FlowGraphOptimizer::ValueOf(Value* value) const {
+  if (value->IsConstant()) {
+    return &value->AsConstant()->value();
+  }
+  BindInstr* bind = value->AsUse()->definition()->AsBind();
+  if ((bind == NULL) || (bind->ssa_temp_index() < 0)) {
+    return non_constant_;
+  }
+  return temp_values_[bind->ssa_temp_index()];
+}
+
+
+const Object* FlowGraphOptimizer::Evaluate(Computation* comp) const {
+  if (comp->IsConstant()) {
+    return &comp->AsConstant()->value();
+  }
+
+  LoadLocalComp* load = comp->AsLoadLocal();
+  if (load != NULL) {
+    if (load->ssa_index() < 0) {
+      return non_constant_;
+    }
+    return version_values_[load->ssa_index()];
+  }
+
+  // The value of a store is the stored value.
+  StoreLocalComp* store = comp->AsStoreLocal();
+  if (store != NULL) {
+    return ValueOf(store->value());
+  }
+
+  // Strict equality is identity, as in the generated code.
+  StrictCompareComp* compare = comp->AsStrictCompare();
+  if (compare != NULL) {
+    const Object* left = ValueOf(compare->left());
+    const Object* right = ValueOf(compare->right());
+    if ((left == NULL) || (right == NULL)) {
+      return NULL;
+    }
+    if (!IsConstant(left) || !IsConstant(right)) {
+      return non_constant_;
+    }
+    const bool is_identical = (left->raw() == right->raw());
+    return (is_identical == (compare->kind() == Token::kEQ_STRICT)) ?
+        &bool_true_ : &bool_false_;
+  }
+
+  // Any value other than true negates to true, as in the generated code.
+  BooleanNegateComp* negate = comp->AsBooleanNegate();
+  if (negate != NULL) {
+    const Object* value = ValueOf(negate->value());
+    if (!IsConstant(value)) {
+      return value;
+    }
+    return (value->raw() == bool_true_.raw()) ? &bool_false_ : &bool_true_;
+  }
+
+  return non_constant_;
+}
+
+
+// True if the compiler loads every input of the instruction with
+// LoadValue, which accepts a constant as well as a temporary.  Other
+// instructions, e.g., calls, expect their inputs on the stack.
+bool FlowGraphOptimizer::AcceptsConstantInput(Instruction* instr) const {
+  if (instr->IsReturn() || instr->IsBranch()) {
+    return true;
+  }
+  Computation* comp = instr->computation();
+  if (comp == NULL) {
+    return false;
+  }
+  return comp->IsStoreLocal() ||
+      comp->IsStrictCompare() ||
+      comp->IsEqualityCompare() ||
+      comp->IsBooleanNegate() ||
+      comp->IsAssertBoolean() ||
+      comp->IsLoadClass();
+}
+
+
+void FlowGraphOptimizer::PropagateConstants() {
+  // The initial versions of locals are parameters or the null the
+  // prologue stores in locals; treat them as unknown at compile time.
+  temp_values_.Clear();
+  for (intptr_t i = 0; i < temp_count_; ++i) {
+    temp_values_.Add(NULL);
+  }
+  version_values_.Clear();
+  for (intptr_t i = 0; i < version_variables_.length(); ++i) {
+    version_values_.Add((i < variables_.length()) ? non_constant_ : NULL);
+  }
+
+  // 1. Iterate to a fixed point, in reverse postorder so that values are
+  // normally computed before they are used.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (intptr_t i = postorder_.length() - 1; i >= 0; --i) {
+      BlockEntryInstr* block = postorder_[i];
+      JoinEntryInstr* join = block->AsJoinEntry();
+      if ((join != NULL) && (join->phis() != NULL)) {
+        ZoneGrowableArray<PhiInstr*>* phis = join->phis();
+        for (intptr_t j = 0; j < phis->length(); ++j) {
+          PhiInstr* phi = (*phis)[j];
+          const Object* value = NULL;
+          for (intptr_t k = 0; k < phi->InputVersionCount(); ++k) {
+            intptr_t version = phi->InputVersionAt(k);
+            value = Meet(value, (version < 0) ?
+                         non_constant_ : version_values_[version]);
+          }
+          if (UpdateValue(&version_values_[phi->ssa_index()], value)) {
+            changed = true;
+          }
+        }
+      }
+      for (Instruction* current = block->NextInBlock();
+           current != NULL;
+           current = current->NextInBlock()) {
+        Computation* comp = current->computation();
+        if (comp == NULL) {
+          continue;
+        }
+        StoreLocalComp* store = comp->AsStoreLocal();
+        if ((store != NULL) && (store->ssa_index() >= 0) &&
+            UpdateValue(&version_values_[store->ssa_index()],
+                        ValueOf(store->value()))) {
+          changed = true;
+        }
+        BindInstr* bind = current->AsBind();
+        if ((bind != NULL) &&
+            UpdateValue(&temp_values_[bind->ssa_temp_index()],
+                        Evaluate(comp))) {
+          changed = true;
+        }
+      }
+    }
+  }
+
+  // 2. Use the constants.
+  for (intptr_t i = 0; i < preorder_.length(); ++i) {
+    for (Instruction* current = preorder_[i]->NextInBlock();
+         current != NULL;
+         current = current->NextInBlock()) {
+      if (AcceptsConstantInput(current)) {
+        for (intptr_t j = 0; j < current->InputCount(); ++j) {
+          Value* input = current->InputAt(j);
+          if (!input->IsUse()) {
+            continue;
+          }
+          const Object* value = ValueOf(input);
+          if (IsConstant(value)) {
+            current->SetInputAt(j, new ConstantVal(*value));
+            propagated_constants_++;
+            changed_ = true;
+          }
+        }
+      }
+      // A computation without side effects and with a constant value is
+      // replaced by the constant.  Its inputs become unused.
+      BindInstr* bind = current->AsBind();
+      if (bind == NULL) {
+        continue;
+      }
+      Computation* comp = bind->computation();
+      const Object* value = temp_values_[bind->ssa_temp_index()];
+      if (IsConstant(value) && !comp->HasSideEffect() && !comp->IsConstant()) {
+        bind->set_computation(new ConstantVal(*value));
+        propagated_constants_++;
+        changed_ = true;
+      }
+    }
+  }
+  DiscardUnusedValues();
+}
+
+
+// ==== Value numbering.
+//
+// Computations get the same value number if they are known to produce the
+// same value: loads of the same version of a local, the same constant, and
+// strict comparisons and negations of values with the same numbers.  Each
+// version of a local is a holder of the value number of its value.  The
+// dominator tree is walked with an environment mapping each local to its
+// current version, so a holder is available at a point if it is the
+// current version of its local there.
+
+void FlowGraphOptimizer::PropagateCopies() {
+  NumberValues(true, false);
+}
+
+
+void FlowGraphOptimizer::EliminateCommonSubexpressions() {
+  NumberValues(false, true);
+}
+
+
+void FlowGraphOptimizer::NumberValues(bool propagate_copies,
+                                      bool eliminate_expressions) {
+  value_number_count_ = 0;
+  holder_heads_.Clear();
+  temp_numbers_.Clear();
+  for (intptr_t i = 0; i < temp_count_; ++i) {
+    temp_numbers_.Add(-1);
+  }
+  version_numbers_.Clear();
+  holder_next_.Clear();
+  for (intptr_t i = 0; i < version_variables_.length(); ++i) {
+    version_numbers_.Add(-1);
+    holder_next_.Add(-1);
+  }
+  table_keys_.Clear();
+  table_.Clear();
+  for (intptr_t i = 0; i < kInitialValueNumberTableSize; ++i) {
+    table_.Add(-1);
+  }
+
+  GrowableArray<intptr_t> env(variables_.length());
+  for (intptr_t i = 0; i < variables_.length(); ++i) {
+    version_numbers_[i] = NewValueNumber();
+    AddHolder(i, version_numbers_[i]);
+    env.Add(i);
+  }
+  NumberBlock(preorder_[0], &env, propagate_copies, eliminate_expressions);
+  DiscardUnusedValues();
+}
+
+
+void FlowGraphOptimizer::NumberBlock(BlockEntryInstr* block,
+                                     GrowableArray<intptr_t>* env,
+                                     bool propagate_copies,
+                                     bool eliminate_expressions) {
+  // A phi has the number of its inputs if they all agree.  Inputs along
+  // back edges are not numbered yet, so loop phis get a new number.
+  JoinEntryInstr* join = block->AsJoinEntry();
+  if ((join != NULL) && (join->phis() != NULL)) {
+    ZoneGrowableArray<PhiInstr*>* phis = join->phis();
+    for (intptr_t i = 0; i < phis->length(); ++i) {
+      PhiInstr* phi = (*phis)[i];
+      intptr_t number = -1;
+      for (intptr_t j = 0; j < phi->InputVersionCount(); ++j) {
+        intptr_t version = phi->InputVersionAt(j);
+        intptr_t input_number =
+            (version < 0) ? -1 : version_numbers_[version];
+        if (j == 0) {
+          number = input_number;
+        } else if (input_number != number) {
+          number = -1;
+        }
+      }
+      if (number < 0) {
+        number = NewValueNumber();
+      }
+      version_numbers_[phi->ssa_index()] = number;
+      AddHolder(phi->ssa_index(), number);
+      (*env)[version_variables_[phi->ssa_index()]] = phi->ssa_index();
+    }
+  }
+
+  for (Instruction* current = block->NextInBlock();
+       current != NULL;
+       current = current->NextInBlock()) {
+    Computation* comp = current->computation();
+    if (comp == NULL) {
+      continue;
+    }
+    BindInstr* bind = current->AsBind();
+    if (bind != NULL) {
+      intptr_t number = ComputationValueNumber(comp);
+      LoadLocalComp* load = comp->AsLoadLocal();
+      if (propagate_copies && (load != NULL) && (load->ssa_index() >= 0)) {
+        // Load the local the value was first stored in.
+        intptr_t holder = FindHolder(number, *env, true);
+        if ((holder >= 0) && (holder != load->ssa_index())) {
+          ReplaceByLoad(bind, holder);
+          propagated_copies_++;
+        }
+      } else if (eliminate_expressions &&
+                 (comp->IsStrictCompare() || comp->IsBooleanNegate())) {
+        intptr_t holder = FindHolder(number, *env, false);
+        if (holder >= 0) {
+          ReplaceByLoad(bind, holder);
+          eliminated_subexpressions_++;
+        }
+      }
+      temp_numbers_[bind->ssa_temp_index()] = number;
+    }
+    StoreLocalComp* store = comp->AsStoreLocal();
+    if ((store != NULL) && (store->ssa_index() >= 0)) {
+      intptr_t version = store->ssa_index();
+      version_numbers_[version] = InputValueNumber(store->value());
+      AddHolder(version, version_numbers_[version]);
+      (*env)[version_variables_[version]] = version;
+    }
+  }
+
+  const GrowableArray<BlockEntryInstr*>& children = block->dominated_blocks();
+  for (intptr_t i = 0; i < children.length(); ++i) {
+    GrowableArray<intptr_t> child_env(env->length());
+    for (intptr_t j = 0; j < env->length(); ++j) {
+      child_env.Add((*env)[j]);
+    }
+    NumberBlock(children[i], &child_env,
+                propagate_copies, eliminate_expressions);
+  }
+}
+
+
+intptr_t FlowGraphOptimizer::InputValueNumber(Value* value) {
+  if (value->IsConstant()) {
+    return LookupValueNumber(
+        kConstantOperator,
+        reinterpret_cast<intptr_t>(value->AsConstant()->value().raw()),
+        0);
+  }
+  BindInstr* bind = value->AsUse()->definition()->AsBind();
+  if ((bind == NULL) || (bind->ssa_temp_index() < 0) ||
+      (temp_numbers_[bind->ssa_temp_index()] < 0)) {
+    return NewValueNumber();
+  }
+  return temp_numbers_[bind->ssa_temp_index()];
+}
+
+
+intptr_t FlowGraphOptimizer::ComputationValueNumber(Computation* comp) {
+  if (comp->IsConstant()) {
+    return InputValueNumber(comp->AsConstant());
+  }
+
+  LoadLocalComp* load = comp->AsLoadLocal();
+  if ((load != NULL) && (load->ssa_index() >= 0) &&
+      (version_numbers_[load->ssa_index()] >= 0)) {
+    return version_numbers_[load->ssa_index()];
+  }
+
+  StoreLocalComp* store = comp->AsStoreLocal();
+  if (store != NULL) {
+    return InputValueNumber(store->value());
+  }
+
+  StrictCompareComp* compare = comp->AsStrictCompare();
+  if (compare != NULL) {
+    return LookupValueNumber(compare->kind(),
+                             InputValueNumber(compare->left()),
+                             InputValueNumber(compare->right()));
+  }
+
+  BooleanNegateComp* negate = comp->AsBooleanNegate();
+  if (negate != NULL) {
+    return LookupValueNumber(Token::kNOT,
+                             InputValueNumber(negate->value()),
+                             0);
+  }
+
+  return NewValueNumber();
+}
+
+
+static uword HashValueNumberKey(intptr_t op, intptr_t left, intptr_t right) {
+  uword hash = static_cast<uword>(op);
+  hash = (hash * 31) + static_cast<uword>(left);
+  hash = (hash * 31) + static_cast<uword>(right);
+  return hash ^ (hash >> 7);
+}
+
+
+// The table is open addressed with linear probing.  Its slots hold indices
+// into table_keys_, which holds (operator, left, right, number) entries.
+intptr_t FlowGraphOptimizer::LookupValueNumber(intptr_t op,
+                                               intptr_t left,
+                                               intptr_t right) {
+  const intptr_t kEntrySize = 4;
+  if (2 * (table_keys_.length() / kEntrySize + 1) > table_.length()) {
+    intptr_t new_size = 2 * table_.length();
+    table_.Clear();
+    for (intptr_t i = 0; i < new_size; ++i) {
+      table_.Add(-1);
+    }
+    for (intptr_t entry = 0;
+         entry < table_keys_.length();
+         entry += kEntrySize) {
+      uword index = HashValueNumberKey(table_keys_[entry],
+                                       table_keys_[entry + 1],
+                                       table_keys_[entry + 2]);
+      index &= (new_size - 1);
+      while (table_[index] >= 0) {
+        index = (index + 1) & (new_size - 1);
+      }
+      table_[index] = entry;
+    }
+  }
+  const uword mask = table_.length() - 1;
+  uword index = HashValueNumberKey(op, left, right) & mask;
+  while (table_[index] >= 0) {
+    intptr_t entry = table_[index];
+    if ((table_keys_[entry] == op) &&
+        (table_keys_[entry + 1] == left) &&
+        (table_keys_[entry + 2] == right)) {
+      return table_keys_[entry + 3];
+    }
+    index = (index + 1) & mask;
+  }
+  intptr_t number = NewValueNumber();
+  table_[index] = table_keys_.length();
+  table_keys_.Add(op);
+  table_keys_.Add(left);
+  table_keys_.Add(right);
+  table_keys_.Add(number);
+  return number;
+}
+
+
+intptr_t FlowGraphOptimizer::NewValueNumber() {
+  holder_heads_.Add(-1);
+  return value_number_count_++;
+}
+
+
+// Holders of a value number are kept in a list through holder_next_, most
+// recent first.
+void FlowGraphOptimizer::AddHolder(intptr_t version, intptr_t value_number) {
+  holder_next_[version] = holder_heads_[value_number];
+  holder_heads_[value_number] = version;
+}
+
+
+// Returns an available holder of the value number, or -1.  The oldest is
+// the original of a copy, otherwise the most recent one is returned.
+intptr_t FlowGraphOptimizer::FindHolder(intptr_t value_number,
+                                        const GrowableArray<intptr_t>& env,
+                                        bool oldest) const {
+  intptr_t result = -1;
+  for (intptr_t version = holder_heads_[value_number];
+       version >= 0;
+       version = holder_next_[version]) {
+    if (env[version_variables_[version]] == version) {
+      result = version;
+      if (!oldest) {
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+
+void FlowGraphOptimizer::ReplaceByLoad(BindInstr* bind, intptr_t version) {
+  // Renamed locals are not captured, so the context level is not used.
+  LoadLocalComp* load =
+      new LoadLocalComp(*variables_[version_variables_[version]], 0);
+  load->set_ssa_index(version);
+  bind->set_computation(load);
+  changed_ = true;
+}
+
+
+// ==== Dead code elimination.
+
+void FlowGraphOptimizer::EliminateDeadCode() {
+  bool changed = true;
+  while (changed) {
+    changed = DiscardUnusedValues();
+    GrowableArray<bool> live(version_variables_.length());
+    ComputeLiveVersions(&live);
+    for (intptr_t i = 0; i < preorder_.length(); ++i) {
+      BlockEntryInstr* block = preorder_[i];
+      JoinEntryInstr* join = block->AsJoinEntry();
+      if ((join != NULL) && (join->phis() != NULL)) {
+        ZoneGrowableArray<PhiInstr*>* phis = join->phis();
+        intptr_t live_count = 0;
+        for (intptr_t j = 0; j < phis->length(); ++j) {
+          PhiInstr* phi = (*phis)[j];
+          if (live[phi->ssa_index()]) {
+            (*phis)[live_count++] = phi;
+          }
+        }
+        while (phis->length() > live_count) {
+          phis->RemoveLast();
+        }
+      }
+
+      Instruction* prev = block;
+      Instruction* current = block->NextInBlock();
+      while (current != NULL) {
+        Instruction* next = current->NextInBlock();
+        bool is_dead = false;
+        if (current->IsDo()) {
+          Computation* comp = current->computation();
+          StoreLocalComp* store = comp->AsStoreLocal();
+          if (store != NULL) {
+            is_dead = (store->ssa_index() >= 0) && !live[store->ssa_index()];
+          } else {
+            is_dead = !comp->HasSideEffect();
+          }
+        }
+        if (is_dead) {
+          RemoveInstruction(block, prev, current);
+          eliminated_dead_instructions_++;
+          changed = true;
+        } else {
+          prev = current;
+        }
+        current = next;
+      }
+    }
+  }
+}
+
+
+// A version is live if it is loaded or is an input of a live phi.
+void FlowGraphOptimizer::ComputeLiveVersions(GrowableArray<bool>* live) const {
+  const intptr_t version_count = version_variables_.length();
+  GrowableArray<PhiInstr*> phis(version_count);
+  for (intptr_t i = 0; i < version_count; ++i) {
+    live->Add(false);
+    phis.Add(NULL);
+  }
+  GrowableArray<intptr_t> worklist;
+  for (intptr_t i = 0; i < preorder_.length(); ++i) {
+    BlockEntryInstr* block = preorder_[i];
+    JoinEntryInstr* join = block->AsJoinEntry();
+    if ((join != NULL) && (join->phis() != NULL)) {
+      for (intptr_t j = 0; j < join->phis()->length(); ++j) {
+        PhiInstr* phi = (*join->phis())[j];
+        phis[phi->ssa_index()] = phi;
+      }
+    }
+    for (Instruction* current = block->NextInBlock();
+         current != NULL;
+         current = current->NextInBlock()) {
+      Computation* comp = current->computation();
+      if ((comp == NULL) || !comp->IsLoadLocal()) {
+        continue;
+      }
+      intptr_t version = comp->AsLoadLocal()->ssa_index();
+      if ((version >= 0) && !(*live)[version]) {
+        (*live)[version] = true;
+        worklist.Add(version);
+      }
+    }
+  }
+  while (!worklist.is_empty()) {
+    PhiInstr* phi = phis[worklist.Last()];
+    worklist.RemoveLast();
+    if (phi == NULL) {
+      continue;
+    }
+    for (intptr_t i = 0; i < phi->InputVersionCount(); ++i) {
+      intptr_t version = phi->InputVersionAt(i);
+      if ((version >= 0) && !(*live)[version]) {
+        (*live)[version] = true;
+        worklist.Add(version);
+      }
+    }
+  }
+}
+
+
+// ==== Maintaining the stack of temporaries.
+
+// Count the uses of each temporary, including unreachable ones.
+void FlowGraphOptimizer::ComputeTempUses(GrowableArray<intptr_t>* uses) const {
+  for (intptr_t i = 0; i < temp_count_; ++i) {
+    uses->Add(0);
+  }
+  for (intptr_t i = 0; i < preorder_.length(); ++i) {
+    for (Instruction* current = NextInChain(preorder_[i]);
+         current != NULL;
+         current = NextInChain(current)) {
+      for (intptr_t j = 0; j < current->InputCount(); ++j) {
+        Value* input = current->InputAt(j);
+        if (!input->IsUse()) {
+          continue;
+        }
+        BindInstr* bind = input->AsUse()->definition()->AsBind();
+        if ((bind != NULL) && (bind->ssa_temp_index() >= 0)) {
+          (*uses)[bind->ssa_temp_index()]++;
+        }
+      }
+    }
+  }
+}
+
+
+// A Bind whose temporary is not used anymore would leave its value on the
+// stack.  Turn it into a Do, which dead code elimination can remove if the
+// computation has no side effects.  Returns true if the graph changed.
+bool FlowGraphOptimizer::DiscardUnusedValues() {
+  GrowableArray<intptr_t> uses(temp_count_);
+  ComputeTempUses(&uses);
+  bool changed = false;
+  for (intptr_t i = 0; i < preorder_.length(); ++i) {
+    BlockEntryInstr* block = preorder_[i];
+    Instruction* prev = block;
+    Instruction* current = block->NextInBlock();
+    while (current != NULL) {
+      Instruction* next = current->NextInBlock();
+      BindInstr* bind = current->AsBind();
+      if ((bind != NULL) && (uses[bind->ssa_temp_index()] == 0)) {
+        DoInstr* replacement = new DoInstr(bind->computation());
+        ReplaceInstruction(block, prev, bind, replacement);
+        current = replacement;
+        changed = true;
+      }
+      prev = current;
+      current = next;
+    }
+  }
+  return changed;
+}
+
+
+void FlowGraphOptimizer::RemoveInstruction(BlockEntryInstr* block,
+                                           Instruction* prev,
+                                           Instruction* instr) {
+  prev->ReplaceSuccessor(instr->StraightLineSuccessor());
+  if (block->last_instruction() == instr) {
+    block->set_last_instruction((prev == block) ? NULL : prev);
+  }
+  changed_ = true;
+}
+
+
+void FlowGraphOptimizer::ReplaceInstruction(BlockEntryInstr* block,
+                                            Instruction* prev,
+                                            Instruction* instr,
+                                            Instruction* replacement) {
+  replacement->SetSuccessor(instr->StraightLineSuccessor());
+  prev->ReplaceSuccessor(replacement);
+  if (block->last_instruction() == instr) {
+    block->set_last_instruction(replacement);
+  }
+  changed_ = true;
+}
+
+
+// Recompute the temporary (stack slot) index of each Bind by simulating
+// the stack height: each use pops a temporary and each Bind pushes one.
+// The builder keeps the height consistent at joins, and the optimizations
+// remove a temporary together with its only use, so it stays consistent.
+void FlowGraphOptimizer::ComputeTempIndices() {
+  const intptr_t block_count = postorder_.length();
+  GrowableArray<intptr_t> exit_heights(block_count);
+  for (intptr_t i = 0; i < block_count; ++i) {
+    exit_heights.Add(-1);
+  }
+  // In reverse postorder, a block other than the graph entry has at least
+  // one predecessor visited before it.
+  for (intptr_t i = block_count - 1; i >= 0; --i) {
+    BlockEntryInstr* block = postorder_[i];
+    intptr_t height = 0;
+    for (intptr_t j = 0; j < block->PredecessorCount(); ++j) {
+      intptr_t pred_height =
+          exit_heights[block->PredecessorAt(j)->postorder_number()];
+      if (pred_height >= 0) {
+        height = pred_height;
+        break;
+      }
+    }
+    for (Instruction* current = NextInChain(block);
+         current != NULL;
+         current = NextInChain(current)) {
+      for (intptr_t j = 0; j < current->InputCount(); ++j) {
+        if (current->InputAt(j)->IsUse()) {
+          --height;
+        }
+      }
+      ASSERT(height >= 0);
+      if (current->IsBind()) {
+        current->AsBind()->set_temp_index(height++);
+      }
+    }
+    exit_heights[block->postorder_number()] = height;
+  }
+}
+
+}  // namespace dart
@@ -0,0 +1,121 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef VM_FLOW_GRAPH_OPTIMIZER_H_
+#define VM_FLOW_GRAPH_OPTIMIZER_H_
+
+#include "vm/allocation.h"
+#include "vm/growable_array.h"
+#include "vm/intermediate_language.h"
+
+namespace dart {
+
+class FlowGraphBuilder;
+class LocalVariable;
+
+// Scalar optimizations on a flow graph in SSA form (see
+// FlowGraphBuilder::ComputeSSA).
+//
+// The graph is still compiled by the stack-based flow graph compiler: a
+// temporary is pushed by its Bind and popped by its only use.  The passes
+// therefore never add uses of a temporary.  They rewrite computations in
+// place (e.g., to a constant or to a load of a local), replace uses of
+// temporaries by constants where the compiler accepts a constant, and
+// remove instructions.  A Bind whose temporary loses its use becomes a Do,
+// and the temporary indices are recomputed at the end.
+class FlowGraphOptimizer : public ValueObject {
+ public:
+  explicit FlowGraphOptimizer(const FlowGraphBuilder& builder);
+
+  // Run the passes enabled by flags.
+  void Optimize();
+
+  // Find the temporaries and versions of locals with a constant value and
+  // use the constant instead.
+  void PropagateConstants();
+
+  // Replace a load of a local holding a copy of another local by a load of
+  // the original.
+  void PropagateCopies();
+
+  // Replace the recomputation of a value held in a local by a load of the
+  // local.
+  void EliminateCommonSubexpressions();
+
+  // Remove computations without side effects whose value is unused, stores
+  // to versions of locals that are never loaded, and unused phis.
+  void EliminateDeadCode();
+
+ private:
+  // Lattice values for constant propagation.
+  const Object* Meet(const Object* a, const Object* b) const;
+  bool IsConstant(const Object* value) const;
+  bool UpdateValue(const Object** slot, const Object* value);
+  const Object* ValueOf(Value* value) const;
+  const Object* Evaluate(Computation* comp) const;
+  bool AcceptsConstantInput(Instruction* instr) const;
+
+  // Value numbering for copy propagation and common subexpressions.
+  void NumberValues(bool propagate_copies, bool eliminate_expressions);
+  void NumberBlock(BlockEntryInstr* block,
+                   GrowableArray<intptr_t>* env,
+                   bool propagate_copies,
+                   bool eliminate_expressions);
+  intptr_t InputValueNumber(Value* value);
+  intptr_t ComputationValueNumber(Computation* comp);
+  intptr_t LookupValueNumber(intptr_t op, intptr_t left, intptr_t right);
+  intptr_t NewValueNumber();
+  void AddHolder(intptr_t version, intptr_t value_number);
+  intptr_t FindHolder(intptr_t value_number,
+                      const GrowableArray<intptr_t>& env,
+                      bool oldest) const;
+  void ReplaceByLoad(BindInstr* bind, intptr_t version);
+
+  // Graph surgery.
+  void ComputeTempUses(GrowableArray<intptr_t>* uses) const;
+  bool DiscardUnusedValues();
+  void ComputeLiveVersions(GrowableArray<bool>* live) const;
+  void RemoveInstruction(BlockEntryInstr* block,
+                         Instruction* prev,
+                         Instruction* instr);
+  void ReplaceInstruction(BlockEntryInstr* block,
+                          Instruction* prev,
+                          Instruction* instr,
+                          Instruction* replacement);
+  void ComputeTempIndices();
+
+  const GrowableArray<BlockEntryInstr*>& preorder_;
+  const GrowableArray<BlockEntryInstr*>& postorder_;
+  const GrowableArray<const LocalVariable*>& variables_;
+  const GrowableArray<intptr_t>& version_variables_;
+  const intptr_t temp_count_;
+
+  const Object* const non_constant_;
+  const Bool& bool_true_;
+  const Bool& bool_false_;
+  GrowableArray<const Object*> temp_values_;
+  GrowableArray<const Object*> version_values_;
+
+  intptr_t value_number_count_;
+  GrowableArray<intptr_t> temp_numbers_;
+  GrowableArray<intptr_t> version_numbers_;
+  GrowableArray<intptr_t> holder_heads_;
+  GrowableArray<intptr_t> holder_next_;
+  GrowableArray<intptr_t> table_keys_;
+  GrowableArray<intptr_t> table_;
+
+  bool changed_;
+
+  // Number of transformations done by each pass, for --compiler_stats.
+  intptr_t propagated_constants_;
+  intptr_t propagated_copies_;
+  intptr_t eliminated_subexpressions_;
+  intptr_t eliminated_dead_instructions_;
+
+  DISALLOW_COPY_AND_ASSIGN(FlowGraphOptimizer);
+};
+
+}  // namespace dart
+
+#endif  // VM_FLOW_GRAPH_OPTIMIZER_H_
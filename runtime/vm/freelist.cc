@@ -66,43 +66,29 @@ FreeList::~FreeList() {
 
 
 uword FreeList::TryAllocate(intptr_t size) {
-  int index = IndexForSize(size);
-  if ((index != kNumLists) && (free_lists_[index] != NULL)) {
-    return reinterpret_cast<uword>(DequeueElement(index));
-  }
-
+  intptr_t index = IndexForSize(size);
+  FreeListElement* element = NULL;
   if (index < kNumLists) {
-    index++;
-    while (index < kNumLists) {
-      if (free_lists_[index] != NULL) {
-        // Dequeue an element from the list, split and enqueue the remainder in
-        // the appropriate list.
-        FreeListElement* element = DequeueElement(index);
-        SplitElementAfterAndEnqueue(element, size);
-        return reinterpret_cast<uword>(element);
-      }
-      index++;
+    if (free_lists_[index] != NULL) {
+      free_bytes_ -= size;
+      return reinterpret_cast<uword>(DequeueElement(index));
     }
+  } else {
+    // Elements in the size class of the request might be too small.
+    element = TryDequeueFirstFit(index, size);
   }
-
-  FreeListElement* previous = NULL;
-  FreeListElement* current = free_lists_[kNumLists];
-  while (current != NULL) {
-    if (current->Size() >= size) {
-      // Found an element large enough to hold the requested size. Dequeue,
-      // split and enqueue the remainder.
-      if (previous == NULL) {
-        free_lists_[kNumLists] = current->next();
-      } else {
-        previous->set_next(current->next());
-      }
-      SplitElementAfterAndEnqueue(current, size);
-      return reinterpret_cast<uword>(current);
+  if (element == NULL) {
+    // Any element in a list above the index is large enough. Use the smallest.
+    index = FindNonEmptyList(index + 1);
+    if (index < 0) {
+      return 0;
     }
-    previous = current;
-    current = current->next();
+    element = DequeueElement(index);
   }
-  return 0;
+  // Split and enqueue the remainder in the appropriate list.
+  SplitElementAfterAndEnqueue(element, size);
+  free_bytes_ -= size;
+  return reinterpret_cast<uword>(element);
 }
 
 
@@ -110,40 +96,102 @@ void FreeList::Free(uword addr, intptr_t size) {
   intptr_t index = IndexForSize(size);
   FreeListElement* element = FreeListElement::AsElement(addr, size);
   EnqueueElement(element, index);
+  free_bytes_ += size;
 }
 
 
 void FreeList::Reset() {
-  for (int i = 0; i < (kNumLists + 1); i++) {
+  for (int i = 0; i < kNumAllLists; i++) {
     free_lists_[i] = NULL;
   }
+  for (int i = 0; i < kNumBitmapWords; i++) {
+    free_map_[i] = 0;
+  }
+  free_bytes_ = 0;
 }
 
+
 intptr_t FreeList::IndexForSize(intptr_t size) {
   ASSERT(size >= kObjectAlignment);
   ASSERT(Utils::IsAligned(size, kObjectAlignment));
 
   intptr_t index = size / kObjectAlignment;
-  if (index >= kNumLists) {
-    index = kNumLists;
+  if (index < kNumLists) {
+    return index;
+  }
+  // Find the size class: class i holds sizes in
+  // [kNumLists << i, kNumLists << (i + 1)) allocation units.
+  intptr_t size_class = 0;
+  index /= (2 * kNumLists);
+  while ((index != 0) && (size_class < (kNumSizeClassLists - 1))) {
+    index >>= 1;
+    size_class++;
   }
-  return index;
+  return kNumLists + size_class;
 }
 
 
 void FreeList::EnqueueElement(FreeListElement* element, intptr_t index) {
-  element->set_next(free_lists_[index]);
+  FreeListElement* next = free_lists_[index];
+  if (next == NULL) {
+    SetListNonEmpty(index);
+  }
+  element->set_next(next);
   free_lists_[index] = element;
 }
 
 
 FreeListElement* FreeList::DequeueElement(intptr_t index) {
   FreeListElement* result = free_lists_[index];
-  free_lists_[index] = result->next();
+  FreeListElement* next = result->next();
+  if (next == NULL) {
+    SetListEmpty(index);
+  }
+  free_lists_[index] = next;
   return result;
 }
 
 
+intptr_t FreeList::FindNonEmptyList(intptr_t index) const {
+  if (index >= kNumAllLists) {
+    return -1;
+  }
+  intptr_t word_index = index / kBitsPerWord;
+  // Mask off the lists below index in the first word.
+  uword word = free_map_[word_index] &
+      ~((static_cast<uword>(1) << (index % kBitsPerWord)) - 1);
+  while (word == 0) {
+    word_index++;
+    if (word_index == kNumBitmapWords) {
+      return -1;
+    }
+    word = free_map_[word_index];
+  }
+  return (word_index * kBitsPerWord) + Utils::CountTrailingZeros(word);
+}
+
+
+FreeListElement* FreeList::TryDequeueFirstFit(intptr_t index, intptr_t size) {
+  ASSERT(index >= kNumLists);
+  FreeListElement* previous = NULL;
+  FreeListElement* current = free_lists_[index];
+  while (current != NULL) {
+    if (current->Size() >= size) {
+      // Found an element large enough to hold the requested size.
+      if (previous == NULL) {
+        DequeueElement(index);
+      } else {
+        previous->set_next(current->next());
+      }
+      return current;
+    }
+    previous = current;
+    current = current->next();
+  }
+  return NULL;
+}
+
+
 void FreeList::SplitElementAfterAndEnqueue(FreeListElement* element,
                                            intptr_t size) {
   intptr_t remainder_size = element->Size() - size;
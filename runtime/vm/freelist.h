@@ -77,6 +77,11 @@ class FreeListElement {
 };
 
 
+// The FreeList keeps free memory in segregated lists. Small elements are kept
+// in lists of exactly one size. Larger elements are kept in lists for size
+// classes that double in size, so the lists are ordered by size. A bitmap
+// records which lists are non-empty, so the smallest list which can satisfy
+// a request is found with a single find-first-set per bitmap word.
 class FreeList {
  public:
   FreeList();
@@ -87,17 +92,45 @@ class FreeList {
 
   void Reset();
 
+  // Number of bytes currently held by the freelist.
+  intptr_t free_bytes() const { return free_bytes_; }
+
  private:
+  // Number of lists holding elements of exactly one size.
   static const int kNumLists = 128;
+  // Number of lists holding elements of a size class. Each size class covers
+  // sizes up to twice its smallest size, the last one is unbounded.
+  static const int kNumSizeClassLists = 8;
+  static const int kNumAllLists = kNumLists + kNumSizeClassLists;
+  static const int kNumBitmapWords =
+      (kNumAllLists + kBitsPerWord - 1) / kBitsPerWord;
 
   static intptr_t IndexForSize(intptr_t size);
 
   void EnqueueElement(FreeListElement* element, intptr_t index);
   FreeListElement* DequeueElement(intptr_t index);
 
+  // Returns the index of the first non-empty list at or after 'index', or -1.
+  intptr_t FindNonEmptyList(intptr_t index) const;
+
+  // Remove the first element of at least 'size' bytes from the size class
+  // list at 'index'. Returns NULL if there is none.
+  FreeListElement* TryDequeueFirstFit(intptr_t index, intptr_t size);
+
+  void SetListNonEmpty(intptr_t index) {
+    free_map_[index / kBitsPerWord] |=
+        static_cast<uword>(1) << (index % kBitsPerWord);
+  }
+  void SetListEmpty(intptr_t index) {
+    free_map_[index / kBitsPerWord] &=
+        ~(static_cast<uword>(1) << (index % kBitsPerWord));
+  }
+
   void SplitElementAfterAndEnqueue(FreeListElement* element, intptr_t size);
 
-  FreeListElement* free_lists_[kNumLists + 1];
+  FreeListElement* free_lists_[kNumAllLists];
+  uword free_map_[kNumBitmapWords];
+  intptr_t free_bytes_;
 
   DISALLOW_COPY_AND_ASSIGN(FreeList);
 };
@@ -50,4 +50,40 @@ TEST_CASE(FreeList) {
   delete free_list;
 }
 
+
+TEST_CASE(FreeListSizeClasses) {
+  FreeList* free_list = new FreeList();
+  intptr_t kBlobSize = 1 * MB;
+  uword blob = reinterpret_cast<uword>(malloc(kBlobSize));
+  // Free blocks of increasing size separated by one allocated word.
+  intptr_t sizes[] = { 2 * kObjectAlignment,
+                       100 * kObjectAlignment,
+                       300 * kObjectAlignment,
+                       1000 * kObjectAlignment,
+                       5000 * kObjectAlignment };
+  intptr_t num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+  uword blocks[sizeof(sizes) / sizeof(sizes[0])];
+  uword current = blob;
+  intptr_t total = 0;
+  for (intptr_t i = num_sizes - 1; i >= 0; i--) {
+    blocks[i] = current;
+    free_list->Free(current, sizes[i]);
+    current += sizes[i] + kObjectAlignment;
+    total += sizes[i];
+  }
+  EXPECT_EQ(total, free_list->free_bytes());
+  // Each request is satisfied from the smallest block which can hold it.
+  EXPECT_EQ(blocks[1], free_list->TryAllocate(3 * kObjectAlignment));
+  EXPECT_EQ(blocks[2], free_list->TryAllocate(200 * kObjectAlignment));
+  EXPECT_EQ(blocks[3], free_list->TryAllocate(600 * kObjectAlignment));
+  EXPECT_EQ(blocks[0], free_list->TryAllocate(2 * kObjectAlignment));
+  // Only the largest block can hold this request.
+  EXPECT_EQ(blocks[4], free_list->TryAllocate(2000 * kObjectAlignment));
+  EXPECT_EQ(static_cast<uword>(0),
+            free_list->TryAllocate(4000 * kObjectAlignment));
+  EXPECT_EQ(total - (2805 * kObjectAlignment), free_list->free_bytes());
+  free(reinterpret_cast<void*>(blob));
+  delete free_list;
+}
+
 }  // namespace dart
@@ -0,0 +1,152 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/gc_compactor.h"
+
+#include "vm/dart_api_state.h"
+#include "vm/heap.h"
+#include "vm/isolate.h"
+#include "vm/pages.h"
+#include "vm/raw_object.h"
+#include "vm/stack_frame.h"
+#include "vm/store_buffer.h"
+#include "vm/visitor.h"
+
+namespace dart {
+
+enum {
+  kForwardingMask = 3,
+  kNotForwarded = 1,  // Tagged pointer.
+  kForwarded = 3,  // Tagged pointer and forwarding bit set.
+};
+
+
+static inline bool IsForwarding(uword header) {
+  uword bits = header & kForwardingMask;
+  ASSERT((bits == kNotForwarded) || (bits == kForwarded));
+  return bits == kForwarded;
+}
+
+
+static inline uword ForwardedAddr(uword header) {
+  ASSERT(IsForwarding(header));
+  return header & ~kForwardingMask;
+}
+
+
+static inline void ForwardTo(uword orignal, uword target) {
+  // Make sure forwarding can be encoded.
+  ASSERT((target & kForwardingMask) == 0);
+  *reinterpret_cast<uword*>(orignal) = target | kForwarded;
+}
+
+
+class CompactorVisitor : public ObjectPointerVisitor {
+ public:
+  explicit CompactorVisitor(StoreBuffer* store_buffer)
+      : store_buffer_(store_buffer),
+        visiting_old_object_(false) { }
+
+  void VisitPointers(RawObject** first, RawObject** last) {
+    for (RawObject** current = first; current <= last; current++) {
+      UpdatePointer(current);
+    }
+  }
+
+  void set_visiting_old_object(bool value) { visiting_old_object_ = value; }
+
+ private:
+  void UpdatePointer(RawObject** p) {
+    RawObject* raw_obj = *p;
+    if (!raw_obj->IsHeapObject()) {
+      return;
+    }
+    if (raw_obj->IsNewObject()) {
+      if (visiting_old_object_) {
+        store_buffer_->AddPointer(reinterpret_cast<uword>(p));
+      }
+      return;
+    }
+    // Only evacuated objects have their header overwritten.
+    uword header = *reinterpret_cast<uword*>(RawObject::ToAddr(raw_obj));
+    if (IsForwarding(header)) {
+      *p = RawObject::FromAddr(ForwardedAddr(header));
+    }
+  }
+
+  StoreBuffer* store_buffer_;
+  bool visiting_old_object_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompactorVisitor);
+};
+
+
+class CompactorWeakVisitor : public HandleVisitor {
+ public:
+  explicit CompactorWeakVisitor(ObjectPointerVisitor* visitor)
+      : visitor_(visitor) { }
+
+  void VisitHandle(uword addr) {
+    FinalizablePersistentHandle* handle =
+        reinterpret_cast<FinalizablePersistentHandle*>(addr);
+    RawObject* raw_obj = handle->raw();
+    visitor_->VisitPointer(&raw_obj);
+    handle->set_raw(raw_obj);
+  }
+
+ private:
+  ObjectPointerVisitor* visitor_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompactorWeakVisitor);
+};
+
+
+void GCCompactor::MoveObject(RawObject* raw_obj, uword target, intptr_t size) {
+  ASSERT(raw_obj->IsMarked());
+  uword raw_addr = RawObject::ToAddr(raw_obj);
+  memmove(reinterpret_cast<void*>(target),
+          reinterpret_cast<void*>(raw_addr),
+          size);
+  ForwardTo(raw_addr, target);
+}
+
+
+void GCCompactor::UpdateRoots(Isolate* isolate) {
+  // Slots in moved objects are stale, they are remembered again while
+  // updating the kept pages.
+  isolate->store_buffer()->Reset();
+  heap_->store_buffer()->Reset();
+  CompactorVisitor visitor(heap_->store_buffer());
+  isolate->VisitObjectPointers(&visitor,
+                               true,
+                               StackFrameIterator::kDontValidateFrames);
+  heap_->IterateNewPointers(&visitor);
+  heap_->IterateCodePointers(&visitor);
+  heap_->IterateStubCodePointers(&visitor);
+  CompactorWeakVisitor weak_visitor(&visitor);
+  isolate->VisitWeakPersistentHandles(&weak_visitor, true);
+}
+
+
+void GCCompactor::UpdatePage(HeapPage* page) {
+  CompactorVisitor visitor(heap_->store_buffer());
+  visitor.set_visiting_old_object(true);
+  uword current = page->first_object_start();
+  uword end = page->top();
+  while (current < end) {
+    RawObject* raw_obj = RawObject::FromAddr(current);
+    intptr_t size = raw_obj->Size();
+    if (raw_obj->IsMarked()) {
+      raw_obj->VisitPointers(&visitor);
+    } else {
+      // Dead objects are only left for the sweeper, which still needs their
+      // class to determine their size.
+      visitor.VisitPointer(
+          reinterpret_cast<RawObject**>(&raw_obj->ptr()->class_));
+    }
+    current += size;
+  }
+}
+
+}  // namespace dart
@@ -0,0 +1,47 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef VM_GC_COMPACTOR_H_
+#define VM_GC_COMPACTOR_H_
+
+#include "vm/allocation.h"
+#include "vm/globals.h"
+
+namespace dart {
+
+// Forward declarations.
+class Heap;
+class HeapPage;
+class Isolate;
+class RawObject;
+
+// The class GCCompactor is used to evacuate the marked objects of sparse old
+// generation pages as part of the mark-sweep collection. Moved objects leave
+// a forwarding pointer behind, which is used to update all pointers to them
+// before the evacuated pages are released.
+class GCCompactor : public ValueObject {
+ public:
+  explicit GCCompactor(Heap* heap) : heap_(heap) { }
+  ~GCCompactor() { }
+
+  // Copy the marked object to 'target' and forward the original to the copy.
+  void MoveObject(RawObject* raw_obj, uword target, intptr_t size);
+
+  // Update the pointers in the roots, the new generation, the code spaces
+  // and the weak persistent handles.
+  void UpdateRoots(Isolate* isolate);
+
+  // Update the pointers in the marked objects of a page which is kept. Slots
+  // pointing into the new generation are remembered again.
+  void UpdatePage(HeapPage* page);
+
+ private:
+  Heap* heap_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(GCCompactor);
+};
+
+}  // namespace dart
+
+#endif  // VM_GC_COMPACTOR_H_
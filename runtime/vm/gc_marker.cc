@@ -5,15 +5,25 @@
 #include "vm/gc_marker.h"
 
 #include "vm/allocation.h"
+#include "vm/dart.h"
 #include "vm/dart_api_state.h"
+#include "vm/flags.h"
+#include "vm/heap.h"
 #include "vm/isolate.h"
 #include "vm/pages.h"
 #include "vm/raw_object.h"
 #include "vm/stack_frame.h"
+#include "vm/store_buffer.h"
+#include "vm/thread.h"
+#include "vm/thread_pool.h"
 #include "vm/visitor.h"
 
 namespace dart {
 
+DEFINE_FLAG(int, marker_tasks, 0,
+            "The number of tasks to spawn during old gen GC marking "
+            "(0 means perform all marking on the main thread).");
+
 // A simple chunked marking stack.
 class MarkingStack : public ValueObject {
  public:
@@ -75,7 +85,6 @@ class MarkingStack : public ValueObject {
     return marking_stack_[top_];
   }
 
- private:
   class MarkingStackChunk {
    public:
     MarkingStackChunk() : next_(NULL) {}
@@ -97,6 +106,27 @@ class MarkingStack : public ValueObject {
     DISALLOW_COPY_AND_ASSIGN(MarkingStackChunk);
   };
 
+  // All chunks below the current one are full and can be handed over to
+  // another marker task.
+  bool HasSpareChunk() const {
+    return head_->next() != NULL;
+  }
+
+  MarkingStackChunk* TakeSpareChunk() {
+    ASSERT(HasSpareChunk());
+    MarkingStackChunk* chunk = head_->next();
+    head_->set_next(chunk->next());
+    chunk->set_next(NULL);
+    return chunk;
+  }
+
+  void AddFullChunk(MarkingStackChunk* chunk) {
+    ASSERT(chunk->next() == NULL);
+    chunk->set_next(head_->next());
+    head_->set_next(chunk);
+  }
+
+ private:
   bool IsMarkingStackChunkFull() const {
     return top_ == MarkingStackChunk::kMarkingStackChunkSize;
   }
@@ -114,33 +144,163 @@ class MarkingStack : public ValueObject {
 };
 
 
+// Full marking stack chunks shared between the marker tasks. Busy tasks hand
+// over their spare chunks while other tasks are idle. Marking is complete
+// once all tasks are idle and no chunks are left to be processed.
+class MarkingWorkList : public ValueObject {
+ public:
+  MarkingWorkList(intptr_t num_workers, intptr_t num_tasks)
+      : chunks_(NULL),
+        num_workers_(num_workers),
+        num_idle_(0),
+        num_running_tasks_(num_tasks),
+        done_(false) {
+    ASSERT(num_tasks < num_workers);
+  }
+
+  ~MarkingWorkList() {
+    ASSERT(chunks_ == NULL);
+    ASSERT(num_running_tasks_ == 0);
+  }
+
+  // Racy read, only used as a hint whether work should be handed over.
+  bool HasIdleWorkers() const { return num_idle_ > 0; }
+
+  void Publish(MarkingStack::MarkingStackChunk* chunk) {
+    MonitorLocker ml(&monitor_);
+    chunk->set_next(chunks_);
+    chunks_ = chunk;
+    ml.Notify();
+  }
+
+  // Blocks until a chunk is available. Returns NULL when marking is complete.
+  MarkingStack::MarkingStackChunk* WaitForWork() {
+    MonitorLocker ml(&monitor_);
+    num_idle_++;
+    while (true) {
+      if (chunks_ != NULL) {
+        MarkingStack::MarkingStackChunk* chunk = chunks_;
+        chunks_ = chunk->next();
+        chunk->set_next(NULL);
+        num_idle_--;
+        return chunk;
+      }
+      if (done_) {
+        return NULL;
+      }
+      if (num_idle_ == num_workers_) {
+        done_ = true;
+        ml.NotifyAll();
+        return NULL;
+      }
+      ml.Wait();
+    }
+  }
+
+  // Called by each marker task when it has finished. The slots it remembered
+  // are added to the heap's store buffer, serialized by the monitor.
+  void TaskDone(StoreBuffer* task_buffer, StoreBuffer* heap_buffer) {
+    MonitorLocker ml(&monitor_);
+    ASSERT(done_);
+    heap_buffer->AddAll(*task_buffer);
+    num_running_tasks_--;
+    ml.NotifyAll();
+  }
+
+  void WaitForTasks() {
+    MonitorLocker ml(&monitor_);
+    while (num_running_tasks_ > 0) {
+      ml.Wait();
+    }
+  }
+
+ private:
+  Monitor monitor_;
+  MarkingStack::MarkingStackChunk* chunks_;
+  const intptr_t num_workers_;
+  volatile intptr_t num_idle_;
+  intptr_t num_running_tasks_;
+  bool done_;
+
+  DISALLOW_COPY_AND_ASSIGN(MarkingWorkList);
+};
+
+
 class MarkingVisitor : public ObjectPointerVisitor {
  public:
-  MarkingVisitor(Heap* heap, PageSpace* page_space, MarkingStack* marking_stack)
+  MarkingVisitor(Heap* heap,
+                 PageSpace* page_space,
+                 MarkingStack* marking_stack,
+                 StoreBuffer* store_buffer)
       : heap_(heap),
         vm_heap_(Dart::vm_isolate()->heap()),
         page_space_(page_space),
-        marking_stack_(marking_stack) {
+        marking_stack_(marking_stack),
+        store_buffer_(store_buffer),
+        work_list_(NULL),
+        visiting_old_object_(NULL) {
     ASSERT(heap_ != vm_heap_);
   }
 
   MarkingStack* marking_stack() const { return marking_stack_; }
 
+  // While a work list is set spare marking stack chunks are handed over to
+  // idle marker tasks.
+  void set_work_list(MarkingWorkList* work_list) { work_list_ = work_list; }
+
+  void DrainMarkingStack() {
+    while (!marking_stack_->IsEmpty()) {
+      RawObject* raw_obj = marking_stack_->Pop();
+      VisitingOldObject(raw_obj);
+      raw_obj->VisitPointers(this);
+      if ((work_list_ != NULL) &&
+          marking_stack_->HasSpareChunk() &&
+          work_list_->HasIdleWorkers()) {
+        work_list_->Publish(marking_stack_->TakeSpareChunk());
+      }
+    }
+    VisitingOldObject(NULL);
+  }
+
+  // Drain the local marking stack and then take over chunks published by
+  // the other marker tasks until all of them run out of work.
+  void DrainMarkingStackShared() {
+    ASSERT(work_list_ != NULL);
+    while (true) {
+      DrainMarkingStack();
+      MarkingStack::MarkingStackChunk* chunk = work_list_->WaitForWork();
+      if (chunk == NULL) {
+        return;
+      }
+      marking_stack_->AddFullChunk(chunk);
+    }
+  }
+
   void VisitPointers(RawObject** first, RawObject** last) {
     for (RawObject** current = first; current <= last; current++) {
-      MarkObject(*current);
+      MarkObject(*current, current);
     }
   }
 
+  // The store buffer is rebuilt while marking: set the old object whose
+  // pointers are being visited, or NULL when visiting roots.
+  void VisitingOldObject(RawObject* raw_obj) {
+    ASSERT((raw_obj == NULL) || raw_obj->IsOldObject());
+    visiting_old_object_ = raw_obj;
+  }
+
  private:
   void MarkAndPush(RawObject* raw_obj) {
     ASSERT(raw_obj->IsHeapObject());
     ASSERT(page_space_->Contains(RawObject::ToAddr(raw_obj)));
 
-    // Mark the object and push it on the marking stack.
-    ASSERT(!raw_obj->IsMarked());
+    // Mark the object and push it on the marking stack. Another marker task
+    // may have won the race to mark this object, in which case it is
+    // responsible for visiting it.
     RawClass* raw_class = raw_obj->ptr()->class_;
-    raw_obj->SetMarkBit();
+    if (!raw_obj->TryAcquireMarkBit()) {
+      return;
+    }
     marking_stack_->Push(raw_obj);
 
     // Update the number of used bytes on this page for fast accounting.
@@ -148,10 +308,11 @@ class MarkingVisitor : public ObjectPointerVisitor {
     page->AddUsed(raw_obj->Size());
 
     // TODO(iposva): Should we mark the classes early?
-    MarkObject(raw_class);
+    ASSERT(!raw_class->IsNewObject());
+    MarkObject(raw_class, NULL);
   }
 
-  void MarkObject(RawObject* raw_obj) {
+  void MarkObject(RawObject* raw_obj, RawObject** p) {
     // Fast exit if the raw object is a Smi.
     if (!raw_obj->IsHeapObject()) return;
 
@@ -161,6 +322,10 @@ class MarkingVisitor : public ObjectPointerVisitor {
     // Skip over new objects, but verify consistency of heap while at it.
     if (raw_obj->IsNewObject()) {
       // TODO(iposva): Add consistency check.
+      if (visiting_old_object_ != NULL) {
+        // Remember the old to new pointer for the next scavenge.
+        store_buffer_->AddPointer(reinterpret_cast<uword>(p));
+      }
       return;
     }
 
@@ -178,11 +343,43 @@ class MarkingVisitor : public ObjectPointerVisitor {
   Heap* vm_heap_;
   PageSpace* page_space_;
   MarkingStack* marking_stack_;
+  StoreBuffer* store_buffer_;
+  MarkingWorkList* work_list_;
+  RawObject* visiting_old_object_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(MarkingVisitor);
 };
 
 
+// Helper task for the parallel marker. Slots remembered by the task are
+// collected in a private store buffer and merged once marking is done.
+class MarkTask : public ThreadPool::Task {
+ public:
+  MarkTask(Heap* heap, PageSpace* page_space, MarkingWorkList* work_list)
+      : heap_(heap),
+        page_space_(page_space),
+        work_list_(work_list) {
+  }
+
+  virtual void Run() {
+    MarkingStack marking_stack;
+    StoreBuffer store_buffer;
+    MarkingVisitor visitor(heap_, page_space_, &marking_stack, &store_buffer);
+    visitor.set_work_list(work_list_);
+    visitor.DrainMarkingStackShared();
+    // The work list must not be accessed after signalling completion.
+    work_list_->TaskDone(&store_buffer, heap_->store_buffer());
+  }
+
+ private:
+  Heap* heap_;
+  PageSpace* page_space_;
+  MarkingWorkList* work_list_;
+
+  DISALLOW_COPY_AND_ASSIGN(MarkTask);
+};
+
+
 bool IsUnreachable(const RawObject* raw_obj) {
   if (!raw_obj->IsHeapObject()) {
     return false;
@@ -217,6 +414,10 @@ void GCMarker::Prologue(Isolate* isolate, bool invoke_api_callbacks) {
   if (invoke_api_callbacks) {
     isolate->gc_prologue_callbacks().Invoke();
   }
+  // The store buffer is rebuilt from the surviving old objects during
+  // marking, which also drops slots of old objects about to be swept.
+  isolate->store_buffer()->Reset();
+  heap_->store_buffer()->Reset();
 }
 
 
@@ -303,10 +504,23 @@ void GCMarker::IterateWeakReferences(Isolate* isolate,
 
 void GCMarker::DrainMarkingStack(Isolate* isolate,
                                  MarkingVisitor* visitor) {
-  while (!visitor->marking_stack()->IsEmpty()) {
-    RawObject* raw_obj = visitor->marking_stack()->Pop();
-    raw_obj->VisitPointers(visitor);
+  visitor->DrainMarkingStack();
+}
+
+
+void GCMarker::DrainMarkingStackParallel(Isolate* isolate,
+                                         PageSpace* page_space,
+                                         MarkingVisitor* visitor) {
+  intptr_t num_tasks = FLAG_marker_tasks;
+  // The mutator thread takes part in marking as well.
+  MarkingWorkList work_list(num_tasks + 1, num_tasks);
+  for (intptr_t i = 0; i < num_tasks; i++) {
+    Dart::thread_pool()->Run(new MarkTask(heap_, page_space, &work_list));
   }
+  visitor->set_work_list(&work_list);
+  visitor->DrainMarkingStackShared();
+  visitor->set_work_list(NULL);
+  work_list.WaitForTasks();
 }
 
 
@@ -315,9 +529,15 @@ void GCMarker::MarkObjects(Isolate* isolate,
                            bool invoke_api_callbacks) {
   MarkingStack marking_stack;
   Prologue(isolate, invoke_api_callbacks);
-  MarkingVisitor mark(heap_, page_space, &marking_stack);
+  MarkingVisitor mark(heap_, page_space, &marking_stack, heap_->store_buffer());
   IterateRoots(isolate, &mark, !invoke_api_callbacks);
-  DrainMarkingStack(isolate, &mark);
+  if ((FLAG_marker_tasks > 0) && (Dart::thread_pool() != NULL)) {
+    DrainMarkingStackParallel(isolate, page_space, &mark);
+  } else {
+    DrainMarkingStack(isolate, &mark);
+  }
+  // Weak references and weak persistent handles are processed on the
+  // mutator thread once all reachable objects have been marked.
   IterateWeakReferences(isolate, &mark);
   MarkingWeakVisitor mark_weak;
   IterateWeakRoots(isolate, &mark_weak, invoke_api_callbacks);
@@ -39,6 +39,9 @@ class GCMarker : public ValueObject {
                         bool visit_prologue_weak_persistent_handles);
   void IterateWeakReferences(Isolate* isolate, MarkingVisitor* visitor);
   void DrainMarkingStack(Isolate* isolate, MarkingVisitor* visitor);
+  void DrainMarkingStackParallel(Isolate* isolate,
+                                 PageSpace* page_space,
+                                 MarkingVisitor* visitor);
 
   Heap* heap_;
 
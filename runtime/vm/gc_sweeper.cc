@@ -15,6 +15,7 @@ intptr_t GCSweeper::SweepPage(HeapPage* page, FreeList* freelist) {
   // sweeping early. Reset the per page in_use count for the next marking phase.
   intptr_t in_use_swept = 0;
   intptr_t in_use = page->used();
+  intptr_t freelist_bytes = 0;
   page->set_used(0);
 
   uword current = page->first_object_start();
@@ -50,11 +51,13 @@ intptr_t GCSweeper::SweepPage(HeapPage* page, FreeList* freelist) {
         break;
       } else {
         freelist->Free(current, obj_size);
+        freelist_bytes += obj_size;
       }
     }
     current += obj_size;
   }
 
+  page->set_freelist_bytes(freelist_bytes);
   return in_use_swept;
 }
 
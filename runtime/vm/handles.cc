@@ -99,12 +99,17 @@ HandleScope::~HandleScope() {
 
 #if defined(DEBUG)
 NoHandleScope::NoHandleScope(BaseIsolate* isolate) : StackResource(isolate) {
-  isolate->IncrementNoHandleScopeDepth();
+  // Helper threads, e.g. parallel marker tasks, run without a current isolate.
+  if (isolate != NULL) {
+    isolate->IncrementNoHandleScopeDepth();
+  }
 }
 
 
 NoHandleScope::~NoHandleScope() {
-  isolate()->DecrementNoHandleScopeDepth();
+  if (isolate() != NULL) {
+    isolate()->DecrementNoHandleScopeDepth();
+  }
 }
 #endif  // defined(DEBUG)
 
@@ -37,6 +37,7 @@ DEFINE_FLAG(int, stub_code_heap_size, Heap::kStubCodeHeapSizeInKB,
             "e.g: --stub_code_heap_size=256 allocates a 256KB stub code heap");
 
 Heap::Heap() {
+  store_buffer_ = new StoreBuffer();
   new_space_ = new Scavenger(this,
                              (FLAG_new_gen_heap_size * MB),
                              kNewObjectAlignmentOffset);
@@ -51,6 +52,7 @@ Heap::~Heap() {
   delete old_space_;
   delete code_space_;
   delete stub_code_space_;
+  delete store_buffer_;
 }
 
 
@@ -155,15 +157,6 @@ void Heap::IterateStubCodePointers(ObjectPointerVisitor* visitor) {
 }
 
 
-RawInstructions* Heap::FindObjectInCodeSpace(FindObjectVisitor* visitor) {
-  // The code heap can only have RawInstructions objects.
-  RawObject* raw_obj = code_space_->FindObject(visitor);
-  ASSERT((raw_obj == Object::null()) ||
-         (raw_obj->ptr()->class_->ptr()->instance_kind_ == kInstructions));
-  return reinterpret_cast<RawInstructions*>(raw_obj);
-}
-
-
 RawInstructions* Heap::FindObjectInStubCodeSpace(FindObjectVisitor* visitor) {
   // The stub code heap can only have RawInstructions objects.
   RawObject* raw_obj = stub_code_space_->FindObject(visitor);
@@ -226,6 +219,26 @@ uword Heap::EndAddress() {
 }
 
 
+uword Heap::OldTopAddress() {
+  return reinterpret_cast<uword>(old_space_->TopAddress());
+}
+
+
+uword Heap::OldEndAddress() {
+  return reinterpret_cast<uword>(old_space_->EndAddress());
+}
+
+
+uword Heap::PretenureTableAddress() {
+  return reinterpret_cast<uword>(new_space_->PretenureTableAddress());
+}
+
+
+uword Heap::PretenureLengthAddress() {
+  return reinterpret_cast<uword>(new_space_->PretenureLengthAddress());
+}
+
+
 void Heap::Init(Isolate* isolate) {
   ASSERT(isolate->heap() == NULL);
   Heap* heap = new Heap();
@@ -233,6 +246,25 @@ void Heap::Init(Isolate* isolate) {
 }
 
 
+intptr_t Heap::Used(Space space) const {
+  ASSERT((space == kNew) || (space == kOld));
+  return (space == kNew) ? new_space_->in_use() : old_space_->in_use();
+}
+
+
+intptr_t Heap::Capacity(Space space) const {
+  ASSERT((space == kNew) || (space == kOld));
+  return (space == kNew) ? new_space_->capacity() : old_space_->capacity();
+}
+
+
+int Heap::Collections(Space space) const {
+  ASSERT((space == kNew) || (space == kOld));
+  return (space == kNew) ? new_space_->collections() :
+      old_space_->collections();
+}
+
+
 bool Heap::Verify() const {
   VerifyPointersVisitor visitor(Isolate::Current());
   new_space_->VisitObjectPointers(&visitor);
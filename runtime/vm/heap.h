@@ -11,6 +11,7 @@
 #include "vm/globals.h"
 #include "vm/pages.h"
 #include "vm/scavenger.h"
+#include "vm/store_buffer.h"
 
 namespace dart {
 
@@ -81,6 +82,18 @@ class Heap {
     return 0;
   }
 
+  // The space in which instances of the class with the given index should be
+  // allocated: Dart classes whose instances survive their first scavenge are
+  // pretenured into old space for the next few scavenges.
+  Space SpaceForAllocation(intptr_t class_index) const {
+    return new_space_->ShouldPretenure(class_index) ? kOld : kNew;
+  }
+
+  // Statistics of the new and old space.
+  intptr_t Used(Space space) const;
+  intptr_t Capacity(Space space) const;
+  int Collections(Space space) const;
+
   // Heap contains the specified address.
   bool Contains(uword addr) const;
   bool CodeContains(uword addr) const;
@@ -99,16 +112,22 @@ class Heap {
   // point.
   // The 'visitor' function should return false if the object is not found,
   // traversal through the heap space continues.
-  RawInstructions* FindObjectInCodeSpace(FindObjectVisitor* visitor);
   RawInstructions* FindObjectInStubCodeSpace(FindObjectVisitor* visitor);
 
   void CollectGarbage(Space space);
   void CollectGarbage(Space space, ApiCallbacks api_callbacks);
   void CollectAllGarbage();
 
+  // The remembered set of old space slots pointing into new space.
+  StoreBuffer* store_buffer() const { return store_buffer_; }
+
   // Accessors for inlined allocation in generated code.
   uword TopAddress();
   uword EndAddress();
+  uword OldTopAddress();
+  uword OldEndAddress();
+  uword PretenureTableAddress();
+  uword PretenureLengthAddress();
   static intptr_t new_space_offset() { return OFFSET_OF(Heap, new_space_); }
 
   // Initialize the heap and register it with the isolate.
@@ -130,6 +149,8 @@ class Heap {
   PageSpace* code_space_;
   PageSpace* stub_code_space_;
 
+  StoreBuffer* store_buffer_;
+
   DISALLOW_COPY_AND_ASSIGN(Heap);
 };
 
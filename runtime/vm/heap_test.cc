@@ -3,12 +3,20 @@
 // BSD-style license that can be found in the LICENSE file.
 
 #include "platform/assert.h"
+#include "vm/class_finalizer.h"
 #include "vm/globals.h"
 #include "vm/heap.h"
+#include "vm/object.h"
 #include "vm/unit_test.h"
 
 namespace dart {
 
+DECLARE_FLAG(bool, compact_old_gen);
+DECLARE_FLAG(bool, lazy_sweep);
+DECLARE_FLAG(int, marker_tasks);
+DECLARE_FLAG(bool, pretenure);
+DECLARE_FLAG(int, tenure_age);
+
 // Only ia32 and x64 can run execution tests.
 #if defined(TARGET_ARCH_IA32) || defined(TARGET_ARCH_X64)
 TEST_CASE(OldGC) {
@@ -54,4 +62,189 @@ TEST_CASE(LargeSweep) {
 }
 
 #endif  // defined(TARGET_ARCH_IA32) || defined(TARGET_ARCH_X64).
+
+
+TEST_CASE(ParallelMarking) {
+  // Build enough reachable objects to fill several marking stack chunks, so
+  // that the work is distributed among the marker tasks.
+  const intptr_t kNumElements = 8 * 1024;
+  const Array& outer = Array::Handle(Array::New(kNumElements, Heap::kOld));
+  Array& inner = Array::Handle();
+  String& str = String::Handle();
+  for (intptr_t i = 0; i < kNumElements; i++) {
+    inner = Array::New(2, Heap::kOld);
+    str = String::New("old", Heap::kOld);
+    inner.SetAt(0, str);
+    str = String::New("new", Heap::kNew);
+    inner.SetAt(1, str);
+    outer.SetAt(i, inner);
+  }
+  Heap* heap = Isolate::Current()->heap();
+  int saved_marker_tasks = FLAG_marker_tasks;
+  FLAG_marker_tasks = 3;
+  heap->CollectGarbage(Heap::kOld);
+  heap->CollectGarbage(Heap::kOld);
+  FLAG_marker_tasks = saved_marker_tasks;
+  // The old to new slots remembered by the marker tasks keep the new strings
+  // alive across a scavenge.
+  heap->CollectGarbage(Heap::kNew);
+  for (intptr_t i = 0; i < kNumElements; i++) {
+    inner ^= outer.At(i);
+    str ^= inner.At(0);
+    EXPECT(str.Equals("old"));
+    str ^= inner.At(1);
+    EXPECT(str.Equals("new"));
+  }
+}
+
+
+TEST_CASE(LazySweep) {
+  const intptr_t kNumElements = 16 * 1024;
+  const Array& outer = Array::Handle(Array::New(kNumElements, Heap::kOld));
+  String& str = String::Handle();
+  for (intptr_t i = 0; i < kNumElements; i++) {
+    str = String::New("garbage", Heap::kOld);
+    outer.SetAt(i, str);
+  }
+  // Drop every other string, leaving free memory on each page.
+  for (intptr_t i = 0; i < kNumElements; i += 2) {
+    outer.SetAt(i, Object::Handle());
+  }
+  Heap* heap = Isolate::Current()->heap();
+  bool saved_lazy_sweep = FLAG_lazy_sweep;
+  FLAG_lazy_sweep = true;
+  heap->CollectGarbage(Heap::kOld);
+  // Allocation sweeps the pages holding the surviving strings.
+  for (intptr_t i = 0; i < kNumElements; i += 2) {
+    str = String::New("new", Heap::kOld);
+    outer.SetAt(i, str);
+  }
+  for (intptr_t i = 0; i < kNumElements; i++) {
+    str ^= outer.At(i);
+    EXPECT(str.Equals(((i % 2) == 0) ? "new" : "garbage"));
+  }
+  // Pages not swept by allocation are swept before marking again.
+  heap->CollectGarbage(Heap::kOld);
+  FLAG_lazy_sweep = saved_lazy_sweep;
+  for (intptr_t i = 0; i < kNumElements; i++) {
+    str ^= outer.At(i);
+    EXPECT(str.Equals(((i % 2) == 0) ? "new" : "garbage"));
+  }
+}
+
+
+TEST_CASE(CompactOldGen) {
+  const intptr_t kNumElements = 64 * 1024;
+  const intptr_t kKeepEvery = 16;
+  const Array& outer = Array::Handle(Array::New(kNumElements, Heap::kOld));
+  String& str = String::Handle();
+  for (intptr_t i = 0; i < kNumElements; i++) {
+    str = String::New("a string which survives", Heap::kOld);
+    outer.SetAt(i, str);
+  }
+  // Keep a handle to one of the surviving strings.
+  const String& kept = String::Handle(String::New("kept", Heap::kOld));
+  outer.SetAt(kKeepEvery, kept);
+  // Drop most strings, so that the old gen pages become sparse.
+  for (intptr_t i = 0; i < kNumElements; i++) {
+    if ((i % kKeepEvery) != 0) {
+      outer.SetAt(i, Object::Handle());
+    }
+  }
+  Heap* heap = Isolate::Current()->heap();
+  // Every page still holds a surviving string, so only evacuating the sparse
+  // pages releases old gen capacity.
+  const intptr_t capacity_before = heap->Capacity(Heap::kOld);
+  bool saved_compact_old_gen = FLAG_compact_old_gen;
+  FLAG_compact_old_gen = true;
+  heap->CollectGarbage(Heap::kOld);
+  FLAG_compact_old_gen = saved_compact_old_gen;
+  // The strings filled at least ten pages, a sixteenth of them survives.
+  const intptr_t released = capacity_before - heap->Capacity(Heap::kOld);
+  EXPECT(released >= (4 * PageSpace::kPageSize));
+  heap->CollectGarbage(Heap::kOld);
+  for (intptr_t i = 0; i < kNumElements; i += kKeepEvery) {
+    str ^= outer.At(i);
+    EXPECT(str.Equals((i == kKeepEvery) ? "kept" : "a string which survives"));
+  }
+  // The handle has been updated to the moved string.
+  EXPECT(kept.Equals("kept"));
+  str ^= outer.At(kKeepEvery);
+  EXPECT(str.raw() == kept.raw());
+}
+
+TEST_CASE(Pretenuring) {
+  const char* kScriptChars =
+      "class A {\n"
+      "  var x;\n"
+      "  var y;\n"
+      "}\n";
+  String& url = String::Handle(String::New("dart-test:Pretenuring"));
+  String& source = String::Handle(String::New(kScriptChars));
+  Script& script = Script::Handle(Script::New(url, source, RawScript::kSource));
+  Library& lib = Library::Handle(Library::CoreLibrary());
+  EXPECT(CompilerTest::TestCompileScript(lib, script));
+  EXPECT(ClassFinalizer::FinalizePendingClasses());
+  const Class& cls = Class::Handle(
+      lib.LookupClass(String::Handle(String::NewSymbol("A"))));
+  EXPECT(!cls.IsNull());
+
+  const intptr_t kNumElements = 4 * 1024;
+  Heap* heap = Isolate::Current()->heap();
+  bool saved_pretenure = FLAG_pretenure;
+  FLAG_pretenure = true;
+  EXPECT_EQ(Heap::kNew, heap->SpaceForAllocation(cls.index()));
+  // All instances and arrays allocated in new space survive the next
+  // scavenge.
+  const Array& instances = Array::Handle(Array::New(kNumElements, Heap::kOld));
+  const Array& arrays = Array::Handle(Array::New(kNumElements, Heap::kOld));
+  Instance& instance = Instance::Handle();
+  Array& array = Array::Handle();
+  for (intptr_t i = 0; i < kNumElements; i++) {
+    instance = Instance::New(cls, Heap::kNew);
+    instances.SetAt(i, instance);
+    array = Array::New(2, Heap::kNew);
+    arrays.SetAt(i, array);
+  }
+  heap->CollectGarbage(Heap::kNew);
+  EXPECT_EQ(Heap::kOld, heap->SpaceForAllocation(cls.index()));
+  // Arrays are allocated at too many unrelated sites to be pretenured.
+  EXPECT_EQ(Heap::kNew, heap->SpaceForAllocation(Array::kInstanceKind));
+
+  // Without new allocations the decision expires after a few scavenges.
+  intptr_t scavenges = 0;
+  while ((heap->SpaceForAllocation(cls.index()) == Heap::kOld) &&
+         (scavenges < 100)) {
+    heap->CollectGarbage(Heap::kNew);
+    scavenges++;
+  }
+  FLAG_pretenure = saved_pretenure;
+  EXPECT(scavenges > 0);
+  EXPECT_EQ(Heap::kNew, heap->SpaceForAllocation(cls.index()));
+  for (intptr_t i = 0; i < kNumElements; i++) {
+    instance ^= instances.At(i);
+    EXPECT_EQ(cls.raw(), instance.clazz());
+    array ^= arrays.At(i);
+    EXPECT_EQ(2, array.Length());
+  }
+}
+
+
+TEST_CASE(TenureAge) {
+  Heap* heap = Isolate::Current()->heap();
+  int saved_tenure_age = FLAG_tenure_age;
+  FLAG_tenure_age = 2;
+  const String& str = String::Handle(String::New("aging", Heap::kNew));
+  EXPECT(str.raw()->IsNewObject());
+  // The string stays in new space for two scavenges.
+  heap->CollectGarbage(Heap::kNew);
+  EXPECT(str.raw()->IsNewObject());
+  heap->CollectGarbage(Heap::kNew);
+  EXPECT(str.raw()->IsNewObject());
+  heap->CollectGarbage(Heap::kNew);
+  EXPECT(str.raw()->IsOldObject());
+  EXPECT(str.Equals("aging"));
+  FLAG_tenure_age = saved_tenure_age;
 }
+
+}  // namespace dart
@@ -33,6 +33,12 @@ Instruction* TargetEntryInstr::Accept(FlowGraphVisitor* visitor) {
 }
 
 
+Instruction* PhiInstr::Accept(FlowGraphVisitor* visitor) {
+  visitor->VisitPhi(this);
+  return NULL;
+}
+
+
 Instruction* PickTempInstr::Accept(FlowGraphVisitor* visitor) {
   visitor->VisitPickTemp(this);
   return successor_;
@@ -192,6 +198,268 @@ intptr_t JoinEntryInstr::InputCount() const {
 }
 
 
+intptr_t PhiInstr::InputCount() const {
+  // Phi inputs are versions of a local, not values.
+  return 0;
+}
+
+
+// ==== Per-instruction inputs.
+Value* AssertAssignableComp::InputAt(intptr_t i) const {
+  ASSERT((i >= 0) && (i < InputCount()));
+  return (i == 0) ? value_ : instantiator_type_arguments_;
+}
+
+
+void AssertAssignableComp::SetInputAt(intptr_t i, Value* value) {
+  ASSERT((i >= 0) && (i < InputCount()));
+  if (i == 0) {
+    value_ = value;
+  } else {
+    instantiator_type_arguments_ = value;
+  }
+}
+
+
+Value* InstanceOfComp::InputAt(intptr_t i) const {
+  ASSERT((i >= 0) && (i < InputCount()));
+  return (i == 0) ? value_ : type_arguments_;
+}
+
+
+void InstanceOfComp::SetInputAt(intptr_t i, Value* value) {
+  ASSERT((i >= 0) && (i < InputCount()));
+  if (i == 0) {
+    value_ = value;
+  } else {
+    type_arguments_ = value;
+  }
+}
+
+
+Value* CreateClosureComp::InputAt(intptr_t i) const {
+  ASSERT(i == 0);
+  return type_arguments_;
+}
+
+
+void CreateClosureComp::SetInputAt(intptr_t i, Value* value) {
+  ASSERT(i == 0);
+  type_arguments_ = value;
+}
+
+
+Value* InstanceCallComp::InputAt(intptr_t i) const {
+  return ArgumentAt(i);
+}
+
+
+void InstanceCallComp::SetInputAt(intptr_t i, Value* value) {
+  (*arguments_)[i] = value;
+}
+
+
+Value* StaticCallComp::InputAt(intptr_t i) const {
+  return ArgumentAt(i);
+}
+
+
+void StaticCallComp::SetInputAt(intptr_t i, Value* value) {
+  (*arguments_)[i] = value;
+}
+
+
+Value* ClosureCallComp::InputAt(intptr_t i) const {
+  // The context is pushed before the arguments.
+  return (i == 0) ? context_ : ArgumentAt(i - 1);
+}
+
+
+void ClosureCallComp::SetInputAt(intptr_t i, Value* value) {
+  if (i == 0) {
+    context_ = value;
+  } else {
+    (*arguments_)[i - 1] = value;
+  }
+}
+
+
+Value* AllocateObjectComp::InputAt(intptr_t i) const {
+  return (*arguments_)[i];
+}
+
+
+void AllocateObjectComp::SetInputAt(intptr_t i, Value* value) {
+  (*arguments_)[i] = value;
+}
+
+
+Value* AllocateObjectWithBoundsCheckComp::InputAt(intptr_t i) const {
+  return (*arguments_)[i];
+}
+
+
+void AllocateObjectWithBoundsCheckComp::SetInputAt(intptr_t i, Value* value) {
+  (*arguments_)[i] = value;
+}
+
+
+Value* CreateArrayComp::InputAt(intptr_t i) const {
+  // The element type is pushed after the elements.
+  return (i < ElementCount()) ? ElementAt(i) : element_type_;
+}
+
+
+void CreateArrayComp::SetInputAt(intptr_t i, Value* value) {
+  if (i < ElementCount()) {
+    (*elements_)[i] = value;
+  } else {
+    ASSERT(i == ElementCount());
+    element_type_ = value;
+  }
+}
+
+
+Value* BranchInstr::InputAt(intptr_t i) const {
+  ASSERT(i == 0);
+  return value_;
+}
+
+
+void BranchInstr::SetInputAt(intptr_t i, Value* value) {
+  ASSERT(i == 0);
+  value_ = value;
+}
+
+
+Value* ReThrowInstr::InputAt(intptr_t i) const {
+  ASSERT((i == 0) || (i == 1));
+  return (i == 0) ? exception_ : stack_trace_;
+}
+
+
+void ReThrowInstr::SetInputAt(intptr_t i, Value* value) {
+  ASSERT((i == 0) || (i == 1));
+  if (i == 0) {
+    exception_ = value;
+  } else {
+    stack_trace_ = value;
+  }
+}
+
+
+Value* ThrowInstr::InputAt(intptr_t i) const {
+  ASSERT(i == 0);
+  return exception_;
+}
+
+
+void ThrowInstr::SetInputAt(intptr_t i, Value* value) {
+  ASSERT(i == 0);
+  exception_ = value;
+}
+
+
+Value* ReturnInstr::InputAt(intptr_t i) const {
+  ASSERT(i == 0);
+  return value_;
+}
+
+
+void ReturnInstr::SetInputAt(intptr_t i, Value* value) {
+  ASSERT(i == 0);
+  value_ = value;
+}
+
+
+Value* BindInstr::InputAt(intptr_t i) const {
+  return computation()->InputAt(i);
+}
+
+
+void BindInstr::SetInputAt(intptr_t i, Value* value) {
+  computation()->SetInputAt(i, value);
+}
+
+
+Value* DoInstr::InputAt(intptr_t i) const {
+  return computation()->InputAt(i);
+}
+
+
+void DoInstr::SetInputAt(intptr_t i, Value* value) {
+  computation()->SetInputAt(i, value);
+}
+
+
+// Instructions without value inputs.
+#define DEFINE_NO_INPUTS(type)                                                 \
+  Value* type##Instr::InputAt(intptr_t i) const {                              \
+    UNREACHABLE();                                                             \
+    return NULL;                                                               \
+  }                                                                            \
+  void type##Instr::SetInputAt(intptr_t i, Value* value) {                     \
+    UNREACHABLE();                                                             \
+  }
+
+DEFINE_NO_INPUTS(TuckTemp)
+DEFINE_NO_INPUTS(PickTemp)
+DEFINE_NO_INPUTS(TargetEntry)
+DEFINE_NO_INPUTS(JoinEntry)
+DEFINE_NO_INPUTS(Phi)
+
+#undef DEFINE_NO_INPUTS
+
+
+// ==== Basic blocks.
+Instruction* Instruction::NextInBlock() {
+  // Control does not fall through a return, throw, or branch, even though
+  // a throw can have a straight-line successor.
+  if (IsReturn() || IsThrow() || IsReThrow() || IsBranch()) return NULL;
+  Instruction* next = StraightLineSuccessor();
+  return ((next == NULL) || next->IsBlockEntry()) ? NULL : next;
+}
+
+
+intptr_t BlockEntryInstr::SuccessorCount() {
+  Instruction* last =
+      (last_instruction() == NULL) ? this : last_instruction();
+  if (last->IsBranch()) return 2;
+  Instruction* next = last->StraightLineSuccessor();
+  return ((next != NULL) && next->IsBlockEntry()) ? 1 : 0;
+}
+
+
+BlockEntryInstr* BlockEntryInstr::SuccessorAt(intptr_t index) {
+  Instruction* last =
+      (last_instruction() == NULL) ? this : last_instruction();
+  BranchInstr* branch = last->AsBranch();
+  if (branch != NULL) {
+    ASSERT((index == 0) || (index == 1));
+    return (index == 0) ? branch->true_successor() : branch->false_successor();
+  }
+  ASSERT(index == 0);
+  return last->StraightLineSuccessor()->AsBlockEntry();
+}
+
+
+intptr_t BlockEntryInstr::IndexOfPredecessor(BlockEntryInstr* pred) const {
+  for (intptr_t i = 0; i < PredecessorCount(); ++i) {
+    if (PredecessorAt(i) == pred) return i;
+  }
+  UNREACHABLE();
+  return -1;
+}
+
+
+void JoinEntryInstr::InsertPhi(PhiInstr* phi) {
+  if (phis_ == NULL) {
+    phis_ = new ZoneGrowableArray<PhiInstr*>();
+  }
+  phis_->Add(phi);
+}
+
+
 // ==== Postorder graph traversal.
 void JoinEntryInstr::DiscoverBlocks(
     BlockEntryInstr* current_block,
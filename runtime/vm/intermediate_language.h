@@ -53,6 +53,7 @@ class LocalVariable;
   M(AllocateObject, AllocateObjectComp)                                        \
   M(AllocateObjectWithBoundsCheck, AllocateObjectWithBoundsCheckComp)          \
   M(NativeLoadField, NativeLoadFieldComp)                                      \
+  M(LoadClass, LoadClassComp)                                                  \
   M(InstantiateTypeArguments, InstantiateTypeArgumentsComp)                    \
   M(ExtractConstructorTypeArguments, ExtractConstructorTypeArgumentsComp)      \
   M(ExtractConstructorInstantiator, ExtractConstructorInstantiatorComp)        \
@@ -66,6 +67,8 @@ class LocalVariable;
 FOR_EACH_COMPUTATION(FORWARD_DECLARATION)
 #undef FORWARD_DECLARATION
 
+class Value;
+
 class Computation : public ZoneAllocated {
  public:
   static const int kNoCid = -1;
@@ -84,7 +87,23 @@ class Computation : public ZoneAllocated {
   // Visiting support.
   virtual void Accept(FlowGraphVisitor* visitor) = 0;
 
+  // Inputs are numbered in the order their values are pushed, so the last
+  // input is the top of the stack when the computation is executed.
   virtual intptr_t InputCount() const = 0;
+  virtual Value* InputAt(intptr_t i) const = 0;
+  virtual void SetInputAt(intptr_t i, Value* value) = 0;
+
+  // False if the computation only produces a value, so it can be removed
+  // when the value is unused and reused when it is recomputed.  Calls,
+  // stores, allocations, and checks that can throw all have side effects.
+  virtual bool HasSideEffect() const { return true; }
+
+#define DEFINE_TESTERS(ShortName, ClassName)                                   \
+  virtual ClassName* As##ShortName() { return NULL; }                          \
+  bool Is##ShortName() { return As##ShortName() != NULL; }
+
+  FOR_EACH_COMPUTATION(DEFINE_TESTERS)
+#undef DEFINE_TESTERS
 
  private:
   friend class Instruction;
@@ -120,11 +139,15 @@ class EmbeddedArray {
  public:
   EmbeddedArray() : elements_() { }
 
-  intptr_t length() { return N; }
+  intptr_t length() const { return N; }
   T& operator[](intptr_t i) {
     ASSERT(i < length());
     return elements_[i];
   }
+  const T& operator[](intptr_t i) const {
+    ASSERT(i < length());
+    return elements_[i];
+  }
 
  private:
   T elements_[N];
@@ -134,21 +157,26 @@ class EmbeddedArray {
 template<typename T>
 class EmbeddedArray<T, 0> {
  public:
-  int length() { return 0; }
+  int length() const { return 0; }
   T& operator[](intptr_t i) {
     UNREACHABLE();
     static T sentinel = 0;
     return sentinel;
   }
+  const T& operator[](intptr_t i) const {
+    UNREACHABLE();
+    static T sentinel = 0;
+    return sentinel;
+  }
 };
 
 
-class Value;
-
 template<intptr_t N>
 class TemplateComputation : public Computation {
  public:
   virtual intptr_t InputCount() const { return N; }
+  virtual Value* InputAt(intptr_t i) const { return inputs_[i]; }
+  virtual void SetInputAt(intptr_t i, Value* value) { inputs_[i] = value; }
 
  protected:
   EmbeddedArray<Value*, N> inputs_;
@@ -159,13 +187,6 @@ class Value : public TemplateComputation<0> {
  public:
   Value() { }
 
-#define DEFINE_TESTERS(ShortName, ClassName)                                   \
-  virtual ClassName* As##ShortName() { return NULL; }                          \
-  bool Is##ShortName() { return As##ShortName() != NULL; }
-
-  FOR_EACH_VALUE(DEFINE_TESTERS)
-#undef DEFINE_TESTERS
-
  private:
   DISALLOW_COPY_AND_ASSIGN(Value);
 };
@@ -174,10 +195,11 @@ class Value : public TemplateComputation<0> {
 // Functions defined in all concrete computation classes.
 #define DECLARE_COMPUTATION(ShortName)                                         \
   virtual void Accept(FlowGraphVisitor* visitor);                              \
+  virtual ShortName##Comp* As##ShortName() { return this; }
 
 // Functions defined in all concrete value classes.
 #define DECLARE_VALUE(ShortName)                                               \
-  DECLARE_COMPUTATION(ShortName)                                               \
+  virtual void Accept(FlowGraphVisitor* visitor);                              \
   virtual ShortName##Val* As##ShortName() { return this; }
 
 
@@ -209,6 +231,8 @@ class ConstantVal: public Value {
 
   const Object& value() const { return value_; }
 
+  virtual bool HasSideEffect() const { return false; }
+
  private:
   const Object& value_;
 
@@ -249,6 +273,8 @@ class AssertAssignableComp : public Computation {
   const String& dst_name() const { return dst_name_; }
 
   virtual intptr_t InputCount() const;
+  virtual Value* InputAt(intptr_t i) const;
+  virtual void SetInputAt(intptr_t i, Value* value);
 
  private:
   const intptr_t token_index_;
@@ -295,6 +321,8 @@ class CurrentContextComp : public TemplateComputation<0> {
 
   DECLARE_COMPUTATION(CurrentContext)
 
+  virtual bool HasSideEffect() const { return false; }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(CurrentContextComp);
 };
@@ -340,6 +368,8 @@ class ClosureCallComp : public Computation {
   Value* ArgumentAt(intptr_t index) const { return (*arguments_)[index]; }
 
   virtual intptr_t InputCount() const;
+  virtual Value* InputAt(intptr_t i) const;
+  virtual void SetInputAt(intptr_t i, Value* value);
 
  private:
   const ClosureCallNode& ast_node_;
@@ -381,6 +411,8 @@ class InstanceCallComp : public Computation {
   intptr_t checked_argument_count() const { return checked_argument_count_; }
 
   virtual intptr_t InputCount() const;
+  virtual Value* InputAt(intptr_t i) const;
+  virtual void SetInputAt(intptr_t i, Value* value);
 
  private:
   const intptr_t token_index_;
@@ -409,6 +441,8 @@ class StrictCompareComp : public TemplateComputation<2> {
   Value* left() { return inputs_[0]; }
   Value* right() { return inputs_[1]; }
 
+  virtual bool HasSideEffect() const { return false; }
+
  private:
   const Token::Kind kind_;
 
@@ -430,7 +464,7 @@ class EqualityCompareComp : public TemplateComputation<2> {
     inputs_[1] = right;
   }
 
-  DECLARE_COMPUTATION(EqualityCompareComp)
+  DECLARE_COMPUTATION(EqualityCompare)
 
   intptr_t token_index() const { return token_index_; }
   intptr_t try_index() const { return try_index_; }
@@ -473,6 +507,8 @@ class StaticCallComp : public Computation {
   Value* ArgumentAt(intptr_t index) const { return (*arguments_)[index]; }
 
   virtual intptr_t InputCount() const;
+  virtual Value* InputAt(intptr_t i) const;
+  virtual void SetInputAt(intptr_t i, Value* value);
 
  private:
   const intptr_t token_index_;
@@ -488,16 +524,24 @@ class StaticCallComp : public Computation {
 class LoadLocalComp : public TemplateComputation<0> {
  public:
   LoadLocalComp(const LocalVariable& local, intptr_t context_level)
-      : local_(local), context_level_(context_level) { }
+      : local_(local), context_level_(context_level), ssa_index_(-1) { }
 
   DECLARE_COMPUTATION(LoadLocal)
 
   const LocalVariable& local() const { return local_; }
   intptr_t context_level() const { return context_level_; }
 
+  // The SSA version of the local that is read, -1 if the graph is not in
+  // SSA form or the local is captured.
+  intptr_t ssa_index() const { return ssa_index_; }
+  void set_ssa_index(intptr_t index) { ssa_index_ = index; }
+
+  virtual bool HasSideEffect() const { return false; }
+
  private:
   const LocalVariable& local_;
   const intptr_t context_level_;
+  intptr_t ssa_index_;
 
   DISALLOW_COPY_AND_ASSIGN(LoadLocalComp);
 };
@@ -508,7 +552,7 @@ class StoreLocalComp : public TemplateComputation<1> {
   StoreLocalComp(const LocalVariable& local,
                  Value* value,
                  intptr_t context_level)
-      : local_(local), context_level_(context_level) {
+      : local_(local), context_level_(context_level), ssa_index_(-1) {
     inputs_[0] = value;
   }
 
@@ -518,9 +562,15 @@ class StoreLocalComp : public TemplateComputation<1> {
   Value* value() { return inputs_[0]; }
   intptr_t context_level() const { return context_level_; }
 
+  // The SSA version of the local defined by the store, -1 if the graph is
+  // not in SSA form or the local is captured.
+  intptr_t ssa_index() const { return ssa_index_; }
+  void set_ssa_index(intptr_t index) { ssa_index_ = index; }
+
  private:
   const LocalVariable& local_;
   const intptr_t context_level_;
+  intptr_t ssa_index_;
 
   DISALLOW_COPY_AND_ASSIGN(StoreLocalComp);
 };
@@ -748,6 +798,8 @@ class BooleanNegateComp : public TemplateComputation<1> {
 
   Value* value() { return inputs_[0]; }
 
+  virtual bool HasSideEffect() const { return false; }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(BooleanNegateComp);
 };
@@ -781,6 +833,8 @@ class InstanceOfComp : public Computation {
   intptr_t try_index() const { return try_index_; }
 
   virtual intptr_t InputCount() const;
+  virtual Value* InputAt(intptr_t i) const;
+  virtual void SetInputAt(intptr_t i, Value* value);
 
  private:
   const intptr_t token_index_;
@@ -812,6 +866,8 @@ class AllocateObjectComp : public Computation {
   const ZoneGrowableArray<Value*>& arguments() const { return *arguments_; }
 
   virtual intptr_t InputCount() const;
+  virtual Value* InputAt(intptr_t i) const;
+  virtual void SetInputAt(intptr_t i, Value* value);
 
  private:
   const ConstructorCallNode& ast_node_;
@@ -839,6 +895,8 @@ class AllocateObjectWithBoundsCheckComp : public Computation {
   const ZoneGrowableArray<Value*>& arguments() const { return *arguments_; }
 
   virtual intptr_t InputCount() const;
+  virtual Value* InputAt(intptr_t i) const;
+  virtual void SetInputAt(intptr_t i, Value* value);
 
  private:
   const ConstructorCallNode& ast_node_;
@@ -875,6 +933,8 @@ class CreateArrayComp : public Computation {
   Value* element_type() const { return element_type_; }
 
   virtual intptr_t InputCount() const;
+  virtual Value* InputAt(intptr_t i) const;
+  virtual void SetInputAt(intptr_t i, Value* value);
 
  private:
   const intptr_t token_index_;
@@ -904,6 +964,8 @@ class CreateClosureComp : public Computation {
   Value* type_arguments() const { return type_arguments_; }
 
   virtual intptr_t InputCount() const;
+  virtual Value* InputAt(intptr_t i) const;
+  virtual void SetInputAt(intptr_t i, Value* value);
 
  private:
   const ClosureNode& ast_node_;
@@ -934,6 +996,26 @@ class NativeLoadFieldComp : public TemplateComputation<1> {
 };
 
 
+// The class of an object, which is the Smi class for a Smi.  Guards code
+// specialized for one of the receiver classes recorded at a call.
+class LoadClassComp : public TemplateComputation<1> {
+ public:
+  explicit LoadClassComp(Value* object) {
+    ASSERT(object != NULL);
+    inputs_[0] = object;
+  }
+
+  DECLARE_COMPUTATION(LoadClass)
+
+  Value* object() { return inputs_[0]; }
+
+  virtual bool HasSideEffect() const { return false; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(LoadClassComp);
+};
+
+
 class InstantiateTypeArgumentsComp : public TemplateComputation<1> {
  public:
   InstantiateTypeArgumentsComp(intptr_t token_index,
@@ -1129,6 +1211,7 @@ class CatchEntryComp : public TemplateComputation<0> {
 #define FOR_EACH_INSTRUCTION(M)                                                \
   M(JoinEntry)                                                                 \
   M(TargetEntry)                                                               \
+  M(Phi)                                                                       \
   M(Do)                                                                        \
   M(Bind)                                                                      \
   M(PickTemp)                                                                  \
@@ -1152,6 +1235,8 @@ FOR_EACH_INSTRUCTION(FORWARD_DECLARATION)
   virtual bool Is##type() const { return true; }                               \
   virtual type##Instr* As##type() { return this; }                             \
   virtual intptr_t InputCount() const;                                         \
+  virtual Value* InputAt(intptr_t i) const;                                    \
+  virtual void SetInputAt(intptr_t i, Value* value);                           \
 
 
 class Instruction : public ZoneAllocated {
@@ -1177,7 +1262,14 @@ class Instruction : public ZoneAllocated {
     return IsDefinition() ? reinterpret_cast<Definition*>(this) : NULL;
   }
 
+  // The values consumed by the instruction.  For Do and Bind these are the
+  // inputs of the computation.
   virtual intptr_t InputCount() const = 0;
+  virtual Value* InputAt(intptr_t i) const = 0;
+  virtual void SetInputAt(intptr_t i, Value* value) = 0;
+
+  // The computation of a Do or Bind, NULL for other instructions.
+  virtual Computation* computation() const { return NULL; }
 
   // Visiting support.
   virtual Instruction* Accept(FlowGraphVisitor* visitor) = 0;
@@ -1185,6 +1277,15 @@ class Instruction : public ZoneAllocated {
   virtual Instruction* StraightLineSuccessor() const = 0;
   virtual void SetSuccessor(Instruction* instr) = 0;
 
+  // Unlike SetSuccessor, overwrites an already set successor.  Used by
+  // optimizations that remove or replace instructions in a block.
+  virtual void ReplaceSuccessor(Instruction* instr) { UNREACHABLE(); }
+
+  // The next instruction in the same basic block, in the order visited by
+  // FlowGraphVisitor::VisitBlocks, or NULL if this instruction ends the
+  // block.
+  Instruction* NextInBlock();
+
   // Discover basic-block structure by performing a recursive depth first
   // traversal of the instruction graph reachable from this instruction.  As
   // a side effect, the block entry instructions in the graph are assigned
@@ -1238,20 +1339,38 @@ class BlockEntryInstr : public Instruction {
   BlockEntryInstr* dominator() const { return dominator_; }
   void set_dominator(BlockEntryInstr* instr) { dominator_ = instr; }
 
+  // The blocks immediately dominated by this one, i.e., its children in the
+  // dominator tree.  Only recorded when the graph is put in SSA form.
+  const GrowableArray<BlockEntryInstr*>& dominated_blocks() const {
+    return dominated_blocks_;
+  }
+  void AddDominatedBlock(BlockEntryInstr* block) {
+    dominated_blocks_.Add(block);
+  }
+
   Instruction* last_instruction() const { return last_instruction_; }
   void set_last_instruction(Instruction* instr) { last_instruction_ = instr; }
 
+  // The control-flow-graph successors, i.e., the blocks whose predecessor
+  // lists contain this block.
+  intptr_t SuccessorCount();
+  BlockEntryInstr* SuccessorAt(intptr_t index);
+
+  intptr_t IndexOfPredecessor(BlockEntryInstr* pred) const;
+
  protected:
   BlockEntryInstr()
       : preorder_number_(-1),
         postorder_number_(-1),
         dominator_(NULL),
+        dominated_blocks_(),
         last_instruction_(NULL) { }
 
  private:
   intptr_t preorder_number_;
   intptr_t postorder_number_;
   BlockEntryInstr* dominator_;  // Immediate dominator, NULL for graph entry.
+  GrowableArray<BlockEntryInstr*> dominated_blocks_;
   Instruction* last_instruction_;
 
   DISALLOW_COPY_AND_ASSIGN(BlockEntryInstr);
@@ -1263,7 +1382,9 @@ class JoinEntryInstr : public BlockEntryInstr {
   JoinEntryInstr()
       : BlockEntryInstr(),
         predecessors_(2),  // Two is the assumed to be the common case.
-        successor_(NULL) { }
+        successor_(NULL),
+        phis_(NULL),
+        loop_id_(AstNode::kNoId) { }
 
   DECLARE_INSTRUCTION(JoinEntry)
 
@@ -1279,6 +1400,7 @@ class JoinEntryInstr : public BlockEntryInstr {
     ASSERT(successor_ == NULL);
     successor_ = instr;
   }
+  virtual void ReplaceSuccessor(Instruction* instr) { successor_ = instr; }
 
   virtual void DiscoverBlocks(
       BlockEntryInstr* current_block,
@@ -1286,9 +1408,20 @@ class JoinEntryInstr : public BlockEntryInstr {
       GrowableArray<BlockEntryInstr*>* postorder,
       GrowableArray<intptr_t>* parent);
 
+  // The phis of the join, NULL if there are none.
+  ZoneGrowableArray<PhiInstr*>* phis() const { return phis_; }
+  void InsertPhi(PhiInstr* phi);
+
+  // The node id of the loop if the join is the target of its back edge,
+  // AstNode::kNoId otherwise.  Used for on-stack replacement.
+  intptr_t loop_id() const { return loop_id_; }
+  void set_loop_id(intptr_t loop_id) { loop_id_ = loop_id; }
+
  private:
   ZoneGrowableArray<BlockEntryInstr*> predecessors_;
   Instruction* successor_;
+  ZoneGrowableArray<PhiInstr*>* phis_;
+  intptr_t loop_id_;
 
   DISALLOW_COPY_AND_ASSIGN(JoinEntryInstr);
 };
@@ -1326,6 +1459,7 @@ class TargetEntryInstr : public BlockEntryInstr {
     ASSERT(successor_ == NULL);
     successor_ = instr;
   }
+  virtual void ReplaceSuccessor(Instruction* instr) { successor_ = instr; }
 
   virtual void DiscoverBlocks(
       BlockEntryInstr* current_block,
@@ -1351,6 +1485,46 @@ class TargetEntryInstr : public BlockEntryInstr {
 };
 
 
+// A phi merges the SSA versions of a local variable flowing into a join
+// from its predecessors: the i-th input version is the one reaching the
+// end of the join's i-th predecessor.  Phis are attached to their join
+// rather than linked into the instruction list and are never compiled;
+// they only exist for the optimizer.
+class PhiInstr : public Instruction {
+ public:
+  PhiInstr(const LocalVariable& local, intptr_t predecessor_count)
+      : local_(local), ssa_index_(-1), input_versions_(predecessor_count) {
+    for (intptr_t i = 0; i < predecessor_count; ++i) {
+      input_versions_.Add(-1);
+    }
+  }
+
+  DECLARE_INSTRUCTION(Phi)
+
+  const LocalVariable& local() const { return local_; }
+
+  // The SSA version of the local defined by the phi.
+  intptr_t ssa_index() const { return ssa_index_; }
+  void set_ssa_index(intptr_t index) { ssa_index_ = index; }
+
+  intptr_t InputVersionCount() const { return input_versions_.length(); }
+  intptr_t InputVersionAt(intptr_t i) const { return input_versions_[i]; }
+  void SetInputVersionAt(intptr_t i, intptr_t version) {
+    input_versions_[i] = version;
+  }
+
+  virtual Instruction* StraightLineSuccessor() const { return NULL; }
+  virtual void SetSuccessor(Instruction* instr) { UNREACHABLE(); }
+
+ private:
+  const LocalVariable& local_;
+  intptr_t ssa_index_;
+  GrowableArray<intptr_t> input_versions_;
+
+  DISALLOW_COPY_AND_ASSIGN(PhiInstr);
+};
+
+
 class DoInstr : public Instruction {
  public:
   explicit DoInstr(Computation* comp)
@@ -1358,7 +1532,7 @@ class DoInstr : public Instruction {
 
   DECLARE_INSTRUCTION(Do)
 
-  Computation* computation() const { return computation_; }
+  virtual Computation* computation() const { return computation_; }
 
   virtual Instruction* StraightLineSuccessor() const {
     return successor_;
@@ -1367,6 +1541,7 @@ class DoInstr : public Instruction {
     ASSERT(successor_ == NULL);
     successor_ = instr;
   }
+  virtual void ReplaceSuccessor(Instruction* instr) { successor_ = instr; }
 
  private:
   Computation* computation_;
@@ -1378,15 +1553,29 @@ class DoInstr : public Instruction {
 
 class Definition : public Instruction {
  public:
-  Definition() : temp_index_(-1) { }
+  Definition()
+      : temp_index_(-1), ssa_temp_index_(-1), register_index_(-1) { }
 
   virtual bool IsDefinition() const { return true; }
 
   intptr_t temp_index() const { return temp_index_; }
   void set_temp_index(intptr_t index) { temp_index_ = index; }
 
+  // Unlike the temp index, which is a stack slot and reused, the SSA temp
+  // index names the definition uniquely.  -1 until the definitions are
+  // named by SSA construction or by the register allocator.
+  intptr_t ssa_temp_index() const { return ssa_temp_index_; }
+  void set_ssa_temp_index(intptr_t index) { ssa_temp_index_ = index; }
+
+  // The index of the allocatable register holding the value, or -1 if the
+  // value is pushed on the expression stack (see FlowGraphAllocator).
+  intptr_t register_index() const { return register_index_; }
+  void set_register_index(intptr_t index) { register_index_ = index; }
+
  private:
   intptr_t temp_index_;
+  intptr_t ssa_temp_index_;
+  intptr_t register_index_;
 
   DISALLOW_COPY_AND_ASSIGN(Definition);
 };
@@ -1399,7 +1588,10 @@ class BindInstr : public Definition {
 
   DECLARE_INSTRUCTION(Bind)
 
-  Computation* computation() const { return computation_; }
+  virtual Computation* computation() const { return computation_; }
+  void set_computation(Computation* computation) {
+    computation_ = computation;
+  }
 
   virtual Instruction* StraightLineSuccessor() const {
     return successor_;
@@ -1408,6 +1600,7 @@ class BindInstr : public Definition {
     ASSERT(successor_ == NULL);
     successor_ = instr;
   }
+  virtual void ReplaceSuccessor(Instruction* instr) { successor_ = instr; }
 
  private:
   Computation* computation_;
@@ -1440,6 +1633,7 @@ class PickTempInstr : public Definition {
     ASSERT(successor_ == NULL && instr != NULL);
     successor_ = instr;
   }
+  virtual void ReplaceSuccessor(Instruction* instr) { successor_ = instr; }
 
  private:
   const intptr_t source_;
@@ -1475,6 +1669,7 @@ class TuckTempInstr : public Instruction {
     ASSERT(successor_ == NULL && instr != NULL);
     successor_ = instr;
   }
+  virtual void ReplaceSuccessor(Instruction* instr) { successor_ = instr; }
 
  private:
   const intptr_t destination_;
@@ -1534,6 +1729,7 @@ class ThrowInstr : public Instruction {
     ASSERT(successor_ == NULL);
     successor_ = instr;
   }
+  virtual void ReplaceSuccessor(Instruction* instr) { successor_ = instr; }
 
  private:
   const intptr_t token_index_;
@@ -95,17 +95,21 @@ bool Intrinsifier::ObjectArray_Allocate(Assembler* assembler) {
   __ movl(EDI, FieldAddress(CTX, Context::isolate_offset()));
   __ movl(EDI, Address(EDI, Isolate::object_store_offset()));
   __ movl(EDI, Address(EDI, ObjectStore::array_class_offset()));
-  __ StoreIntoObject(EAX, FieldAddress(EAX, Array::class_offset()), EDI);
+  __ StoreIntoObjectNoBarrier(EAX,
+                              FieldAddress(EAX, Array::class_offset()),
+                              EDI);
 
   // Store the type argument field.
   __ movl(EDI, Address(ESP, kTypeArgumentsOffset));  // type argument.
-  __ StoreIntoObject(EAX,
-                     FieldAddress(EAX, Array::type_arguments_offset()),
-                     EDI);
+  __ StoreIntoObjectNoBarrier(EAX,
+                              FieldAddress(EAX, Array::type_arguments_offset()),
+                              EDI);
 
   // Set the length field.
   __ movl(EDI, Address(ESP, kArrayLengthOffset));  // Array Length.
-  __ StoreIntoObject(EAX, FieldAddress(EAX, Array::length_offset()), EDI);
+  __ StoreIntoObjectNoBarrier(EAX,
+                              FieldAddress(EAX, Array::length_offset()),
+                              EDI);
 
   // Initialize all array elements to raw_null.
   // EAX: new object start as a tagged pointer.
@@ -300,25 +304,27 @@ bool Intrinsifier::GArray_Allocate(Assembler* assembler) {
 
   // Store backing array object in growable array object.
   __ movl(EBX, Address(ESP, kArrayOffset));  // data argument.
-  __ StoreIntoObject(EAX,
-                     FieldAddress(EAX, GrowableObjectArray::data_offset()),
-                     EBX);
+  __ StoreIntoObjectNoBarrier(
+      EAX,
+      FieldAddress(EAX, GrowableObjectArray::data_offset()),
+      EBX);
 
   // Store class value for the growable array object.
   // EAX: new growable array object start as a tagged pointer.
   __ movl(EBX, FieldAddress(CTX, Context::isolate_offset()));
   __ movl(EBX, Address(EBX, Isolate::object_store_offset()));
   __ movl(EBX, Address(EBX, ObjectStore::growable_object_array_class_offset()));
-  __ StoreIntoObject(EAX,
-                     FieldAddress(EAX, GrowableObjectArray::class_offset()),
-                     EBX);
+  __ StoreIntoObjectNoBarrier(
+      EAX,
+      FieldAddress(EAX, GrowableObjectArray::class_offset()),
+      EBX);
 
   // Store the type argument field in the growable array object.
   __ movl(EBX, Address(ESP, kTypeArgumentsOffset));  // type argument.
-  __ StoreIntoObject(EAX,
-                     FieldAddress(EAX,
-                                  GrowableObjectArray::type_arguments_offset()),
-                     EBX);
+  __ StoreIntoObjectNoBarrier(
+      EAX,
+      FieldAddress(EAX, GrowableObjectArray::type_arguments_offset()),
+      EBX);
 
   // Set the length field in the growable array object to 0.
   __ movl(FieldAddress(EAX, GrowableObjectArray::length_offset()),
@@ -426,7 +432,9 @@ bool Intrinsifier::GrowableArray_setData(Assembler* assembler) {
   }
   __ movl(EAX, Address(ESP, + 2 * kWordSize));
   __ movl(EBX, Address(ESP, + 1 * kWordSize));
-  __ movl(FieldAddress(EAX, GrowableObjectArray::data_offset()), EBX);
+  __ StoreIntoObject(EAX,
+                     FieldAddress(EAX, GrowableObjectArray::data_offset()),
+                     EBX);
   __ ret();
   return true;
 }
@@ -7,6 +7,7 @@
 #include "include/dart_api.h"
 #include "platform/assert.h"
 #include "lib/mirrors.h"
+#include "vm/code_index_table.h"
 #include "vm/compiler_stats.h"
 #include "vm/dart_api_state.h"
 #include "vm/dart_entry.h"
@@ -18,6 +19,7 @@
 #include "vm/parser.h"
 #include "vm/port.h"
 #include "vm/random.h"
+#include "vm/regexp_bytecode.h"
 #include "vm/stack_frame.h"
 #include "vm/stub_code.h"
 #include "vm/thread.h"
@@ -41,6 +43,8 @@ class IsolateMessageHandler : public MessageHandler {
   const char* name() const;
   void MessageNotify(Message::Priority priority);
   bool HandleMessage(Message* message);
+  bool HasIdleWork();
+  void HandleIdleWork();
 
 #if defined(DEBUG)
   // Check that it is safe to access this handler.
@@ -118,6 +122,21 @@ bool IsolateMessageHandler::HandleMessage(Message* message) {
 }
 
 
+bool IsolateMessageHandler::HasIdleWork() {
+  return !isolate_->background_compiler()->IsEmpty();
+}
+
+
+// No Dart code of the isolate is running between messages, so optimized
+// code can be installed.
+void IsolateMessageHandler::HandleIdleWork() {
+  StartIsolateScope start_scope(isolate_);
+  Zone zone(isolate_);
+  HandleScope handle_scope(isolate_);
+  isolate_->background_compiler()->CompileNext();
+}
+
+
 #if defined(DEBUG)
 void IsolateMessageHandler::CheckAccess() {
   ASSERT(isolate_ == Isolate::Current());
@@ -148,11 +167,14 @@ Isolate::Isolate()
       api_state_(NULL),
       stub_code_(NULL),
       debugger_(NULL),
+      code_index_table_(new CodeIndexTable()),
       long_jump_base_(NULL),
       timer_list_(),
       ast_node_id_(AstNode::kNoId),
       computation_id_(AstNode::kNoId),
       ic_data_array_(Array::null()),
+      deopt_frame_copy_(NULL),
+      regexp_stack_(new RegExpStack()),
       mutex_(new Mutex()),
       stack_limit_(0),
       saved_stack_limit_(0),
@@ -168,6 +190,8 @@ Isolate::~Isolate() {
   delete api_state_;
   delete stub_code_;
   delete debugger_;
+  delete code_index_table_;
+  delete regexp_stack_;
   delete mutex_;
   mutex_ = NULL;  // Fail fast if interrupts are scheduled on a dead isolate.
   delete message_handler_;
@@ -377,6 +401,7 @@ void Isolate::Shutdown() {
     PrintInvokedFunctions();
   }
   CompilerStats::Print();
+  megamorphic_cache_table()->PrintStatistics();
   if (FLAG_generate_gdb_symbols) {
     DebugInfo::UnregisterAllSections();
   }
@@ -425,6 +450,12 @@ void Isolate::VisitObjectPointers(ObjectPointerVisitor* visitor,
   // Visit objects in the class table.
   class_table()->VisitObjectPointers(visitor);
 
+  // Visit the targets and keys of megamorphic calls.
+  megamorphic_cache_table()->VisitObjectPointers(visitor);
+
+  // Visit the functions waiting for background compilation.
+  background_compiler()->VisitObjectPointers(visitor);
+
   // Visit objects in per isolate stubs.
   StubCode::VisitObjectPointers(visitor);
 
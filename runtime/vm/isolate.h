@@ -9,8 +9,10 @@
 #include "platform/assert.h"
 #include "vm/class_table.h"
 #include "platform/thread.h"
+#include "vm/background_compiler.h"
 #include "vm/base_isolate.h"
 #include "vm/gc_callbacks.h"
+#include "vm/megamorphic_cache_table.h"
 #include "vm/store_buffer.h"
 #include "vm/timer.h"
 
@@ -20,6 +22,7 @@ namespace dart {
 class ApiState;
 class CodeIndexTable;
 class Debugger;
+class DeoptFrameCopy;
 class HandleScope;
 class HandleVisitor;
 class Heap;
@@ -31,6 +34,7 @@ class ObjectStore;
 class RawArray;
 class RawContext;
 class RawError;
+class RegExpStack;
 class StackResource;
 class StubCode;
 class Zone;
@@ -62,6 +66,15 @@ class Isolate : public BaseIsolate {
 
   ClassTable* class_table() { return &class_table_; }
 
+  MegamorphicCacheTable* megamorphic_cache_table() {
+    return &megamorphic_cache_table_;
+  }
+  static intptr_t megamorphic_cache_table_offset() {
+    return OFFSET_OF(Isolate, megamorphic_cache_table_);
+  }
+
+  BackgroundCompiler* background_compiler() { return &background_compiler_; }
+
   Dart_MessageNotifyCallback message_notify_callback() const {
     return message_notify_callback_;
   }
@@ -171,8 +184,20 @@ class Isolate : public BaseIsolate {
   RawArray* ic_data_array() const { return ic_data_array_; }
   void set_ic_data_array(RawArray* value) { ic_data_array_ = value; }
 
+  // The frames being deoptimized, between the two runtime calls of the
+  // Deoptimize stub.
+  DeoptFrameCopy* deopt_frame_copy() const { return deopt_frame_copy_; }
+  void set_deopt_frame_copy(DeoptFrameCopy* value) {
+    deopt_frame_copy_ = value;
+  }
+
+  // The registers and backtracking stack of the bytecode regexp engine.
+  RegExpStack* regexp_stack() const { return regexp_stack_; }
+
   Debugger* debugger() const { return debugger_; }
 
+  CodeIndexTable* code_index_table() const { return code_index_table_; }
+
   static void SetCreateCallback(Dart_IsolateCreateCallback cback);
   static Dart_IsolateCreateCallback CreateCallback();
 
@@ -201,6 +226,8 @@ class Isolate : public BaseIsolate {
   static ThreadLocalKey isolate_key;
   StoreBufferBlock store_buffer_;
   ClassTable class_table_;
+  MegamorphicCacheTable megamorphic_cache_table_;
+  BackgroundCompiler background_compiler_;
   Dart_MessageNotifyCallback message_notify_callback_;
   char* name_;
   Dart_Port main_port_;
@@ -214,11 +241,14 @@ class Isolate : public BaseIsolate {
   ApiState* api_state_;
   StubCode* stub_code_;
   Debugger* debugger_;
+  CodeIndexTable* code_index_table_;
   LongJump* long_jump_base_;
   TimerList timer_list_;
   intptr_t ast_node_id_;  // Deprecate.
   intptr_t computation_id_;
   RawArray* ic_data_array_;
+  DeoptFrameCopy* deopt_frame_copy_;
+  RegExpStack* regexp_stack_;
   Mutex* mutex_;  // protects stack_limit_ and saved_stack_limit_.
   uword stack_limit_;
   uword saved_stack_limit_;
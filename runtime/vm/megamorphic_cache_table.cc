@@ -0,0 +1,127 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/megamorphic_cache_table.h"
+
+#include "vm/flags.h"
+#include "vm/object.h"
+#include "vm/visitor.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool, print_megamorphic_cache_stats, false,
+            "Print megamorphic cache table statistics on isolate shutdown.");
+
+MegamorphicCacheTable::MegamorphicCacheTable()
+    : entries_(NULL),
+      count_(0),
+      hits_(0),
+      misses_(0),
+      evictions_(0) {
+  entries_ = reinterpret_cast<RawObject**>(
+      calloc(kCapacity * kEntrySize, sizeof(RawObject*)));  // NOLINT
+}
+
+
+MegamorphicCacheTable::~MegamorphicCacheTable() {
+  free(entries_);
+}
+
+
+RawSmi* MegamorphicCacheTable::ArgumentsKey(intptr_t num_arguments,
+                                            intptr_t num_named_arguments) {
+  intptr_t num_positional_arguments = num_arguments - num_named_arguments;
+  ASSERT((num_positional_arguments >= 0) &&
+         (num_positional_arguments < (1 << 16)));
+  return Smi::New((num_arguments << 16) | num_positional_arguments);
+}
+
+
+intptr_t MegamorphicCacheTable::IndexFor(const Class& cls,
+                                         const String& function_name) {
+  // Must match the hash computed by the megamorphic lookup stub.
+  return (function_name.Hash() ^ cls.index()) & kMask;
+}
+
+
+RawFunction* MegamorphicCacheTable::Lookup(const Class& cls,
+                                           const String& function_name,
+                                           intptr_t num_arguments,
+                                           intptr_t num_named_arguments) {
+  ASSERT(function_name.IsSymbol());
+  RawSmi* key = ArgumentsKey(num_arguments, num_named_arguments);
+  intptr_t index = IndexFor(cls, function_name);
+  for (intptr_t i = 0; i < kMaxProbes; i++) {
+    RawObject** entry = EntryAt(index);
+    if (entry[kClass] == NULL) {
+      break;
+    }
+    if ((entry[kClass] == cls.raw()) &&
+        (entry[kFunctionName] == function_name.raw()) &&
+        (entry[kArgumentsKey] == key)) {
+      return reinterpret_cast<RawFunction*>(entry[kFunction]);
+    }
+    index = (index + 1) & kMask;
+  }
+  return Function::null();
+}
+
+
+void MegamorphicCacheTable::Insert(const Class& cls,
+                                   const String& function_name,
+                                   intptr_t num_arguments,
+                                   intptr_t num_named_arguments,
+                                   const Function& function) {
+  ASSERT(function_name.IsSymbol());
+  ASSERT(!function.IsNull());
+  intptr_t first_index = IndexFor(cls, function_name);
+  intptr_t index = first_index;
+  RawObject** entry = NULL;
+  for (intptr_t i = 0; i < kMaxProbes; i++) {
+    entry = EntryAt(index);
+    if (entry[kClass] == NULL) {
+      count_++;
+      break;
+    }
+    index = (index + 1) & kMask;
+    entry = NULL;
+  }
+  if (entry == NULL) {
+    // All probe positions are taken: evict the entry at the first one.
+    entry = EntryAt(first_index);
+    evictions_++;
+  }
+  entry[kClass] = cls.raw();
+  entry[kFunctionName] = function_name.raw();
+  entry[kArgumentsKey] = ArgumentsKey(num_arguments, num_named_arguments);
+  entry[kFunction] = function.raw();
+}
+
+
+void MegamorphicCacheTable::Clear() {
+  if (count_ == 0) {
+    return;
+  }
+  memset(entries_, 0, kCapacity * kEntrySize * sizeof(entries_[0]));
+  count_ = 0;
+}
+
+
+void MegamorphicCacheTable::PrintStatistics() const {
+  if (!FLAG_print_megamorphic_cache_stats) {
+    return;
+  }
+  OS::Print("Megamorphic cache: %" Pd " entries, %" Pd " hits, "
+            "%" Pd " misses, %" Pd " evictions\n",
+            count_, hits_, misses_, evictions_);
+}
+
+
+void MegamorphicCacheTable::VisitObjectPointers(
+    ObjectPointerVisitor* visitor) {
+  ASSERT(visitor != NULL);
+  visitor->VisitPointers(entries_, &entries_[kCapacity * kEntrySize - 1]);
+}
+
+}  // namespace dart
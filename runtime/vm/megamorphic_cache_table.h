@@ -0,0 +1,108 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef VM_MEGAMORPHIC_CACHE_TABLE_H_
+#define VM_MEGAMORPHIC_CACHE_TABLE_H_
+
+#include "platform/assert.h"
+#include "vm/globals.h"
+
+namespace dart {
+
+class Class;
+class Function;
+class ObjectPointerVisitor;
+class RawFunction;
+class RawObject;
+class RawSmi;
+class String;
+
+// The MegamorphicCacheTable maps (receiver class, selector, argument counts)
+// to the target function of megamorphic instance calls. It is a fixed size
+// open addressed hash table which is probed inline by the megamorphic lookup
+// stub. An entry holds the target function rather than its code, so that
+// calls always enter the current code of the function after it has been
+// optimized, deoptimized or patched by FixCallersTarget.
+//
+// The hash of an entry is computed from the class index and the hash of the
+// selector symbol, both of which stay the same when objects are moved.
+// Entries are never removed individually: when all probe positions for a key
+// are occupied the entry at the first position is evicted.
+class MegamorphicCacheTable {
+ public:
+  enum EntryFields {
+    kClass = 0,
+    kFunctionName = 1,
+    kArgumentsKey = 2,
+    kFunction = 3,
+    kEntrySize = 4
+  };
+
+  static const intptr_t kCapacity = 1024;
+  static const intptr_t kMask = kCapacity - 1;
+  // Number of probes done by the lookup before giving up.
+  static const intptr_t kMaxProbes = 4;
+  static const intptr_t kEntrySizeInBytes = kEntrySize * kWordSize;
+  static const intptr_t kEntrySizeInBytesLog2 = 2 + kWordSizeLog2;
+
+  MegamorphicCacheTable();
+  ~MegamorphicCacheTable();
+
+  RawFunction* Lookup(const Class& cls,
+                      const String& function_name,
+                      intptr_t num_arguments,
+                      intptr_t num_named_arguments);
+  void Insert(const Class& cls,
+              const String& function_name,
+              intptr_t num_arguments,
+              intptr_t num_named_arguments,
+              const Function& function);
+
+  // Drop all entries, e.g. when the functions of a class are replaced.
+  void Clear();
+
+  void RecordMiss() { misses_++; }
+
+  intptr_t hits() const { return hits_; }
+  intptr_t misses() const { return misses_; }
+  intptr_t evictions() const { return evictions_; }
+  intptr_t count() const { return count_; }
+
+  void PrintStatistics() const;
+
+  void VisitObjectPointers(ObjectPointerVisitor* visitor);
+
+  // The arguments key packs the total and the positional argument count into
+  // a single Smi, the lookup stub computes it from the arguments descriptor.
+  static RawSmi* ArgumentsKey(intptr_t num_arguments,
+                              intptr_t num_named_arguments);
+
+  static intptr_t entries_offset() {
+    return OFFSET_OF(MegamorphicCacheTable, entries_);
+  }
+  static intptr_t hits_offset() {
+    return OFFSET_OF(MegamorphicCacheTable, hits_);
+  }
+
+ private:
+  static intptr_t IndexFor(const Class& cls, const String& function_name);
+
+  RawObject** EntryAt(intptr_t index) const {
+    ASSERT((index >= 0) && (index < kCapacity));
+    return &entries_[index * kEntrySize];
+  }
+
+  // kCapacity entries of kEntrySize words, an empty entry has a NULL class.
+  RawObject** entries_;
+  intptr_t count_;
+  intptr_t hits_;
+  intptr_t misses_;
+  intptr_t evictions_;
+
+  DISALLOW_COPY_AND_ASSIGN(MegamorphicCacheTable);
+};
+
+}  // namespace dart
+
+#endif  // VM_MEGAMORPHIC_CACHE_TABLE_H_
@@ -0,0 +1,69 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "platform/assert.h"
+#include "vm/megamorphic_cache_table.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+static RawClass* CreateTestClass(const char* name) {
+  const String& class_name = String::Handle(String::NewSymbol(name));
+  const Script& script = Script::Handle();
+  return Class::New(class_name, script, Scanner::kDummyTokenIndex);
+}
+
+
+static RawFunction* CreateTestFunction(const String& name) {
+  return Function::New(name, RawFunction::kFunction, false, false, 0);
+}
+
+
+TEST_CASE(MegamorphicCacheTable) {
+  MegamorphicCacheTable* table = new MegamorphicCacheTable();
+  const Class& cls_a = Class::Handle(CreateTestClass("A"));
+  const Class& cls_b = Class::Handle(CreateTestClass("B"));
+  const String& foo = String::Handle(String::NewSymbol("foo"));
+  const String& bar = String::Handle(String::NewSymbol("bar"));
+  const Function& foo_a = Function::Handle(CreateTestFunction(foo));
+  const Function& foo_b = Function::Handle(CreateTestFunction(foo));
+  const Function& bar_a = Function::Handle(CreateTestFunction(bar));
+
+  EXPECT(table->Lookup(cls_a, foo, 1, 0) == Function::null());
+  table->Insert(cls_a, foo, 1, 0, foo_a);
+  table->Insert(cls_b, foo, 1, 0, foo_b);
+  table->Insert(cls_a, bar, 3, 1, bar_a);
+  EXPECT_EQ(3, table->count());
+  EXPECT(table->Lookup(cls_a, foo, 1, 0) == foo_a.raw());
+  EXPECT(table->Lookup(cls_b, foo, 1, 0) == foo_b.raw());
+  EXPECT(table->Lookup(cls_a, bar, 3, 1) == bar_a.raw());
+  // The class, the name and both argument counts have to match.
+  EXPECT(table->Lookup(cls_b, bar, 3, 1) == Function::null());
+  EXPECT(table->Lookup(cls_a, foo, 2, 0) == Function::null());
+  EXPECT(table->Lookup(cls_a, bar, 3, 0) == Function::null());
+  EXPECT(table->Lookup(cls_a, bar, 3, 2) == Function::null());
+
+  // Inserting more entries than fit into the table evicts older entries.
+  String& name = String::Handle();
+  Function& function = Function::Handle();
+  char buffer[32];
+  const intptr_t kNumNames = 2 * MegamorphicCacheTable::kCapacity;
+  for (intptr_t i = 0; i < kNumNames; i++) {
+    OS::SNPrint(buffer, sizeof(buffer), "name%d", i);
+    name = String::NewSymbol(buffer);
+    function = CreateTestFunction(name);
+    table->Insert(cls_a, name, 1, 0, function);
+    EXPECT(table->Lookup(cls_a, name, 1, 0) == function.raw());
+  }
+  EXPECT(table->count() <= MegamorphicCacheTable::kCapacity);
+  EXPECT(table->evictions() > 0);
+
+  table->Clear();
+  EXPECT_EQ(0, table->count());
+  EXPECT(table->Lookup(cls_b, foo, 1, 0) == Function::null());
+  delete table;
+}
+
+}  // namespace dart
@@ -65,6 +65,17 @@ void MessageHandler::MessageNotify(Message::Priority priority) {
 }
 
 
+bool MessageHandler::HasIdleWork() {
+  // By default, there is no deferred work.
+  return false;
+}
+
+
+void MessageHandler::HandleIdleWork() {
+  UNREACHABLE();
+}
+
+
 void MessageHandler::Run(ThreadPool* pool,
                          StartCallback start_callback,
                          EndCallback end_callback,
@@ -210,6 +221,16 @@ void MessageHandler::TaskCallback() {
     if (ok) {
       ok = HandleMessages(true, true);
     }
+
+    // Use the idle time for deferred work, and handle the messages posted
+    // meanwhile after each unit of work.
+    while (ok && HasLivePorts() && HasIdleWork()) {
+      monitor_.Exit();
+      HandleIdleWork();
+      ASSERT(Isolate::Current() == NULL);
+      monitor_.Enter();
+      ok = HandleMessages(true, true);
+    }
     task_ = NULL;  // No task in queue.
 
     if (!ok || !HasLivePorts()) {
@@ -95,6 +95,16 @@ class MessageHandler {
   // Returns true on success.
   virtual bool HandleMessage(Message* message) = 0;
 
+  // Deferred work done when there are no messages to handle, e.g.,
+  // background compilation.  Optionally provided by subclass.
+  //
+  // Returns true if there is deferred work left.
+  virtual bool HasIdleWork();
+
+  // Performs a unit of deferred work.  Messages are handled between two
+  // units of work.
+  virtual void HandleIdleWork();
+
  private:
   friend class PortMap;
   friend class MessageHandlerTestPeer;
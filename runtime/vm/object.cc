@@ -9,6 +9,7 @@
 #include "vm/bigint_operations.h"
 #include "vm/bootstrap.h"
 #include "vm/code_generator.h"
+#include "vm/code_index_table.h"
 #include "vm/code_patcher.h"
 #include "vm/compiler.h"
 #include "vm/compiler_stats.h"
@@ -1074,10 +1075,6 @@ void Class::InitEmptyFields() {
     return;
   }
   StorePointer(&raw_ptr()->interfaces_, empty_array.raw());
-  // TODO(srdjan): Make functions_cache growable and start with a smaller size.
-  Array& fcache =
-      Array::Handle(Array::New(FunctionsCache::kNumEntries * 32, Heap::kOld));
-  StorePointer(&raw_ptr()->functions_cache_, fcache.raw());
   StorePointer(&raw_ptr()->constants_, empty_array.raw());
   StorePointer(&raw_ptr()->canonical_types_, empty_array.raw());
   StorePointer(&raw_ptr()->functions_, empty_array.raw());
@@ -1107,6 +1104,9 @@ void Class::SetFunctions(const Array& value) const {
     func.set_owner(*this);
   }
   StorePointer(&raw_ptr()->functions_, value.raw());
+  StorePointer(&raw_ptr()->functions_hash_table_, Array::null());
+  // Cached megamorphic call targets may now resolve differently.
+  Isolate::Current()->megamorphic_cache_table()->Clear();
 }
 
 
@@ -1683,12 +1683,6 @@ void Class::set_interfaces(const Array& value) const {
 }
 
 
-void Class::set_functions_cache(const Array& value) const {
-  ASSERT(!value.IsNull());
-  StorePointer(&raw_ptr()->functions_cache_, value.raw());
-}
-
-
 RawArray* Class::constants() const {
   return raw_ptr()->constants_;
 }
@@ -1928,18 +1922,80 @@ static bool MatchesPrivateName(const String& name, const String& private_name) {
 }
 
 
-RawFunction* Class::LookupFunction(const String& name) const {
+// Hash of a function name without its private key, so that private names
+// hash to the same value as the name they are looked up by.
+static intptr_t FunctionNameHash(const String& name) {
+  intptr_t len = name.Length();
+  for (intptr_t i = 0; i < len; i++) {
+    if (name.CharAt(i) == Scanner::kPrivateKeySeparator) {
+      len = i;
+      break;
+    }
+  }
+  return String::Hash(name, 0, len);
+}
+
+
+RawArray* Class::functions_hash_table() const {
+  if (raw_ptr()->functions_hash_table_ != Array::null()) {
+    return raw_ptr()->functions_hash_table_;
+  }
   Isolate* isolate = Isolate::Current();
-  Array& funcs = Array::Handle(isolate, functions());
+  const Array& funcs = Array::Handle(isolate, functions());
   Function& function = Function::Handle(isolate, Function::null());
   String& function_name = String::Handle(isolate, String::null());
   intptr_t len = funcs.Length();
+  // Keep the load factor at or below 1/2.
+  intptr_t capacity = Utils::RoundUpToPowerOfTwo(2 * len);
+  const Array& table = Array::Handle(isolate, Array::New(capacity, Heap::kOld));
+  intptr_t mask = capacity - 1;
+  // Functions are inserted in order, so that functions with the same name
+  // hash are probed in the order of the functions array.
   for (intptr_t i = 0; i < len; i++) {
     function ^= funcs.At(i);
     function_name ^= function.name();
+    intptr_t index = FunctionNameHash(function_name) & mask;
+    while (table.At(index) != Object::null()) {
+      index = (index + 1) & mask;
+    }
+    table.SetAt(index, Smi::Handle(isolate, Smi::New(i)));
+  }
+  StorePointer(&raw_ptr()->functions_hash_table_, table.raw());
+  return table.raw();
+}
+
+
+RawFunction* Class::LookupFunction(const String& name) const {
+  Isolate* isolate = Isolate::Current();
+  Array& funcs = Array::Handle(isolate, functions());
+  Function& function = Function::Handle(isolate, Function::null());
+  String& function_name = String::Handle(isolate, String::null());
+  intptr_t len = funcs.Length();
+  if (len < kFunctionsHashTableThreshold) {
+    for (intptr_t i = 0; i < len; i++) {
+      function ^= funcs.At(i);
+      function_name ^= function.name();
+      if (function_name.Equals(name) ||
+          MatchesPrivateName(function_name, name)) {
+        return function.raw();
+      }
+    }
+    // No function found.
+    return Function::null();
+  }
+
+  const Array& table = Array::Handle(isolate, functions_hash_table());
+  intptr_t mask = table.Length() - 1;
+  intptr_t index = FunctionNameHash(name) & mask;
+  RawObject* entry = table.At(index);
+  while (entry != Object::null()) {
+    function ^= funcs.At(Smi::Value(reinterpret_cast<RawSmi*>(entry)));
+    function_name ^= function.name();
     if (function_name.Equals(name) || MatchesPrivateName(function_name, name)) {
       return function.raw();
     }
+    index = (index + 1) & mask;
+    entry = table.At(index);
   }
 
   // No function found.
@@ -4272,104 +4328,313 @@ const char* LiteralToken::ToCString() const {
 }
 
 
+// Writes a non-negative value seven bits at a time, least significant group
+// first, with the high bit set on all but the last byte.
+static void WriteUnsignedVarint(GrowableArray<uint8_t>* stream,
+                                intptr_t value) {
+  ASSERT(value >= 0);
+  while (value >= 0x80) {
+    stream->Add(static_cast<uint8_t>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  stream->Add(static_cast<uint8_t>(value));
+}
+
+
+static intptr_t ReadUnsignedVarint(const Uint8Array& stream,
+                                   intptr_t* offset) {
+  intptr_t value = 0;
+  intptr_t shift = 0;
+  uint8_t byte;
+  do {
+    byte = stream.At((*offset)++);
+    value |= static_cast<intptr_t>(byte & 0x7F) << shift;
+    shift += 7;
+  } while ((byte & 0x80) != 0);
+  return value;
+}
+
+
 void TokenStream::SetLength(intptr_t value) const {
   raw_ptr()->length_ = Smi::New(value);
 }
 
 
-void TokenStream::SetTokenAt(intptr_t index,
-                             Token::Kind kind,
-                             const String& literal) {
-  if (kind == Token::kIDENT) {
-    if (FLAG_compiler_stats) {
-      CompilerStats::num_ident_tokens_total += 1;
-    }
-    StorePointer(EntryAddr(index), reinterpret_cast<RawObject*>(literal.raw()));
-  } else if (Token::NeedsLiteralToken(kind)) {
-    if (FLAG_compiler_stats) {
-      CompilerStats::num_literal_tokens_total += 1;
-    }
-    StorePointer(
-        EntryAddr(index),
-        reinterpret_cast<RawObject*>(LiteralToken::New(kind, literal)));
-  } else {
-    ASSERT(kind < Token::kNumTokens);
-    *(SmiAddr(index)) = Smi::New(kind);
-  }
+static bool HasLiteralIndex(Token::Kind kind) {
+  return (kind == Token::kIDENT) || Token::NeedsLiteralToken(kind);
 }
 
 
-void TokenStream::SetTokenAt(intptr_t index, const Object& token) {
-  StorePointer(EntryAddr(index), token.raw());
+Token::Kind TokenStream::KindAt(intptr_t index) const {
+  TokenStreamIterator iterator(*this, index);
+  return iterator.CurrentTokenKind();
 }
 
 
 RawObject* TokenStream::TokenAt(intptr_t index) const {
-  return *EntryAddr(index);
+  TokenStreamIterator iterator(*this, index);
+  return iterator.CurrentToken();
 }
 
 
 RawString* TokenStream::LiteralAt(intptr_t index) const {
-  const Object& obj = Object::Handle(TokenAt(index));
-  if (obj.IsString()) {
-    return reinterpret_cast<RawString*>(obj.raw());
-  } else if (obj.IsSmi()) {
-    Token::Kind kind = static_cast<Token::Kind>(
-        Smi::Value(reinterpret_cast<RawSmi*>(obj.raw())));
-    ASSERT(kind < Token::kNumTokens);
-    if (Token::IsPseudoKeyword(kind) || Token::IsKeyword(kind)) {
-      Isolate* isolate = Isolate::Current();
-      ObjectStore* object_store = isolate->object_store();
-      String& str = String::Handle(isolate, String::null());
-      const Array& symbols = Array::Handle(isolate,
-                                           object_store->keyword_symbols());
-      ASSERT(!symbols.IsNull());
-      str ^= symbols.At(kind - Token::kFirstKeyword);
-      ASSERT(!str.IsNull());
-      return str.raw();
-    }
-    return String::NewSymbol(Token::Str(kind));
-  } else {
-    LiteralToken& token = LiteralToken::Handle();
-    token ^= obj.raw();  // Must be a literal token.
-    return token.literal();
-  }
+  TokenStreamIterator iterator(*this, index);
+  return iterator.CurrentLiteral();
 }
 
 
-RawTokenStream* TokenStream::New(intptr_t len) {
+RawTokenStream* TokenStream::New() {
   const Class& token_stream_class = Class::Handle(Object::token_stream_class());
-  TokenStream& result = TokenStream::Handle();
-  {
-    RawObject* raw = Object::Allocate(token_stream_class,
-                                      TokenStream::InstanceSize(len),
-                                      Heap::kOld);
-    NoGCScope no_gc;
-    result ^= raw;
-    result.SetLength(len);
-  }
-  return result.raw();
+  RawObject* raw = Object::Allocate(token_stream_class,
+                                    TokenStream::InstanceSize(),
+                                    Heap::kOld);
+  return reinterpret_cast<RawTokenStream*>(raw);
 }
 
 
-RawTokenStream* TokenStream::New(const Scanner::GrowableTokenStream& tokens) {
-  intptr_t len = tokens.length();
+// Collects the identifiers and literal tokens of a token stream so that each
+// distinct one is allocated and stored only once. The scanner returns symbols,
+// so two literals are the same if their kind and symbol are the same.
+class TokenLiteralPool : public ValueObject {
+ public:
+  TokenLiteralPool()
+      : literals_(GrowableObjectArray::Handle(
+            GrowableObjectArray::New(Heap::kOld))),
+        symbols_(GrowableObjectArray::Handle(
+            GrowableObjectArray::New(Heap::kOld))),
+        kinds_(),
+        table_(),
+        mask_(0) {
+    Rehash(kInitialCapacity);
+  }
+
+  // Returns the index of the literal, adding it to the pool if it is new.
+  intptr_t IndexOf(Token::Kind kind, const String& symbol) {
+    ASSERT(symbol.IsSymbol());
+    intptr_t probe = Hash(kind, symbol) & mask_;
+    while (table_[probe] != kEmpty) {
+      const intptr_t index = table_[probe];
+      if ((kinds_[index] == kind) && (symbols_.At(index) == symbol.raw())) {
+        return index;
+      }
+      probe = (probe + 1) & mask_;
+    }
+    const intptr_t index = kinds_.length();
+    if (kind == Token::kIDENT) {
+      literals_.Add(symbol);
+    } else {
+      literals_.Add(LiteralToken::Handle(LiteralToken::New(kind, symbol)));
+    }
+    symbols_.Add(symbol);
+    kinds_.Add(kind);
+    table_[probe] = index;
+    if ((kinds_.length() * 4) > (table_.length() * 3)) {
+      Rehash(table_.length() * 2);
+    }
+    return index;
+  }
+
+  RawArray* MakeArray() const {
+    return Array::MakeArray(literals_);
+  }
+
+ private:
+  static const intptr_t kInitialCapacity = 256;
+  static const intptr_t kEmpty = -1;
+
+  static intptr_t Hash(Token::Kind kind, const String& symbol) {
+    return symbol.Hash() + kind;
+  }
+
+  void Rehash(intptr_t capacity) {
+    ASSERT(Utils::IsPowerOfTwo(capacity));
+    table_.Clear();
+    for (intptr_t i = 0; i < capacity; i++) {
+      table_.Add(kEmpty);
+    }
+    mask_ = capacity - 1;
+    String& symbol = String::Handle();
+    for (intptr_t index = 0; index < kinds_.length(); index++) {
+      symbol ^= symbols_.At(index);
+      intptr_t probe = Hash(kinds_[index], symbol) & mask_;
+      while (table_[probe] != kEmpty) {
+        probe = (probe + 1) & mask_;
+      }
+      table_[probe] = index;
+    }
+  }
+
+  const GrowableObjectArray& literals_;
+  const GrowableObjectArray& symbols_;
+  GrowableArray<Token::Kind> kinds_;
+  GrowableArray<intptr_t> table_;  // Indices into kinds_, or kEmpty.
+  intptr_t mask_;
 
-  TokenStream& result = TokenStream::Handle(New(len));
-  // Copy the relevant data out of the scanner's token stream.
-  const String& empty_literal = String::Handle();
+  DISALLOW_COPY_AND_ASSIGN(TokenLiteralPool);
+};
+
+
+RawTokenStream* TokenStream::New(const Scanner::GrowableTokenStream& tokens) {
+  ASSERT(Utils::IsUint(8, Token::kNumTokens - 1));
+  const intptr_t len = tokens.length();
+  const intptr_t num_blocks = (len + kTokenBlockSize - 1) / kTokenBlockSize;
+  const Uint32Array& index =
+      Uint32Array::Handle(Uint32Array::New(num_blocks, Heap::kOld));
+  TokenLiteralPool pool;
+  GrowableArray<uint8_t> stream;
   for (intptr_t i = 0; i < len; i++) {
-    Scanner::TokenDescriptor token = tokens[i];
-    if (token.literal != NULL) {
-      result.SetTokenAt(i, token.kind, *(token.literal));
-    } else {
-      result.SetTokenAt(i, token.kind, empty_literal);
+    if ((i % kTokenBlockSize) == 0) {
+      index.SetAt(i / kTokenBlockSize, stream.length());
+    }
+    const Scanner::TokenDescriptor& token = tokens[i];
+    ASSERT(token.kind < Token::kNumTokens);
+    stream.Add(static_cast<uint8_t>(token.kind));
+    if (HasLiteralIndex(token.kind)) {
+      ASSERT(token.literal != NULL);
+      WriteUnsignedVarint(&stream, pool.IndexOf(token.kind, *token.literal));
+      if (FLAG_compiler_stats) {
+        if (token.kind == Token::kIDENT) {
+          CompilerStats::num_ident_tokens_total += 1;
+        } else {
+          CompilerStats::num_literal_tokens_total += 1;
+        }
+      }
+    }
+  }
+  const Array& literals = Array::Handle(pool.MakeArray());
+  const Uint8Array& data = Uint8Array::Handle(
+      Uint8Array::New(stream.data(), stream.length(), Heap::kOld));
+
+  const TokenStream& result = TokenStream::Handle(New());
+  result.SetLength(len);
+  result.StorePointer(&result.raw_ptr()->literals_, literals.raw());
+  result.StorePointer(&result.raw_ptr()->stream_, data.raw());
+  result.StorePointer(&result.raw_ptr()->index_, index.raw());
+  if (FLAG_compiler_stats) {
+    CompilerStats::num_token_literals_total += literals.Length();
+    CompilerStats::token_stream_size +=
+        TokenStream::InstanceSize() +
+        Array::InstanceSize(literals.Length()) +
+        Uint8Array::InstanceSize(data.Length()) +
+        Uint32Array::InstanceSize(index.Length());
+    // A word per token and a literal token for every literal occurrence.
+    intptr_t unpacked_size = RoundedAllocationSize(
+        sizeof(RawTokenStream) + (len * kWordSize));
+    for (intptr_t i = 0; i < len; i++) {
+      if (Token::NeedsLiteralToken(tokens[i].kind)) {
+        unpacked_size += LiteralToken::InstanceSize();
+      }
     }
+    CompilerStats::token_stream_unpacked_size += unpacked_size;
   }
   return result.raw();
 }
 
 
+TokenStreamIterator::TokenStreamIterator(const TokenStream& tokens,
+                                         intptr_t token_index)
+    : tokens_(tokens),
+      literals_(Array::Handle(tokens.literals())),
+      stream_(Uint8Array::Handle(tokens.stream())),
+      index_(Uint32Array::Handle(tokens.index())),
+      cur_index_(0),
+      cur_offset_(0),
+      next_offset_(0),
+      cur_kind_(Token::kILLEGAL),
+      cur_literal_index_(-1) {
+  ReadToken();
+  SetCurrentPosition(token_index);
+}
+
+
+void TokenStreamIterator::SetCurrentPosition(intptr_t value) {
+  ASSERT((value >= 0) && (value < tokens_.Length()));
+  if ((value < cur_index_) ||
+      (value >= (cur_index_ + TokenStream::kTokenBlockSize))) {
+    const intptr_t block = value / TokenStream::kTokenBlockSize;
+    cur_index_ = block * TokenStream::kTokenBlockSize;
+    cur_offset_ = index_.At(block);
+    ReadToken();
+  }
+  while (cur_index_ < value) {
+    Advance();
+  }
+}
+
+
+void TokenStreamIterator::Advance() {
+  ASSERT(cur_index_ < (tokens_.Length() - 1));
+  cur_index_++;
+  cur_offset_ = next_offset_;
+  ReadToken();
+}
+
+
+void TokenStreamIterator::ReadToken() {
+  intptr_t offset = cur_offset_;
+  cur_kind_ = static_cast<Token::Kind>(stream_.At(offset++));
+  if (HasLiteralIndex(cur_kind_)) {
+    cur_literal_index_ = ReadUnsignedVarint(stream_, &offset);
+  } else {
+    cur_literal_index_ = -1;
+  }
+  next_offset_ = offset;
+}
+
+
+Token::Kind TokenStreamIterator::LookaheadTokenKind(
+    intptr_t num_tokens) const {
+  ASSERT(num_tokens >= 0);
+  ASSERT((cur_index_ + num_tokens) < tokens_.Length());
+  if (num_tokens == 0) {
+    return cur_kind_;
+  }
+  intptr_t offset = next_offset_;
+  Token::Kind kind = static_cast<Token::Kind>(stream_.At(offset++));
+  for (intptr_t i = 1; i < num_tokens; i++) {
+    if (HasLiteralIndex(kind)) {
+      ReadUnsignedVarint(stream_, &offset);
+    }
+    kind = static_cast<Token::Kind>(stream_.At(offset++));
+  }
+  return kind;
+}
+
+
+RawObject* TokenStreamIterator::CurrentToken() const {
+  if (cur_literal_index_ < 0) {
+    return Smi::New(cur_kind_);
+  }
+  return literals_.At(cur_literal_index_);
+}
+
+
+RawString* TokenStreamIterator::CurrentLiteral() const {
+  if (cur_kind_ == Token::kIDENT) {
+    String& str = String::Handle();
+    str ^= literals_.At(cur_literal_index_);
+    return str.raw();
+  }
+  if (cur_literal_index_ >= 0) {
+    LiteralToken& token = LiteralToken::Handle();
+    token ^= literals_.At(cur_literal_index_);
+    return token.literal();
+  }
+  if (Token::IsPseudoKeyword(cur_kind_) || Token::IsKeyword(cur_kind_)) {
+    Isolate* isolate = Isolate::Current();
+    ObjectStore* object_store = isolate->object_store();
+    String& str = String::Handle(isolate, String::null());
+    const Array& symbols = Array::Handle(isolate,
+                                         object_store->keyword_symbols());
+    ASSERT(!symbols.IsNull());
+    str ^= symbols.At(cur_kind_ - Token::kFirstKeyword);
+    ASSERT(!str.IsNull());
+    return str.raw();
+  }
+  return String::NewSymbol(Token::Str(cur_kind_));
+}
+
+
 const char* TokenStream::ToCString() const {
   return "TokenStream";
 }
@@ -4406,30 +4671,151 @@ void Script::Tokenize(const String& private_key) const {
   TimerScope timer(FLAG_compiler_stats, &CompilerStats::scanner_timer);
   const String& src = String::Handle(source());
   Scanner scanner(src, private_key);
-  set_tokens(TokenStream::Handle(TokenStream::New(scanner.GetStream())));
+  const Scanner::GrowableTokenStream& stream = scanner.GetStream();
+  set_tokens(TokenStream::Handle(TokenStream::New(stream)));
+  SetTokenPositions(stream);
   if (FLAG_compiler_stats) {
     CompilerStats::src_length += src.Length();
   }
 }
 
 
+// Advances (line, column) from the position of a token to the position of the
+// next token. A token on the same line is encoded as the column delta shifted
+// left by one, otherwise the line delta shifted left by one with the low bit
+// set is followed by the absolute column.
+static void DecodeTokenPosition(const Uint8Array& deltas,
+                                intptr_t* offset,
+                                intptr_t* line,
+                                intptr_t* column) {
+  intptr_t value = ReadUnsignedVarint(deltas, offset);
+  if ((value & 1) == 0) {
+    *column += (value >> 1);
+  } else {
+    *line += (value >> 1);
+    *column = ReadUnsignedVarint(deltas, offset);
+  }
+}
+
+
+void Script::SetTokenPositions(
+    const Scanner::GrowableTokenStream& tokens) const {
+  const intptr_t num_tokens = tokens.length();
+  const intptr_t num_blocks =
+      (num_tokens + kTokenPositionBlockSize - 1) / kTokenPositionBlockSize;
+  const Uint32Array& blocks = Uint32Array::Handle(
+      Uint32Array::New(num_blocks * kBlockEntrySize, Heap::kOld));
+  GrowableArray<uint8_t> deltas(num_tokens + 1);
+  intptr_t line = 0;
+  intptr_t column = 0;
+  for (intptr_t i = 0; i < num_tokens; i++) {
+    const intptr_t token_line = tokens[i].position.line;
+    const intptr_t token_column = tokens[i].position.column;
+    if ((i % kTokenPositionBlockSize) == 0) {
+      // The first token of a block is stored with its absolute position.
+      const intptr_t block = (i / kTokenPositionBlockSize) * kBlockEntrySize;
+      blocks.SetAt(block + kBlockDeltaOffset, deltas.length());
+      blocks.SetAt(block + kBlockLine, token_line);
+      blocks.SetAt(block + kBlockColumn, token_column);
+    } else if ((token_line == line) && (token_column >= column)) {
+      WriteUnsignedVarint(&deltas, (token_column - column) << 1);
+    } else {
+      ASSERT(token_line >= line);
+      WriteUnsignedVarint(&deltas, ((token_line - line) << 1) | 1);
+      WriteUnsignedVarint(&deltas, token_column);
+    }
+    line = token_line;
+    column = token_column;
+  }
+  const Uint8Array& encoded = Uint8Array::Handle(
+      Uint8Array::New(deltas.data(), deltas.length(), Heap::kOld));
+  StorePointer(&raw_ptr()->token_position_blocks_, blocks.raw());
+  StorePointer(&raw_ptr()->token_position_deltas_, encoded.raw());
+}
+
+
 void Script::GetTokenLocation(intptr_t token_index,
                               intptr_t* line,
                               intptr_t* column) const {
-  const String& src = String::Handle(source());
-  const String& dummy_key = String::Handle(String::New(""));
-  Scanner scanner(src, dummy_key);
-  scanner.ScanTo(token_index);
-  *line = scanner.CurrentPosition().line;
-  *column = scanner.CurrentPosition().column;
+  const Uint32Array& blocks =
+      Uint32Array::Handle(raw_ptr()->token_position_blocks_);
+  if (blocks.IsNull()) {
+    // The script has not been tokenized, scan up to the token.
+    const String& src = String::Handle(source());
+    const String& dummy_key = String::Handle(String::New(""));
+    Scanner scanner(src, dummy_key);
+    scanner.ScanTo(token_index);
+    *line = scanner.CurrentPosition().line;
+    *column = scanner.CurrentPosition().column;
+    return;
+  }
+  const Uint8Array& deltas =
+      Uint8Array::Handle(raw_ptr()->token_position_deltas_);
+  const intptr_t num_tokens = TokenStream::Handle(tokens()).Length();
+  ASSERT(token_index >= 0);
+  if (token_index >= num_tokens) {
+    // Positions past the end of the script map to the end of stream token.
+    token_index = num_tokens - 1;
+  }
+  const intptr_t block = token_index / kTokenPositionBlockSize;
+  const intptr_t entry = block * kBlockEntrySize;
+  intptr_t offset = blocks.At(entry + kBlockDeltaOffset);
+  *line = blocks.At(entry + kBlockLine);
+  *column = blocks.At(entry + kBlockColumn);
+  for (intptr_t i = block * kTokenPositionBlockSize; i < token_index; i++) {
+    DecodeTokenPosition(deltas, &offset, line, column);
+  }
 }
 
 
 intptr_t Script::TokenIndexAtLine(intptr_t line_number) const {
-  const String& src = String::Handle(source());
-  const String& dummy_key = String::Handle(String::New(""));
-  Scanner scanner(src, dummy_key);
-  return scanner.TokenIndexAtLine(line_number);
+  const Uint32Array& blocks =
+      Uint32Array::Handle(raw_ptr()->token_position_blocks_);
+  if (blocks.IsNull()) {
+    // The script has not been tokenized, scan up to the line.
+    const String& src = String::Handle(source());
+    const String& dummy_key = String::Handle(String::New(""));
+    Scanner scanner(src, dummy_key);
+    return scanner.TokenIndexAtLine(line_number);
+  }
+  ASSERT(line_number >= 0);
+  // Find the first block which starts at or after the line, the token is
+  // either the first token of that block or a token of the preceding block.
+  const intptr_t num_blocks = blocks.Length() / kBlockEntrySize;
+  intptr_t low = 0;
+  intptr_t high = num_blocks;
+  while (low < high) {
+    intptr_t mid = low + ((high - low) / 2);
+    intptr_t mid_line = blocks.At((mid * kBlockEntrySize) + kBlockLine);
+    if (mid_line < line_number) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low == 0) {
+    return 0;
+  }
+  const Uint8Array& deltas =
+      Uint8Array::Handle(raw_ptr()->token_position_deltas_);
+  const intptr_t num_tokens = TokenStream::Handle(tokens()).Length();
+  const intptr_t block = low - 1;
+  const intptr_t entry = block * kBlockEntrySize;
+  intptr_t offset = blocks.At(entry + kBlockDeltaOffset);
+  intptr_t line = blocks.At(entry + kBlockLine);
+  intptr_t column = blocks.At(entry + kBlockColumn);
+  intptr_t token_index = block * kTokenPositionBlockSize;
+  const intptr_t block_end =
+      Utils::Minimum(token_index + kTokenPositionBlockSize, num_tokens);
+  for (token_index++; token_index < block_end; token_index++) {
+    DecodeTokenPosition(deltas, &offset, &line, &column);
+    if (line >= line_number) {
+      return token_index;
+    }
+  }
+  // Not found in the preceding block, it is the first token of the next
+  // block, if there is one.
+  return (low < num_blocks) ? (low * kTokenPositionBlockSize) : -1;
 }
 
 
@@ -5281,9 +5667,10 @@ RawLibrary* Library::New() {
 RawLibrary* Library::NewLibraryHelper(const String& url,
                                       bool import_core_lib) {
   const Library& result = Library::Handle(Library::New());
-  result.raw_ptr()->name_ = url.raw();
-  result.raw_ptr()->url_ = url.raw();
-  result.raw_ptr()->private_key_ = Scanner::AllocatePrivateKey(result);
+  result.StorePointer(&result.raw_ptr()->name_, url.raw());
+  result.StorePointer(&result.raw_ptr()->url_, url.raw());
+  result.StorePointer(&result.raw_ptr()->private_key_,
+                      Scanner::AllocatePrivateKey(result));
   result.raw_ptr()->dictionary_ = Array::Empty();
   result.raw_ptr()->anonymous_classes_ = Array::Empty();
   result.raw_ptr()->num_anonymous_ = 0;
@@ -5677,6 +6064,9 @@ RawInstructions* Instructions::New(intptr_t size, Heap::Space space) {
     result ^= raw;
     result.set_size(size);
   }
+  if (space == Heap::kDartCode) {
+    Isolate::Current()->code_index_table()->AddInstructions(result);
+  }
   return result.raw();
 }
 
@@ -5769,6 +6159,7 @@ const char* PcDescriptors::KindAsStr(intptr_t index) const {
     case PcDescriptors::kIcCall: return "ic-call";
     case PcDescriptors::kFuncCall: return "fn-call";
     case PcDescriptors::kReturn: return "return";
+    case PcDescriptors::kOsrEntry: return "osr-entry";
     case PcDescriptors::kOther: return "other";
   }
   UNREACHABLE();
@@ -5840,11 +6231,6 @@ void PcDescriptors::Verify(bool check_ids) const {
 }
 
 
-void Stackmap::SetCode(const Code& code) const {
-  StorePointer(&raw_ptr()->code_, code.raw());
-}
-
-
 bool Stackmap::GetBit(intptr_t bit_offset) const {
   ASSERT(InRange(bit_offset));
   int byte_offset = bit_offset >> kBitsPerByteLog2;
@@ -5869,7 +6255,7 @@ void Stackmap::SetBit(intptr_t bit_offset, bool value) const {
 }
 
 
-RawStackmap* Stackmap::New(uword pc_offset, BitmapBuilder* bmap) {
+RawStackmap* Stackmap::New(BitmapBuilder* bmap) {
   const Class& cls = Class::Handle(Object::stackmap_class());
   ASSERT(!cls.IsNull());
   ASSERT(bmap != NULL);
@@ -5884,7 +6270,6 @@ RawStackmap* Stackmap::New(uword pc_offset, BitmapBuilder* bmap) {
     result ^= raw;
     result.set_bitmap_size_in_bytes(size);
   }
-  result.SetPC(pc_offset);
   intptr_t bound = bmap->SizeInBits();
   for (intptr_t i = 0; i < bound; i++) {
     result.SetBit(i, bmap->Get(i));
@@ -5895,6 +6280,22 @@ RawStackmap* Stackmap::New(uword pc_offset, BitmapBuilder* bmap) {
 }
 
 
+bool Stackmap::Equals(BitmapBuilder* bmap) const {
+  ASSERT(bmap != NULL);
+  if ((MinimumBitOffset() != bmap->Minimum()) ||
+      (MaximumBitOffset() != bmap->Maximum())) {
+    return false;
+  }
+  // Bits outside of [minimum, maximum] are not set in either bit map.
+  for (intptr_t i = MinimumBitOffset(); i <= MaximumBitOffset(); i++) {
+    if (IsObject(i) != bmap->Get(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
 void Stackmap::set_bitmap_size_in_bytes(intptr_t value) const {
   // This is only safe because we create a new Smi, which does not cause
   // heap allocation.
@@ -5906,13 +6307,13 @@ const char* Stackmap::ToCString() const {
   if (IsNull()) {
     return "{null}";
   } else {
-    intptr_t index = OS::SNPrint(NULL, 0, "0x%lx { ", PC());
+    intptr_t index = OS::SNPrint(NULL, 0, "{ ");
     intptr_t alloc_size =
         index + ((MaximumBitOffset() + 1) * 2) + 2;  // "{ 1 0 .... }".
     Isolate* isolate = Isolate::Current();
     char* chars = reinterpret_cast<char*>(
         isolate->current_zone()->Allocate(alloc_size));
-    index = OS::SNPrint(chars, alloc_size, "0x%lx { ", PC());
+    index = OS::SNPrint(chars, alloc_size, "{ ");
     for (intptr_t i = 0; i <= MaximumBitOffset(); i++) {
       index += OS::SNPrint((chars + index),
                            (alloc_size - index),
@@ -5989,7 +6390,7 @@ RawLocalVarDescriptors* LocalVarDescriptors::New(intptr_t num_variables) {
     result.raw_ptr()->length_ = num_variables;
   }
   const Array& names = Array::Handle(Array::New(num_variables, Heap::kOld));
-  result.raw_ptr()->names_ = names.raw();
+  result.StorePointer(&result.raw_ptr()->names_, names.raw());
   return result.raw();
 }
 
@@ -6077,6 +6478,33 @@ void Code::set_stackmaps(const Array& maps) const {
 }
 
 
+void Code::set_stackmap_index(const Uint32Array& index) const {
+  StorePointer(&raw_ptr()->stackmap_index_, index.raw());
+}
+
+
+void Code::set_deopt_info_array(const Array& array) const {
+  StorePointer(&raw_ptr()->deopt_info_array_, array.raw());
+}
+
+
+intptr_t Code::GetDeoptIndexAtPc(uword pc) const {
+  const Array& table = Array::Handle(deopt_info_array());
+  if (table.IsNull()) {
+    return -1;
+  }
+  const intptr_t pc_offset = pc - EntryPoint();
+  Smi& offset = Smi::Handle();
+  for (intptr_t i = 0; i < table.Length(); i += kDeoptEntrySize) {
+    offset ^= table.At(i + kDeoptPcOffsetEntry);
+    if (offset.Value() == pc_offset) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+
 RawCode* Code::New(int pointer_offsets_length) {
   const Class& cls = Class::Handle(Object::code_class());
   Code& result = Code::Handle();
@@ -6205,6 +6633,20 @@ uword Code::GetDeoptPcAtNodeId(intptr_t node_id) const {
 }
 
 
+uword Code::GetOsrEntryPcAtNodeId(intptr_t node_id) const {
+  const PcDescriptors& descriptors = PcDescriptors::Handle(pc_descriptors());
+  uword result = 0;
+  for (intptr_t i = 0; i < descriptors.Length(); i++) {
+    if ((descriptors.NodeId(i) == node_id) &&
+        (descriptors.DescriptorKind(i) == PcDescriptors::kOsrEntry)) {
+      if (result != 0) return 0;
+      result = descriptors.PC(i);
+    }
+  }
+  return result;
+}
+
+
 const char* Code::ToCString() const {
   const char* kFormat = "Code entry:0x%d";
   intptr_t len = OS::SNPrint(NULL, 0, kFormat, EntryPoint());
@@ -6261,10 +6703,14 @@ intptr_t Code::ExtractIcDataArraysAtCalls(
 }
 
 
-RawStackmap* Code::GetStackmap(uword pc, Array* maps, Stackmap* map) const {
+RawStackmap* Code::GetStackmap(uword pc,
+                               Uint32Array* index,
+                               Array* maps,
+                               Stackmap* map) const {
   // This code is used only during iterating frames during a GC and hence
   // it should not in turn start a GC.
   NoGCScope no_gc;
+  *map = Stackmap::null();
   if (stackmaps() == Array::null()) {
     // No stack maps are present in the code object which means this
     // frame relies on tagged pointers.
@@ -6272,23 +6718,42 @@ RawStackmap* Code::GetStackmap(uword pc, Array* maps, Stackmap* map) const {
   }
   // A stack map is present in the code object, use the stack map to visit
   // frame slots which are marked as having objects.
-  RawStackmap* previous_map = Stackmap::null();
-  *maps = stackmaps();
-  *map = Stackmap::null();
-  for (intptr_t i = 0; i < maps->Length(); i++) {
-    *map ^= maps->At(i);
-    ASSERT(!map->IsNull());
-    if (map->PC() == pc) {
-      break;  // We found a stack map for this frame.
-    }
-    if (map->PC() > pc) {
-      // We have not found a stackmap corresponding to the PC of this frame,
-      // we will use the closest previous stack map.
-      *map = previous_map;
-      break;
+  // Find the last safepoint at or before pc, the index is sorted by PC offset.
+  Instructions instructions;
+  instructions = this->instructions();
+  const intptr_t pc_offset = pc - instructions.EntryPoint();
+  *index = stackmap_index();
+  const intptr_t length = index->Length() / kStackmapIndexEntrySize;
+  intptr_t low = 0;
+  intptr_t high = length - 1;
+  intptr_t probes = 0;
+  while (low <= high) {
+    intptr_t mid = low + ((high - low) / 2);
+    probes++;
+    intptr_t mid_offset =
+        index->At((mid * kStackmapIndexEntrySize) + kStackmapPcOffsetEntry);
+    if (mid_offset <= pc_offset) {
+      low = mid + 1;
+    } else {
+      high = mid - 1;
     }
-    previous_map = map->raw();
   }
+  if (FLAG_compiler_stats) {
+    CompilerStats::num_stackmap_lookups++;
+    CompilerStats::num_stackmap_probes += probes;
+    // A linear scan stops at the first entry past pc.
+    CompilerStats::num_stackmap_linear_probes +=
+        Utils::Minimum(high + 2, length);
+  }
+  if (high < 0) {
+    // We have not found a stackmap corresponding to the PC of this frame
+    // or any preceding PC.
+    return Stackmap::null();
+  }
+  *maps = stackmaps();
+  *map ^= maps->At(
+      index->At((high * kStackmapIndexEntrySize) + kStackmapMapIndexEntry));
+  ASSERT(!map->IsNull());
   return map->raw();
 }
 
@@ -9628,12 +10093,12 @@ RawClosure* Closure::New(const Function& function,
 
 
 void Closure::set_context(const Context& value) const {
-  raw_ptr()->context_ = value.raw();
+  StorePointer(&raw_ptr()->context_, value.raw());
 }
 
 
 void Closure::set_function(const Function& value) const {
-  raw_ptr()->function_ = value.raw();
+  StorePointer(&raw_ptr()->function_, value.raw());
 }
 
 
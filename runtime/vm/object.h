@@ -360,10 +360,10 @@ CLASS_LIST_NO_OBJECT(DEFINE_CLASS_TESTER);
   }
 
   template<typename type> void StorePointer(type* addr, type value) const {
-    // TODO(iposva): Implement real store barrier here.
     *addr = value;
-    // Filter stores based on source and target.
-    if (value->IsNewObject() && raw()->IsOldObject()) {
+    // Filter stores based on source and target: only old space slots which
+    // now refer to new space objects need to be remembered.
+    if (value->IsHeapObject() && value->IsNewObject() && raw()->IsOldObject()) {
       uword ptr = reinterpret_cast<uword>(addr);
       Isolate::Current()->store_buffer()->AddPointer(ptr);
     }
@@ -468,6 +468,7 @@ class Class : public Object {
   void set_index(intptr_t value) const {
     raw_ptr()->index_ = value;
   }
+  static intptr_t index_offset() { return OFFSET_OF(RawClass, index_); }
 
   RawString* Name() const;
 
@@ -569,13 +570,6 @@ class Class : public Object {
     return OFFSET_OF(RawClass, interfaces_);
   }
 
-  RawArray* functions_cache() const { return raw_ptr()->functions_cache_; }
-  void set_functions_cache(const Array& value) const;
-
-  static intptr_t functions_cache_offset() {
-    return OFFSET_OF(RawClass, functions_cache_);
-  }
-
   // Check if this class represents the class of null.
   bool IsNullClass() const { return raw() == Object::null_class(); }
 
@@ -732,6 +726,15 @@ class Class : public Object {
                                       intptr_t prefix_length,
                                       const String& name) const;
 
+  // Classes with at least this many functions look up functions by name
+  // through a hash table instead of scanning the functions array.
+  static const intptr_t kFunctionsHashTableThreshold = 16;
+
+  // The hash table maps the hash of a function name, ignoring any private key
+  // suffix, to the indices of the functions in the functions array. It is
+  // built on first use and dropped when the functions are replaced.
+  RawArray* functions_hash_table() const;
+
   // Allocate an instance class which has a VM implementation.
   template <class FakeInstance> static RawClass* New(intptr_t index);
   template <class FakeInstance> static RawClass* New(const String& name,
@@ -1577,46 +1580,76 @@ class LiteralToken : public Object {
 };
 
 
+// Tokens are encoded as one byte holding the token kind. Identifiers and
+// literal tokens are followed by a varint index into a pool of literals in
+// which every identifier and literal occurs only once. The stream is meant to
+// be read sequentially with a TokenStreamIterator; the offset of every
+// kTokenBlockSize-th token is recorded so that an iterator can be positioned
+// anywhere in the stream by decoding at most one block.
 class TokenStream : public Object {
  public:
   inline intptr_t Length() const;
 
-  inline Token::Kind KindAt(intptr_t index) const;
-
-  void SetTokenAt(intptr_t index, Token::Kind kind, const String& literal);
-  void SetTokenAt(intptr_t index, const Object& token);
-
+  // Random access, prefer a TokenStreamIterator when reading sequentially.
+  Token::Kind KindAt(intptr_t index) const;
   RawObject* TokenAt(intptr_t index) const;
   RawString* LiteralAt(intptr_t index) const;
 
   static intptr_t InstanceSize() {
-    ASSERT(sizeof(RawTokenStream) == OFFSET_OF(RawTokenStream, data_));
-    return 0;
-  }
-  static intptr_t InstanceSize(intptr_t len) {
-    return RoundedAllocationSize(sizeof(RawTokenStream) + (len * kWordSize));
-  }
-  static intptr_t StreamLength(intptr_t len) {
-    return len;
+    return RoundedAllocationSize(sizeof(RawTokenStream));
   }
 
-  static RawTokenStream* New(intptr_t length);
   static RawTokenStream* New(const Scanner::GrowableTokenStream& tokens);
 
  private:
-  void SetLength(intptr_t value) const;
+  static const intptr_t kTokenBlockSize = 32;
 
-  RawObject** EntryAddr(intptr_t index) const {
-    ASSERT((index >=0) && (index < Length()));
-    return &raw_ptr()->data_[index];
-  }
+  void SetLength(intptr_t value) const;
+  RawArray* literals() const { return raw_ptr()->literals_; }
+  RawUint8Array* stream() const { return raw_ptr()->stream_; }
+  RawUint32Array* index() const { return raw_ptr()->index_; }
 
-  RawSmi** SmiAddr(intptr_t index) const {
-    return reinterpret_cast<RawSmi**>(EntryAddr(index));
-  }
+  static RawTokenStream* New();
 
   HEAP_OBJECT_IMPLEMENTATION(TokenStream, Object);
   friend class Class;
+  friend class TokenStreamIterator;
+};
+
+
+// Decodes a TokenStream sequentially. Moving the iterator backwards or far
+// ahead repositions it at the start of the enclosing block.
+class TokenStreamIterator : public ValueObject {
+ public:
+  TokenStreamIterator(const TokenStream& tokens, intptr_t token_index);
+
+  intptr_t CurrentPosition() const { return cur_index_; }
+  void SetCurrentPosition(intptr_t value);
+
+  void Advance();
+
+  Token::Kind CurrentTokenKind() const { return cur_kind_; }
+  Token::Kind LookaheadTokenKind(intptr_t num_tokens) const;
+
+  // Returns a Smi holding the token kind, the identifier or the literal token.
+  RawObject* CurrentToken() const;
+  RawString* CurrentLiteral() const;
+
+ private:
+  // Decodes the token at stream offset cur_offset_.
+  void ReadToken();
+
+  const TokenStream& tokens_;
+  const Array& literals_;
+  const Uint8Array& stream_;
+  const Uint32Array& index_;
+  intptr_t cur_index_;  // Index of the current token.
+  intptr_t cur_offset_;  // Stream offset of the current token.
+  intptr_t next_offset_;  // Stream offset of the next token.
+  Token::Kind cur_kind_;
+  intptr_t cur_literal_index_;  // -1 if the current token has no literal.
+
+  DISALLOW_COPY_AND_ASSIGN(TokenStreamIterator);
 };
 
 
@@ -1657,6 +1690,19 @@ class Script : public Object {
   void set_tokens(const TokenStream& value) const;
   static RawScript* New();
 
+  // The line and column of every token are recorded when the script is
+  // tokenized. Each token is delta encoded relative to the previous one, and
+  // the absolute position of every kTokenPositionBlockSize-th token is kept
+  // in a table of blocks, so a lookup decodes at most one block.
+  static const intptr_t kTokenPositionBlockSize = 32;
+  enum {
+    kBlockDeltaOffset = 0,  // Offset of the block's deltas in the stream.
+    kBlockLine,  // Line of the first token of the block.
+    kBlockColumn,  // Column of the first token of the block.
+    kBlockEntrySize
+  };
+  void SetTokenPositions(const Scanner::GrowableTokenStream& tokens) const;
+
   HEAP_OBJECT_IMPLEMENTATION(Script, Object);
   friend class Class;
 };
@@ -1954,6 +2000,7 @@ class PcDescriptors : public Object {
     kIcCall,     // IC call.
     kFuncCall,   // Call to known target, e.g. static call, closure call.
     kReturn,     // Return from function.
+    kOsrEntry,   // Loop entry from unoptimized code (on-stack replacement).
     kOther
   };
 
@@ -2039,11 +2086,6 @@ class Stackmap : public Object {
   bool IsObject(intptr_t offset) const {
     return InRange(offset) && GetBit(offset);
   }
-  uword PC() const { return raw_ptr()->pc_; }
-  void SetPC(uword value) const { raw_ptr()->pc_ = value; }
-
-  RawCode* GetCode() const { return raw_ptr()->code_; }
-  void SetCode(const Code& code) const;
 
   // Return the offset of the highest stack slot that has an object.
   intptr_t MaximumBitOffset() const { return raw_ptr()->max_set_bit_offset_; }
@@ -2055,10 +2097,13 @@ class Stackmap : public Object {
     ASSERT(sizeof(RawStackmap) == OFFSET_OF(RawStackmap, data_));
     return 0;
   }
-  static intptr_t InstanceSize(intptr_t size) {
-    return RoundedAllocationSize(sizeof(RawStackmap) + (size * kWordSize));
+  static intptr_t InstanceSize(intptr_t size_in_bytes) {
+    return RoundedAllocationSize(sizeof(RawStackmap) + size_in_bytes);
   }
-  static RawStackmap* New(uword pc, BitmapBuilder* bmap);
+  static RawStackmap* New(BitmapBuilder* bmap);
+
+  // Returns true if this stack map has the same layout as 'bmap'.
+  bool Equals(BitmapBuilder* bmap) const;
 
  private:
   inline intptr_t SizeInBits() const;
@@ -2171,7 +2216,24 @@ class Code : public Object {
     return raw_ptr()->stackmaps_;
   }
   void set_stackmaps(const Array& maps) const;
-  RawStackmap* GetStackmap(uword pc, Array* stackmaps, Stackmap* map) const;
+  RawUint32Array* stackmap_index() const {
+    return raw_ptr()->stackmap_index_;
+  }
+  void set_stackmap_index(const Uint32Array& index) const;
+  // Returns the stack map of the safepoint at 'pc', or of the closest
+  // safepoint preceding it. The handles 'index', 'maps' and 'map' are used as
+  // scratch handles, no handles are allocated as this is called during GC.
+  RawStackmap* GetStackmap(uword pc,
+                           Uint32Array* index,
+                           Array* maps,
+                           Stackmap* map) const;
+
+  // Entries of the stackmap index are pairs of (PC offset, map index).
+  enum {
+    kStackmapPcOffsetEntry = 0,
+    kStackmapMapIndexEntry,
+    kStackmapIndexEntrySize
+  };
 
   RawLocalVarDescriptors* var_descriptors() const {
     return raw_ptr()->var_descriptors_;
@@ -2180,6 +2242,27 @@ class Code : public Object {
     StorePointer(&raw_ptr()->var_descriptors_, value.raw());
   }
 
+  // The deoptimization points of optimized code: for each one, the PC
+  // offset of its call to the Deoptimize stub, the instructions translating
+  // the optimized frame into unoptimized frames and the objects they refer
+  // to (see DeoptInstr), and the deoptimization reason.
+  RawArray* deopt_info_array() const {
+    return raw_ptr()->deopt_info_array_;
+  }
+  void set_deopt_info_array(const Array& array) const;
+
+  enum {
+    kDeoptPcOffsetEntry = 0,
+    kDeoptInstructionsEntry,
+    kDeoptObjectTableEntry,
+    kDeoptReasonEntry,
+    kDeoptEntrySize
+  };
+
+  // Returns the index in the deoptimization info array of the first entry
+  // of the deoptimization point whose call returns to 'pc', or -1.
+  intptr_t GetDeoptIndexAtPc(uword pc) const;
+
   RawExceptionHandlers* exception_handlers() const {
     return raw_ptr()->exception_handlers_;
   }
@@ -2217,6 +2300,9 @@ class Code : public Object {
   uword GetPatchCodePc() const;
 
   uword GetDeoptPcAtNodeId(intptr_t node_id) const;
+  // Find pc of the loop entry for on-stack replacement. Return 0 if not
+  // found or if the loop occurs more than once, e.g., in a finally block.
+  uword GetOsrEntryPcAtNodeId(intptr_t node_id) const;
   uword GetTypeTestAtNodeId(intptr_t node_id) const;
 
   // Returns true if there is an object in the code between 'start_offset'
@@ -3144,6 +3230,7 @@ class OneByteString : public String {
   }
 
   HEAP_OBJECT_IMPLEMENTATION(OneByteString, String);
+  friend class BytecodeRegExp;
   friend class Class;
   friend class String;
 };
@@ -3197,6 +3284,7 @@ class TwoByteString : public String {
   }
 
   HEAP_OBJECT_IMPLEMENTATION(TwoByteString, String);
+  friend class BytecodeRegExp;
   friend class Class;
   friend class String;
 };
@@ -3247,6 +3335,7 @@ class FourByteString : public String {
   }
 
   HEAP_OBJECT_IMPLEMENTATION(FourByteString, String);
+  friend class BytecodeRegExp;
   friend class Class;
   friend class String;
 };
@@ -3291,6 +3380,7 @@ class ExternalOneByteString : public String {
   static void Finalize(Dart_Handle handle, void* peer);
 
   HEAP_OBJECT_IMPLEMENTATION(ExternalOneByteString, String);
+  friend class BytecodeRegExp;
   friend class Class;
   friend class String;
 };
@@ -3335,6 +3425,7 @@ class ExternalTwoByteString : public String {
   static void Finalize(Dart_Handle handle, void* peer);
 
   HEAP_OBJECT_IMPLEMENTATION(ExternalTwoByteString, String);
+  friend class BytecodeRegExp;
   friend class Class;
   friend class String;
 };
@@ -3379,6 +3470,7 @@ class ExternalFourByteString : public String {
   static void Finalize(Dart_Handle handle, void* peer);
 
   HEAP_OBJECT_IMPLEMENTATION(ExternalFourByteString, String);
+  friend class BytecodeRegExp;
   friend class Class;
   friend class String;
 };
@@ -3434,7 +3526,7 @@ class Array : public Instance {
     return raw_ptr()->type_arguments_;
   }
   virtual void SetTypeArguments(const AbstractTypeArguments& value) const {
-    raw_ptr()->type_arguments_ = value.raw();
+    StorePointer(&raw_ptr()->type_arguments_, value.raw());
   }
 
   virtual bool Equals(const Instance& other) const;
@@ -3564,7 +3656,7 @@ class GrowableObjectArray : public Instance {
   virtual void SetTypeArguments(const AbstractTypeArguments& value) const {
     const Array& contents = Array::Handle(data());
     contents.SetTypeArguments(value);
-    raw_ptr()->type_arguments_ = value.raw();
+    StorePointer(&raw_ptr()->type_arguments_, value.raw());
   }
 
   virtual bool Equals(const Instance& other) const;
@@ -3636,6 +3728,13 @@ class ByteArray : public Instance {
                    intptr_t src_offset,
                    intptr_t length);
 
+  // Returns the address of the first byte of the array, NULL if it is
+  // empty. The bytes of an array in the Dart heap move with it, so the
+  // address is only valid while no GC can happen.
+  uint8_t* DataAddr() const {
+    return (ByteLength() > 0) ? ByteAddr(0) : NULL;
+  }
+
  protected:
   virtual uint8_t* ByteAddr(intptr_t byte_offset) const;
 
@@ -4682,7 +4781,7 @@ class Closure : public Instance {
     return raw_ptr()->type_arguments_;
   }
   virtual void SetTypeArguments(const AbstractTypeArguments& value) const {
-    raw_ptr()->type_arguments_ = value.raw();
+    StorePointer(&raw_ptr()->type_arguments_, value.raw());
   }
   static intptr_t type_arguments_offset() {
     return OFFSET_OF(RawClosure, type_arguments_);
@@ -4748,10 +4847,12 @@ class JSRegExp : public Instance {
   // kUninitialized: the type of th regexp has not been initialized yet.
   // kSimple: A simple pattern to match against, using string indexOf operation.
   // kComplex: A complex pattern to match.
+  // kBytecode: A pattern compiled to bytecode by BytecodeRegExp.
   enum RegExType {
     kUnitialized = 0,
     kSimple,
     kComplex,
+    kBytecode,
   };
 
   // Flags are passed to a regex object as follows:
@@ -4766,6 +4867,7 @@ class JSRegExp : public Instance {
   bool is_initialized() const { return (raw_ptr()->type_ != kUnitialized); }
   bool is_simple() const { return (raw_ptr()->type_ == kSimple); }
   bool is_complex() const { return (raw_ptr()->type_ == kComplex); }
+  bool is_bytecode() const { return (raw_ptr()->type_ == kBytecode); }
 
   bool is_global() const { return (raw_ptr()->flags_ & kGlobal); }
   bool is_ignore_case() const { return (raw_ptr()->flags_ & kIgnoreCase); }
@@ -4783,6 +4885,7 @@ class JSRegExp : public Instance {
   void set_is_multi_line() const { raw_ptr()->flags_ |= kMultiLine; }
   void set_is_simple() const { raw_ptr()->type_ = kSimple; }
   void set_is_complex() const { raw_ptr()->type_ = kComplex; }
+  void set_is_bytecode() const { raw_ptr()->type_ = kBytecode; }
 
   void* GetDataStartAddress() const;
   static RawJSRegExp* FromDataStartAddress(void* data);
@@ -4873,21 +4976,6 @@ intptr_t TokenStream::Length() const {
 }
 
 
-Token::Kind TokenStream::KindAt(intptr_t index) const {
-  const Object& obj = Object::Handle(TokenAt(index));
-  if (obj.IsSmi()) {
-    return static_cast<Token::Kind>(
-        Smi::Value(reinterpret_cast<RawSmi*>(obj.raw())));
-  } else if (obj.IsLiteralToken()) {
-    LiteralToken& token = LiteralToken::Handle();
-    token ^= obj.raw();
-    return token.kind();
-  }
-  ASSERT(obj.IsString());  // Must be an identifier.
-  return Token::kIDENT;
-}
-
-
 void Context::SetAt(intptr_t index, const Instance& value) const {
   StorePointer(InstanceAddr(index), value.raw());
 }
@@ -102,13 +102,60 @@ TEST_CASE(Class) {
   interfaces.SetAt(1, Type::Handle(Type::NewNonParameterizedType(interface)));
   cls.set_interfaces(interfaces);
   cls.Finalize();
+}
+
 
-  const Array& array = Array::Handle(cls.functions_cache());
-  array.SetAt(0, function_name);
-  cls.set_functions_cache(array);
-  String& test_name = String::Handle();
-  test_name ^= Array::Handle(cls.functions_cache()).At(0);
-  EXPECT(test_name.Equals(function_name));
+TEST_CASE(ClassLookupFunctionHashed) {
+  const String& class_name = String::Handle(String::NewSymbol("ManyMembers"));
+  const Script& script = Script::Handle();
+  const Class& cls = Class::Handle(
+      Class::New(class_name, script, Scanner::kDummyTokenIndex));
+  // Enough functions for the lookup to go through the hash table.
+  const intptr_t kNumFunctions = 64;
+  const Array& functions = Array::Handle(Array::New(kNumFunctions));
+  Function& function = Function::Handle();
+  String& function_name = String::Handle();
+  char name[32];
+  for (intptr_t i = 0; i < kNumFunctions - 1; i++) {
+    OS::SNPrint(name, sizeof(name), "m%d", i);
+    function_name = String::NewSymbol(name);
+    function = Function::New(
+        function_name, RawFunction::kFunction, false, false, 0);
+    functions.SetAt(i, function);
+  }
+  // A private function is found by its unmangled name.
+  function_name = String::NewSymbol("_hidden@12345");
+  function = Function::New(
+      function_name, RawFunction::kFunction, false, false, 0);
+  functions.SetAt(kNumFunctions - 1, function);
+  cls.SetFunctions(functions);
+
+  for (intptr_t i = 0; i < kNumFunctions - 1; i++) {
+    OS::SNPrint(name, sizeof(name), "m%d", i);
+    function_name = String::New(name);
+    function = cls.LookupDynamicFunction(function_name);
+    EXPECT(!function.IsNull());
+    EXPECT(function_name.Equals(String::Handle(function.name())));
+  }
+  function = cls.LookupDynamicFunction(String::Handle(String::New("_hidden")));
+  EXPECT(!function.IsNull());
+  function = cls.LookupDynamicFunction(String::Handle(String::New("m64")));
+  EXPECT(function.IsNull());
+
+  // Replacing the functions drops the stale hash table.
+  const Array& other_functions = Array::Handle(Array::New(kNumFunctions));
+  for (intptr_t i = 0; i < kNumFunctions; i++) {
+    OS::SNPrint(name, sizeof(name), "n%d", i);
+    function_name = String::NewSymbol(name);
+    function = Function::New(
+        function_name, RawFunction::kFunction, false, false, 0);
+    other_functions.SetAt(i, function);
+  }
+  cls.SetFunctions(other_functions);
+  function = cls.LookupDynamicFunction(String::Handle(String::New("m1")));
+  EXPECT(function.IsNull());
+  function = cls.LookupDynamicFunction(String::Handle(String::New("n1")));
+  EXPECT(!function.IsNull());
 }
 
 
@@ -149,6 +196,110 @@ TEST_CASE(TokenStream) {
 }
 
 
+TEST_CASE(TokenStreamIterator) {
+  // Enough tokens to span several blocks of the stream index.
+  const char* kSource =
+      "class A { foo(x) { return x + 1.5 + 17 + bar + 'str' + foo; } }\n"
+      "class B { bar(y) { return y * 1.5 * 17 * foo * 'str' * bar; } }\n"
+      "class C { baz(z) { return z - 1.5 - 17 - baz - 'str' - foo; } }\n";
+  String& source = String::Handle(String::New(kSource));
+  String& private_key = String::Handle(String::New(""));
+  Scanner scanner(source, private_key);
+  const Scanner::GrowableTokenStream& ts = scanner.GetStream();
+  const TokenStream& tokens = TokenStream::Handle(TokenStream::New(ts));
+  EXPECT_EQ(ts.length(), tokens.Length());
+
+  // Sequential iteration.
+  TokenStreamIterator iterator(tokens, 0);
+  String& literal = String::Handle();
+  for (intptr_t i = 0; i < ts.length(); i++) {
+    EXPECT_EQ(i, iterator.CurrentPosition());
+    EXPECT_EQ(ts[i].kind, iterator.CurrentTokenKind());
+    if ((i + 2) < ts.length()) {
+      EXPECT_EQ(ts[i + 2].kind, iterator.LookaheadTokenKind(2));
+    }
+    if (ts[i].literal != NULL) {
+      literal = iterator.CurrentLiteral();
+      EXPECT(literal.Equals(*ts[i].literal));
+    }
+    if ((i + 1) < ts.length()) {
+      iterator.Advance();
+    }
+  }
+
+  // Moving backwards and far ahead.
+  const intptr_t kPositions[] = { 65, 3, 40, 41, 0, 69 };
+  for (size_t i = 0; i < ARRAY_SIZE(kPositions); i++) {
+    const intptr_t pos = kPositions[i];
+    EXPECT(pos < ts.length());
+    iterator.SetCurrentPosition(pos);
+    EXPECT_EQ(ts[pos].kind, iterator.CurrentTokenKind());
+    EXPECT_EQ(ts[pos].kind, tokens.KindAt(pos));
+  }
+
+  // Repeated identifiers and literals share the same object.
+  intptr_t first_double = -1;
+  intptr_t first_foo = -1;
+  const String& foo = String::Handle(String::NewSymbol("foo"));
+  Object& token = Object::Handle();
+  for (intptr_t i = 0; i < ts.length(); i++) {
+    if (ts[i].kind == Token::kDOUBLE) {
+      if (first_double < 0) {
+        first_double = i;
+      } else {
+        token = tokens.TokenAt(i);
+        EXPECT_EQ(tokens.TokenAt(first_double), token.raw());
+      }
+    } else if ((ts[i].kind == Token::kIDENT) && ts[i].literal->Equals(foo)) {
+      if (first_foo < 0) {
+        first_foo = i;
+      } else {
+        token = tokens.TokenAt(i);
+        EXPECT_EQ(tokens.TokenAt(first_foo), token.raw());
+      }
+    }
+  }
+  EXPECT(first_double >= 0);
+  EXPECT(first_foo >= 0);
+}
+
+
+TEST_CASE(TokenStreamNumberLiterals) {
+  String& source = String::Handle(String::New("17 + 2.5 + 17 + 2.5 + 0x11"));
+  String& private_key = String::Handle(String::New(""));
+  Scanner scanner(source, private_key);
+  const Scanner::GrowableTokenStream& ts = scanner.GetStream();
+  EXPECT_EQ(10, ts.length());
+  for (intptr_t i = 0; i < ts.length(); i++) {
+    if (ts[i].literal != NULL) {
+      EXPECT(ts[i].literal->IsSymbol());
+    }
+  }
+  const TokenStream& tokens = TokenStream::Handle(TokenStream::New(ts));
+  EXPECT_EQ(Token::kINTEGER, tokens.KindAt(0));
+  EXPECT_EQ(Token::kDOUBLE, tokens.KindAt(2));
+  LiteralToken& token = LiteralToken::Handle();
+  token ^= tokens.TokenAt(0);
+  EXPECT_EQ(Token::kINTEGER, token.kind());
+  Integer& integer = Integer::Handle();
+  integer ^= token.value();
+  EXPECT_EQ(17, integer.AsInt64Value());
+  token ^= tokens.TokenAt(2);
+  EXPECT_EQ(Token::kDOUBLE, token.kind());
+  Double& number = Double::Handle();
+  number ^= token.value();
+  EXPECT_EQ(2.5, number.value());
+  // Repeated number literals share the same token, different spellings of
+  // the same value do not.
+  EXPECT_EQ(tokens.TokenAt(0), tokens.TokenAt(4));
+  EXPECT_EQ(tokens.TokenAt(2), tokens.TokenAt(6));
+  EXPECT(tokens.TokenAt(0) != tokens.TokenAt(8));
+  token ^= tokens.TokenAt(8);
+  integer ^= token.value();
+  EXPECT_EQ(17, integer.AsInt64Value());
+}
+
+
 TEST_CASE(InstanceClass) {
   // Allocate the class first.
   String& class_name = String::Handle(String::NewSymbol("EmptyClass"));
@@ -2192,6 +2343,48 @@ TEST_CASE(Script) {
 }
 
 
+TEST_CASE(ScriptTokenLocation) {
+  // Blank lines, long lines and enough tokens for several position blocks.
+  const char* source_chars =
+      "class A {\n"
+      "  static foo(a, b) { return a + b; }\n"
+      "\n"
+      "\n"
+      "  static bar() {\n"
+      "    var x = [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16];\n"
+      "    return foo(x.length,                                               "
+      "                                                                 7);\n"
+      "  }\n"
+      "  // Comment.\n"
+      "  static baz() => bar() + bar() + bar() + bar() + bar() + bar();\n"
+      "}\n";
+  const String& url = String::Handle(String::New("test-lib"));
+  const String& source = String::Handle(String::New(source_chars));
+  const Script& script = Script::Handle(Script::New(url,
+                                                    source,
+                                                    RawScript::kScript));
+  script.Tokenize(String::Handle(String::New("")));
+  const intptr_t num_tokens = TokenStream::Handle(script.tokens()).Length();
+  EXPECT(num_tokens > 2 * 32);
+
+  // The recorded positions match the positions found by the scanner.
+  const String& dummy_key = String::Handle(String::New(""));
+  Scanner scanner(source, dummy_key);
+  intptr_t line = -1;
+  intptr_t column = -1;
+  for (intptr_t i = 0; i < num_tokens + 2; i++) {
+    scanner.ScanTo(i);
+    script.GetTokenLocation(i, &line, &column);
+    EXPECT_EQ(scanner.CurrentPosition().line, line);
+    EXPECT_EQ(scanner.CurrentPosition().column, column);
+  }
+  for (intptr_t i = 0; i < 14; i++) {
+    EXPECT_EQ(scanner.TokenIndexAtLine(i), script.TokenIndexAtLine(i));
+  }
+  EXPECT_EQ(-1, script.TokenIndexAtLine(100));
+}
+
+
 TEST_CASE(Context) {
   const int kNumVariables = 5;
   const Context& parent_context = Context::Handle(Context::New(0));
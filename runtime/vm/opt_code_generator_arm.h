@@ -24,6 +24,9 @@ class OptimizingCodeGenerator : public CodeGenerator {
     return true;
   }
 
+  // Called for all optimized code; no deoptimization points are emitted.
+  void FinalizeDeoptInfo(const Code& code) { }
+
  private:
   DISALLOW_IMPLICIT_CONSTRUCTORS(OptimizingCodeGenerator);
 };
@@ -9,6 +9,7 @@
 
 #include "vm/assembler_macros.h"
 #include "vm/ast_printer.h"
+#include "vm/deopt_instructions.h"
 #include "vm/object.h"
 #include "vm/object_store.h"
 #include "vm/resolver.h"
@@ -33,6 +34,8 @@ DECLARE_FLAG(bool, enable_type_checks);
   V(labels_used, bool, false)                                                  \
   V(request_result_in_eax, bool, false)                                        \
   V(result_returned_in_eax, bool, false)                                       \
+  V(request_result_in_xmm0, bool, false)                                       \
+  V(result_returned_in_xmm0, bool, false)                                      \
   V(fallthrough_label, Label*, NULL)                                           \
   V(is_class, const Class*, &Class::ZoneHandle())                              \
 
@@ -113,18 +116,38 @@ class DeoptimizationBlob : public ZoneAllocated {
   DeoptimizationBlob(AstNode* node, DeoptReasonId deopt_reason_id)
       : node_(node),
         registers_(2),
+        is_double_(2),
         label_(),
         deopt_reason_id_(deopt_reason_id) {}
 
-  void Push(Register reg) { registers_.Add(reg); }
+  // The unoptimized frame has the locals and the expression stack of the
+  // optimized frame, followed by the values held in the pushed registers.
+  void Push(Register reg) {
+    registers_.Add(reg);
+    is_double_.Add(false);
+  }
+  // 'reg' holds an unboxed double, which is boxed for unoptimized code.
+  void PushDouble(XmmRegister reg) {
+    registers_.Add(reg);
+    is_double_.Add(true);
+  }
 
   void Generate(OptimizingCodeGenerator* codegen) {
     codegen->assembler()->Bind(&label_);
+    DeoptInfoBuilder info;
+    info.AddFrame(codegen->parsed_function().function(), node_->id());
+    info.AddCopyStackToSp(-1);
     for (int i = 0; i < registers_.length(); i++) {
-      codegen->assembler()->pushl(registers_[i]);
+      if (is_double_[i]) {
+        info.AddMaterializeDouble(registers_[i]);
+      } else {
+        info.AddCopyRegister(registers_[i]);
+      }
     }
-    codegen->assembler()->movl(EAX, Immediate(Smi::RawValue(deopt_reason_id_)));
-    codegen->CallDeoptimize(node_->id(), node_->token_index());
+    codegen->CallDeoptimize(node_->id(),
+                            node_->token_index(),
+                            info,
+                            deopt_reason_id_);
 #if defined(DEBUG)
     // Check that deoptimization point exists in unoptimized code.
     const Code& unoptimized_code =
@@ -141,7 +164,8 @@ class DeoptimizationBlob : public ZoneAllocated {
 
  private:
   const AstNode* node_;
-  GrowableArray<Register> registers_;
+  GrowableArray<intptr_t> registers_;
+  GrowableArray<bool> is_double_;
   Label label_;
   DeoptReasonId deopt_reason_id_;
 
@@ -241,6 +265,7 @@ OptimizingCodeGenerator::OptimizingCodeGenerator(
     Assembler* assembler, const ParsedFunction& parsed_function)
         : CodeGenerator(assembler, parsed_function),
           deoptimization_blobs_(4),
+          deopt_table_(new DeoptTableBuilder()),
           classes_for_locals_(NULL),
           smi_class_(Class::ZoneHandle(Isolate::Current()->object_store()
               ->smi_class())),
@@ -303,6 +328,11 @@ OptimizingCodeGenerator::AddDeoptimizationBlob(AstNode* node,
 }
 
 
+void OptimizingCodeGenerator::FinalizeDeoptInfo(const Code& code) {
+  deopt_table_->FinalizeDeoptTable(code);
+}
+
+
 void OptimizingCodeGenerator::GenerateDeferredCode() {
   CodeGenerator::GenerateDeferredCode();
   for (int i = 0; i < deoptimization_blobs_.length(); i++) {
@@ -378,9 +408,12 @@ void OptimizingCodeGenerator::GeneratePreEntryCode() {
 
 
 void OptimizingCodeGenerator::CallDeoptimize(intptr_t node_id,
-                                             intptr_t token_index) {
+                                             intptr_t token_index,
+                                             const DeoptInfoBuilder& info,
+                                             DeoptReasonId reason_id) {
   __ call(&StubCode::DeoptimizeLabel());
   AddCurrentDescriptor(PcDescriptors::kOther, node_id, token_index);
+  deopt_table_->AddDeoptInfo(assembler()->CodeSize(), info, reason_id);
 #if defined(DEBUG)
   __ int3();
 #endif
@@ -772,59 +805,40 @@ void OptimizingCodeGenerator::GenerateSmiUnaryOp(UnaryOpNode* node) {
 
 
 void OptimizingCodeGenerator::GenerateDoubleUnaryOp(UnaryOpNode* node) {
+  ASSERT(node->kind() == Token::kSUB);
   const Register kOperandRegister = ECX;
   const Register kTempRegister = EBX;
-  const Register kResultRegister = EAX;
-  const ICData& ic_data = node->ic_data();
-  DeoptReasonId deopt_reason_id = ic_data.NumberOfChecks() == 0 ?
-      kDeoptNoTypeFeedback : kDeoptUnaryOp;
-  DeoptimizationBlob* deopt_blob =
-      AddDeoptimizationBlob(node, kOperandRegister, deopt_reason_id);
   CodeGenInfo info(node->operand());
   info.set_allow_temp(true);
-  VisitLoadOne(node->operand(), kOperandRegister);
-  if (ic_data.NumberOfChecks() == 0) {
-    // No type feedback.
-    __ jmp(deopt_blob->label());
-    return;
-  }
-  ASSERT(ic_data.NumberOfChecks() == 1);
-  if (!info.IsClass(double_class_)) {
-    // Deoptimize if not double.
-    CheckIfDoubleOrSmi(kOperandRegister,
-                       kTempRegister,
-                       deopt_blob->label(),
-                       deopt_blob->label());
-    PropagateBackLocalClass(node->operand(), double_class_);
-  }
-  const bool using_temp =
-      (node->info() != NULL) && node->info()->allow_temp();
-  if (!using_temp) {
-    const Code& stub =
-        Code::Handle(StubCode::GetAllocationStubForClass(double_class_));
-    const ExternalLabel label(double_class_.ToCString(), stub.EntryPoint());
-    __ pushl(kOperandRegister);
-    GenerateCall(node->token_index(), &label, PcDescriptors::kOther);
-    ASSERT(kResultRegister == EAX);
-    __ popl(kOperandRegister);
-  } else if (info.is_temp()) {
-    __ movl(kResultRegister, kOperandRegister);
+  if (CanReturnUnboxedDouble(node->operand())) {
+    info.set_request_result_in_xmm0(true);
+    node->operand()->Visit(this);
+    ASSERT(info.result_returned_in_xmm0());
   } else {
-    const Double& double_object =
-        Double::ZoneHandle(Double::New(0.0, Heap::kOld));
-    __ LoadObject(kResultRegister, double_object);
-  }
-  __ movsd(XMM0, FieldAddress(kOperandRegister, Double::value_offset()));
-  ASSERT(node->kind() == Token::kSUB);
-  __ DoubleNegate(XMM0);
-  __ movsd(FieldAddress(kResultRegister, Double::value_offset()), XMM0);
-  if (IsResultNeeded(node)) {
-    if (node->info() != NULL) {
-      node->info()->set_is_temp(using_temp);
-      node->info()->set_is_class(&double_class_);
+    const ICData& ic_data = node->ic_data();
+    DeoptReasonId deopt_reason_id = ic_data.NumberOfChecks() == 0 ?
+        kDeoptNoTypeFeedback : kDeoptUnaryOp;
+    DeoptimizationBlob* deopt_blob =
+        AddDeoptimizationBlob(node, kOperandRegister, deopt_reason_id);
+    VisitLoadOne(node->operand(), kOperandRegister);
+    if (ic_data.NumberOfChecks() == 0) {
+      // No type feedback.
+      __ jmp(deopt_blob->label());
+      return;
+    }
+    ASSERT(ic_data.NumberOfChecks() == 1);
+    if (!info.IsClass(double_class_)) {
+      // Deoptimize if not double.
+      CheckIfDoubleOrSmi(kOperandRegister,
+                         kTempRegister,
+                         deopt_blob->label(),
+                         deopt_blob->label());
+      PropagateBackLocalClass(node->operand(), double_class_);
     }
-    HandleResult(node, kResultRegister);
+    __ movsd(XMM0, FieldAddress(kOperandRegister, Double::value_offset()));
   }
+  __ DoubleNegate(XMM0);
+  HandleDoubleResult(node);
 }
 
 
@@ -962,6 +976,8 @@ void OptimizingCodeGenerator::GenerateSmiBinaryOp(BinaryOpNode* node) {
 // Supports some mixed Smi/Mint operations.
 // For BIT_AND operation with right operand being Smi, we can throw away
 // any Mint bits above the Smi range as long as the right operand is positive.
+// ADD, SUB, BIT_OR and BIT_XOR compute on the unboxed 64-bit values and
+// allocate a Mint only for results outside of the Smi range.
 // 'allow_smi' is true if Smi and Mint classes have been encountered.
 void OptimizingCodeGenerator::GenerateMintBinaryOp(BinaryOpNode* node,
                                                    bool allow_smi) {
@@ -1008,6 +1024,33 @@ void OptimizingCodeGenerator::GenerateMintBinaryOp(BinaryOpNode* node,
     HandleResult(node, EAX);
     return;
   }
+  if ((kind == Token::kADD) ||
+      (kind == Token::kSUB) ||
+      (kind == Token::kBIT_OR) ||
+      (kind == Token::kBIT_XOR)) {
+    TraceOpt(node, kOptMessage);
+    Label box, done;
+    VisitLoadTwo(node->left(), node->right(), EAX, EDX);
+    DeoptimizationBlob* deopt_blob =
+        AddDeoptimizationBlob(node, EAX, EDX, kDeoptMintBinaryOp);
+    GenerateMintOperation(kind, deopt_blob->label());
+    // The result is a Smi if the high word is the sign of the low word and
+    // the low word can be tagged.
+    __ movl(EDI, ECX);
+    __ sarl(EDI, Immediate(31));
+    __ cmpl(EDI, EBX);
+    __ j(NOT_EQUAL, &box, Assembler::kNearJump);
+    __ movl(EDI, ECX);
+    __ SmiTag(EDI);
+    __ j(OVERFLOW, &box, Assembler::kNearJump);
+    __ movl(EAX, EDI);
+    __ jmp(&done);
+    __ Bind(&box);
+    GenerateBoxMint(node->token_index());
+    __ Bind(&done);
+    HandleResult(node, EAX);
+    return;
+  }
   if ((kind == Token::kSHL) && allow_smi) {
     GenerateSmiShiftBinaryOp(node);
     HandleResult(node, EAX);
@@ -1018,6 +1061,121 @@ void OptimizingCodeGenerator::GenerateMintBinaryOp(BinaryOpNode* node,
 }
 
 
+// Apply the operation 'kind' to the low words, or to the high words, of two
+// 64-bit integers. The high words of kADD and kSUB use the carry of the low
+// words.
+void OptimizingCodeGenerator::GenerateMintWordOperation(Token::Kind kind,
+                                                        bool is_high_word,
+                                                        Register dst,
+                                                        Register src) {
+  switch (kind) {
+    case Token::kADD:
+      if (is_high_word) {
+        __ adcl(dst, src);
+      } else {
+        __ addl(dst, src);
+      }
+      break;
+    case Token::kSUB:
+      if (is_high_word) {
+        __ sbbl(dst, src);
+      } else {
+        __ subl(dst, src);
+      }
+      break;
+    case Token::kBIT_OR:
+      __ orl(dst, src);
+      break;
+    case Token::kBIT_XOR:
+      __ xorl(dst, src);
+      break;
+    default:
+      UNREACHABLE();
+  }
+}
+
+
+// Compute 'EAX kind EDX' as 64-bit integers into ECX (low word) and EBX (high
+// word), where each operand is a Smi or a Mint. Jumps to 'deopt' if an
+// operand is neither, or if the result overflows 64 bits. EAX and EDX are
+// not modified, EDI is trashed.
+void OptimizingCodeGenerator::GenerateMintOperation(Token::Kind kind,
+                                                    Label* deopt) {
+  const Class& mint_class =
+      Class::ZoneHandle(Isolate::Current()->object_store()->mint_class());
+  const intptr_t kLowOffset = Mint::value_offset();
+  const intptr_t kHighOffset = Mint::value_offset() + kWordSize;
+  Label left_is_smi, left_done;
+  __ testl(EAX, Immediate(kSmiTagMask));
+  __ j(ZERO, &left_is_smi, Assembler::kNearJump);
+  __ movl(EBX, FieldAddress(EAX, Object::class_offset()));
+  __ CompareObject(EBX, mint_class);
+  __ j(NOT_EQUAL, deopt);
+  __ movl(ECX, FieldAddress(EAX, kLowOffset));
+  __ movl(EBX, FieldAddress(EAX, kHighOffset));
+  __ jmp(&left_done, Assembler::kNearJump);
+  __ Bind(&left_is_smi);
+  __ movl(ECX, EAX);
+  __ SmiUntag(ECX);
+  __ movl(EBX, ECX);
+  __ sarl(EBX, Immediate(31));
+  __ Bind(&left_done);
+
+  // Moves between the low and high word operations keep the carry.
+  Label right_is_smi, right_is_negative_smi, done;
+  __ testl(EDX, Immediate(kSmiTagMask));
+  __ j(ZERO, &right_is_smi, Assembler::kNearJump);
+  __ movl(EDI, FieldAddress(EDX, Object::class_offset()));
+  __ CompareObject(EDI, mint_class);
+  __ j(NOT_EQUAL, deopt);
+  __ movl(EDI, FieldAddress(EDX, kLowOffset));
+  GenerateMintWordOperation(kind, false, ECX, EDI);
+  __ movl(EDI, FieldAddress(EDX, kHighOffset));
+  GenerateMintWordOperation(kind, true, EBX, EDI);
+  __ jmp(&done, Assembler::kNearJump);
+  __ Bind(&right_is_smi);
+  __ movl(EDI, EDX);
+  __ SmiUntag(EDI);
+  __ j(SIGN, &right_is_negative_smi, Assembler::kNearJump);
+  GenerateMintWordOperation(kind, false, ECX, EDI);
+  __ movl(EDI, Immediate(0));
+  GenerateMintWordOperation(kind, true, EBX, EDI);
+  __ jmp(&done, Assembler::kNearJump);
+  __ Bind(&right_is_negative_smi);
+  GenerateMintWordOperation(kind, false, ECX, EDI);
+  __ movl(EDI, Immediate(-1));
+  GenerateMintWordOperation(kind, true, EBX, EDI);
+  __ Bind(&done);
+  if ((kind == Token::kADD) || (kind == Token::kSUB)) {
+    __ j(OVERFLOW, deopt);
+  }
+}
+
+
+// Box the 64-bit integer in ECX (low word) and EBX (high word) into a new
+// Mint in EAX. The allocation may call into the runtime, so the value is kept
+// in an old space mint of the code meanwhile. Trashes EDI.
+void OptimizingCodeGenerator::GenerateBoxMint(intptr_t token_index) {
+  const Class& mint_class =
+      Class::ZoneHandle(Isolate::Current()->object_store()->mint_class());
+  const intptr_t kLowOffset = Mint::value_offset();
+  const intptr_t kHighOffset = Mint::value_offset() + kWordSize;
+  const Mint& spill_object = Mint::ZoneHandle(Mint::New(kMaxInt64, Heap::kOld));
+  __ LoadObject(EDI, spill_object);
+  __ movl(FieldAddress(EDI, kLowOffset), ECX);
+  __ movl(FieldAddress(EDI, kHighOffset), EBX);
+  const Code& stub =
+      Code::Handle(StubCode::GetAllocationStubForClass(mint_class));
+  const ExternalLabel label(mint_class.ToCString(), stub.EntryPoint());
+  GenerateCall(token_index, &label, PcDescriptors::kOther);
+  __ LoadObject(EDI, spill_object);
+  __ movl(ECX, FieldAddress(EDI, kLowOffset));
+  __ movl(EBX, FieldAddress(EDI, kHighOffset));
+  __ movl(FieldAddress(EAX, kLowOffset), ECX);
+  __ movl(FieldAddress(EAX, kHighOffset), EBX);
+}
+
+
 // Conservative approach:
 // - true if both nodes are LoadLocalNodes with the same index.
 static bool AreNodesOfSameType(AstNode* a, AstNode* b) {
@@ -1055,13 +1213,199 @@ void OptimizingCodeGenerator::CheckIfDoubleOrSmi(Register reg,
 }
 
 
-// Result of the computation is a newly allocated double object or
-// a temporary object if the parent node specifies a CodeGenInfo for this node
-// and therefore knows how to handle a temporary. A temporary object cannot
-// be used for long living values (e.g., the ones stored on stack or into other
-// objects).
+// True if 'node' is a binary operation that GenerateDoubleBinaryOp
+// implements, which can leave its result unboxed in XMM0.
+bool OptimizingCodeGenerator::CanReturnUnboxedDouble(AstNode* node) const {
+  BinaryOpNode* binary_op = node->AsBinaryOpNode();
+  if (binary_op == NULL) {
+    return false;
+  }
+  const Token::Kind kind = binary_op->kind();
+  if ((kind != Token::kADD) &&
+      (kind != Token::kSUB) &&
+      (kind != Token::kMUL) &&
+      (kind != Token::kDIV)) {
+    return false;
+  }
+  // Same dispatch as in VisitBinaryOpNode.
+  if ((binary_op->ic_data().NumberOfChecks() == 0) ||
+      NodeHasTwoClasses(binary_op, smi_class_, smi_class_)) {
+    return false;
+  }
+  return NodeHasClassAt(binary_op, double_class_, 0) ||
+      NodeHasTwoClasses(binary_op, smi_class_, double_class_);
+}
+
+
+// Load the value of the Double in 'reg', or of the Smi if 'can_be_smi', into
+// 'xmm'. Jumps to 'not_double' otherwise. 'reg' is not modified, EBX is
+// trashed.
+void OptimizingCodeGenerator::LoadDoubleOperand(Register reg,
+                                                XmmRegister xmm,
+                                                bool can_be_smi,
+                                                Label* not_double) {
+  ASSERT(reg != EBX);
+  Label is_smi, done;
+  CheckIfDoubleOrSmi(reg, EBX, can_be_smi ? &is_smi : not_double, not_double);
+  __ movsd(xmm, FieldAddress(reg, Double::value_offset()));
+  if (can_be_smi) {
+    __ jmp(&done, Assembler::kNearJump);
+    __ Bind(&is_smi);
+    __ movl(EBX, reg);
+    __ SmiUntag(EBX);
+    __ cvtsi2sd(xmm, EBX);
+    __ Bind(&done);
+  }
+}
+
+
+// Evaluate the operands of the double operation 'node' into XMM0 and XMM1.
+// An operand that is a double operation itself is evaluated unboxed: the
+// left one if the right one is a quick load, which leaves XMM0 alone,
+// otherwise the right one. The other operand is checked; if it is not a
+// double, or a Smi where allowed, the code deoptimizes with both operands,
+// the unboxed one being boxed by the deoptimization.
+void OptimizingCodeGenerator::LoadDoubleOperands(AstNode* node,
+                                                 AstNode* left,
+                                                 AstNode* right,
+                                                 CodeGenInfo* left_info,
+                                                 CodeGenInfo* right_info,
+                                                 bool left_can_be_smi,
+                                                 bool right_can_be_smi,
+                                                 DeoptReasonId reason_id) {
+  const bool unbox_left = CanReturnUnboxedDouble(left) && IsQuickLoad(right);
+  const bool unbox_right = !unbox_left && CanReturnUnboxedDouble(right);
+  if (unbox_left) {
+    left_info->set_request_result_in_xmm0(true);
+    left->Visit(this);
+    ASSERT(left_info->result_returned_in_xmm0());
+    VisitLoadOne(right, EDX);
+  } else if (unbox_right) {
+    // As in unoptimized code, the left operand is on the stack while the
+    // right one is evaluated.
+    left->Visit(this);
+    right_info->set_request_result_in_xmm0(true);
+    right->Visit(this);
+    ASSERT(right_info->result_returned_in_xmm0());
+    __ movsd(XMM1, XMM0);
+    __ popl(EAX);
+  } else {
+    VisitLoadTwo(left, right, EAX, EDX);
+  }
+
+  const bool left_is_double = unbox_left || left_info->IsClass(double_class_);
+  // If the operands are the same local, the check of the left one suffices.
+  const bool right_is_double = unbox_right ||
+      right_info->IsClass(double_class_) ||
+      (!left_can_be_smi && AreNodesOfSameType(left, right));
+  if (left_is_double && right_is_double) {
+    if (!unbox_left) {
+      __ movsd(XMM0, FieldAddress(EAX, Double::value_offset()));
+    }
+    if (!unbox_right) {
+      __ movsd(XMM1, FieldAddress(EDX, Double::value_offset()));
+      PropagateBackLocalClass(right, double_class_);
+    }
+    return;
+  }
+
+  DeoptimizationBlob* deopt_blob = NULL;
+  if (unbox_left) {
+    deopt_blob = AddDeoptimizationBlob(node, reason_id);
+    deopt_blob->PushDouble(XMM0);
+    deopt_blob->Push(EDX);
+  } else if (unbox_right) {
+    deopt_blob = AddDeoptimizationBlob(node, EAX, reason_id);
+    deopt_blob->PushDouble(XMM1);
+  } else {
+    deopt_blob = AddDeoptimizationBlob(node, EAX, EDX, reason_id);
+  }
+  if (!left_is_double && !right_is_double &&
+      left_can_be_smi && right_can_be_smi) {
+    // Two Smis are not a double operation.
+    __ movl(EBX, EAX);
+    __ orl(EBX, EDX);
+    __ testl(EBX, Immediate(kSmiTagMask));
+    __ j(ZERO, deopt_blob->label());
+  }
+  if (left_is_double) {
+    if (!unbox_left) {
+      __ movsd(XMM0, FieldAddress(EAX, Double::value_offset()));
+    }
+  } else {
+    LoadDoubleOperand(EAX, XMM0, left_can_be_smi, deopt_blob->label());
+    if (!left_can_be_smi) {
+      PropagateBackLocalClass(left, double_class_);
+    }
+  }
+  if (right_is_double) {
+    if (!unbox_right) {
+      __ movsd(XMM1, FieldAddress(EDX, Double::value_offset()));
+    }
+  } else {
+    LoadDoubleOperand(EDX, XMM1, right_can_be_smi, deopt_blob->label());
+    if (!right_can_be_smi) {
+      PropagateBackLocalClass(right, double_class_);
+    }
+  }
+}
+
+
+// Box the double in 'value' into a new Double in EAX. The allocation may
+// call into the runtime, which does not preserve the XMM registers, so the
+// value is kept in an old space double of the code meanwhile. Trashes ECX.
+void OptimizingCodeGenerator::GenerateBoxDouble(intptr_t token_index,
+                                                XmmRegister value) {
+  const Double& spill_object =
+      Double::ZoneHandle(Double::New(0.0, Heap::kOld));
+  __ LoadObject(ECX, spill_object);
+  __ movsd(FieldAddress(ECX, Double::value_offset()), value);
+  const Code& stub =
+      Code::Handle(StubCode::GetAllocationStubForClass(double_class_));
+  const ExternalLabel label(double_class_.ToCString(), stub.EntryPoint());
+  GenerateCall(token_index, &label, PcDescriptors::kOther);
+  __ LoadObject(ECX, spill_object);
+  __ movsd(value, FieldAddress(ECX, Double::value_offset()));
+  __ movsd(FieldAddress(EAX, Double::value_offset()), value);
+}
+
+
+// The result of a double operation in XMM0 stays there if the parent node
+// requested it. Otherwise it is stored into a temporary double object if the
+// parent node knows how to handle one, or boxed into a new Double. A
+// temporary object cannot be used for long living values (e.g., the ones
+// stored on stack or into other objects).
+void OptimizingCodeGenerator::HandleDoubleResult(AstNode* node) {
+  if (!IsResultNeeded(node)) {
+    return;
+  }
+  CodeGenInfo* info = node->info();
+  if ((info != NULL) && info->request_result_in_xmm0()) {
+    info->set_result_returned_in_xmm0(true);
+    info->set_is_class(&double_class_);
+    return;
+  }
+  const bool using_temp = (info != NULL) && info->allow_temp();
+  if (using_temp) {
+    const Double& double_object =
+        Double::ZoneHandle(Double::New(0.0, Heap::kOld));
+    __ LoadObject(EAX, double_object);
+    __ movsd(FieldAddress(EAX, Double::value_offset()), XMM0);
+  } else {
+    GenerateBoxDouble(node->token_index(), XMM0);
+  }
+  if (info != NULL) {
+    info->set_is_temp(using_temp);
+    info->set_is_class(&double_class_);
+  }
+  HandleResult(node, EAX);
+}
+
+
 // Implement for combinations: Double/Double, Double/Smi, Smi/Double, as
-// the result is always double.
+// the result is always double. Operands that are double operations are not
+// boxed, see LoadDoubleOperands, and the result is boxed only if the parent
+// node needs an object, see HandleDoubleResult.
 // TODO(srdjan): Implement Smi/Smi for kDIV (result also double).
 void OptimizingCodeGenerator::GenerateDoubleBinaryOp(BinaryOpNode* node,
                                                      bool receiver_can_be_smi) {
@@ -1072,115 +1416,19 @@ void OptimizingCodeGenerator::GenerateDoubleBinaryOp(BinaryOpNode* node,
       (kind == Token::kMUL) ||
       (kind == Token::kDIV)) {
     TraceOpt(node, kOptMessage);
-    // All four register below must be different.
-    const Register kLeftRegister = EAX;
-    const Register kRightRegister = EDX;
-    const Register kAllocatedRegister = ECX;
-    const Register kTempRegister = EBX;
     CodeGenInfo left_info(node->left());  // Receiver.
     CodeGenInfo right_info(node->right());
     left_info.set_allow_temp(true);
     right_info.set_allow_temp(true);
-    VisitLoadTwo(node->left(), node->right(), kLeftRegister, kRightRegister);
-    // First allocate result object or specify an existing object as result.
-    Register result_register = kNoRegister;
-    const bool using_temp =
-        (node->info() != NULL) && node->info()->allow_temp();
-    if (!using_temp) {
-      // Parent node cannot handle a temporary double object, allocate one
-      // each time.
-      result_register = kAllocatedRegister;
-      const Code& stub =
-          Code::Handle(StubCode::GetAllocationStubForClass(double_class_));
-      const ExternalLabel label(double_class_.ToCString(), stub.EntryPoint());
-      __ pushl(kLeftRegister);
-      __ pushl(kRightRegister);
-      GenerateCall(node->token_index(), &label, PcDescriptors::kOther);
-      __ movl(result_register, EAX);
-      __ popl(kRightRegister);
-      __ popl(kLeftRegister);
-    } else if (left_info.IsClass(double_class_) && left_info.is_temp()) {
-      result_register = kLeftRegister;
-    } else if (right_info.IsClass(double_class_) && right_info.is_temp()) {
-      result_register = kRightRegister;
-    } else {
-      result_register = kAllocatedRegister;
-      // Use inlined temporary double object.
-      const Double& double_object =
-          Double::ZoneHandle(Double::New(0.0, Heap::kOld));
-      __ LoadObject(result_register, double_object);
-    }
-
-    DeoptimizationBlob* deopt_blob = NULL;
-    Label* deopt_lbl = NULL;
-    // Deoptimization can only occur if one of arguments is not double.
-    if (!left_info.IsClass(double_class_) ||
-        !right_info.IsClass(double_class_)) {
-      deopt_blob = AddDeoptimizationBlob(node,
-                                         kLeftRegister,
-                                         kRightRegister,
-                                         kDeoptDoubleBinaryOp);
-      deopt_lbl = deopt_blob->label();
-    }
-
-    if (receiver_can_be_smi) {
-      // Only deoptimize if both argument are Smi.
-      __ movl(kTempRegister, kLeftRegister);
-      __ orl(kTempRegister, kRightRegister);
-      __ testl(kTempRegister, Immediate(kSmiTagMask));
-      __ j(ZERO, deopt_lbl);
-    }
-
-    bool args_of_same_type = AreNodesOfSameType(node->left(), node->right());
-    if (left_info.IsClass(double_class_)) {
-      __ movsd(XMM0, FieldAddress(kLeftRegister, Double::value_offset()));
-    } else {
-      if (receiver_can_be_smi) {
-        Label is_smi, done;
-        CheckIfDoubleOrSmi(kLeftRegister, kTempRegister, &is_smi, deopt_lbl);
-        // Fall through for double. Jump to 'is_smi' if double, jump to
-        // 'deopt' if neither smi nor double.
-        __ movsd(XMM0, FieldAddress(kLeftRegister, Double::value_offset()));
-        __ jmp(&done);
-        __ Bind(&is_smi);
-        __ SmiUntag(kLeftRegister);
-        __ cvtsi2sd(XMM0, kLeftRegister);
-        __ Bind(&done);
-      } else {
-        CheckIfDoubleOrSmi(kLeftRegister, kTempRegister, deopt_lbl, deopt_lbl);
-        __ movsd(XMM0, FieldAddress(kLeftRegister, Double::value_offset()));
-        PropagateBackLocalClass(node->left(), double_class_);
-      }
-    }
-
-    const bool right_must_be_double = NodeHasClassAt(node, double_class_, 1);
-
-    // If arguments are of same type (e.g., same local), then the test of left
-    // argument was sufficient.
-    if (right_info.IsClass(double_class_) || args_of_same_type) {
-      __ movsd(XMM1, FieldAddress(kRightRegister, Double::value_offset()));
-      if (!right_info.IsClass(double_class_)) {
-        PropagateBackLocalClass(node->right(), double_class_);
-      }
-    } else {
-      if (right_must_be_double) {
-        CheckIfDoubleOrSmi(kRightRegister, kTempRegister, deopt_lbl, deopt_lbl);
-        __ movsd(XMM1, FieldAddress(kRightRegister, Double::value_offset()));
-        PropagateBackLocalClass(node->right(), double_class_);
-      } else {
-        Label is_smi, done;
-        CheckIfDoubleOrSmi(kRightRegister, kTempRegister, &is_smi, deopt_lbl);
-        // Fall through for double. Jump to 'is_smi' if double, jump to
-        // 'deopt' if neither smi nor double.
-        __ movsd(XMM1, FieldAddress(kRightRegister, Double::value_offset()));
-        __ jmp(&done);
-        __ Bind(&is_smi);
-        __ SmiUntag(kRightRegister);
-        __ cvtsi2sd(XMM1, kRightRegister);
-        __ Bind(&done);
-      }
-    }
-
+    const bool right_can_be_smi = !NodeHasClassAt(node, double_class_, 1);
+    LoadDoubleOperands(node,
+                       node->left(),
+                       node->right(),
+                       &left_info,
+                       &right_info,
+                       receiver_can_be_smi,
+                       right_can_be_smi,
+                       kDeoptDoubleBinaryOp);
     switch (kind) {
       case Token::kADD: __ addsd(XMM0, XMM1); break;
       case Token::kSUB: __ subsd(XMM0, XMM1); break;
@@ -1188,14 +1436,7 @@ void OptimizingCodeGenerator::GenerateDoubleBinaryOp(BinaryOpNode* node,
       case Token::kDIV: __ divsd(XMM0, XMM1); break;
       default: UNREACHABLE();
     }
-    __ movsd(FieldAddress(result_register, Double::value_offset()), XMM0);
-    if (IsResultNeeded(node)) {
-      if (node->info() != NULL) {
-        node->info()->set_is_temp(using_temp);
-        node->info()->set_is_class(&double_class_);
-      }
-      HandleResult(node, result_register);
-    }
+    HandleDoubleResult(node);
     return;
   }
 
@@ -2040,21 +2281,15 @@ bool OptimizingCodeGenerator::GenerateDoubleComparison(ComparisonNode* node) {
   CodeGenInfo right_info(node->right());
   left_info.set_allow_temp(true);
   right_info.set_allow_temp(true);
-  VisitLoadTwo(node->left(), node->right(), EAX, EDX);
-  DeoptimizationBlob* deopt_blob = NULL;
-  if (!left_info.IsClass(double_class_) || !right_info.IsClass(double_class_)) {
-    deopt_blob = AddDeoptimizationBlob(node, EAX, EDX, kDeoptDoubleComparison);
-  }
-  if (!left_info.IsClass(double_class_)) {
-    CheckIfDoubleOrSmi(EAX, EBX, deopt_blob->label(), deopt_blob->label());
-    PropagateBackLocalClass(node->left(), double_class_);
-  }
-  if (!right_info.IsClass(double_class_)) {
-    CheckIfDoubleOrSmi(EDX, EBX, deopt_blob->label(), deopt_blob->label());
-    PropagateBackLocalClass(node->right(), double_class_);
-  }
-  __ movsd(XMM0, FieldAddress(EAX, Double::value_offset()));
-  __ movsd(XMM1, FieldAddress(EDX, Double::value_offset()));
+  const bool kCanBeSmi = false;
+  LoadDoubleOperands(node,
+                     node->left(),
+                     node->right(),
+                     &left_info,
+                     &right_info,
+                     kCanBeSmi,
+                     kCanBeSmi,
+                     kDeoptDoubleComparison);
   __ comisd(XMM0, XMM1);
   if (NodeInfoHasLabels(node)) {
     __ j(PARITY_EVEN, node->info()->false_label());  // NaN -> false;
@@ -15,7 +15,10 @@ namespace dart {
 
 // Forward declarations.
 class ClassesForLocals;
+class CodeGenInfo;
 class DeoptimizationBlob;
+class DeoptInfoBuilder;
+class DeoptTableBuilder;
 struct InstanceSetterArgs;
 
 // Temporary hierarchy, until optimized code generator implemented.
@@ -54,6 +57,9 @@ class OptimizingCodeGenerator : public CodeGenerator {
 
   virtual void InitGenerator();
 
+  // Add the deoptimization points to code (see Code::deopt_info_array).
+  void FinalizeDeoptInfo(const Code& code);
+
  private:
   friend class DeoptimizationBlob;
 
@@ -97,7 +103,10 @@ class OptimizingCodeGenerator : public CodeGenerator {
                             Register recv_reg,
                             Register value_reg);
 
-  void CallDeoptimize(intptr_t node_id, intptr_t token_index);
+  void CallDeoptimize(intptr_t node_id,
+                      intptr_t token_index,
+                      const DeoptInfoBuilder& info,
+                      DeoptReasonId reason_id);
 
   void GenerateSmiUnaryOp(UnaryOpNode* node);
   void GenerateDoubleUnaryOp(UnaryOpNode* node);
@@ -107,6 +116,30 @@ class OptimizingCodeGenerator : public CodeGenerator {
 
   void GenerateDoubleBinaryOp(BinaryOpNode* node, bool receiver_can_be_smi);
   void GenerateMintBinaryOp(BinaryOpNode* node, bool allow_smi);
+  void GenerateMintWordOperation(Token::Kind kind,
+                                 bool is_high_word,
+                                 Register dst,
+                                 Register src);
+  void GenerateMintOperation(Token::Kind kind, Label* deopt);
+  void GenerateBoxMint(intptr_t token_index);
+
+  // Double operations leave their result unboxed in XMM0 when the parent
+  // node requests it (see CodeGenInfo).
+  bool CanReturnUnboxedDouble(AstNode* node) const;
+  void LoadDoubleOperand(Register reg,
+                         XmmRegister xmm,
+                         bool can_be_smi,
+                         Label* not_double);
+  void LoadDoubleOperands(AstNode* node,
+                          AstNode* left,
+                          AstNode* right,
+                          CodeGenInfo* left_info,
+                          CodeGenInfo* right_info,
+                          bool left_can_be_smi,
+                          bool right_can_be_smi,
+                          DeoptReasonId reason_id);
+  void GenerateBoxDouble(intptr_t token_index, XmmRegister value);
+  void HandleDoubleResult(AstNode* node);
   void CheckIfDoubleOrSmi(Register reg,
                           Register temp,
                           Label* is_smi,
@@ -150,6 +183,7 @@ class OptimizingCodeGenerator : public CodeGenerator {
   void TraceNotOpt(AstNode* node, const char* message);
 
   GrowableArray<DeoptimizationBlob*> deoptimization_blobs_;
+  DeoptTableBuilder* deopt_table_;
   ClassesForLocals* classes_for_locals_;
   const Class& smi_class_;
   const Class& double_class_;
@@ -64,6 +64,10 @@ class OS {
   // Returns number of available processor cores.
   static int NumberOfAvailableProcessors();
 
+  // Returns the resident set size of the current process in bytes, or 0 if
+  // it cannot be determined.
+  static intptr_t CurrentRSS();
+
   // Sleep the currently executing thread for millis ms.
   static void Sleep(int64_t millis);
 
@@ -131,6 +131,23 @@ int OS::NumberOfAvailableProcessors() {
 }
 
 
+intptr_t OS::CurrentRSS() {
+  // The second field of /proc/self/statm is the number of resident pages.
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm == NULL) {
+    return 0;
+  }
+  long size = 0;  // NOLINT
+  long resident = 0;  // NOLINT
+  int fields = fscanf(statm, "%ld %ld", &size, &resident);
+  fclose(statm);
+  if (fields != 2) {
+    return 0;
+  }
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+
 void OS::Sleep(int64_t millis) {
   // TODO(5411554):  For now just use usleep we may have to revisit this.
   usleep(millis * 1000);
@@ -106,6 +106,20 @@ int OS::NumberOfAvailableProcessors() {
 }
 
 
+intptr_t OS::CurrentRSS() {
+  struct task_basic_info info;
+  mach_msg_type_number_t count = TASK_BASIC_INFO_COUNT;
+  kern_return_t result = task_info(mach_task_self(),
+                                   TASK_BASIC_INFO,
+                                   reinterpret_cast<task_info_t>(&info),
+                                   &count);
+  if (result != KERN_SUCCESS) {
+    return 0;
+  }
+  return info.resident_size;
+}
+
+
 void OS::Sleep(int64_t millis) {
   // TODO(5411554):  For now just use usleep we may have to revisit this.
   usleep(millis * 1000);
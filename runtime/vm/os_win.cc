@@ -4,6 +4,7 @@
 
 #include "vm/os.h"
 
+#include <psapi.h>
 #include <time.h>
 
 #include "platform/assert.h"
@@ -110,6 +111,15 @@ int OS::NumberOfAvailableProcessors() {
 }
 
 
+intptr_t OS::CurrentRSS() {
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return 0;
+  }
+  return counters.WorkingSetSize;
+}
+
+
 void OS::Sleep(int64_t millis) {
   ::Sleep(millis);
 }
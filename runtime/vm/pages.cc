@@ -5,6 +5,7 @@
 #include "vm/pages.h"
 
 #include "platform/assert.h"
+#include "vm/gc_compactor.h"
 #include "vm/gc_marker.h"
 #include "vm/gc_sweeper.h"
 #include "vm/object.h"
@@ -12,6 +13,14 @@
 
 namespace dart {
 
+DEFINE_FLAG(bool, lazy_sweep, true,
+            "Sweep old gen pages on allocation instead of during the pause.");
+DEFINE_FLAG(bool, compact_old_gen, false,
+            "Evacuate sparse old gen pages when fragmentation is high.");
+DEFINE_FLAG(int, compaction_threshold, 50,
+            "Percentage of dead memory in old gen pages above which sparse "
+            "pages are evacuated.");
+
 HeapPage* HeapPage::Initialize(VirtualMemory* memory, bool is_executable) {
   ASSERT(memory->size() > VirtualMemory::PageSize());
   memory->Commit(is_executable);
@@ -20,6 +29,7 @@ HeapPage* HeapPage::Initialize(VirtualMemory* memory, bool is_executable) {
   result->memory_ = memory;
   result->next_ = NULL;
   result->used_ = 0;
+  result->freelist_bytes_ = 0;
   result->top_ = result->first_object_start();
   return result;
 }
@@ -70,11 +80,16 @@ PageSpace::PageSpace(Heap* heap, intptr_t max_capacity, bool is_executable)
       pages_(NULL),
       pages_tail_(NULL),
       large_pages_(NULL),
+      unswept_pages_(NULL),
       bump_page_(NULL),
+      top_(0),
+      end_(0),
+      buffer_page_(NULL),
       max_capacity_(max_capacity),
       capacity_(0),
       in_use_(0),
       count_(0),
+      lazy_sweep_time_(0),
       is_executable_(is_executable),
       sweeping_(false) { }
 
@@ -82,6 +97,7 @@ PageSpace::PageSpace(Heap* heap, intptr_t max_capacity, bool is_executable)
 PageSpace::~PageSpace() {
   FreePages(pages_);
   FreePages(large_pages_);
+  FreePages(unswept_pages_);
 }
 
 
@@ -131,6 +147,39 @@ void PageSpace::FreePage(HeapPage* page, HeapPage* previous_page) {
 }
 
 
+bool PageSpace::SweepNextPage() {
+  HeapPage* page = unswept_pages_;
+  if (page == NULL) {
+    return false;
+  }
+  int64_t start = FLAG_verbose_gc ? OS::GetCurrentTimeMicros() : 0;
+  unswept_pages_ = page->next();
+  page->set_next(NULL);
+  GCSweeper sweeper(heap_);
+  intptr_t page_in_use = sweeper.SweepPage(page, &freelist_);
+  // Empty pages have already been released at the end of marking.
+  ASSERT(page_in_use > 0);
+  // Append the swept page, it is tried first for bump allocation.
+  if (pages_ == NULL) {
+    pages_ = page;
+  } else {
+    pages_tail_->set_next(page);
+  }
+  pages_tail_ = page;
+  if (FLAG_verbose_gc) {
+    lazy_sweep_time_ += OS::GetCurrentTimeMicros() - start;
+  }
+  return true;
+}
+
+
+void PageSpace::CompleteSweep() {
+  while (SweepNextPage()) {
+    // Sweep all remaining pages.
+  }
+}
+
+
 void PageSpace::FreeLargePage(HeapPage* page, HeapPage* previous_page) {
   capacity_ -= page->memory_->size();
   // Remove the page from the list.
@@ -153,13 +202,12 @@ void PageSpace::FreePages(HeapPage* pages) {
 }
 
 
-uword PageSpace::TryBumpAllocate(intptr_t size) {
+HeapPage* PageSpace::FindBumpPage(intptr_t size) {
   if (pages_tail_ == NULL) {
-    return 0;
+    return NULL;
   }
-  uword result = pages_tail_->TryBumpAllocate(size);
-  if (result != 0) {
-    return result;
+  if (static_cast<intptr_t>(pages_tail_->end() - pages_tail_->top()) >= size) {
+    return pages_tail_;
   }
   if (bump_page_ == NULL) {
     // The bump page has not yet been used: Start at the beginning of the list.
@@ -168,48 +216,121 @@ uword PageSpace::TryBumpAllocate(intptr_t size) {
   // The last page has already been attempted above.
   while (bump_page_ != pages_tail_) {
     ASSERT(bump_page_->next() != NULL);
-    result = bump_page_->TryBumpAllocate(size);
-    if (result != 0) {
-      return result;
+    if (static_cast<intptr_t>(bump_page_->end() - bump_page_->top()) >= size) {
+      return bump_page_;
     }
     bump_page_ = bump_page_->next();
   }
   // Ran through all of the pages trying to bump allocate: Give up.
-  return 0;
+  return NULL;
 }
 
 
-uword PageSpace::TryAllocate(intptr_t size) {
-  ASSERT(size >= kObjectAlignment);
-  ASSERT(Utils::IsAligned(size, kObjectAlignment));
-  uword result = 0;
-  if (size < kAllocatablePageSize) {
-    result = TryBumpAllocate(size);
-    if (result == 0) {
-      result = freelist_.TryAllocate(size);
-      if ((result == 0) && CanIncreaseCapacity(kPageSize)) {
-        AllocatePage();
-        result = TryBumpAllocate(size);
-        ASSERT(result != 0);
+uword PageSpace::TryFreeListAllocate(intptr_t size) {
+  uword result = freelist_.TryAllocate(size);
+  if (result != 0) {
+    // Freelist elements never span pages, so the whole allocation is taken
+    // from the page holding its start.
+    PageFor(RawObject::FromAddr(result))->SubtractFreelistBytes(size);
+  }
+  return result;
+}
+
+
+uword PageSpace::TryFreeListAllocateBuffer(intptr_t size,
+                                           intptr_t* buffer_size) {
+  *buffer_size = Utils::Maximum(size, kAllocationBufferSize);
+  uword result = TryFreeListAllocate(*buffer_size);
+  if ((result == 0) && (*buffer_size != size)) {
+    *buffer_size = size;
+    result = TryFreeListAllocate(size);
+  }
+  return result;
+}
+
+
+bool PageSpace::TryAcquireAllocationBuffer(intptr_t size) {
+  ASSERT((top_ == 0) && (end_ == 0));
+  HeapPage* page = FindBumpPage(size);
+  if (page == NULL) {
+    intptr_t buffer_size = 0;
+    uword buffer = TryFreeListAllocateBuffer(size, &buffer_size);
+    // Sweep pages left over from the last mark-sweep before growing.
+    while ((buffer == 0) && SweepNextPage()) {
+      page = FindBumpPage(size);
+      if (page != NULL) {
+        break;
       }
+      buffer = TryFreeListAllocateBuffer(size, &buffer_size);
     }
-  } else {
-    // Large page allocation.
-    intptr_t page_size = LargePageSizeFor(size);
-    if (page_size < size) {
-      // On overflow we fail to allocate.
-      return 0;
+    if (buffer != 0) {
+      top_ = buffer;
+      end_ = buffer + buffer_size;
+      in_use_ += buffer_size;
+      return true;
     }
-    if (CanIncreaseCapacity(page_size)) {
-      HeapPage* page = AllocateLargePage(size);
-      if (page != NULL) {
-        result = page->top();
-        page->set_top(result + size);
+    if (page == NULL) {
+      if (!CanIncreaseCapacity(kPageSize)) {
+        return false;
       }
+      AllocatePage();
+      page = pages_tail_;
     }
   }
-  if (result != 0) {
-    in_use_ += size;
+  // Claim the remainder of the page, it is handed back on release.
+  top_ = page->top();
+  end_ = page->end();
+  page->set_top(end_);
+  buffer_page_ = page;
+  in_use_ += end_ - top_;
+  return true;
+}
+
+
+void PageSpace::ReleaseAllocationBuffer() {
+  in_use_ -= end_ - top_;
+  if (buffer_page_ != NULL) {
+    // Hand the unused remainder back to the page for bump allocation.
+    ASSERT(buffer_page_->top() == end_);
+    buffer_page_->set_top(top_);
+    buffer_page_ = NULL;
+  } else if (top_ < end_) {
+    // Return the unused part of the freelist block.
+    intptr_t size = end_ - top_;
+    freelist_.Free(top_, size);
+    PageFor(RawObject::FromAddr(top_))->AddFreelistBytes(size);
+  }
+  top_ = 0;
+  end_ = 0;
+}
+
+
+uword PageSpace::TryAllocateSlow(intptr_t size) {
+  ASSERT(size >= kObjectAlignment);
+  ASSERT(Utils::IsAligned(size, kObjectAlignment));
+  uword result = 0;
+  if (size < kAllocatablePageSize) {
+    // The allocation buffer is accounted as in use when it is acquired.
+    ReleaseAllocationBuffer();
+    if (TryAcquireAllocationBuffer(size)) {
+      result = top_;
+      top_ += size;
+    }
+    return result;
+  }
+  // Large page allocation.
+  intptr_t page_size = LargePageSizeFor(size);
+  if (page_size < size) {
+    // On overflow we fail to allocate.
+    return 0;
+  }
+  if (CanIncreaseCapacity(page_size)) {
+    HeapPage* page = AllocateLargePage(size);
+    if (page != NULL) {
+      result = page->top();
+      page->set_top(result + size);
+      in_use_ += size;
+    }
   }
   return result;
 }
@@ -231,11 +352,24 @@ bool PageSpace::Contains(uword addr) const {
     }
     page = page->next();
   }
+
+  page = unswept_pages_;
+  while (page != NULL) {
+    if (page->Contains(addr)) {
+      return true;
+    }
+    page = page->next();
+  }
   return false;
 }
 
 
-void PageSpace::VisitObjectPointers(ObjectPointerVisitor* visitor) const {
+void PageSpace::VisitObjectPointers(ObjectPointerVisitor* visitor) {
+  // The unused part of the allocation buffer cannot be iterated, and unswept
+  // pages still contain dead objects which may refer to memory which has been
+  // reused already.
+  ReleaseAllocationBuffer();
+  CompleteSweep();
   HeapPage* page = pages_;
   while (page != NULL) {
     page->VisitObjectPointers(visitor);
@@ -250,8 +384,10 @@ void PageSpace::VisitObjectPointers(ObjectPointerVisitor* visitor) const {
 }
 
 
-RawObject* PageSpace::FindObject(FindObjectVisitor* visitor) const {
+RawObject* PageSpace::FindObject(FindObjectVisitor* visitor) {
   ASSERT(Isolate::Current()->no_gc_scope_depth() != 0);
+  ReleaseAllocationBuffer();
+  CompleteSweep();
   HeapPage* page = pages_;
   while (page != NULL) {
     RawObject* obj = page->FindObject(visitor);
@@ -273,6 +409,169 @@ RawObject* PageSpace::FindObject(FindObjectVisitor* visitor) const {
 }
 
 
+void PageSpace::PrintFragmentation() const {
+  const intptr_t KB2 = KB / 2;
+  intptr_t num_pages = 0;
+  intptr_t num_sparse_pages = 0;
+  intptr_t page_bytes = 0;
+  HeapPage* page = pages_;
+  while (page != NULL) {
+    intptr_t size = page->top() - page->first_object_start();
+    num_pages++;
+    page_bytes += size;
+    // Pages with more than half of their objects on the freelist.
+    if ((page->freelist_bytes() * 2) > static_cast<uword>(size)) {
+      num_sparse_pages++;
+    }
+    page = page->next();
+  }
+  intptr_t freelist_bytes = freelist_.free_bytes();
+  OS::PrintErr("Fragmentation[%d]: %dK of %dK on the freelist (%d%%), "
+               "%d of %d pages sparse\n",
+               count_,
+               (freelist_bytes + KB2) / KB,
+               (page_bytes + KB2) / KB,
+               (page_bytes == 0) ? 0 : ((freelist_bytes * 100) / page_bytes),
+               num_sparse_pages,
+               num_pages);
+}
+
+
+bool PageSpace::IsSparse(HeapPage* page) const {
+  intptr_t extent = page->top() - page->first_object_start();
+  return (static_cast<intptr_t>(page->used()) * 100) <
+      (extent * (100 - FLAG_compaction_threshold));
+}
+
+
+void PageSpace::Compact(Isolate* isolate) {
+  // Measure fragmentation using the live bytes accounted by the marker.
+  intptr_t extent = 0;
+  intptr_t live = 0;
+  HeapPage* page = pages_;
+  while (page != NULL) {
+    extent += page->top() - page->first_object_start();
+    live += page->used();
+    page = page->next();
+  }
+  if ((extent == 0) ||
+      (((extent - live) * 100) <= (extent * FLAG_compaction_threshold))) {
+    return;
+  }
+
+  Timer timer(FLAG_verbose_gc, "Compact");
+  timer.Start();
+  intptr_t rss_before = FLAG_verbose_gc ? OS::CurrentRSS() : 0;
+  intptr_t capacity_before = capacity_;
+
+  // Unlink the sparse pages. Empty pages are released by the sweep anyway.
+  HeapPage* sparse_pages = NULL;
+  HeapPage* prev_page = NULL;
+  page = pages_;
+  while (page != NULL) {
+    HeapPage* next_page = page->next();
+    if ((page->used() > 0) && IsSparse(page)) {
+      if (prev_page == NULL) {
+        pages_ = next_page;
+      } else {
+        prev_page->set_next(next_page);
+      }
+      if (page == pages_tail_) {
+        pages_tail_ = prev_page;
+      }
+      page->set_next(sparse_pages);
+      sparse_pages = page;
+    } else {
+      prev_page = page;
+    }
+    page = next_page;
+  }
+
+  // Move the marked objects into fresh pages, appended to pages_. The live
+  // objects of a sparse page always fit into one additional page.
+  GCCompactor compactor(heap_);
+  HeapPage* evacuated_pages = NULL;
+  HeapPage* target_page = NULL;
+  intptr_t evacuated_count = 0;
+  intptr_t evacuated_live = 0;
+  while ((sparse_pages != NULL) && CanIncreaseCapacity(kPageSize)) {
+    page = sparse_pages;
+    sparse_pages = page->next();
+    uword current = page->first_object_start();
+    uword end = page->top();
+    while (current < end) {
+      RawObject* raw_obj = RawObject::FromAddr(current);
+      intptr_t size = raw_obj->Size();
+      if (raw_obj->IsMarked()) {
+        uword target = (target_page == NULL) ?
+            0 : target_page->TryBumpAllocate(size);
+        if (target == 0) {
+          AllocatePage();
+          target_page = pages_tail_;
+          target = target_page->TryBumpAllocate(size);
+          ASSERT(target != 0);
+        }
+        compactor.MoveObject(raw_obj, target, size);
+        target_page->AddUsed(size);
+      }
+      current += size;
+    }
+    evacuated_live += page->used();
+    evacuated_count++;
+    page->set_next(evacuated_pages);
+    evacuated_pages = page;
+  }
+  // Pages which could not be evacuated for lack of capacity are kept.
+  while (sparse_pages != NULL) {
+    page = sparse_pages;
+    sparse_pages = page->next();
+    page->set_next(NULL);
+    if (pages_ == NULL) {
+      pages_ = page;
+    } else {
+      pages_tail_->set_next(page);
+    }
+    pages_tail_ = page;
+  }
+
+  // Update all pointers to the moved objects before releasing their pages.
+  compactor.UpdateRoots(isolate);
+  page = pages_;
+  while (page != NULL) {
+    if (page->used() > 0) {
+      compactor.UpdatePage(page);
+    }
+    page = page->next();
+  }
+  page = large_pages_;
+  while (page != NULL) {
+    compactor.UpdatePage(page);
+    page = page->next();
+  }
+  while (evacuated_pages != NULL) {
+    page = evacuated_pages;
+    evacuated_pages = page->next();
+    capacity_ -= page->memory_->size();
+    page->Deallocate();
+  }
+
+  timer.Stop();
+  if (FLAG_verbose_gc) {
+    const intptr_t KB2 = KB / 2;
+    OS::PrintErr("Compact[%d]: %lldus, %d pages evacuated (%dK live), "
+                 "capacity %dK -> %dK, RSS %dK -> %dK\n",
+                 count_,
+                 timer.TotalElapsedTime(),
+                 evacuated_count,
+                 (evacuated_live + KB2) / KB,
+                 (capacity_before + KB2) / KB,
+                 (capacity_ + KB2) / KB,
+                 (rss_before + KB2) / KB,
+                 (OS::CurrentRSS() + KB2) / KB);
+  }
+}
+
+
 void PageSpace::MarkSweep(bool invoke_api_callbacks) {
   // MarkSweep is not reentrant. Make sure that is the case.
   ASSERT(!sweeping_);
@@ -280,6 +579,23 @@ void PageSpace::MarkSweep(bool invoke_api_callbacks) {
   Isolate* isolate = Isolate::Current();
   NoHandleScope no_handles(isolate);
 
+  ReleaseAllocationBuffer();
+  // The mark bits of the objects on unswept pages are still set.
+  Timer lazy_sweep_timer(FLAG_verbose_gc, "Lazy sweep");
+  lazy_sweep_timer.Start();
+  CompleteSweep();
+  lazy_sweep_timer.Stop();
+  if (FLAG_verbose_gc && (count_ > 0)) {
+    OS::PrintErr("Lazy-Sweep[%d]: %lldus (%lldus during the pause)\n",
+                 count_ - 1,
+                 lazy_sweep_time_,
+                 lazy_sweep_timer.TotalElapsedTime());
+  }
+  lazy_sweep_time_ = 0;
+  if (FLAG_verbose_gc) {
+    PrintFragmentation();
+  }
+
   if (FLAG_verify_before_gc) {
     OS::PrintErr("Verifying before MarkSweep... ");
     heap_->Verify();
@@ -290,9 +606,18 @@ void PageSpace::MarkSweep(bool invoke_api_callbacks) {
   timer.Start();
 
   // Mark all reachable old-gen objects.
+  Timer mark_timer(FLAG_verbose_gc, "Mark");
+  mark_timer.Start();
   GCMarker marker(heap_);
   marker.MarkObjects(isolate, this, invoke_api_callbacks);
+  mark_timer.Stop();
+
+  if (FLAG_compact_old_gen) {
+    Compact(isolate);
+  }
 
+  Timer sweep_timer(FLAG_verbose_gc, "Sweep");
+  sweep_timer.Start();
   // Reset the bump allocation page to unused.
   bump_page_ = NULL;
   // Reset the freelists and setup sweeping.
@@ -300,20 +625,37 @@ void PageSpace::MarkSweep(bool invoke_api_callbacks) {
   GCSweeper sweeper(heap_);
   intptr_t in_use = 0;
 
+  // Pages without any marked objects are released right away. The marker
+  // accounted for the live bytes of each page, so the remaining pages are
+  // either swept now or left for lazy sweeping on allocation.
+  ASSERT(unswept_pages_ == NULL);
+  HeapPage* unswept_tail = NULL;
   HeapPage* prev_page = NULL;
   HeapPage* page = pages_;
   while (page != NULL) {
-    intptr_t page_in_use = sweeper.SweepPage(page, &freelist_);
     HeapPage* next_page = page->next();
-    if (page_in_use == 0) {
+    if (page->used() == 0) {
       FreePage(page, prev_page);
+    } else if (FLAG_lazy_sweep) {
+      in_use += page->used();
+      page->set_next(NULL);
+      if (unswept_tail == NULL) {
+        unswept_pages_ = page;
+      } else {
+        unswept_tail->set_next(page);
+      }
+      unswept_tail = page;
     } else {
-      in_use += page_in_use;
+      in_use += sweeper.SweepPage(page, &freelist_);
       prev_page = page;
     }
     // Advance to the next page.
     page = next_page;
   }
+  if (FLAG_lazy_sweep) {
+    pages_ = NULL;
+    pages_tail_ = NULL;
+  }
 
   prev_page = NULL;
   page = large_pages_;
@@ -329,6 +671,7 @@ void PageSpace::MarkSweep(bool invoke_api_callbacks) {
     // Advance to the next page.
     page = next_page;
   }
+  sweep_timer.Stop();
 
   // Record data and print if requested.
   intptr_t in_use_before = in_use_;
@@ -337,12 +680,16 @@ void PageSpace::MarkSweep(bool invoke_api_callbacks) {
   timer.Stop();
   if (FLAG_verbose_gc) {
     const intptr_t KB2 = KB / 2;
-    OS::PrintErr("Mark-Sweep[%d]: %lldus (%dK -> %dK, %dK)\n",
+    OS::PrintErr("Mark-Sweep[%d]: %lldus (%dK -> %dK, %dK), "
+                 "mark %lldus, sweep %lldus%s\n",
                  count_,
                  timer.TotalElapsedTime(),
                  (in_use_before + (KB2)) / KB,
                  (in_use + (KB2)) / KB,
-                 (capacity_ + KB2) / KB);
+                 (capacity_ + KB2) / KB,
+                 mark_timer.TotalElapsedTime(),
+                 sweep_timer.TotalElapsedTime(),
+                 FLAG_lazy_sweep ? " (lazy)" : "");
   }
 
   if (FLAG_verify_after_gc) {
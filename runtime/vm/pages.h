@@ -5,6 +5,7 @@
 #ifndef VM_PAGES_H_
 #define VM_PAGES_H_
 
+#include "vm/atomic.h"
 #include "vm/freelist.h"
 #include "vm/globals.h"
 #include "vm/virtual_memory.h"
@@ -13,6 +14,7 @@ namespace dart {
 
 // Forward declarations.
 class Heap;
+class Isolate;
 class ObjectPointerVisitor;
 
 // An aligned page containing old generation objects. Alignment is used to be
@@ -38,8 +40,19 @@ class HeapPage {
 
   void set_used(uword used) { used_ = used; }
   uword used() const { return used_; }
+  // May be called concurrently by parallel marker tasks.
   void AddUsed(uword size) {
-    used_ += size;
+    AtomicOperations::FetchAndIncrementBy(
+        reinterpret_cast<intptr_t*>(&used_), size);
+  }
+
+  // Number of bytes of this page held by the freelist, set when sweeping.
+  void set_freelist_bytes(uword bytes) { freelist_bytes_ = bytes; }
+  uword freelist_bytes() const { return freelist_bytes_; }
+  void AddFreelistBytes(uword size) { freelist_bytes_ += size; }
+  void SubtractFreelistBytes(uword size) {
+    ASSERT(freelist_bytes_ >= size);
+    freelist_bytes_ -= size;
   }
 
   uword TryBumpAllocate(intptr_t size) {
@@ -67,6 +80,7 @@ class HeapPage {
   VirtualMemory* memory_;
   HeapPage* next_;
   uword used_;
+  uword freelist_bytes_;
   uword top_;
 
   friend class PageSpace;
@@ -85,9 +99,29 @@ class PageSpace {
   PageSpace(Heap* heap, intptr_t max_capacity, bool is_executable = false);
   ~PageSpace();
 
-  uword TryAllocate(intptr_t size);
+  // Small objects are bump allocated in the current allocation buffer, which
+  // is carved out of the unused end of a page or a freelist block. The whole
+  // buffer is accounted as in use when it is acquired, so that generated code
+  // only needs to bump top_.
+  uword TryAllocate(intptr_t size) {
+    ASSERT(size >= kObjectAlignment);
+    ASSERT(Utils::IsAligned(size, kObjectAlignment));
+    uword result = top_;
+    intptr_t remaining = end_ - result;
+    if (size <= remaining) {
+      top_ = result + size;
+      return result;
+    }
+    return TryAllocateSlow(size);
+  }
+
+  // Accessors for inlined allocation in generated code.
+  uword* TopAddress() { return &top_; }
+  uword* EndAddress() { return &end_; }
 
-  intptr_t in_use() const { return in_use_; }
+  intptr_t in_use() const { return in_use_ - (end_ - top_); }
+  intptr_t capacity() const { return capacity_; }
+  int collections() const { return count_; }
   bool Contains(uword addr) const;
   bool IsValidAddress(uword addr) const {
     return Contains(addr);
@@ -96,13 +130,19 @@ class PageSpace {
     return size <= kAllocatablePageSize;
   }
 
-  void VisitObjectPointers(ObjectPointerVisitor* visitor) const;
+  // Iterating over the objects in the space finishes any pending sweep first.
+  void VisitObjectPointers(ObjectPointerVisitor* visitor);
 
-  RawObject* FindObject(FindObjectVisitor* visitor) const;
+  RawObject* FindObject(FindObjectVisitor* visitor);
 
-  // Collect the garbage in the page space using mark-sweep.
+  // Collect the garbage in the page space using mark-sweep. With lazy
+  // sweeping only the marking happens during the pause, the pages are swept
+  // on demand when allocation runs out of free memory.
   void MarkSweep(bool invoke_api_callbacks);
 
+  // Sweep all pages which have not been swept since the last marking phase.
+  void CompleteSweep();
+
   static HeapPage* PageFor(RawObject* raw_obj) {
     return reinterpret_cast<HeapPage*>(
         RawObject::ToAddr(raw_obj) & ~(kPageSize -1));
@@ -110,6 +150,8 @@ class PageSpace {
 
  private:
   static const intptr_t kAllocatablePageSize = kPageSize - sizeof(HeapPage);
+  // Preferred size of an allocation buffer taken from the freelist.
+  static const intptr_t kAllocationBufferSize = 4 * KB;
 
   void AllocatePage();
   void FreePage(HeapPage* page, HeapPage* previous_page);
@@ -123,7 +165,29 @@ class PageSpace {
     return increase <= (max_capacity_ - capacity_);
   }
 
-  uword TryBumpAllocate(intptr_t size);
+  uword TryAllocateSlow(intptr_t size);
+  HeapPage* FindBumpPage(intptr_t size);
+  uword TryFreeListAllocate(intptr_t size);
+  uword TryFreeListAllocateBuffer(intptr_t size, intptr_t* buffer_size);
+
+  // Set up a new allocation buffer of at least 'size' bytes. The current
+  // allocation buffer has to be released before.
+  bool TryAcquireAllocationBuffer(intptr_t size);
+  // Return the unused part of the allocation buffer to the page or freelist,
+  // which keeps the pages iterable.
+  void ReleaseAllocationBuffer();
+
+  // Print how much of the swept pages is held by the freelist.
+  void PrintFragmentation() const;
+
+  // After marking, evacuate the live objects of sparse pages into fresh pages
+  // and release the sparse pages, if fragmentation is above the threshold.
+  void Compact(Isolate* isolate);
+  bool IsSparse(HeapPage* page) const;
+
+  // Sweep the next unswept page and move it to the list of swept pages.
+  // Returns false if there are no pages left to sweep.
+  bool SweepNextPage();
 
   FreeList freelist_;
 
@@ -133,6 +197,10 @@ class PageSpace {
   HeapPage* pages_tail_;
   HeapPage* large_pages_;
 
+  // Pages holding marked objects which still need to be swept. They are only
+  // added to pages_ once swept, so allocation never happens on them.
+  HeapPage* unswept_pages_;
+
   // Page being used for bump allocation.
   // The value has different meanings:
   // NULL: Still bump allocating from last allocated fresh page.
@@ -140,6 +208,12 @@ class PageSpace {
   // tail page, we give up bump allocating.
   HeapPage* bump_page_;
 
+  // Current allocation buffer [top_, end_). If buffer_page_ is set, the buffer
+  // is the unused end of that page, otherwise it is a freelist block.
+  uword top_;
+  uword end_;
+  HeapPage* buffer_page_;
+
   // Various sizes being tracked for this generation.
   intptr_t max_capacity_;
   intptr_t capacity_;
@@ -148,6 +222,9 @@ class PageSpace {
   // Old-gen GC cycle count.
   int count_;
 
+  // Time spent sweeping lazily since the last mark-sweep, in micros.
+  int64_t lazy_sweep_time_;
+
   bool is_executable_;
 
   // Keep track whether a MarkSweep is currently running.
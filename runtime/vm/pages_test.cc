@@ -31,4 +31,25 @@ TEST_CASE(Pages) {
   delete space;
 }
 
+
+TEST_CASE(PagesAllocationBuffer) {
+  PageSpace* space = new PageSpace(NULL, 4 * MB);
+  const intptr_t kBlockSize = 4 * kWordSize;
+  uword first = space->TryAllocate(kBlockSize);
+  EXPECT(first != 0);
+  // Consecutive small allocations are bump allocated from the same buffer.
+  uword second = space->TryAllocate(kBlockSize);
+  EXPECT_EQ(first + kBlockSize, second);
+  EXPECT_EQ(2 * kBlockSize, space->in_use());
+  uword top = *space->TopAddress();
+  EXPECT_EQ(second + kBlockSize, top);
+  EXPECT(*space->EndAddress() > top);
+  // A large allocation does not disturb the allocation buffer.
+  uword large_block = space->TryAllocate(1 * MB);
+  EXPECT(large_block != 0);
+  EXPECT_EQ(top, *space->TopAddress());
+  EXPECT_EQ(top, space->TryAllocate(kBlockSize));
+  delete space;
+}
+
 }  // namespace dart
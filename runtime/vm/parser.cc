@@ -189,6 +189,29 @@ void ParsedFunction::AllocateVariables() {
 }
 
 
+int ParsedFunction::AllocateInlinedVariables(int first_frame_index) {
+  LocalScope* scope = node_sequence()->scope();
+  const int parameter_count = function().NumberOfParameters();
+  // The arguments are stored in the frame of the caller like copied
+  // parameters: parameter i at fp[first_frame_index - i], followed by the
+  // local variables.
+  first_parameter_index_ = first_frame_index;
+  first_stack_local_index_ = first_frame_index - parameter_count;
+  copied_parameter_count_ = 0;
+  LocalScope* context_owner = NULL;
+  int next_free_frame_index =
+      scope->AllocateVariables(first_parameter_index_,
+                               parameter_count,
+                               first_stack_local_index_,
+                               scope,
+                               &context_owner);
+  if (context_owner != NULL) return -1;
+  ASSERT(next_free_frame_index <= first_stack_local_index_);
+  stack_local_count_ = first_stack_local_index_ - next_free_frame_index;
+  return first_frame_index - next_free_frame_index;
+}
+
+
 struct Parser::Block : public ZoneAllocated {
   Block(Block* outer_block, LocalScope* local_scope, SequenceNode* seq)
     : parent(outer_block), scope(local_scope), statements(seq) {
@@ -240,6 +263,7 @@ Parser::Parser(const Script& script,
                const Library& library)
     : script_(script),
       tokens_(TokenStream::Handle(script.tokens())),
+      tokens_iterator_(tokens_, 0),
       token_index_(0),
       current_block_(NULL),
       is_top_level_(false),
@@ -261,6 +285,7 @@ Parser::Parser(const Script& script,
                intptr_t token_index)
     : script_(script),
       tokens_(TokenStream::Handle(script.tokens())),
+      tokens_iterator_(tokens_, 0),
       token_index_(0),
       current_block_(NULL),
       is_top_level_(false),
@@ -322,7 +347,8 @@ void Parser::ParseCompilationUnit(const Library& library,
 
 Token::Kind Parser::CurrentToken() {
   if (token_kind_ == Token::kILLEGAL) {
-    token_kind_ = tokens_.KindAt(token_index_);
+    tokens_iterator_.SetCurrentPosition(token_index_);
+    token_kind_ = tokens_iterator_.CurrentTokenKind();
     if (token_kind_ == Token::kERROR) {
       ErrorMsg(token_index_, CurrentLiteral()->ToCString());
     }
@@ -335,20 +361,33 @@ Token::Kind Parser::CurrentToken() {
 Token::Kind Parser::LookaheadToken(int num_tokens) {
   CompilerStats::num_tokens_lookahead++;
   CompilerStats::num_token_checks++;
-  return tokens_.KindAt(token_index_ + num_tokens);
+  tokens_iterator_.SetCurrentPosition(token_index_);
+  return tokens_iterator_.LookaheadTokenKind(num_tokens);
 }
 
 
 String* Parser::CurrentLiteral() const {
   String& result = String::ZoneHandle();
-  result ^= tokens_.LiteralAt(token_index_);
+  if (tokens_iterator_.CurrentPosition() == token_index_) {
+    result ^= tokens_iterator_.CurrentLiteral();
+  } else {
+    result ^= tokens_.LiteralAt(token_index_);
+  }
   return &result;
 }
 
 
+RawObject* Parser::CurrentTokenObject() const {
+  if (tokens_iterator_.CurrentPosition() == token_index_) {
+    return tokens_iterator_.CurrentToken();
+  }
+  return tokens_.TokenAt(token_index_);
+}
+
+
 RawDouble* Parser::CurrentDoubleLiteral() const {
   LiteralToken& token = LiteralToken::Handle();
-  token ^= tokens_.TokenAt(token_index_);
+  token ^= CurrentTokenObject();
   ASSERT(token.kind() == Token::kDOUBLE);
   return reinterpret_cast<RawDouble*>(token.value());
 }
@@ -356,7 +395,7 @@ RawDouble* Parser::CurrentDoubleLiteral() const {
 
 RawInteger* Parser::CurrentIntegerLiteral() const {
   LiteralToken& token = LiteralToken::Handle();
-  token ^= tokens_.TokenAt(token_index_);
+  token ^= CurrentTokenObject();
   ASSERT(token.kind() == Token::kINTEGER);
   return reinterpret_cast<RawInteger*>(token.value());
 }
@@ -86,6 +86,12 @@ class ParsedFunction : ValueObject {
 
   void AllocateVariables();
 
+  // Allocate the parameters and locals of a function inlined into another
+  // function in the frame of the latter, from first_frame_index downward.
+  // Returns the number of frame slots used, or -1 if the function has
+  // captured variables, which cannot be inlined.
+  int AllocateInlinedVariables(int first_frame_index);
+
  private:
   const Function& function_;
   SequenceNode* node_sequence_;
@@ -171,6 +177,7 @@ class Parser : ValueObject {
   inline Token::Kind CurrentToken();
   Token::Kind LookaheadToken(int num_tokens);
   String* CurrentLiteral() const;
+  RawObject* CurrentTokenObject() const;
   RawDouble* CurrentDoubleLiteral() const;
   RawInteger* CurrentIntegerLiteral() const;
 
@@ -487,6 +494,9 @@ class Parser : ValueObject {
 
   const Script& script_;
   const TokenStream& tokens_;
+  // Reads tokens_ sequentially, it is moved to token_index_ when the current
+  // or a lookahead token is inspected.
+  TokenStreamIterator tokens_iterator_;
   intptr_t token_index_;
   Token::Kind token_kind_;  // Cached token kind for the token_index_.
   Block* current_block_;
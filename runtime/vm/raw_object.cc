@@ -54,13 +54,6 @@ intptr_t RawObject::SizeFromClass() const {
 
   if (instance_size == 0) {
     switch (instance_kind) {
-      case kTokenStream: {
-        const RawTokenStream* raw_tokens =
-            reinterpret_cast<const RawTokenStream*>(this);
-        intptr_t tokens_length = Smi::Value(raw_tokens->ptr()->length_);
-        instance_size = TokenStream::InstanceSize(tokens_length);
-        break;
-      }
       case kCode: {
         const RawCode* raw_code = reinterpret_cast<const RawCode*>(this);
         intptr_t pointer_offsets_length =
@@ -386,9 +379,8 @@ intptr_t RawLiteralToken::VisitLiteralTokenPointers(
 
 intptr_t RawTokenStream::VisitTokenStreamPointers(
     RawTokenStream* raw_obj, ObjectPointerVisitor* visitor) {
-  intptr_t length = Smi::Value(raw_obj->ptr()->length_);
-  visitor->VisitPointers(raw_obj->from(), raw_obj->to(length));
-  return TokenStream::InstanceSize(length);
+  visitor->VisitPointers(raw_obj->from(), raw_obj->to());
+  return TokenStream::InstanceSize();
 }
 
 
@@ -438,23 +430,6 @@ intptr_t RawInstructions::VisitInstructionsPointers(
 }
 
 
-bool RawInstructions::ContainsPC(RawObject* raw_obj, uword pc) {
-  RawClass* raw_class = raw_obj->ptr()->class_;
-  ObjectKind instance_kind = raw_class->ptr()->instance_kind_;
-  if (instance_kind == kInstructions) {
-    RawInstructions* raw_instr = reinterpret_cast<RawInstructions*>(raw_obj);
-    uword start_pc =
-        reinterpret_cast<uword>(raw_instr->ptr()) + Instructions::HeaderSize();
-    uword end_pc = start_pc + raw_instr->ptr()->size_;
-    ASSERT(end_pc > start_pc);
-    if ((pc >= start_pc) && (pc < end_pc)) {
-      return true;
-    }
-  }
-  return false;
-}
-
-
 intptr_t RawPcDescriptors::VisitPcDescriptorsPointers(
     RawPcDescriptors* raw_obj, ObjectPointerVisitor* visitor) {
   RawPcDescriptors* obj = raw_obj->ptr();
@@ -6,6 +6,7 @@
 #define VM_RAW_OBJECT_H_
 
 #include "platform/assert.h"
+#include "vm/atomic.h"
 #include "vm/globals.h"
 #include "vm/token.h"
 #include "vm/snapshot.h"
@@ -179,10 +180,8 @@ class RawObject {
     kMarkBit = 1,
     kCanonicalBit = 2,
     kFromSnapshotBit = 3,
-    kReservedBit10K = 4,
-    kReservedBit100K = 5,
-    kReservedBit1M = 6,
-    kReservedBit10M = 7,
+    kAgeTagBit = 4,
+    kAgeTagSize = 4,
     kSizeTagBit = 8,
     kSizeTagSize = 8,
     kClassTagBit = kSizeTagBit + kSizeTagSize,
@@ -245,12 +244,37 @@ class RawObject {
     uword tags = ptr()->tags_;
     ptr()->tags_ = MarkBit::update(true, tags);
   }
+  // Atomically set the mark bit. Returns false if the object was already
+  // marked, e.g. by a concurrently running marker task.
+  bool TryAcquireMarkBit() {
+    uword tags = ptr()->tags_;
+    while (!MarkBit::decode(tags)) {
+      uword old_tags = AtomicOperations::CompareAndSwapWord(
+          &ptr()->tags_, tags, MarkBit::update(true, tags));
+      if (old_tags == tags) {
+        return true;
+      }
+      tags = old_tags;
+    }
+    return false;
+  }
   void ClearMarkBit() {
     ASSERT(IsMarked());
     uword tags = ptr()->tags_;
     ptr()->tags_ = MarkBit::update(false, tags);
   }
 
+  // Support for the number of scavenges survived by a new space object.
+  static const intptr_t kMaxAge = (1 << kAgeTagSize) - 1;
+  intptr_t GetAge() const {
+    return AgeTag::decode(ptr()->tags_);
+  }
+  void SetAge(intptr_t age) {
+    ASSERT((age >= 0) && (age <= kMaxAge));
+    uword tags = ptr()->tags_;
+    ptr()->tags_ = AgeTag::update(age, tags);
+  }
+
   // Support for object tags.
   bool IsCanonical() const {
     return CanonicalObjectTag::decode(ptr()->tags_);
@@ -267,6 +291,10 @@ class RawObject {
     ptr()->tags_ = CreatedFromSnapshotTag::update(true, tags);
   }
 
+  intptr_t GetClassIndex() const {
+    return ClassTag::decode(ptr()->tags_);
+  }
+
   intptr_t Size() const {
     uword tags = ptr()->tags_;
     intptr_t result = SizeTag::decode(tags);
@@ -314,6 +342,8 @@ class RawObject {
 
   class CreatedFromSnapshotTag : public BitField<bool, kFromSnapshotBit, 1> {};
 
+  class AgeTag : public BitField<intptr_t, kAgeTagBit, kAgeTagSize> {};
+
   RawObject* ptr() const {
     ASSERT(IsHeapObject());
     return reinterpret_cast<RawObject*>(
@@ -329,6 +359,7 @@ class RawObject {
   friend class SnapshotWriter;
   friend class SnapshotReader;
   friend class MarkingVisitor;
+  friend class GCCompactor;
 
   DISALLOW_ALLOCATION();
   DISALLOW_IMPLICIT_CONSTRUCTORS(RawObject);
@@ -349,6 +380,7 @@ class RawClass : public RawObject {
   RawObject** from() { return reinterpret_cast<RawObject**>(&ptr()->name_); }
   RawString* name_;
   RawArray* functions_;
+  RawArray* functions_hash_table_;  // Lazily built index into functions_.
   RawArray* fields_;
   RawGrowableObjectArray* closure_functions_;  // Local functions and literals.
   RawArray* interfaces_;  // Array of AbstractType.
@@ -359,7 +391,6 @@ class RawClass : public RawObject {
   RawType* super_type_;
   RawObject* factory_class_;  // UnresolvedClass (until finalization) or Class.
   RawFunction* signature_function_;  // Associated function for signature class.
-  RawArray* functions_cache_;  // See class FunctionsCache.
   RawArray* constants_;  // Canonicalized values of this class.
   RawArray* canonical_types_;  // Canonicalized types of this class.
   RawCode* allocation_stub_;  // Stub code for allocation of instances.
@@ -599,11 +630,11 @@ class RawTokenStream : public RawObject {
   }
   RawString* private_key_;  // Key used for private identifiers.
   RawSmi* length_;  // Number of tokens.
-
-  // Variable length data follows here.
-  RawObject* data_[0];
-  RawObject** to(intptr_t length) {
-    return reinterpret_cast<RawObject**>(&ptr()->data_[length - 1]);
+  RawArray* literals_;  // Identifiers and literal tokens, without duplicates.
+  RawUint8Array* stream_;  // Token kinds and indices into literals_.
+  RawUint32Array* index_;  // Stream offset of every kTokenBlockSize-th token.
+  RawObject** to() {
+    return reinterpret_cast<RawObject**>(&ptr()->index_);
   }
 
   friend class SnapshotReader;
@@ -625,7 +656,12 @@ class RawScript : public RawObject {
   RawString* url_;
   RawString* source_;
   RawTokenStream* tokens_;
-  RawObject** to() { return reinterpret_cast<RawObject**>(&ptr()->tokens_); }
+  // Source positions of the tokens, see Script::GetTokenLocation.
+  RawUint32Array* token_position_blocks_;
+  RawUint8Array* token_position_deltas_;
+  RawObject** to() {
+    return reinterpret_cast<RawObject**>(&ptr()->token_position_deltas_);
+  }
 
   Kind kind_;
 };
@@ -692,10 +728,14 @@ class RawCode : public RawObject {
   RawFunction* function_;
   RawExceptionHandlers* exception_handlers_;
   RawPcDescriptors* pc_descriptors_;
-  RawArray* stackmaps_;
+  RawArray* stackmaps_;  // Distinct stack maps of the code.
+  // Sorted pairs of safepoint PC offset and index into stackmaps_.
+  RawUint32Array* stackmap_index_;
   RawLocalVarDescriptors* var_descriptors_;
+  // Deoptimization points of optimized code (see Code::kDeoptEntrySize).
+  RawArray* deopt_info_array_;
   RawObject** to() {
-    return reinterpret_cast<RawObject**>(&ptr()->var_descriptors_);
+    return reinterpret_cast<RawObject**>(&ptr()->deopt_info_array_);
   }
 
   intptr_t pointer_offsets_length_;
@@ -718,11 +758,6 @@ class RawInstructions : public RawObject {
   // Variable length data follows here.
   uint8_t data_[0];
 
-  // Private helper function used while visiting stack frames. The
-  // code which iterates over dart frames is also called during GC and
-  // is not allowed to create handles.
-  static bool ContainsPC(RawObject* raw_obj, uword pc);
-
   friend class RawCode;
   friend class StackFrame;
 };
@@ -739,25 +774,24 @@ class RawPcDescriptors : public RawObject {
 
 
 // Stackmap is an immutable representation of the layout of the stack at
-// a PC. The stack map representation consists of a bit map which marks
+// a safepoint. The stack map representation consists of a bit map which marks
 // each stack slot index starting from the FP (frame pointer) as an object
 // or regular untagged value.
-// The Stackmap also consists of a link to code object corresponding to
-// the frame which the stack map is describing.
+// Safepoints of a code object which have the same stack layout share a single
+// Stackmap, the code object maps the PC offsets of its safepoints to its
+// stack maps (see Code::GetStackmap).
 // The bit map representation is optimized for dense and small bit maps,
 // without any upper bound.
 class RawStackmap : public RawObject {
   RAW_HEAP_OBJECT_IMPLEMENTATION(Stackmap);
 
   RawObject** from() {
-    return reinterpret_cast<RawObject**>(&ptr()->code_);
+    return reinterpret_cast<RawObject**>(&ptr()->bitmap_size_in_bytes_);
   }
-  RawCode* code_;  // Code object corresponding to the frame described.
   RawSmi* bitmap_size_in_bytes_;  // Size of the bit map in bytes.
   RawObject** to() {
     return reinterpret_cast<RawObject**>(&ptr()->bitmap_size_in_bytes_);
   }
-  uword pc_;  // PC corresponding to this stack map representation.
   intptr_t min_set_bit_offset_;  // Minimum bit offset which is set.
   intptr_t max_set_bit_offset_;  // Maximum bit offset which is set.
 
@@ -65,7 +65,7 @@ RawClass* Class::ReadFrom(SnapshotReader* reader,
     // allocations may happen.
     intptr_t num_flds = (cls.raw()->to() - cls.raw()->from());
     for (intptr_t i = 0; i <= num_flds; i++) {
-      *(cls.raw()->from() + i) = reader->ReadObject();
+      cls.StorePointer((cls.raw()->from() + i), reader->ReadObject());
     }
   } else {
     cls ^= reader->ReadClassId(object_id);
@@ -131,7 +131,8 @@ RawUnresolvedClass* UnresolvedClass::ReadFrom(SnapshotReader* reader,
   intptr_t num_flds = (unresolved_class.raw()->to() -
                        unresolved_class.raw()->from());
   for (intptr_t i = 0; i <= num_flds; i++) {
-    *(unresolved_class.raw()->from() + i) = reader->ReadObject();
+    unresolved_class.StorePointer((unresolved_class.raw()->from() + i),
+                                  reader->ReadObject());
   }
   return unresolved_class.raw();
 }
@@ -197,7 +198,8 @@ RawType* Type::ReadFrom(SnapshotReader* reader,
   intptr_t num_flds = (parameterized_type.raw()->to() -
                        parameterized_type.raw()->from());
   for (intptr_t i = 0; i <= num_flds; i++) {
-    *(parameterized_type.raw()->from() + i) = reader->ReadObject();
+    parameterized_type.StorePointer((parameterized_type.raw()->from() + i),
+                                    reader->ReadObject());
   }
 
   // If object needs to be a canonical object, Canonicalize it.
@@ -254,7 +256,8 @@ RawTypeParameter* TypeParameter::ReadFrom(SnapshotReader* reader,
   intptr_t num_flds = (type_parameter.raw()->to() -
                        type_parameter.raw()->from());
   for (intptr_t i = 0; i <= num_flds; i++) {
-    *(type_parameter.raw()->from() + i) = reader->ReadObject();
+    type_parameter.StorePointer((type_parameter.raw()->from() + i),
+                                reader->ReadObject());
   }
 
   return type_parameter.raw();
@@ -377,7 +380,8 @@ RawInstantiatedTypeArguments* InstantiatedTypeArguments::ReadFrom(
   intptr_t num_flds = (instantiated_type_arguments.raw()->to() -
                        instantiated_type_arguments.raw()->from());
   for (intptr_t i = 0; i <= num_flds; i++) {
-    *(instantiated_type_arguments.raw()->from() + i) = reader->ReadObject();
+    instantiated_type_arguments.StorePointer(
+        (instantiated_type_arguments.raw()->from() + i), reader->ReadObject());
   }
   return instantiated_type_arguments.raw();
 }
@@ -434,7 +438,7 @@ RawFunction* Function::ReadFrom(SnapshotReader* reader,
   // allocations may happen.
   intptr_t num_flds = (func.raw()->to() - func.raw()->from());
   for (intptr_t i = 0; i <= num_flds; i++) {
-    *(func.raw()->from() + i) = reader->ReadObject();
+    func.StorePointer((func.raw()->from() + i), reader->ReadObject());
   }
 
   return func.raw();
@@ -496,7 +500,7 @@ RawField* Field::ReadFrom(SnapshotReader* reader,
   // allocations may happen.
   intptr_t num_flds = (field.raw()->to() - field.raw()->from());
   for (intptr_t i = 0; i <= num_flds; i++) {
-    *(field.raw()->from() + i) = reader->ReadObject();
+    field.StorePointer((field.raw()->from() + i), reader->ReadObject());
   }
 
   return field.raw();
@@ -582,21 +586,21 @@ RawTokenStream* TokenStream::ReadFrom(SnapshotReader* reader,
   ASSERT(reader != NULL);
   ASSERT(kind != Snapshot::kMessage && !RawObject::IsCreatedFromSnapshot(tags));
 
-  // Read the length so that we can determine number of tokens to read.
-  intptr_t len = reader->ReadSmiValue();
-
   // Create the token stream object.
   TokenStream& token_stream = TokenStream::ZoneHandle(
-      reader->isolate(), NEW_OBJECT_WITH_LEN(TokenStream, len));
+      reader->isolate(), NEW_OBJECT(TokenStream));
   reader->AddBackwardReference(object_id, &token_stream);
 
   // Set the object tags.
   token_stream.set_tags(tags);
 
-  // Read the token stream into the TokenStream.
-  for (intptr_t i = 0; i < len; i++) {
-    *reader->ObjectHandle() = reader->ReadObject();
-    token_stream.SetTokenAt(i, *reader->ObjectHandle());
+  // Set all the object fields, the literal pool and the encoded stream.
+  // TODO(5411462): Need to assert No GC can happen here, even though
+  // allocations may happen.
+  intptr_t num_flds = (token_stream.raw()->to() - token_stream.raw()->from());
+  for (intptr_t i = 0; i <= num_flds; i++) {
+    token_stream.StorePointer((token_stream.raw()->from() + i),
+                              reader->ReadObject());
   }
   return token_stream.raw();
 }
@@ -614,14 +618,9 @@ void RawTokenStream::WriteTo(SnapshotWriter* writer,
   // Write out the class and tags information.
   writer->WriteObjectHeader(Object::kTokenStreamClass, ptr()->tags_);
 
-  // Write out the length field.
-  writer->Write<RawObject*>(ptr()->length_);
-
-  // Write out the token stream (token kind and literal).
-  intptr_t len = Smi::Value(ptr()->length_);
-  for (intptr_t i = 0; i < TokenStream::StreamLength(len); i++) {
-    writer->WriteObject(ptr()->data_[i]);
-  }
+  // Write out all the object pointer fields.
+  SnapshotWriterVisitor visitor(writer);
+  visitor.VisitPointers(from(), to());
 }
 
 
@@ -644,7 +643,7 @@ RawScript* Script::ReadFrom(SnapshotReader* reader,
   // allocations may happen.
   intptr_t num_flds = (script.raw()->to() - script.raw()->from());
   for (intptr_t i = 0; i <= num_flds; i++) {
-    *(script.raw()->from() + i) = reader->ReadObject();
+    script.StorePointer((script.raw()->from() + i), reader->ReadObject());
   }
 
   return script.raw();
@@ -711,7 +710,7 @@ RawLibrary* Library::ReadFrom(SnapshotReader* reader,
     // allocations may happen.
     intptr_t num_flds = (library.raw()->to() - library.raw()->from());
     for (intptr_t i = 0; i <= num_flds; i++) {
-      *(library.raw()->from() + i) = reader->ReadObject();
+      library.StorePointer((library.raw()->from() + i), reader->ReadObject());
     }
     if (kind != Snapshot::kFull) {
       library.Register();
@@ -781,7 +780,7 @@ RawLibraryPrefix* LibraryPrefix::ReadFrom(SnapshotReader* reader,
   // allocations may happen.
   intptr_t num_flds = (prefix.raw()->to() - prefix.raw()->from());
   for (intptr_t i = 0; i <= num_flds; i++) {
-    *(prefix.raw()->from() + i) = reader->ReadObject();
+    prefix.StorePointer((prefix.raw()->from() + i), reader->ReadObject());
   }
 
   return prefix.raw();
@@ -934,7 +933,7 @@ RawContext* Context::ReadFrom(SnapshotReader* reader,
   // allocations may happen.
   intptr_t num_flds = (context.raw()->to(num_vars) - context.raw()->from());
   for (intptr_t i = 0; i <= num_flds; i++) {
-    *(context.raw()->from() + i) = reader->ReadObject();
+    context.StorePointer((context.raw()->from() + i), reader->ReadObject());
   }
 
   return context.raw();
@@ -984,7 +983,7 @@ RawContextScope* ContextScope::ReadFrom(SnapshotReader* reader,
   // allocations may happen.
   intptr_t num_flds = (scope.raw()->to(num_vars) - scope.raw()->from());
   for (intptr_t i = 0; i <= num_flds; i++) {
-    *(scope.raw()->from() + i) = reader->ReadObject();
+    scope.StorePointer((scope.raw()->from() + i), reader->ReadObject());
   }
 
   return scope.raw();
@@ -2351,10 +2350,19 @@ RawJSRegExp* JSRegExp::ReadFrom(SnapshotReader* reader,
   // Read and Set all the other fields.
   regex.raw_ptr()->num_bracket_expressions_ = reader->ReadAsSmi();
   *reader->StringHandle() ^= reader->ReadObject();
-  regex.raw_ptr()->pattern_ = (*reader->StringHandle()).raw();
+  regex.StorePointer(&regex.raw_ptr()->pattern_,
+                     (*reader->StringHandle()).raw());
   regex.raw_ptr()->type_ = reader->ReadIntptrValue();
   regex.raw_ptr()->flags_ = reader->ReadIntptrValue();
 
+  // The bytecode of a regex does not depend on the isolate, read it back.
+  if (regex.is_bytecode()) {
+    uint8_t* data = reinterpret_cast<uint8_t*>(regex.GetDataStartAddress());
+    for (intptr_t i = 0; i < len; i++) {
+      data[i] = reader->Read<uint8_t>();
+    }
+  }
+
   // TODO(5411462): Need to implement a way of recompiling the regex.
 
   return regex.raw();
@@ -2382,7 +2390,13 @@ void RawJSRegExp::WriteTo(SnapshotWriter* writer,
   writer->WriteIntptrValue(ptr()->type_);
   writer->WriteIntptrValue(ptr()->flags_);
 
-  // Do not write out the data part which is native.
+  // Do not write out the data part which is native, unless it is bytecode.
+  if (ptr()->type_ == JSRegExp::kBytecode) {
+    const intptr_t len = Smi::Value(ptr()->data_length_);
+    for (intptr_t i = 0; i < len; i++) {
+      writer->Write<uint8_t>(ptr()->data_[i]);
+    }
+  }
 }
 
 
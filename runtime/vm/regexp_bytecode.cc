@@ -0,0 +1,1153 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/regexp_bytecode.h"
+
+#include "platform/assert.h"
+#include "vm/growable_array.h"
+#include "vm/isolate.h"
+#include "vm/object.h"
+
+namespace dart {
+
+// The data of a JSRegExp compiled to bytecode is an array of 32-bit words:
+// the header below, followed by the bytecode.
+static const intptr_t kCaptureCountIndex = 0;  // Including the whole match.
+static const intptr_t kProgressCountIndex = 1;
+static const intptr_t kCodeLengthIndex = 2;
+static const intptr_t kHeaderSize = 3;
+
+// Patterns with a larger bytecode, for instance because of large counted
+// repetitions, are left to jscre.
+static const intptr_t kMaxCodeLength = 64 * KB;
+static const intptr_t kMaxRepetitionCount = 64 * KB;
+
+// Give up a match after that many backtracks or when the backtracking stack
+// grows past its limit, like jscre does when it hits its match limit.
+static const intptr_t kBacktrackLimit = 10 * MB;
+static const intptr_t kMaxStackLength = 4 * MB;
+
+static const int32_t kMaxCharCode = 0x7fffffff;
+
+
+// The operands of an instruction follow its opcode. Branch offsets are
+// relative to the opcode of the branch.
+enum RegExpOpcode {
+  kMatch = 0,         // Succeed.
+  kChar,              // c: match the character c.
+  kCharIgnoreCase,    // c: match the lower case ASCII letter c, or its
+                      //    upper case.
+  kAnyButNewline,     // Match any character but a line terminator.
+  kCharClass,         // negated, n, from_1, to_1, ..., from_n, to_n: match
+                      //    a character in one of the ranges, or in none of
+                      //    them if negated.
+  kAssertStart,       // Match at the start of the subject.
+  kAssertEnd,         // Match at the end of the subject.
+  kAssertLineStart,   // Match at the start of the subject or of a line.
+  kAssertLineEnd,     // Match at the end of the subject or of a line.
+  kWordBoundary,      // Match between a word and a non-word character.
+  kNotWordBoundary,   // Match anywhere else.
+  kSplitNext,         // offset: continue with the next instruction, and
+                      //    backtrack to the branch target.
+  kSplitJump,         // offset: continue at the branch target, and backtrack
+                      //    to the next instruction.
+  kJump,              // offset: continue at the branch target.
+  kSave,              // r: store the position in capture register r.
+  kClearCaptures,     // from, to: clear the capture registers from 'from'
+                      //    to 'to' excluded, at the start of an iteration.
+  kSetProgress,       // r: store the position in progress register r.
+  kCheckProgress,     // r: fail if the position is still progress register
+                      //    r, so that loops stop on empty iterations.
+};
+
+
+static const int32_t kDigitRanges[] = { '0', '9' };
+static const int32_t kWordRanges[] = { '0', '9', 'A', 'Z', '_', '_', 'a', 'z' };
+static const int32_t kSpaceRanges[] = {
+  0x09, 0x0d, 0x20, 0x20, 0xa0, 0xa0, 0x1680, 0x1680, 0x180e, 0x180e,
+  0x2000, 0x200a, 0x2028, 0x2029, 0x202f, 0x202f, 0x205f, 0x205f,
+  0x3000, 0x3000, 0xfeff, 0xfeff
+};
+
+
+static bool IsLineTerminator(int32_t c) {
+  return (c == '\n') || (c == '\r') || (c == 0x2028) || (c == 0x2029);
+}
+
+
+static bool IsWordChar(int32_t c) {
+  return (('a' <= c) && (c <= 'z')) ||
+         (('A' <= c) && (c <= 'Z')) ||
+         (('0' <= c) && (c <= '9')) ||
+         (c == '_');
+}
+
+
+static bool IsAsciiLetter(int32_t c) {
+  return (('a' <= c) && (c <= 'z')) || (('A' <= c) && (c <= 'Z'));
+}
+
+
+static bool IsDecimalDigit(int32_t c) {
+  return ('0' <= c) && (c <= '9');
+}
+
+
+static intptr_t HexValue(int32_t c) {
+  if (IsDecimalDigit(c)) return c - '0';
+  if (('a' <= c) && (c <= 'f')) return c - 'a' + 10;
+  if (('A' <= c) && (c <= 'F')) return c - 'A' + 10;
+  return -1;
+}
+
+
+// Parses a pattern and emits its bytecode. The bytecode starts by saving
+// the start of the match in capture register 0, and ends by saving its end
+// in capture register 1.
+class RegExpParser : public ValueObject {
+ public:
+  RegExpParser(const GrowableArray<int32_t>& pattern,
+               bool multi_line,
+               bool ignore_case,
+               GrowableArray<int32_t>* code)
+      : pattern_(pattern),
+        position_(0),
+        multi_line_(multi_line),
+        ignore_case_(ignore_case),
+        code_(code),
+        capture_count_(1),
+        progress_count_(0) { }
+
+  // Returns false if the pattern is invalid or not supported.
+  bool Parse();
+
+  intptr_t capture_count() const { return capture_count_; }
+  intptr_t progress_count() const { return progress_count_; }
+
+ private:
+  bool ParseDisjunction(bool* can_be_empty);
+  bool ParseAlternative(bool* can_be_empty);
+  bool ParseTerm(bool* can_be_empty);
+  bool ParseAtom(bool* can_be_empty);
+  bool ParseQuantifier(bool* has_quantifier,
+                       intptr_t* min,
+                       intptr_t* max,
+                       bool* greedy);
+  bool ParseCharacterClass();
+  bool ParseClassAtom(GrowableArray<int32_t>* ranges,
+                      int32_t* c,
+                      bool* is_class);
+  bool ParseCharacterEscape(int32_t* c);
+  bool ParseHex(intptr_t digits, int32_t* value);
+  bool ParseDecimal(intptr_t* value);
+
+  bool AtEnd() const { return position_ >= pattern_.length(); }
+  int32_t Current() const { return pattern_[position_]; }
+  void Advance() { position_++; }
+  bool Accept(int32_t c) {
+    if (!AtEnd() && (Current() == c)) {
+      Advance();
+      return true;
+    }
+    return false;
+  }
+  bool AtQuantifier() const {
+    if (AtEnd()) return false;
+    int32_t c = Current();
+    return (c == '*') || (c == '+') || (c == '?') || (c == '{');
+  }
+
+  void Emit(int32_t word) { code_->Add(word); }
+  bool EmitChar(int32_t c);
+  void EmitClass(GrowableArray<int32_t>* ranges, bool negated);
+  bool EmitQuantified(intptr_t atom_start,
+                      intptr_t first_capture,
+                      intptr_t min,
+                      intptr_t max,
+                      bool greedy,
+                      bool atom_can_be_empty);
+  // Emits an iteration after the minimum count, with a progress check if
+  // 'progress' is a progress register.
+  void EmitOptionalIteration(const GrowableArray<int32_t>& iteration,
+                             intptr_t progress);
+  // Returns the position of the branch, to patch once the target is known.
+  intptr_t EmitBranch(RegExpOpcode opcode) {
+    intptr_t position = code_->length();
+    Emit(opcode);
+    Emit(0);
+    return position;
+  }
+  void PatchBranch(intptr_t branch, intptr_t target) {
+    (*code_)[branch + 1] = target - branch;
+  }
+  // Inserts a kSplitNext before the code from 'position', which must not be
+  // the target of any branch, and returns the position of the split.
+  intptr_t InsertSplit(intptr_t position);
+
+  const GrowableArray<int32_t>& pattern_;
+  intptr_t position_;
+  const bool multi_line_;
+  const bool ignore_case_;
+  GrowableArray<int32_t>* code_;
+  intptr_t capture_count_;
+  intptr_t progress_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(RegExpParser);
+};
+
+
+// Appends the ranges of the class escape \c (one of dDsSwW) to 'ranges'.
+static void AddClassEscapeRanges(int32_t c, GrowableArray<int32_t>* ranges) {
+  const int32_t* table = NULL;
+  intptr_t table_length = 0;
+  switch (c) {
+    case 'd':
+    case 'D':
+      table = kDigitRanges;
+      table_length = ARRAY_SIZE(kDigitRanges);
+      break;
+    case 's':
+    case 'S':
+      table = kSpaceRanges;
+      table_length = ARRAY_SIZE(kSpaceRanges);
+      break;
+    case 'w':
+    case 'W':
+      table = kWordRanges;
+      table_length = ARRAY_SIZE(kWordRanges);
+      break;
+    default:
+      UNREACHABLE();
+  }
+  if (('a' <= c) && (c <= 'z')) {
+    for (intptr_t i = 0; i < table_length; i++) {
+      ranges->Add(table[i]);
+    }
+    return;
+  }
+  // The tables are sorted, add the gaps between their ranges.
+  int32_t from = 0;
+  for (intptr_t i = 0; i < table_length; i += 2) {
+    if (table[i] > from) {
+      ranges->Add(from);
+      ranges->Add(table[i] - 1);
+    }
+    from = table[i + 1] + 1;
+  }
+  ranges->Add(from);
+  ranges->Add(kMaxCharCode);
+}
+
+
+static bool IsClassEscape(int32_t c) {
+  return (c == 'd') || (c == 'D') || (c == 's') || (c == 'S') ||
+         (c == 'w') || (c == 'W');
+}
+
+
+bool RegExpParser::Parse() {
+  Emit(kSave);
+  Emit(0);
+  bool can_be_empty = false;
+  if (!ParseDisjunction(&can_be_empty) || !AtEnd()) {
+    return false;
+  }
+  Emit(kSave);
+  Emit(1);
+  Emit(kMatch);
+  return code_->length() <= kMaxCodeLength;
+}
+
+
+bool RegExpParser::ParseDisjunction(bool* can_be_empty) {
+  *can_be_empty = false;
+  GrowableArray<intptr_t> exits;
+  while (true) {
+    intptr_t start = code_->length();
+    bool alternative_can_be_empty = false;
+    if (!ParseAlternative(&alternative_can_be_empty)) {
+      return false;
+    }
+    *can_be_empty = *can_be_empty || alternative_can_be_empty;
+    if (!Accept('|')) {
+      break;
+    }
+    // Try this alternative first, and backtrack to the next one.
+    intptr_t split = InsertSplit(start);
+    exits.Add(EmitBranch(kJump));
+    PatchBranch(split, code_->length());
+  }
+  for (intptr_t i = 0; i < exits.length(); i++) {
+    PatchBranch(exits[i], code_->length());
+  }
+  return true;
+}
+
+
+bool RegExpParser::ParseAlternative(bool* can_be_empty) {
+  *can_be_empty = true;
+  while (!AtEnd() && (Current() != '|') && (Current() != ')')) {
+    bool term_can_be_empty = false;
+    if (!ParseTerm(&term_can_be_empty)) {
+      return false;
+    }
+    *can_be_empty = *can_be_empty && term_can_be_empty;
+    if (code_->length() > kMaxCodeLength) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+bool RegExpParser::ParseTerm(bool* can_be_empty) {
+  // Assertions, which cannot be quantified.
+  int32_t assertion = -1;
+  if (Current() == '^') {
+    assertion = multi_line_ ? kAssertLineStart : kAssertStart;
+    Advance();
+  } else if (Current() == '$') {
+    assertion = multi_line_ ? kAssertLineEnd : kAssertEnd;
+    Advance();
+  } else if ((Current() == '\\') && (position_ + 1 < pattern_.length()) &&
+             ((pattern_[position_ + 1] == 'b') ||
+              (pattern_[position_ + 1] == 'B'))) {
+    Advance();
+    assertion = (Current() == 'b') ? kWordBoundary : kNotWordBoundary;
+    Advance();
+  }
+  if (assertion != -1) {
+    Emit(assertion);
+    *can_be_empty = true;
+    return !AtQuantifier();
+  }
+
+  intptr_t atom_start = code_->length();
+  intptr_t first_capture = capture_count_;
+  bool atom_can_be_empty = false;
+  if (!ParseAtom(&atom_can_be_empty)) {
+    return false;
+  }
+  bool has_quantifier = false;
+  intptr_t min = 1;
+  intptr_t max = 1;
+  bool greedy = true;
+  if (!ParseQuantifier(&has_quantifier, &min, &max, &greedy)) {
+    return false;
+  }
+  *can_be_empty = atom_can_be_empty || (min == 0);
+  if (!has_quantifier) {
+    return true;
+  }
+  return EmitQuantified(atom_start, first_capture, min, max, greedy,
+                        atom_can_be_empty);
+}
+
+
+bool RegExpParser::ParseAtom(bool* can_be_empty) {
+  *can_be_empty = false;
+  int32_t c = Current();
+  switch (c) {
+    case '.':
+      Advance();
+      Emit(kAnyButNewline);
+      return true;
+    case '(': {
+      Advance();
+      if (Accept('?')) {
+        // Lookaheads are left to jscre.
+        if (!Accept(':')) {
+          return false;
+        }
+        return ParseDisjunction(can_be_empty) && Accept(')');
+      }
+      intptr_t index = capture_count_++;
+      Emit(kSave);
+      Emit(2 * index);
+      if (!ParseDisjunction(can_be_empty) || !Accept(')')) {
+        return false;
+      }
+      Emit(kSave);
+      Emit(2 * index + 1);
+      return true;
+    }
+    case '[':
+      return ParseCharacterClass();
+    case '\\': {
+      Advance();
+      if (AtEnd()) {
+        return false;
+      }
+      if (IsClassEscape(Current())) {
+        GrowableArray<int32_t> ranges;
+        AddClassEscapeRanges(Current(), &ranges);
+        Advance();
+        EmitClass(&ranges, false);
+        return true;
+      }
+      int32_t escaped;
+      return ParseCharacterEscape(&escaped) && EmitChar(escaped);
+    }
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+    case '}':
+    case ']':
+      // Invalid, or accepted as characters by jscre.
+      return false;
+    default:
+      Advance();
+      return EmitChar(c);
+  }
+}
+
+
+bool RegExpParser::ParseQuantifier(bool* has_quantifier,
+                                   intptr_t* min,
+                                   intptr_t* max,
+                                   bool* greedy) {
+  *has_quantifier = false;
+  if (!AtQuantifier()) {
+    return true;
+  }
+  switch (Current()) {
+    case '*':
+      *min = 0;
+      *max = -1;
+      Advance();
+      break;
+    case '+':
+      *min = 1;
+      *max = -1;
+      Advance();
+      break;
+    case '?':
+      *min = 0;
+      *max = 1;
+      Advance();
+      break;
+    case '{':
+      Advance();
+      if (!ParseDecimal(min)) {
+        return false;
+      }
+      if (Accept(',')) {
+        if (!AtEnd() && (Current() == '}')) {
+          *max = -1;
+        } else if (!ParseDecimal(max) || (*max < *min)) {
+          return false;
+        }
+      } else {
+        *max = *min;
+      }
+      if (!Accept('}')) {
+        return false;
+      }
+      break;
+    default:
+      UNREACHABLE();
+  }
+  *greedy = !Accept('?');
+  *has_quantifier = true;
+  return true;
+}
+
+
+bool RegExpParser::ParseCharacterClass() {
+  ASSERT(Current() == '[');
+  Advance();
+  bool negated = Accept('^');
+  GrowableArray<int32_t> ranges;
+  while (true) {
+    if (AtEnd()) {
+      return false;
+    }
+    if (Accept(']')) {
+      break;
+    }
+    int32_t from;
+    bool from_is_class = false;
+    if (!ParseClassAtom(&ranges, &from, &from_is_class)) {
+      return false;
+    }
+    if (from_is_class) {
+      continue;
+    }
+    if ((position_ + 1 < pattern_.length()) && (Current() == '-') &&
+        (pattern_[position_ + 1] != ']')) {
+      Advance();
+      int32_t to;
+      bool to_is_class = false;
+      if (!ParseClassAtom(&ranges, &to, &to_is_class) ||
+          to_is_class ||
+          (to < from)) {
+        return false;
+      }
+      ranges.Add(from);
+      ranges.Add(to);
+    } else {
+      ranges.Add(from);
+      ranges.Add(from);
+    }
+  }
+  if (ignore_case_) {
+    // Close the class over the ASCII letters. The class has no other
+    // letters of different case, apart from those of the class escapes,
+    // which contain both cases.
+    intptr_t length = ranges.length();
+    for (intptr_t i = 0; i < length; i += 2) {
+      int32_t from = ranges[i];
+      int32_t to = ranges[i + 1];
+      if ((from <= 'z') && (to >= 'a')) {
+        ranges.Add((from < 'a' ? 'a' : from) - 'a' + 'A');
+        ranges.Add((to > 'z' ? 'z' : to) - 'a' + 'A');
+      }
+      if ((from <= 'Z') && (to >= 'A')) {
+        ranges.Add((from < 'A' ? 'A' : from) - 'A' + 'a');
+        ranges.Add((to > 'Z' ? 'Z' : to) - 'A' + 'a');
+      }
+    }
+  }
+  EmitClass(&ranges, negated);
+  return true;
+}
+
+
+bool RegExpParser::ParseClassAtom(GrowableArray<int32_t>* ranges,
+                                  int32_t* c,
+                                  bool* is_class) {
+  *is_class = false;
+  if (!Accept('\\')) {
+    *c = Current();
+    Advance();
+  } else {
+    if (AtEnd()) {
+      return false;
+    }
+    if (IsClassEscape(Current())) {
+      AddClassEscapeRanges(Current(), ranges);
+      Advance();
+      *is_class = true;
+      return true;
+    }
+    if (Accept('b')) {
+      *c = '\b';
+    } else if (!ParseCharacterEscape(c)) {
+      return false;
+    }
+  }
+  // Case-insensitive non-ASCII characters are left to jscre.
+  return !ignore_case_ || (*c < 0x80);
+}
+
+
+bool RegExpParser::ParseCharacterEscape(int32_t* c) {
+  int32_t escaped = Current();
+  Advance();
+  switch (escaped) {
+    case 'n': *c = '\n'; return true;
+    case 'r': *c = '\r'; return true;
+    case 't': *c = '\t'; return true;
+    case 'v': *c = '\v'; return true;
+    case 'f': *c = '\f'; return true;
+    case '0':
+      // Octal escapes are left to jscre.
+      *c = 0;
+      return AtEnd() || !IsDecimalDigit(Current());
+    case 'x':
+      return ParseHex(2, c);
+    case 'u':
+      return ParseHex(4, c);
+    case 'c':
+      if (AtEnd() || !IsAsciiLetter(Current())) {
+        return false;
+      }
+      *c = Current() % 32;
+      Advance();
+      return true;
+    default:
+      // Back references and the other escaped letters and digits are left
+      // to jscre.
+      *c = escaped;
+      return !IsWordChar(escaped);
+  }
+}
+
+
+bool RegExpParser::ParseHex(intptr_t digits, int32_t* value) {
+  *value = 0;
+  for (intptr_t i = 0; i < digits; i++) {
+    if (AtEnd() || (HexValue(Current()) < 0)) {
+      return false;
+    }
+    *value = (*value * 16) + HexValue(Current());
+    Advance();
+  }
+  return true;
+}
+
+
+bool RegExpParser::ParseDecimal(intptr_t* value) {
+  if (AtEnd() || !IsDecimalDigit(Current())) {
+    return false;
+  }
+  *value = 0;
+  while (!AtEnd() && IsDecimalDigit(Current())) {
+    *value = (*value * 10) + (Current() - '0');
+    if (*value > kMaxRepetitionCount) {
+      return false;
+    }
+    Advance();
+  }
+  return true;
+}
+
+
+bool RegExpParser::EmitChar(int32_t c) {
+  if (!ignore_case_) {
+    Emit(kChar);
+    Emit(c);
+    return true;
+  }
+  if (IsAsciiLetter(c)) {
+    Emit(kCharIgnoreCase);
+    Emit(c | 0x20);
+    return true;
+  }
+  // Case-insensitive non-ASCII characters are left to jscre.
+  Emit(kChar);
+  Emit(c);
+  return c < 0x80;
+}
+
+
+void RegExpParser::EmitClass(GrowableArray<int32_t>* ranges, bool negated) {
+  // Sort the ranges by their start, and merge the ones that overlap or
+  // touch.
+  intptr_t length = ranges->length();
+  for (intptr_t i = 2; i < length; i += 2) {
+    int32_t from = (*ranges)[i];
+    int32_t to = (*ranges)[i + 1];
+    intptr_t j = i;
+    while ((j > 0) && ((*ranges)[j - 2] > from)) {
+      (*ranges)[j] = (*ranges)[j - 2];
+      (*ranges)[j + 1] = (*ranges)[j - 1];
+      j -= 2;
+    }
+    (*ranges)[j] = from;
+    (*ranges)[j + 1] = to;
+  }
+  intptr_t merged = 0;
+  for (intptr_t i = 0; i < length; i += 2) {
+    if ((merged > 0) &&
+        ((*ranges)[i] <= (*ranges)[merged - 1] + 1)) {
+      if ((*ranges)[i + 1] > (*ranges)[merged - 1]) {
+        (*ranges)[merged - 1] = (*ranges)[i + 1];
+      }
+    } else {
+      (*ranges)[merged] = (*ranges)[i];
+      (*ranges)[merged + 1] = (*ranges)[i + 1];
+      merged += 2;
+    }
+  }
+  Emit(kCharClass);
+  Emit(negated ? 1 : 0);
+  Emit(merged / 2);
+  for (intptr_t i = 0; i < merged; i++) {
+    Emit((*ranges)[i]);
+  }
+}
+
+
+bool RegExpParser::EmitQuantified(intptr_t atom_start,
+                                  intptr_t first_capture,
+                                  intptr_t min,
+                                  intptr_t max,
+                                  bool greedy,
+                                  bool atom_can_be_empty) {
+  // Take the code of the atom out, and emit it again for each iteration.
+  // The branches of the atom are relative and stay inside of it. Each
+  // iteration starts by clearing the captures of the atom.
+  GrowableArray<int32_t> iteration(code_->length() - atom_start + 3);
+  if (first_capture < capture_count_) {
+    iteration.Add(kClearCaptures);
+    iteration.Add(2 * first_capture);
+    iteration.Add(2 * capture_count_);
+  }
+  for (intptr_t i = atom_start; i < code_->length(); i++) {
+    iteration.Add((*code_)[i]);
+  }
+  while (code_->length() > atom_start) {
+    code_->RemoveLast();
+  }
+  // The optional iterations also have a split and a progress check.
+  const intptr_t iteration_length = iteration.length() + 6;
+  const intptr_t copies = (max == -1) ? min + 1 : max;
+  if (copies > kMaxCodeLength / iteration_length) {
+    return false;
+  }
+  for (intptr_t i = 0; i < min; i++) {
+    code_->AddArray(iteration);
+  }
+  // The optional iterations fail if they match the empty string.
+  intptr_t progress = -1;
+  if (atom_can_be_empty && (max != min)) {
+    progress = progress_count_++;
+  }
+  const RegExpOpcode split_opcode = greedy ? kSplitNext : kSplitJump;
+  if (max == -1) {
+    // loop: split exit; iteration; jump loop; exit:
+    intptr_t loop = code_->length();
+    intptr_t exit_split = EmitBranch(split_opcode);
+    EmitOptionalIteration(iteration, progress);
+    PatchBranch(EmitBranch(kJump), loop);
+    PatchBranch(exit_split, code_->length());
+  } else {
+    // split exit; iteration; split exit; iteration; ...; exit:
+    GrowableArray<intptr_t> exit_splits;
+    for (intptr_t i = min; i < max; i++) {
+      exit_splits.Add(EmitBranch(split_opcode));
+      EmitOptionalIteration(iteration, progress);
+    }
+    for (intptr_t i = 0; i < exit_splits.length(); i++) {
+      PatchBranch(exit_splits[i], code_->length());
+    }
+  }
+  return code_->length() <= kMaxCodeLength;
+}
+
+
+void RegExpParser::EmitOptionalIteration(
+    const GrowableArray<int32_t>& iteration, intptr_t progress) {
+  if (progress >= 0) {
+    Emit(kSetProgress);
+    Emit(progress);
+  }
+  code_->AddArray(iteration);
+  if (progress >= 0) {
+    Emit(kCheckProgress);
+    Emit(progress);
+  }
+}
+
+
+intptr_t RegExpParser::InsertSplit(intptr_t position) {
+  const intptr_t kSplitLength = 2;
+  for (intptr_t i = 0; i < kSplitLength; i++) {
+    Emit(0);
+  }
+  for (intptr_t i = code_->length() - 1; i >= position + kSplitLength; i--) {
+    (*code_)[i] = (*code_)[i - kSplitLength];
+  }
+  (*code_)[position] = kSplitNext;
+  (*code_)[position + 1] = 0;
+  return position;
+}
+
+
+enum RegExpMatchResult {
+  kNoMatch,
+  kMatched,
+  kHitLimit,
+};
+
+
+static bool InClass(const int32_t* instruction, int32_t c) {
+  const bool negated = (instruction[1] != 0);
+  const intptr_t count = instruction[2];
+  const int32_t* ranges = instruction + 3;
+  for (intptr_t i = 0; i < count; i++) {
+    if (c < ranges[2 * i]) {
+      // The ranges are sorted.
+      return negated;
+    }
+    if (c <= ranges[2 * i + 1]) {
+      return !negated;
+    }
+  }
+  return negated;
+}
+
+
+// Matches the bytecode at position 'start' of the subject. The registers
+// must be cleared. The backtracking stack holds pairs: the pc and position
+// to backtrack to, or the negated index and the previous value of a
+// register to restore.
+template<typename CharType>
+static RegExpMatchResult MatchAt(const int32_t* code,
+                                 const CharType* subject,
+                                 intptr_t length,
+                                 intptr_t start,
+                                 intptr_t* captures,
+                                 intptr_t* progress,
+                                 RegExpStack* stack,
+                                 intptr_t* backtrack_budget) {
+  stack->Clear();
+  intptr_t pc = 0;
+  intptr_t position = start;
+  while (true) {
+    bool failed = false;
+    switch (code[pc]) {
+      case kMatch:
+        return kMatched;
+      case kChar:
+        if ((position < length) &&
+            (static_cast<int32_t>(subject[position]) == code[pc + 1])) {
+          position++;
+          pc += 2;
+        } else {
+          failed = true;
+        }
+        break;
+      case kCharIgnoreCase:
+        if ((position < length) &&
+            ((static_cast<int32_t>(subject[position]) | 0x20) ==
+             code[pc + 1])) {
+          position++;
+          pc += 2;
+        } else {
+          failed = true;
+        }
+        break;
+      case kAnyButNewline:
+        if ((position < length) && !IsLineTerminator(subject[position])) {
+          position++;
+          pc++;
+        } else {
+          failed = true;
+        }
+        break;
+      case kCharClass:
+        if ((position < length) &&
+            InClass(code + pc, static_cast<int32_t>(subject[position]))) {
+          position++;
+          pc += 3 + 2 * code[pc + 2];
+        } else {
+          failed = true;
+        }
+        break;
+      case kAssertStart:
+        failed = (position != 0);
+        pc++;
+        break;
+      case kAssertEnd:
+        failed = (position != length);
+        pc++;
+        break;
+      case kAssertLineStart:
+        failed = (position != 0) && !IsLineTerminator(subject[position - 1]);
+        pc++;
+        break;
+      case kAssertLineEnd:
+        failed = (position != length) && !IsLineTerminator(subject[position]);
+        pc++;
+        break;
+      case kWordBoundary:
+      case kNotWordBoundary: {
+        bool before = (position > 0) && IsWordChar(subject[position - 1]);
+        bool after = (position < length) && IsWordChar(subject[position]);
+        failed = ((before != after) != (code[pc] == kWordBoundary));
+        pc++;
+        break;
+      }
+      case kSplitNext:
+        if (stack->length() > kMaxStackLength) {
+          return kHitLimit;
+        }
+        stack->Push(pc + code[pc + 1]);
+        stack->Push(position);
+        pc += 2;
+        break;
+      case kSplitJump:
+        if (stack->length() > kMaxStackLength) {
+          return kHitLimit;
+        }
+        stack->Push(pc + 2);
+        stack->Push(position);
+        pc += code[pc + 1];
+        break;
+      case kJump:
+        pc += code[pc + 1];
+        break;
+      case kSave:
+        stack->Push(-1 - code[pc + 1]);
+        stack->Push(captures[code[pc + 1]]);
+        captures[code[pc + 1]] = position;
+        pc += 2;
+        break;
+      case kClearCaptures:
+        for (intptr_t r = code[pc + 1]; r < code[pc + 2]; r++) {
+          stack->Push(-1 - r);
+          stack->Push(captures[r]);
+          captures[r] = -1;
+        }
+        pc += 3;
+        break;
+      case kSetProgress:
+        // Progress registers are restored with negated indices past the
+        // capture registers, see below.
+        stack->Push(-1 - (kMaxCodeLength + code[pc + 1]));
+        stack->Push(progress[code[pc + 1]]);
+        progress[code[pc + 1]] = position;
+        pc += 2;
+        break;
+      case kCheckProgress:
+        failed = (progress[code[pc + 1]] == position);
+        pc += 2;
+        break;
+      default:
+        UNREACHABLE();
+    }
+    if (!failed) {
+      continue;
+    }
+    // Backtrack, restoring the registers on the way.
+    if (--(*backtrack_budget) < 0) {
+      return kHitLimit;
+    }
+    while (true) {
+      if (stack->is_empty()) {
+        return kNoMatch;
+      }
+      intptr_t value = stack->Pop();
+      intptr_t target = stack->Pop();
+      if (target >= 0) {
+        pc = target;
+        position = value;
+        break;
+      }
+      intptr_t index = -1 - target;
+      if (index < kMaxCodeLength) {
+        captures[index] = value;
+      } else {
+        progress[index - kMaxCodeLength] = value;
+      }
+    }
+  }
+}
+
+
+// Tries the start positions from start_index until a match is found. The
+// capture registers of the match are left in 'captures'.
+template<typename CharType>
+static RegExpMatchResult Match(const int32_t* data,
+                               const CharType* subject,
+                               intptr_t length,
+                               intptr_t start_index,
+                               intptr_t* captures,
+                               intptr_t* progress,
+                               RegExpStack* stack) {
+  const intptr_t capture_registers = 2 * data[kCaptureCountIndex];
+  const intptr_t progress_registers = data[kProgressCountIndex];
+  const int32_t* code = data + kHeaderSize;
+  // The first instruction saves the start of the match. Look at the next
+  // one for a pattern that is anchored or starts with a known character.
+  ASSERT(code[0] == kSave);
+  const int32_t first = code[2];
+  const bool anchored = (first == kAssertStart);
+  const int32_t first_char = (first == kChar) ? code[3] : -1;
+  intptr_t backtrack_budget = kBacktrackLimit;
+  for (intptr_t start = start_index; start <= length; start++) {
+    if (first_char >= 0) {
+      while ((start < length) &&
+             (static_cast<int32_t>(subject[start]) != first_char)) {
+        start++;
+      }
+      if (start == length) {
+        return kNoMatch;
+      }
+    }
+    for (intptr_t i = 0; i < capture_registers; i++) {
+      captures[i] = -1;
+    }
+    for (intptr_t i = 0; i < progress_registers; i++) {
+      progress[i] = -1;
+    }
+    RegExpMatchResult result = MatchAt(code, subject, length, start,
+                                       captures, progress, stack,
+                                       &backtrack_budget);
+    if ((result != kNoMatch) || anchored) {
+      return result;
+    }
+  }
+  return kNoMatch;
+}
+
+
+RegExpStack::RegExpStack()
+    : registers_(NULL),
+      register_capacity_(0),
+      data_(NULL),
+      length_(0),
+      capacity_(0) {
+}
+
+
+RegExpStack::~RegExpStack() {
+  free(registers_);
+  free(data_);
+}
+
+
+intptr_t* RegExpStack::Registers(intptr_t count) {
+  if (count > register_capacity_) {
+    register_capacity_ = Utils::RoundUpToPowerOfTwo(count);
+    free(registers_);
+    registers_ = reinterpret_cast<intptr_t*>(
+        malloc(register_capacity_ * sizeof(intptr_t)));
+  }
+  return registers_;
+}
+
+
+void RegExpStack::Grow() {
+  capacity_ = (capacity_ == 0) ? kInitialCapacity : (2 * capacity_);
+  data_ = reinterpret_cast<intptr_t*>(
+      realloc(data_, capacity_ * sizeof(intptr_t)));
+}
+
+
+void RegExpStack::Trim() {
+  length_ = 0;
+  if (capacity_ > kRetainedCapacity) {
+    capacity_ = kRetainedCapacity;
+    data_ = reinterpret_cast<intptr_t*>(
+        realloc(data_, capacity_ * sizeof(intptr_t)));
+  }
+}
+
+
+RawJSRegExp* BytecodeRegExp::Compile(const String& pattern,
+                                     bool multi_line,
+                                     bool ignore_case) {
+  GrowableArray<int32_t> pattern_chars(pattern.Length());
+  for (intptr_t i = 0; i < pattern.Length(); i++) {
+    pattern_chars.Add(pattern.CharAt(i));
+  }
+  GrowableArray<int32_t> code(64);
+  RegExpParser parser(pattern_chars, multi_line, ignore_case, &code);
+  if (!parser.Parse()) {
+    return JSRegExp::null();
+  }
+
+  const intptr_t size = (kHeaderSize + code.length()) * sizeof(int32_t);
+  const JSRegExp& regexp = JSRegExp::Handle(JSRegExp::New(size));
+  int32_t* data = reinterpret_cast<int32_t*>(regexp.GetDataStartAddress());
+  data[kCaptureCountIndex] = parser.capture_count();
+  data[kProgressCountIndex] = parser.progress_count();
+  data[kCodeLengthIndex] = code.length();
+  memmove(data + kHeaderSize, code.data(), code.length() * sizeof(int32_t));
+
+  regexp.set_pattern(pattern);
+  if (multi_line) {
+    regexp.set_is_multi_line();
+  }
+  if (ignore_case) {
+    regexp.set_is_ignore_case();
+  }
+  // A Dart regexp is always global.
+  regexp.set_is_global();
+  regexp.set_is_bytecode();
+  regexp.set_num_bracket_expressions(parser.capture_count() - 1);
+  return regexp.raw();
+}
+
+
+RawArray* BytecodeRegExp::Execute(const JSRegExp& regex,
+                                  const String& str,
+                                  intptr_t start_index) {
+  ASSERT(regex.is_bytecode());
+  const intptr_t length = str.Length();
+  if (start_index > length) {
+    return Array::null();
+  }
+  const intptr_t capture_count =
+      reinterpret_cast<int32_t*>(regex.GetDataStartAddress())[
+          kCaptureCountIndex];
+  const intptr_t progress_count =
+      reinterpret_cast<int32_t*>(regex.GetDataStartAddress())[
+          kProgressCountIndex];
+  // The registers and the backtracking stack of the isolate are reused for
+  // all the start positions. Match clears them.
+  RegExpStack* stack = Isolate::Current()->regexp_stack();
+  intptr_t* captures =
+      stack->Registers(2 * capture_count + progress_count);
+  intptr_t* progress = captures + 2 * capture_count;
+
+  // Match the characters of the string in place, without allocating in the
+  // Dart heap.
+  RegExpMatchResult result = kNoMatch;
+  if (length == 0) {
+    NoGCScope no_gc;
+    const int32_t* data =
+        reinterpret_cast<int32_t*>(regex.GetDataStartAddress());
+    const uint8_t* no_chars = NULL;
+    result = Match(data, no_chars, 0, start_index, captures, progress, stack);
+  } else if (str.IsOneByteString()) {
+    OneByteString& typed_str = OneByteString::Handle();
+    typed_str ^= str.raw();
+    NoGCScope no_gc;
+    const int32_t* data =
+        reinterpret_cast<int32_t*>(regex.GetDataStartAddress());
+    result = Match(data, typed_str.CharAddr(0), length, start_index,
+                   captures, progress, stack);
+  } else if (str.IsTwoByteString()) {
+    TwoByteString& typed_str = TwoByteString::Handle();
+    typed_str ^= str.raw();
+    NoGCScope no_gc;
+    const int32_t* data =
+        reinterpret_cast<int32_t*>(regex.GetDataStartAddress());
+    result = Match(data, typed_str.CharAddr(0), length, start_index,
+                   captures, progress, stack);
+  } else if (str.IsFourByteString()) {
+    FourByteString& typed_str = FourByteString::Handle();
+    typed_str ^= str.raw();
+    NoGCScope no_gc;
+    const int32_t* data =
+        reinterpret_cast<int32_t*>(regex.GetDataStartAddress());
+    result = Match(data, typed_str.CharAddr(0), length, start_index,
+                   captures, progress, stack);
+  } else if (str.IsExternalOneByteString()) {
+    ExternalOneByteString& typed_str = ExternalOneByteString::Handle();
+    typed_str ^= str.raw();
+    NoGCScope no_gc;
+    const int32_t* data =
+        reinterpret_cast<int32_t*>(regex.GetDataStartAddress());
+    result = Match(data, typed_str.CharAddr(0), length, start_index,
+                   captures, progress, stack);
+  } else if (str.IsExternalTwoByteString()) {
+    ExternalTwoByteString& typed_str = ExternalTwoByteString::Handle();
+    typed_str ^= str.raw();
+    NoGCScope no_gc;
+    const int32_t* data =
+        reinterpret_cast<int32_t*>(regex.GetDataStartAddress());
+    result = Match(data, typed_str.CharAddr(0), length, start_index,
+                   captures, progress, stack);
+  } else {
+    ASSERT(str.IsExternalFourByteString());
+    ExternalFourByteString& typed_str = ExternalFourByteString::Handle();
+    typed_str ^= str.raw();
+    NoGCScope no_gc;
+    const int32_t* data =
+        reinterpret_cast<int32_t*>(regex.GetDataStartAddress());
+    result = Match(data, typed_str.CharAddr(0), length, start_index,
+                   captures, progress, stack);
+  }
+  stack->Trim();
+  // Like jscre, a match that hits the backtracking limit fails.
+  if (result != kMatched) {
+    return Array::null();
+  }
+
+  const Array& array = Array::Handle(Array::New(2 * capture_count));
+  Smi& offset = Smi::Handle();
+  for (intptr_t i = 0; i < 2 * capture_count; i++) {
+    offset = Smi::New(captures[i]);
+    array.SetAt(i, offset);
+  }
+  return array.raw();
+}
+
+}  // namespace dart
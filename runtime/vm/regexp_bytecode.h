@@ -0,0 +1,84 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef VM_REGEXP_BYTECODE_H_
+#define VM_REGEXP_BYTECODE_H_
+
+#include "vm/allocation.h"
+#include "vm/object.h"
+
+namespace dart {
+
+// A backtracking regular expression engine for JSSyntaxRegExp patterns.
+// A pattern is compiled once to a bytecode kept in the data of its JSRegExp
+// object, which is then interpreted directly on the characters of the
+// subject string, whatever its representation. Matches follow ECMAScript
+// semantics.
+//
+// Patterns using back references, lookaheads or, when ignoring case,
+// non-ASCII characters are not compiled and are left to jscre.
+class BytecodeRegExp : public AllStatic {
+ public:
+  // Returns JSRegExp::null() if the pattern is invalid or not supported.
+  static RawJSRegExp* Compile(const String& pattern,
+                              bool multi_line,
+                              bool ignore_case);
+
+  // Like Jscre::Execute, returns null if there is no match at or after
+  // start_index. Otherwise returns the start and end of the match and of
+  // each group, -1 for the groups that did not participate in the match.
+  static RawArray* Execute(const JSRegExp& regex,
+                           const String& str,
+                           intptr_t start_index);
+};
+
+
+// The registers and the backtracking stack of BytecodeRegExp::Execute. The
+// isolate keeps one, reused by all matches, so that a match only allocates
+// when it needs more room than the matches before it. The room beyond
+// kRetainedCapacity words is released after each match.
+class RegExpStack {
+ public:
+  RegExpStack();
+  ~RegExpStack();
+
+  // Returns 'count' registers, valid until the next call.
+  intptr_t* Registers(intptr_t count);
+
+  intptr_t length() const { return length_; }
+  bool is_empty() const { return length_ == 0; }
+  void Clear() { length_ = 0; }
+
+  void Push(intptr_t value) {
+    if (length_ == capacity_) {
+      Grow();
+    }
+    data_[length_++] = value;
+  }
+  intptr_t Pop() {
+    ASSERT(length_ > 0);
+    return data_[--length_];
+  }
+
+  // Empties the stack and releases the room beyond kRetainedCapacity.
+  void Trim();
+
+ private:
+  static const intptr_t kInitialCapacity = 256;
+  static const intptr_t kRetainedCapacity = 64 * KB;
+
+  void Grow();
+
+  intptr_t* registers_;
+  intptr_t register_capacity_;
+  intptr_t* data_;
+  intptr_t length_;
+  intptr_t capacity_;
+
+  DISALLOW_COPY_AND_ASSIGN(RegExpStack);
+};
+
+}  // namespace dart
+
+#endif  // VM_REGEXP_BYTECODE_H_
@@ -0,0 +1,208 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "platform/assert.h"
+#include "vm/object.h"
+#include "vm/regexp_bytecode.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+// Returns the offsets of the match as "start,end start,end ...", "no match"
+// or "not compiled".
+static const char* Match(const char* pattern_chars,
+                         const String& subject,
+                         intptr_t start_index = 0,
+                         bool multi_line = false,
+                         bool ignore_case = false) {
+  const String& pattern = String::Handle(String::New(pattern_chars));
+  const JSRegExp& regexp = JSRegExp::Handle(
+      BytecodeRegExp::Compile(pattern, multi_line, ignore_case));
+  if (regexp.IsNull()) {
+    return "not compiled";
+  }
+  const Array& match = Array::Handle(
+      BytecodeRegExp::Execute(regexp, subject, start_index));
+  if (match.IsNull()) {
+    return "no match";
+  }
+  EXPECT_EQ(2 * (Smi::Value(regexp.num_bracket_expressions()) + 1),
+            match.Length());
+  char* buffer = reinterpret_cast<char*>(
+      Isolate::Current()->current_zone()->Allocate(match.Length() * 16));
+  intptr_t length = 0;
+  Smi& offset = Smi::Handle();
+  for (intptr_t i = 0; i < match.Length(); i += 2) {
+    offset ^= match.At(i);
+    const intptr_t start = offset.Value();
+    offset ^= match.At(i + 1);
+    length += OS::SNPrint(buffer + length, 16, "%s%d,%d",
+                          (i == 0) ? "" : " ", start, offset.Value());
+  }
+  return buffer;
+}
+
+
+static const char* Match(const char* pattern_chars,
+                         const char* subject_chars,
+                         intptr_t start_index = 0,
+                         bool multi_line = false,
+                         bool ignore_case = false) {
+  const String& subject = String::Handle(String::New(subject_chars));
+  return Match(pattern_chars, subject, start_index, multi_line, ignore_case);
+}
+
+
+TEST_CASE(BytecodeRegExpSimple) {
+  EXPECT_STREQ("0,0", Match("", ""));
+  EXPECT_STREQ("2,5", Match("cde", "abcdefcde"));
+  EXPECT_STREQ("6,9", Match("cde", "abcdefcde", 3));
+  EXPECT_STREQ("no match", Match("cde", "abcdefcde", 7));
+  EXPECT_STREQ("no match", Match("cde", "abcdefcde", 20));
+  EXPECT_STREQ("1,2", Match("b|cd", "abcd"));
+  EXPECT_STREQ("1,3", Match("cd|b", "acdb"));
+  EXPECT_STREQ("0,3", Match("a.c", "abc"));
+  EXPECT_STREQ("no match", Match("a.c", "a\nc"));
+  EXPECT_STREQ("3,5", Match("\\d\\d", "ab 12 34"));
+  EXPECT_STREQ("0,3", Match("\\w+", "ab_ c"));
+  EXPECT_STREQ("2,3", Match("\\s", "ab\tc"));
+  EXPECT_STREQ("1,2", Match("[^a-c]", "ad"));
+  EXPECT_STREQ("0,3", Match("[\\d-]+", "1-2x"));
+  EXPECT_STREQ("0,1", Match("\\x41", "AB"));
+  EXPECT_STREQ("1,2", Match("\\u0042", "AB"));
+}
+
+
+TEST_CASE(BytecodeRegExpQuantifiers) {
+  EXPECT_STREQ("0,4", Match("a*", "aaaa"));
+  EXPECT_STREQ("0,0", Match("a*?", "aaaa"));
+  EXPECT_STREQ("0,1", Match("a+?", "aaaa"));
+  EXPECT_STREQ("0,3", Match("a{3}", "aaaa"));
+  EXPECT_STREQ("0,2", Match("a{1,2}", "aaaa"));
+  EXPECT_STREQ("0,4", Match("a{2,}", "aaaa"));
+  EXPECT_STREQ("0,2", Match("a{2,}?", "aaaa"));
+  EXPECT_STREQ("0,6", Match("<.*>", "<a><b>"));
+  EXPECT_STREQ("0,3", Match("<.*?>", "<a><b>"));
+  // Optional iterations do not match the empty string.
+  EXPECT_STREQ("0,2 0,2", Match("(a*)*", "aab"));
+  EXPECT_STREQ("0,0", Match("(?:a?)*?", "aab"));
+  EXPECT_STREQ("0,1", Match("(?:b*a?\?)?", "ab"));
+}
+
+
+TEST_CASE(BytecodeRegExpGroups) {
+  EXPECT_STREQ("0,3 0,1 1,3", Match("(a)(bc)", "abc"));
+  EXPECT_STREQ("0,1 -1,-1 0,1", Match("(a)|(b)", "b"));
+  EXPECT_STREQ("0,4 3,4", Match("(?:a|b)*(c)", "abac"));
+  EXPECT_STREQ("0,3 2,3", Match("(\\w)*", "abc"));
+  EXPECT_STREQ("4,7 4,5 5,7", Match("(x)(\\d+)", "abc x12"));
+  // The captures of an atom are cleared at each of its iterations.
+  EXPECT_STREQ("0,2 -1,-1 1,2", Match("(?:(a)|(b))*", "ab"));
+}
+
+
+TEST_CASE(BytecodeRegExpAssertions) {
+  EXPECT_STREQ("0,1", Match("^a", "aba"));
+  EXPECT_STREQ("no match", Match("^b", "aba"));
+  EXPECT_STREQ("no match", Match("^a", "aba", 1));
+  EXPECT_STREQ("2,3", Match("a$", "aba"));
+  EXPECT_STREQ("no match", Match("^b", "a\nb"));
+  EXPECT_STREQ("2,3", Match("^b", "a\nb", 0, true));
+  EXPECT_STREQ("0,1", Match("a$", "a\nb", 0, true));
+  EXPECT_STREQ("5,8", Match("\\bcat\\b", "cats cat"));
+  EXPECT_STREQ("1,3", Match("\\Bat", "cat"));
+}
+
+
+TEST_CASE(BytecodeRegExpIgnoreCase) {
+  EXPECT_STREQ("no match", Match("abc", "xABC"));
+  EXPECT_STREQ("1,4", Match("abc", "xABC", 0, false, true));
+  EXPECT_STREQ("1,4", Match("[a-c]+", "xAbC", 0, false, true));
+  EXPECT_STREQ("0,1", Match("[^a]", "@", 0, false, true));
+  EXPECT_STREQ("no match", Match("[^a]", "A", 0, false, true));
+}
+
+
+TEST_CASE(BytecodeRegExpTwoByteSubject) {
+  const uint16_t kChars[] = { 'a', 0x3b1, 0x3b2, 0x2028, 'b', '1' };
+  const String& subject =
+      String::Handle(String::New(kChars, ARRAY_SIZE(kChars)));
+  EXPECT(subject.IsTwoByteString());
+  EXPECT_STREQ("1,3", Match("[\\u03b1-\\u03c9]+", subject));
+  EXPECT_STREQ("0,3", Match(".*", subject));
+  EXPECT_STREQ("4,5", Match("^b", subject, 0, true));
+  EXPECT_STREQ("5,6", Match("\\d", subject));
+}
+
+
+TEST_CASE(BytecodeRegExpNotCompiled) {
+  // Back references, lookaheads and invalid patterns are left to jscre.
+  EXPECT_STREQ("not compiled", Match("(a)\\1", "aa"));
+  EXPECT_STREQ("not compiled", Match("a(?=b)", "ab"));
+  EXPECT_STREQ("not compiled", Match("a(?!b)", "ab"));
+  EXPECT_STREQ("not compiled", Match("(a", "a"));
+  EXPECT_STREQ("not compiled", Match("a)", "a"));
+  EXPECT_STREQ("not compiled", Match("[b-a]", "a"));
+  EXPECT_STREQ("not compiled", Match("^*", "a"));
+  EXPECT_STREQ("not compiled", Match("\\u00e9", "a", 0, false, true));
+  EXPECT_STREQ("not compiled", Match("a{100000}", "a"));
+}
+
+
+TEST_CASE(BytecodeRegExpBacktrackLimit) {
+  // Exponential backtracking gives up like jscre, instead of hanging.
+  const intptr_t kLength = 40;
+  char subject[kLength + 2];
+  for (intptr_t i = 0; i < kLength; i++) {
+    subject[i] = 'a';
+  }
+  subject[kLength] = 'b';
+  subject[kLength + 1] = '\0';
+  EXPECT_STREQ("no match", Match("^(a|a)*$", subject));
+}
+
+
+TEST_CASE(BytecodeRegExpDeepStack) {
+  // Every iteration leaves choice points on the backtracking stack, which
+  // grows past the room kept between matches.
+  const intptr_t kLength = 100000;
+  char* subject = reinterpret_cast<char*>(
+      Isolate::Current()->current_zone()->Allocate(kLength + 2));
+  for (intptr_t i = 0; i < kLength; i++) {
+    subject[i] = 'a';
+  }
+  subject[kLength] = 'c';
+  subject[kLength + 1] = '\0';
+  EXPECT_STREQ("0,100001 99999,100000", Match("(a|b)*c", subject));
+  EXPECT_STREQ("0,100001 99999,100000", Match("(a|b)*c", subject));
+  EXPECT(Isolate::Current()->regexp_stack()->is_empty());
+}
+
+
+TEST_CASE(RegExpStack) {
+  RegExpStack* stack = new RegExpStack();
+  intptr_t* registers = stack->Registers(4);
+  registers[3] = 3;
+  // Registers are reused when there is room.
+  EXPECT(stack->Registers(2) == registers);
+  const intptr_t kCount = 256 * KB;
+  for (intptr_t i = 0; i < kCount; i++) {
+    stack->Push(i);
+  }
+  EXPECT_EQ(kCount, stack->length());
+  bool in_order = true;
+  for (intptr_t i = kCount - 1; i >= 0; i--) {
+    in_order = in_order && (stack->Pop() == i);
+  }
+  EXPECT(in_order);
+  EXPECT(stack->is_empty());
+  stack->Push(1);
+  stack->Trim();
+  EXPECT(stack->is_empty());
+  stack->Push(2);
+  EXPECT_EQ(2, stack->Pop());
+  delete stack;
+}
+
+}  // namespace dart
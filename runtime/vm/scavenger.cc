@@ -14,6 +14,35 @@
 
 namespace dart {
 
+DEFINE_FLAG(bool, adaptive_new_gen, true,
+            "Grow and shrink the semispaces based on the survival rate.");
+DEFINE_FLAG(bool, pretenure, false,
+            "Allocate instances of classes which mostly survive their first "
+            "scavenge directly in old space.");
+DEFINE_FLAG(int, pretenure_threshold, 80,
+            "Percentage of the allocated bytes of a class which need to "
+            "survive a scavenge for the class to be pretenured.");
+DEFINE_FLAG(int, tenure_age, 1,
+            "Number of scavenges an object has to survive in new space "
+            "before it is promoted, e.g. 0 promotes all survivors.");
+DEFINE_FLAG(bool, verify_remembered_set, false,
+            "Verify that all old space slots pointing into new space are "
+            "remembered in the store buffer before every scavenge.");
+
+// Semispace sizing when --adaptive_new_gen is enabled.
+static const intptr_t kInitialSemiSpaceSize = 1 * MB;
+static const intptr_t kMinSemiSpaceSize = 256 * KB;
+// Grow the semispaces if more than this percentage of the from space
+// survives, shrink them if less than kShrinkSurvivalRate percent survives.
+static const intptr_t kGrowSurvivalRate = 20;
+static const intptr_t kShrinkSurvivalRate = 5;
+// Only classes with at least this many bytes allocated since the last
+// scavenge are considered for pretenuring.
+static const intptr_t kPretenureMinAllocated = 64 * KB;
+// A pretenuring decision holds for this many scavenges, afterwards instances
+// are allocated in new space again so that their survival is measured anew.
+static const intptr_t kPretenureScavenges = 4;
+
 enum {
   kForwardingMask = 3,
   kNotForwarded = 1,  // Tagged pointer.
@@ -46,7 +75,9 @@ class ScavengerVisitor : public ObjectPointerVisitor {
   explicit ScavengerVisitor(Scavenger* scavenger)
       : scavenger_(scavenger),
         heap_(scavenger->heap_),
-        vm_heap_(Dart::vm_isolate()->heap()) {}
+        vm_heap_(Dart::vm_isolate()->heap()),
+        store_buffer_(scavenger->heap_->store_buffer()),
+        visiting_old_pointers_(false) {}
 
   void VisitPointers(RawObject** first, RawObject** last) {
     for (RawObject** current = first; current <= last; current++) {
@@ -54,9 +85,17 @@ class ScavengerVisitor : public ObjectPointerVisitor {
     }
   }
 
+  // Set while visiting slots which live in old space objects, i.e. slots from
+  // the store buffer or from promoted objects.
+  void set_visiting_old_pointers(bool value) { visiting_old_pointers_ = value; }
+
  private:
   void UpdateStoreBuffer(RawObject** p, RawObject* obj) {
-    // TODO(iposva): Implement store buffers.
+    // Old space slots which still refer to new space after this scavenge need
+    // to be remembered for the next one.
+    if (visiting_old_pointers_ && obj->IsNewObject()) {
+      store_buffer_->AddPointer(reinterpret_cast<uword>(p));
+    }
   }
 
   void ScavengePointer(RawObject** p) {
@@ -71,6 +110,9 @@ class ScavengerVisitor : public ObjectPointerVisitor {
     // below.
     // The scavenger is only interested in objects located in the from space.
     if (!scavenger_->from_->Contains(raw_addr)) {
+      // The slot might already have been updated to refer to a surviving
+      // object in the to space.
+      UpdateStoreBuffer(p, raw_obj);
       return;
     }
 
@@ -83,23 +125,21 @@ class ScavengerVisitor : public ObjectPointerVisitor {
       new_addr = ForwardedAddr(header);
     } else {
       intptr_t size = raw_obj->Size();
+      intptr_t age = raw_obj->GetAge();
       // Check whether object should be promoted.
-      if (scavenger_->survivor_end_ <= raw_addr) {
-        // Not a survivor of a previous scavenge. Just copy the object into the
-        // to space.
+      if (age < scavenger_->tenure_age_) {
+        // The object has not survived enough scavenges yet. Just copy the
+        // object into the to space.
         new_addr = scavenger_->TryAllocate(size);
       } else {
-        // TODO(iposva): Experiment with less aggressive promotion. For example
-        // a coin toss determines if an object is promoted or whether it should
-        // survive in this generation.
-        //
-        // This object is a survivor of a previous scavenge. Attempt to promote
+        // This object has survived tenure_age_ scavenges. Attempt to promote
         // the object.
         new_addr = heap_->TryAllocate(size, Heap::kOld);
         if (new_addr != 0) {
           // If promotion succeeded then we need to remember it so that it can
           // be traversed later.
           scavenger_->PushToPromotedStack(new_addr);
+          scavenger_->promoted_bytes_ += size;
         } else {
           // Promotion did not succeed. Copy into the to space instead.
           scavenger_->had_promotion_failure_ = true;
@@ -113,6 +153,13 @@ class ScavengerVisitor : public ObjectPointerVisitor {
       memmove(reinterpret_cast<void*>(new_addr),
               reinterpret_cast<void*>(raw_addr),
               size);
+      // Age the surviving object, the age is only used in new space.
+      RawObject* new_obj = RawObject::FromAddr(new_addr);
+      if (scavenger_->to_->Contains(new_addr)) {
+        new_obj->SetAge(Utils::Minimum(age + 1, RawObject::kMaxAge));
+      } else {
+        new_obj->SetAge(0);
+      }
       // Remember forwarding address.
       ForwardTo(raw_addr, new_addr);
     }
@@ -126,6 +173,8 @@ class ScavengerVisitor : public ObjectPointerVisitor {
   Scavenger* scavenger_;
   Heap* heap_;
   Heap* vm_heap_;
+  StoreBuffer* store_buffer_;
+  bool visiting_old_pointers_;
 
   DISALLOW_COPY_AND_ASSIGN(ScavengerVisitor);
 };
@@ -152,9 +201,46 @@ class ScavengerWeakVisitor : public HandleVisitor {
 };
 
 
+// Checks that every old space slot pointing into new space is remembered.
+class VerifyStoreBufferVisitor : public ObjectPointerVisitor {
+ public:
+  VerifyStoreBufferVisitor(Heap* heap, StoreBufferBlock* block)
+      : heap_(heap), store_buffer_(heap->store_buffer()), block_(block) {}
+
+  void VisitPointers(RawObject** first, RawObject** last) {
+    for (RawObject** current = first; current <= last; current++) {
+      RawObject* raw_obj = *current;
+      if (!raw_obj->IsHeapObject() || !raw_obj->IsNewObject()) {
+        continue;
+      }
+      uword slot = reinterpret_cast<uword>(current);
+      // Code is always scanned in full, its slots need not be remembered.
+      if (heap_->CodeContains(slot) || heap_->StubCodeContains(slot)) {
+        continue;
+      }
+      if (!store_buffer_->Contains(slot) && !block_->Contains(slot)) {
+        FATAL2("Missing write barrier: slot 0x%" PRIxPTR " refers to "
+               "new object 0x%" PRIxPTR, slot, reinterpret_cast<uword>(raw_obj));
+      }
+    }
+  }
+
+ private:
+  Heap* heap_;
+  StoreBuffer* store_buffer_;
+  StoreBufferBlock* block_;
+
+  DISALLOW_COPY_AND_ASSIGN(VerifyStoreBufferVisitor);
+};
+
+
 Scavenger::Scavenger(Heap* heap, intptr_t max_capacity, uword object_alignment)
     : heap_(heap),
+      tenure_age_(0),
       object_alignment_(object_alignment),
+      promoted_bytes_(0),
+      survival_(NULL),
+      survival_length_(0),
       count_(0),
       scavenging_(false) {
   // Allocate the virtual memory for this scavenge heap.
@@ -164,11 +250,16 @@ Scavenger::Scavenger(Heap* heap, intptr_t max_capacity, uword object_alignment)
   // Allocate the entire space at the beginning.
   space_->Commit(false);
 
-  // Setup the semi spaces.
+  // Setup the semi spaces. Each semispace starts at its half of the reserved
+  // space, the used part of a half is resized between scavenges.
   uword semi_space_size = space_->size() / 2;
   ASSERT((semi_space_size & (VirtualMemory::PageSize() - 1)) == 0);
+  if (FLAG_adaptive_new_gen) {
+    semi_space_size = Utils::Minimum(semi_space_size,
+                                     static_cast<uword>(kInitialSemiSpaceSize));
+  }
   to_ = new MemoryRegion(space_->address(), semi_space_size);
-  uword middle = space_->start() + semi_space_size;
+  uword middle = space_->start() + (space_->size() / 2);
   from_ = new MemoryRegion(reinterpret_cast<void*>(middle), semi_space_size);
 
   // Make sure that the two semi-spaces are aligned properly.
@@ -193,6 +284,114 @@ Scavenger::~Scavenger() {
   delete to_;
   delete from_;
   delete space_;
+  delete[] survival_;
+}
+
+
+MemoryRegion* Scavenger::NewSemiSpace(MemoryRegion* region, intptr_t size) {
+  if (static_cast<intptr_t>(region->size()) == size) {
+    return region;
+  }
+  MemoryRegion* result = new MemoryRegion(region->pointer(), size);
+  delete region;
+  return result;
+}
+
+
+void Scavenger::ResizeSemiSpaces(intptr_t used_before) {
+  intptr_t capacity = to_->size();
+  intptr_t survived = in_use() + promoted_bytes_;
+  intptr_t survival_rate = (used_before == 0) ? 0 :
+      (survived * 100) / used_before;
+  intptr_t new_capacity = capacity;
+  if (survival_rate > kGrowSurvivalRate) {
+    new_capacity = Utils::Minimum(capacity * 2, space_->size() / 2);
+  } else if (survival_rate < kShrinkSurvivalRate) {
+    // The survivors stay where they are, keep room for them.
+    intptr_t used = Utils::RoundUp(static_cast<intptr_t>(top_ - to_->start()),
+                                   VirtualMemory::PageSize());
+    new_capacity = Utils::Maximum(capacity / 2, kMinSemiSpaceSize);
+    new_capacity = Utils::Maximum(new_capacity, used);
+  }
+  if (FLAG_verbose_gc) {
+    OS::PrintErr("Scavenge[%d]: survived %d%% (%dK of %dK, %dK promoted), "
+                 "semispace %dK -> %dK\n",
+                 count_, survival_rate, survived / KB, used_before / KB,
+                 promoted_bytes_ / KB, capacity / KB, new_capacity / KB);
+  }
+  if (new_capacity != capacity) {
+    // The from space is resized in the next prologue.
+    to_ = NewSemiSpace(to_, new_capacity);
+    end_ = to_->end();
+  }
+}
+
+
+void Scavenger::RecordAllocation(intptr_t class_index,
+                                 intptr_t size,
+                                 bool survived) {
+  if (class_index >= survival_length_) {
+    intptr_t new_length = Utils::RoundUpToPowerOfTwo(class_index + 1);
+    ClassSurvival* new_survival = new ClassSurvival[new_length];
+    memset(new_survival, 0, new_length * sizeof(new_survival[0]));
+    if (survival_ != NULL) {
+      memmove(new_survival, survival_,
+              survival_length_ * sizeof(survival_[0]));
+      delete[] survival_;
+    }
+    survival_ = new_survival;
+    survival_length_ = new_length;
+  }
+  survival_[class_index].allocated += size;
+  if (survived) {
+    survival_[class_index].survived += size;
+  }
+}
+
+
+void Scavenger::UpdatePretenuring(uword from_top) {
+  // Walk the objects allocated since the previous scavenge. Objects which
+  // survived have been forwarded, the headers of dead objects are intact.
+  uword cur = survivor_end_;
+  while (cur < from_top) {
+    uword header = *reinterpret_cast<uword*>(cur);
+    RawObject* raw_obj = RawObject::FromAddr(cur);
+    bool survived = IsForwarding(header);
+    if (survived) {
+      raw_obj = RawObject::FromAddr(ForwardedAddr(header));
+    }
+    intptr_t size = raw_obj->Size();
+    // Only instances of Dart classes are allocated by the runtime entries
+    // which consult the pretenuring decision. Instances of VM classes such as
+    // arrays come from many unrelated allocation sites.
+    intptr_t class_index = raw_obj->GetClassIndex();
+    if (class_index >= kNumPredefinedKinds) {
+      RecordAllocation(class_index, size, survived);
+    }
+    cur += size;
+  }
+  for (intptr_t i = kNumPredefinedKinds; i < survival_length_; i++) {
+    ClassSurvival* entry = &survival_[i];
+    if (entry->pretenure_scavenges > 0) {
+      entry->pretenure_scavenges--;
+      if ((entry->pretenure_scavenges == 0) && FLAG_verbose_gc) {
+        OS::PrintErr("Scavenge[%d]: no longer pretenuring class %" Pd "\n",
+                     count_, i);
+      }
+    } else if (entry->allocated >= kPretenureMinAllocated) {
+      intptr_t survival_rate = (entry->survived * 100) / entry->allocated;
+      if (survival_rate >= FLAG_pretenure_threshold) {
+        entry->pretenure_scavenges = kPretenureScavenges;
+        if (FLAG_verbose_gc) {
+          OS::PrintErr("Scavenge[%d]: pretenuring class %" Pd ", "
+                       "%" Pd "%% of %" Pd "K survived\n",
+                       count_, i, survival_rate, entry->allocated / KB);
+        }
+      }
+    }
+    entry->allocated = 0;
+    entry->survived = 0;
+  }
 }
 
 
@@ -204,14 +403,25 @@ void Scavenger::Prologue(Isolate* isolate, bool invoke_api_callbacks) {
   // objects.
   MemoryRegion* temp = from_;
   from_ = to_;
-  to_ = temp;
+  to_ = NewSemiSpace(temp, from_->size());
   top_ = FirstObjectStart();
+  promoted_bytes_ = 0;
+  tenure_age_ = Utils::Minimum(Utils::Maximum(FLAG_tenure_age, 0),
+                               static_cast<int>(RawObject::kMaxAge));
   resolved_top_ = top_;
   end_ = to_->end();
 }
 
 
-void Scavenger::Epilogue(Isolate* isolate, bool invoke_api_callbacks) {
+void Scavenger::Epilogue(Isolate* isolate,
+                         bool invoke_api_callbacks,
+                         uword from_top) {
+  if (FLAG_pretenure) {
+    UpdatePretenuring(from_top);
+  }
+  if (FLAG_adaptive_new_gen) {
+    ResizeSemiSpaces(from_top - (from_->start() | object_alignment_));
+  }
   // All objects in the to space have been copied from the from space at this
   // moment.
   survivor_end_ = top_;
@@ -225,13 +435,39 @@ void Scavenger::Epilogue(Isolate* isolate, bool invoke_api_callbacks) {
 }
 
 
+void Scavenger::VerifyStoreBuffer(Isolate* isolate) {
+  VerifyStoreBufferVisitor visitor(heap_, isolate->store_buffer());
+  heap_->IterateOldPointers(&visitor);
+}
+
+
+void Scavenger::IterateStoreBuffers(Isolate* isolate,
+                                    ScavengerVisitor* visitor) {
+  // Move the pending entries of the isolate local block into the heap wide
+  // store buffer and visit all remembered slots. Slots which still refer to
+  // new space objects are added back by the visitor.
+  isolate->store_buffer()->ProcessBuffer();
+  intptr_t remembered = heap_->store_buffer()->Count();
+  visitor->set_visiting_old_pointers(true);
+  heap_->store_buffer()->VisitAndReset(visitor);
+  visitor->set_visiting_old_pointers(false);
+  if (FLAG_verbose_gc) {
+    OS::PrintErr("Scavenge[%d]: store buffer %d slots\n", count_, remembered);
+  }
+}
+
+
 void Scavenger::IterateRoots(Isolate* isolate,
-                             ObjectPointerVisitor* visitor,
+                             ScavengerVisitor* visitor,
                              bool visit_prologue_weak_persistent_handles) {
   isolate->VisitObjectPointers(visitor,
                                visit_prologue_weak_persistent_handles,
                                StackFrameIterator::kDontValidateFrames);
-  heap_->IterateOldPointers(visitor);
+  IterateStoreBuffers(isolate, visitor);
+  // Code objects get patched without going through the write barrier. The
+  // code spaces are small, scan them completely.
+  heap_->IterateCodePointers(visitor);
+  heap_->IterateStubCodePointers(visitor);
 }
 
 
@@ -258,7 +494,7 @@ bool Scavenger::IsUnreachable(RawObject** p) {
 
 
 void Scavenger::IterateWeakReferences(Isolate* isolate,
-                                      ObjectPointerVisitor* visitor) {
+                                      ScavengerVisitor* visitor) {
   ApiState* state = isolate->api_state();
   ASSERT(state != NULL);
   while (true) {
@@ -317,13 +553,16 @@ void Scavenger::IterateWeakRoots(Isolate* isolate,
 }
 
 
-void Scavenger::ProcessToSpace(ObjectPointerVisitor* visitor) {
+void Scavenger::ProcessToSpace(ScavengerVisitor* visitor) {
   // Iterate until all work has been drained.
   while ((resolved_top_ < top_) || PromotedStackHasMore()) {
     while (resolved_top_ < top_) {
       RawObject* raw_obj = RawObject::FromAddr(resolved_top_);
       resolved_top_ += raw_obj->VisitPointers(visitor);
     }
+    // Promoted objects live in old space now, their slots referring to
+    // objects remaining in new space have to be remembered.
+    visitor->set_visiting_old_pointers(true);
     while (PromotedStackHasMore()) {
       RawObject* raw_object = RawObject::FromAddr(PopFromPromotedStack());
       // Resolve or copy all objects referred to by the current object. This
@@ -331,6 +570,7 @@ void Scavenger::ProcessToSpace(ObjectPointerVisitor* visitor) {
       // objects to be resolved in the to space.
       raw_object->VisitPointers(visitor);
     }
+    visitor->set_visiting_old_pointers(false);
   }
 }
 
@@ -364,17 +604,24 @@ void Scavenger::Scavenge(bool invoke_api_callbacks) {
     OS::PrintErr(" done.\n");
   }
 
+  if (FLAG_verify_remembered_set) {
+    OS::PrintErr("Verifying remembered set before Scavenge... ");
+    VerifyStoreBuffer(isolate);
+    OS::PrintErr(" done.\n");
+  }
+
   Timer timer(FLAG_verbose_gc, "Scavenge");
   timer.Start();
   // Setup the visitor and run a scavenge.
   ScavengerVisitor visitor(this);
+  uword from_top = top_;
   Prologue(isolate, invoke_api_callbacks);
   IterateRoots(isolate, &visitor, !invoke_api_callbacks);
   ProcessToSpace(&visitor);
   IterateWeakReferences(isolate, &visitor);
   ScavengerWeakVisitor weak_visitor(this);
   IterateWeakRoots(isolate, &weak_visitor, invoke_api_callbacks);
-  Epilogue(isolate, invoke_api_callbacks);
+  Epilogue(isolate, invoke_api_callbacks, from_top);
   timer.Stop();
   if (FLAG_verbose_gc) {
     OS::PrintErr("Scavenge[%d]: %dus\n", count_, timer.TotalElapsedTime());
@@ -18,8 +18,11 @@ namespace dart {
 // Forward declarations.
 class Heap;
 class Isolate;
+class ScavengerVisitor;
 
 DECLARE_FLAG(bool, gc_at_alloc);
+DECLARE_FLAG(bool, pretenure);
+DECLARE_FLAG(bool, verify_remembered_set);
 
 class Scavenger {
  public:
@@ -69,24 +72,58 @@ class Scavenger {
   static intptr_t end_offset() { return OFFSET_OF(Scavenger, end_); }
 
   intptr_t in_use() const { return (top_ - FirstObjectStart()); }
+  intptr_t capacity() const { return to_->size(); }
+  int collections() const { return count_; }
+
+  // Returns true if instances of the class with the given index survived their
+  // first scavenge often enough recently that they should be allocated in old
+  // space.
+  bool ShouldPretenure(intptr_t class_index) const {
+    return (class_index < survival_length_) &&
+        (survival_[class_index].pretenure_scavenges > 0);
+  }
+
+  // Accessors for the pretenuring decisions checked by allocation stubs: the
+  // table of per class statistics moves when it grows, its address does not.
+  uword* PretenureTableAddress() {
+    return reinterpret_cast<uword*>(&survival_);
+  }
+  intptr_t* PretenureLengthAddress() { return &survival_length_; }
+  static intptr_t pretenure_offset(intptr_t class_index) {
+    return (class_index * sizeof(ClassSurvival)) +
+        OFFSET_OF(ClassSurvival, pretenure_scavenges);
+  }
 
   void VisitObjectPointers(ObjectPointerVisitor* visitor) const;
 
  private:
   uword FirstObjectStart() const { return to_->start() | object_alignment_; }
   void Prologue(Isolate* isolate, bool invoke_api_callbacks);
+  void IterateStoreBuffers(Isolate* isolate, ScavengerVisitor* visitor);
   void IterateRoots(Isolate* isolate,
-                    ObjectPointerVisitor* visitor,
+                    ScavengerVisitor* visitor,
                     bool visit_prologue_weak_persistent_handles);
-  void IterateWeakReferences(Isolate* isolate, ObjectPointerVisitor* visitor);
+  void IterateWeakReferences(Isolate* isolate, ScavengerVisitor* visitor);
   void IterateWeakRoots(Isolate* isolate,
                         HandleVisitor* visitor,
                         bool visit_prologue_weak_persistent_handles);
-  void ProcessToSpace(ObjectPointerVisitor* visitor);
-  void Epilogue(Isolate* isolate, bool invoke_api_callbacks);
+  void ProcessToSpace(ScavengerVisitor* visitor);
+  void Epilogue(Isolate* isolate, bool invoke_api_callbacks, uword from_top);
+
+  // Size the semispaces for the next scavenge based on the fraction of the
+  // from space which survived this scavenge.
+  void ResizeSemiSpaces(intptr_t used_before);
+  MemoryRegion* NewSemiSpace(MemoryRegion* region, intptr_t size);
+
+  // Attribute the objects allocated since the last scavenge to their classes
+  // and select classes for pretenuring.
+  void UpdatePretenuring(uword from_top);
+  void RecordAllocation(intptr_t class_index, intptr_t size, bool survived);
 
   bool IsUnreachable(RawObject** p);
 
+  void VerifyStoreBuffer(Isolate* isolate);
+
   // During a scavenge we need to remember the promoted objects.
   // This is implemented as a stack of objects at the end of the to space. As
   // object sizes are always greater than sizeof(uword) and promoted objects do
@@ -124,9 +161,27 @@ class Scavenger {
   // Objects below this address have survived a scavenge.
   uword survivor_end_;
 
+  // Objects which survived this many scavenges are promoted, set from
+  // --tenure_age at the start of each scavenge.
+  intptr_t tenure_age_;
+
   // All object are aligned to this value.
   uword object_alignment_;
 
+  // Bytes promoted to old space during the current scavenge.
+  intptr_t promoted_bytes_;
+
+  // Per class allocation and survival statistics, indexed by class index.
+  struct ClassSurvival {
+    intptr_t allocated;
+    intptr_t survived;
+    // Number of scavenges for which instances are still allocated in old
+    // space, zero if the class is not pretenured.
+    intptr_t pretenure_scavenges;
+  };
+  ClassSurvival* survival_;
+  intptr_t survival_length_;
+
   // Scavenge cycle count.
   int count_;
   // Keep track whether a scavenge is currently running.
@@ -193,13 +193,6 @@ RawTypeArguments* SnapshotReader::NewTypeArguments(intptr_t len) {
 }
 
 
-RawTokenStream* SnapshotReader::NewTokenStream(intptr_t len) {
-  ALLOC_NEW_OBJECT_WITH_LEN(TokenStream,
-                            Object::token_stream_class(),
-                            len);
-}
-
-
 RawContext* SnapshotReader::NewContext(intptr_t num_variables) {
   ASSERT(kind_ == Snapshot::kFull);
   ASSERT(isolate()->no_gc_scope_depth() != 0);
@@ -325,6 +318,11 @@ RawLiteralToken* SnapshotReader::NewLiteralToken() {
 }
 
 
+RawTokenStream* SnapshotReader::NewTokenStream() {
+  ALLOC_NEW_OBJECT(TokenStream, Object::token_stream_class());
+}
+
+
 RawGrowableObjectArray* SnapshotReader::NewGrowableObjectArray() {
   ALLOC_NEW_OBJECT(GrowableObjectArray,
                    object_store()->growable_object_array_class());
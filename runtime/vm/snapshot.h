@@ -362,7 +362,6 @@ class SnapshotReader : public BaseReader {
   RawTwoByteString* NewTwoByteString(intptr_t len);
   RawFourByteString* NewFourByteString(intptr_t len);
   RawTypeArguments* NewTypeArguments(intptr_t len);
-  RawTokenStream* NewTokenStream(intptr_t len);
   RawContext* NewContext(intptr_t num_variables);
   RawClass* NewClass(int value);
   RawMint* NewMint(int64_t value);
@@ -377,6 +376,7 @@ class SnapshotReader : public BaseReader {
   RawLibraryPrefix* NewLibraryPrefix();
   RawScript* NewScript();
   RawLiteralToken* NewLiteralToken();
+  RawTokenStream* NewTokenStream();
   RawGrowableObjectArray* NewGrowableObjectArray();
 
  private:
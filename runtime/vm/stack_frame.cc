@@ -4,6 +4,7 @@
 
 #include "vm/stack_frame.h"
 
+#include "vm/code_index_table.h"
 #include "vm/isolate.h"
 #include "vm/object.h"
 #include "vm/object_store.h"
@@ -14,11 +15,6 @@
 
 namespace dart {
 
-bool StackFrame::FindRawCodeVisitor::FindObject(RawObject* obj) {
-  return RawInstructions::ContainsPC(obj, pc_);
-}
-
-
 bool StackFrame::IsStubFrame() const {
   if (Dart::vm_isolate()->heap()->StubCodeContains(pc())) {
     return true;  // Common stub code is generated in the VM heap.
@@ -36,16 +32,13 @@ void StackFrame::Print() const {
 
 
 RawCode* StackFrame::LookupCode(Isolate* isolate, uword pc) {
-  // TODO(asiva): Need to add a data structure for storing a (pc, code
-  // object) map in order to do a quick lookup and avoid having to
-  // traverse the code heap.
   ASSERT(isolate != NULL);
   // We add a no gc scope to ensure that the code below does not trigger
   // a GC as we are handling raw object references here. It is possible
   // that the code is called while a GC is in progress, that is ok.
   NoGCScope no_gc;
-  FindRawCodeVisitor visitor(pc);
-  RawInstructions* instr = isolate->heap()->FindObjectInCodeSpace(&visitor);
+  RawInstructions* instr =
+      isolate->code_index_table()->LookupInstructions(pc);
   if (instr != Instructions::null()) {
     return instr->ptr()->code_;
   }
@@ -79,10 +72,11 @@ void StackFrame::VisitObjectPointers(ObjectPointerVisitor* visitor) {
   Code code;
   code = LookupDartCode();
   if (!code.IsNull()) {
+    Uint32Array index;
     Array maps;
     maps = Array::null();
     Stackmap map;
-    map = code.GetStackmap(pc(), &maps, &map);
+    map = code.GetStackmap(pc(), &index, &maps, &map);
     if (!map.IsNull()) {
       // A stack map is present in the code object, use the stack map to visit
       // frame slots which are marked as having objects.
@@ -96,6 +90,14 @@ void StackFrame::VisitObjectPointers(ObjectPointerVisitor* visitor) {
         }
         bit_offset += 1;
       }
+      // The stack map describes the fixed part of the frame, up to its last
+      // object slot.  The slots below hold the expression stack and the
+      // outgoing arguments, which are always tagged.
+      uword last = fp() - ((end_bit_offset + 2) * kWordSize);
+      if (last >= sp()) {
+        visitor->VisitPointers(reinterpret_cast<RawObject**>(sp()),
+                               reinterpret_cast<RawObject**>(last));
+      }
       return;
     }
   }
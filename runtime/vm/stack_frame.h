@@ -64,21 +64,6 @@ class StackFrame : public ValueObject {
   virtual const char* GetName() const { return IsStubFrame()? "stub" : "dart"; }
 
  private:
-  // An object finder visitor interface.
-  class FindRawCodeVisitor : public FindObjectVisitor {
-   public:
-    explicit FindRawCodeVisitor(uword pc) : pc_(pc) { }
-    virtual ~FindRawCodeVisitor() { }
-
-    // Check if object matches find condition.
-    virtual bool FindObject(RawObject* obj);
-
-   private:
-    uword pc_;
-
-    DISALLOW_COPY_AND_ASSIGN(FindRawCodeVisitor);
-  };
-
   // Target specific implementations for locating pc and caller fp/sp values.
   static intptr_t PcAddressOffsetFromSp();
   uword GetCallerSp() const;
@@ -5,12 +5,127 @@
 #include "vm/store_buffer.h"
 
 #include "platform/assert.h"
+#include "vm/heap.h"
+#include "vm/isolate.h"
+#include "vm/visitor.h"
 
 namespace dart {
 
 void StoreBufferBlock::ProcessBuffer() {
-  // TODO(iposva): Do the right thing for store buffer overflow.
-  top_ = 0;  // Currently just reset back to the beginning.
+  StoreBuffer* store_buffer = Isolate::Current()->heap()->store_buffer();
+  for (int32_t i = 0; i < top_; i++) {
+    store_buffer->AddPointer(pointers_[i]);
+  }
+  top_ = 0;
+}
+
+
+bool StoreBufferBlock::Contains(uword pointer) const {
+  for (int32_t i = 0; i < top_; i++) {
+    if (pointers_[i] == pointer) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+StoreBuffer::StoreBuffer()
+    : entries_(new uword[kInitialCapacity]),
+      capacity_(kInitialCapacity),
+      count_(0) {
+  memset(entries_, 0, capacity_ * sizeof(entries_[0]));
+}
+
+
+StoreBuffer::~StoreBuffer() {
+  delete[] entries_;
+}
+
+
+void StoreBuffer::AddPointer(uword pointer) {
+  ASSERT(pointer != 0);
+  intptr_t mask = capacity_ - 1;
+  intptr_t index = Hash(pointer) & mask;
+  while (entries_[index] != 0) {
+    if (entries_[index] == pointer) {
+      return;
+    }
+    index = (index + 1) & mask;
+  }
+  entries_[index] = pointer;
+  count_++;
+  // Keep the load factor below 1/2 to keep the probe sequences short.
+  if ((count_ * 2) > capacity_) {
+    Rehash(capacity_ * 2);
+  }
+}
+
+
+bool StoreBuffer::Contains(uword pointer) const {
+  intptr_t mask = capacity_ - 1;
+  intptr_t index = Hash(pointer) & mask;
+  while (entries_[index] != 0) {
+    if (entries_[index] == pointer) {
+      return true;
+    }
+    index = (index + 1) & mask;
+  }
+  return false;
+}
+
+
+void StoreBuffer::AddAll(const StoreBuffer& other) {
+  for (intptr_t i = 0; i < other.capacity_; i++) {
+    if (other.entries_[i] != 0) {
+      AddPointer(other.entries_[i]);
+    }
+  }
+}
+
+
+void StoreBuffer::Rehash(intptr_t new_capacity) {
+  ASSERT(Utils::IsPowerOfTwo(new_capacity));
+  uword* old_entries = entries_;
+  intptr_t old_capacity = capacity_;
+  entries_ = new uword[new_capacity];
+  capacity_ = new_capacity;
+  count_ = 0;
+  memset(entries_, 0, capacity_ * sizeof(entries_[0]));
+  for (intptr_t i = 0; i < old_capacity; i++) {
+    if (old_entries[i] != 0) {
+      AddPointer(old_entries[i]);
+    }
+  }
+  delete[] old_entries;
+}
+
+
+void StoreBuffer::VisitAndReset(ObjectPointerVisitor* visitor) {
+  // Detach the current table, the visitor repopulates a fresh one.
+  uword* entries = entries_;
+  intptr_t capacity = capacity_;
+  entries_ = new uword[kInitialCapacity];
+  capacity_ = kInitialCapacity;
+  count_ = 0;
+  memset(entries_, 0, capacity_ * sizeof(entries_[0]));
+  for (intptr_t i = 0; i < capacity; i++) {
+    if (entries[i] != 0) {
+      visitor->VisitPointer(reinterpret_cast<RawObject**>(entries[i]));
+    }
+  }
+  delete[] entries;
+}
+
+
+void StoreBuffer::Reset() {
+  if (capacity_ != kInitialCapacity) {
+    delete[] entries_;
+    entries_ = new uword[kInitialCapacity];
+    capacity_ = kInitialCapacity;
+  }
+  count_ = 0;
+  memset(entries_, 0, capacity_ * sizeof(entries_[0]));
 }
 
 }  // namespace dart
@@ -10,6 +10,9 @@
 
 namespace dart {
 
+// Forward declarations.
+class ObjectPointerVisitor;
+
 class StoreBufferBlock {
  public:
   // Each block contains kSize pointers.
@@ -35,11 +38,57 @@ class StoreBufferBlock {
   // Process this store buffer and remember its contents in the heap.
   void ProcessBuffer();
 
+  // Drop all pointers recorded in this block without processing them.
+  void Reset() { top_ = 0; }
+
+  bool Contains(uword pointer) const;
+
  private:
   int32_t top_;
   uword pointers_[kSize];
 };
 
+
+// The StoreBuffer is the remembered set of the heap: it holds the addresses of
+// all slots in old space objects which might point into new space. Entries
+// are deduplicated so that every slot is visited at most once per scavenge.
+class StoreBuffer {
+ public:
+  StoreBuffer();
+  ~StoreBuffer();
+
+  void AddPointer(uword pointer);
+  bool Contains(uword pointer) const;
+
+  intptr_t Count() const { return count_; }
+
+  // Add all slots remembered in 'other' to this store buffer.
+  void AddAll(const StoreBuffer& other);
+
+  // Visit all remembered slots and clear the store buffer. The visitor is
+  // expected to add back the slots which still point into new space.
+  void VisitAndReset(ObjectPointerVisitor* visitor);
+
+  // Drop all remembered slots.
+  void Reset();
+
+ private:
+  static const intptr_t kInitialCapacity = 1024;
+
+  static intptr_t Hash(uword pointer) {
+    return static_cast<intptr_t>((pointer >> kWordSizeLog2) * 0x9E3779B1U);
+  }
+
+  void Rehash(intptr_t new_capacity);
+
+  // Open addressed hash table of slot addresses, 0 marks an empty entry.
+  uword* entries_;
+  intptr_t capacity_;
+  intptr_t count_;
+
+  DISALLOW_COPY_AND_ASSIGN(StoreBuffer);
+};
+
 }  // namespace dart
 
 #endif  // VM_STORE_BUFFER_H_
@@ -0,0 +1,74 @@
+// Copyright (c) 2012, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "platform/assert.h"
+#include "vm/heap.h"
+#include "vm/object.h"
+#include "vm/store_buffer.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+class CountingVisitor : public ObjectPointerVisitor {
+ public:
+  CountingVisitor() : count_(0) {}
+
+  void VisitPointers(RawObject** first, RawObject** last) {
+    count_ += (last - first) + 1;
+  }
+
+  intptr_t count() const { return count_; }
+
+ private:
+  intptr_t count_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingVisitor);
+};
+
+
+UNIT_TEST_CASE(StoreBuffer) {
+  StoreBuffer* store_buffer = new StoreBuffer();
+  const intptr_t kNumSlots = 5000;
+  uword slots[kNumSlots];
+  for (intptr_t i = 0; i < kNumSlots; i++) {
+    store_buffer->AddPointer(reinterpret_cast<uword>(&slots[i]));
+  }
+  EXPECT_EQ(kNumSlots, store_buffer->Count());
+  // Entries are deduplicated.
+  for (intptr_t i = 0; i < kNumSlots; i++) {
+    store_buffer->AddPointer(reinterpret_cast<uword>(&slots[i]));
+  }
+  EXPECT_EQ(kNumSlots, store_buffer->Count());
+  for (intptr_t i = 0; i < kNumSlots; i++) {
+    EXPECT(store_buffer->Contains(reinterpret_cast<uword>(&slots[i])));
+  }
+  uword other = 0;
+  EXPECT(!store_buffer->Contains(reinterpret_cast<uword>(&other)));
+  // Visiting drains the store buffer.
+  CountingVisitor visitor;
+  store_buffer->VisitAndReset(&visitor);
+  EXPECT_EQ(kNumSlots, visitor.count());
+  EXPECT_EQ(0, store_buffer->Count());
+  delete store_buffer;
+}
+
+
+TEST_CASE(StoreBufferOldToNew) {
+  Heap* heap = Isolate::Current()->heap();
+  const Array& old_array = Array::Handle(Array::New(1, Heap::kOld));
+  const String& new_string = String::Handle(String::New("new", Heap::kNew));
+  old_array.SetAt(0, new_string);
+  // The store has to be remembered for the string to survive a scavenge.
+  FLAG_verify_remembered_set = true;
+  heap->CollectGarbage(Heap::kNew);
+  heap->CollectGarbage(Heap::kNew);
+  FLAG_verify_remembered_set = false;
+  String& result = String::Handle();
+  result ^= old_array.At(0);
+  EXPECT(result.Equals("new"));
+  // After the string has been promoted nothing needs to be remembered.
+  EXPECT(result.raw()->IsOldObject());
+}
+
+}  // namespace dart
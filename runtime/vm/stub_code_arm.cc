@@ -21,6 +21,11 @@ void StubCode::GenerateStubCallToRuntimeStub(Assembler* assembler) {
 }
 
 
+void StubCode::GenerateUpdateStoreBufferStub(Assembler* assembler) {
+  __ Unimplemented("UpdateStoreBuffer stub");
+}
+
+
 void StubCode::GenerateCallNativeCFunctionStub(Assembler* assembler) {
   __ Unimplemented("CallNativeCFunction stub");
 }
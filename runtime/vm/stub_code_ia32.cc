@@ -92,6 +92,53 @@ static void PrintStopMessage(const char* message) {
 }
 
 
+// Remember the address of a slot in an old object which was made to refer to
+// a new object.
+static void UpdateStoreBuffer(uword slot) {
+  Isolate::Current()->store_buffer()->AddPointer(slot);
+}
+
+
+// Called from the write barrier emitted by Assembler::StoreIntoObject.
+// Input parameters:
+//   ESP : points to return address.
+//   ESP + 4 : address of the updated slot.
+// Must preserve all registers.
+void StubCode::GenerateUpdateStoreBufferStub(Assembler* assembler) {
+  // Preserve caller-saved registers.
+  __ pushl(EAX);
+  __ pushl(ECX);
+  __ pushl(EDX);
+
+  __ EnterFrame(0);
+
+  // Load the slot address passed above the saved registers and the return
+  // address.
+  __ movl(EAX, Address(EBP, 5 * kWordSize));
+
+  // Reserve space for the native argument and align frame before entering
+  // the C++ world.
+  __ AddImmediate(ESP, Immediate(-kWordSize));
+  if (OS::ActivationFrameAlignment() > 0) {
+    __ andl(ESP, Immediate(~(OS::ActivationFrameAlignment() - 1)));
+  }
+
+  // Pass argument and call native function.
+  __ movl(Address(ESP, 0), EAX);
+  __ movl(EAX, Immediate(reinterpret_cast<uword>(&UpdateStoreBuffer)));
+  __ call(EAX);
+
+  __ LeaveFrame();
+
+  // Restore caller-saved registers.
+  __ popl(EDX);
+  __ popl(ECX);
+  __ popl(EAX);
+
+  __ ret();
+}
+
+
 // Input parameters:
 //   ESP : points to return address.
 //   EAX : stop message (const char*).
@@ -265,7 +312,8 @@ void StubCode::GenerateFixCallersTargetStub(Assembler* assembler) {
 }
 
 
-// Lookup for [function-name, arg count] in 'functions_map_'.
+// Lookup for [class, function-name, arg count] in the megamorphic cache
+// table of the isolate.
 // Input parameters (to be treated as read only, unless calling to target!):
 //   ECX: ic-data.
 //   EDX: arguments descriptor array (num_args is first Smi element).
@@ -303,46 +351,71 @@ static void MegamorphicLookup(Assembler* assembler) {
   __ Bind(&class_in_eax);
   // Class is in EAX.
 
-  Label loop, next_iteration;
-  // Get functions_cache, since it is allocated lazily it maybe null.
-  __ movl(EAX, FieldAddress(EAX, Class::functions_cache_offset()));
-  // Iterate and search for identical name.
-  __ leal(EBX, FieldAddress(EAX, Array::data_offset()));
-
-  // EBX is  pointing into content of functions_map_ array.
-  __ Bind(&loop);
-  __ movl(EDI, Address(EBX, FunctionsCache::kFunctionName * kWordSize));
-
-  __ cmpl(EDI, raw_null);
-  __ j(EQUAL, &not_found, Assembler::kNearJump);
-
-  __ cmpl(EDI, FieldAddress(ECX, ICData::target_name_offset()));
-  __ j(NOT_EQUAL, &next_iteration, Assembler::kNearJump);
+  // Preserve ic-data and context, ECX and ESI are needed for the probe.
+  __ pushl(ECX);
+  __ pushl(CTX);
+  __ movl(ECX, FieldAddress(ECX, ICData::target_name_offset()));
+  // Compute the byte offset of the first probed entry from the hash of the
+  // function name and the class index, see MegamorphicCacheTable::IndexFor.
+  __ movl(EDI, FieldAddress(ECX, String::hash_offset()));
+  __ SmiUntag(EDI);
+  __ movl(EBX, FieldAddress(EAX, Class::index_offset()));
+  __ xorl(EDI, EBX);
+  __ andl(EDI, Immediate(MegamorphicCacheTable::kMask));
+  __ shll(EDI, Immediate(MegamorphicCacheTable::kEntrySizeInBytesLog2));
+  // Load the entries of the megamorphic cache table of the current isolate.
+  __ movl(EBX, FieldAddress(CTX, Context::isolate_offset()));
+  __ movl(EBX, Address(EBX, Isolate::megamorphic_cache_table_offset() +
+                            MegamorphicCacheTable::entries_offset()));
+  // The arguments key is the Smi (total_args << 16) | positional_args.
+  __ movl(ESI, FieldAddress(EDX, Array::data_offset()));
+  __ shll(ESI, Immediate(16));
+  __ addl(ESI, FieldAddress(EDX, Array::data_offset() + kWordSize));
+
+  // EAX: class, ECX: function name, ESI: arguments key.
+  // EBX + EDI: entry to probe.
+  Label found, restore_and_not_found;
+  for (intptr_t i = 0; i < MegamorphicCacheTable::kMaxProbes; i++) {
+    Label next_probe;
+    __ cmpl(EAX, Address(EBX, EDI, TIMES_1,
+                         MegamorphicCacheTable::kClass * kWordSize));
+    __ j(NOT_EQUAL, &next_probe, Assembler::kNearJump);
+    __ cmpl(ECX, Address(EBX, EDI, TIMES_1,
+                         MegamorphicCacheTable::kFunctionName * kWordSize));
+    __ j(NOT_EQUAL, &next_probe, Assembler::kNearJump);
+    __ cmpl(ESI, Address(EBX, EDI, TIMES_1,
+                         MegamorphicCacheTable::kArgumentsKey * kWordSize));
+    __ j(EQUAL, &found);
+    __ Bind(&next_probe);
+    // An empty entry terminates the probe sequence.
+    __ cmpl(Address(EBX, EDI, TIMES_1,
+                    MegamorphicCacheTable::kClass * kWordSize),
+            Immediate(0));
+    __ j(EQUAL, &restore_and_not_found);
+    __ addl(EDI, Immediate(MegamorphicCacheTable::kEntrySizeInBytes));
+    __ andl(EDI, Immediate(MegamorphicCacheTable::kMask <<
+                           MegamorphicCacheTable::kEntrySizeInBytesLog2));
+  }
+  __ Bind(&restore_and_not_found);
+  __ popl(CTX);
+  __ popl(ECX);
+  __ jmp(&not_found);
 
-  // Name found, check total argument count and named argument count.
-  __ movl(EAX, FieldAddress(EDX, Array::data_offset()));
-  // EAX is total argument count as Smi.
-  __ movl(EDI, Address(EBX, FunctionsCache::kArgCount * kWordSize));
-  __ cmpl(EAX, EDI);  // Compare total argument counts.
-  __ j(NOT_EQUAL, &next_iteration, Assembler::kNearJump);
-  __ subl(EAX, FieldAddress(EDX, Array::data_offset() + kWordSize));
-  // EAX is named argument count as Smi.
-  __ movl(EDI, Address(EBX, FunctionsCache::kNamedArgCount * kWordSize));
-  __ cmpl(EAX, EDI);  // Compare named argument counts.
-  __ j(NOT_EQUAL, &next_iteration, Assembler::kNearJump);
-
-  // Argument count matches, jump to target.
+  __ Bind(&found);
+  __ popl(CTX);
+  __ popl(ECX);  // Discard ic-data, ECX is loaded with the target below.
+  __ movl(EAX, FieldAddress(CTX, Context::isolate_offset()));
+  __ incl(Address(EAX, Isolate::megamorphic_cache_table_offset() +
+                       MegamorphicCacheTable::hits_offset()));
+  // Jump to the current code of the target function.
   // EDX: arguments descriptor array.
-  __ movl(ECX, Address(EBX, FunctionsCache::kFunction * kWordSize));
+  __ movl(ECX, Address(EBX, EDI, TIMES_1,
+                       MegamorphicCacheTable::kFunction * kWordSize));
   __ movl(ECX, FieldAddress(ECX, Function::code_offset()));
   __ movl(ECX, FieldAddress(ECX, Code::instructions_offset()));
   __ addl(ECX, Immediate(Instructions::HeaderSize() - kHeapObjectTag));
   __ jmp(ECX);
 
-  __ Bind(&next_iteration);
-  __ AddImmediate(EBX, Immediate(FunctionsCache::kNumEntries * kWordSize));
-  __ jmp(&loop, Assembler::kNearJump);
-
   __ Bind(&not_found);
 }
 
@@ -390,8 +463,8 @@ void StubCode::GenerateMegamorphicLookupStub(Assembler* assembler) {
       Immediate(reinterpret_cast<intptr_t>(Object::null()));
 
   MegamorphicLookup(assembler);
-  // Lookup in function_table_ failed, resolve, compile and enter function
-  // into function_table_.
+  // Lookup in the megamorphic cache table failed, resolve, compile and enter
+  // function into the table.
 
   // Create a stub frame as we are pushing some objects on the stack before
   // calling into the runtime.
@@ -571,17 +644,43 @@ void StubCode::GenerateMegamorphicLookupStub(Assembler* assembler) {
 }
 
 
+// Called at a deoptimization point of optimized code, see
+// DeoptimizeCopyFrame and DeoptimizeFillFrame.
+// Stack at this point:
+// TOS + 0: Deoptimization point (return address).
+// TOS + 1: top-of-stack of the optimized frame at the deoptimization point.
+// All registers hold their values at the deoptimization point.
 void StubCode::GenerateDeoptimizeStub(Assembler* assembler) {
+  const Immediate raw_null =
+      Immediate(reinterpret_cast<intptr_t>(Object::null()));
   __ EnterFrame(0);
-  // EAX: deoptimization reason id.
-  // Stack at this point:
-  // TOS + 0: Saved EBP of function frame that will be deoptimized. <== EBP
-  // TOS + 1: Deoptimization point (return address), will be patched.
-  // TOS + 2: top-of-stack at deoptimization point (all arguments on stack).
-  __ pushl(EAX);
-  __ CallRuntime(kDeoptimizeRuntimeEntry);
+  // Save the registers, register number r at EBP - (8 - r) * kWordSize,
+  // followed by the XMM registers.
+  for (intptr_t i = kNumberOfCpuRegisters - 1; i >= 0; i--) {
+    __ pushl(static_cast<Register>(i));
+  }
+  __ subl(ESP, Immediate(kNumberOfXmmRegisters * sizeof(double)));
+  for (intptr_t i = 0; i < kNumberOfXmmRegisters; i++) {
+    __ movsd(Address(ESP, i * sizeof(double)), static_cast<XmmRegister>(i));
+  }
+  __ pushl(raw_null);  // Space for the result: size of unoptimized frame.
+  __ CallRuntime(kDeoptimizeCopyFrameRuntimeEntry);
   __ popl(EAX);
   __ LeaveFrame();
+
+  // Replace the optimized frame below its frame pointer with room for the
+  // unoptimized frame, and a stub frame whose return address is set by
+  // DeoptimizeFillFrame.
+  __ movl(ESP, EBP);
+  __ shll(EAX, Immediate(1));  // Size as Smi times two is size in bytes.
+  __ subl(ESP, EAX);
+  __ pushl(Immediate(0));  // Return address.
+  __ EnterFrame(0);
+  __ pushl(raw_null);  // Space for the result.
+  __ CallRuntime(kDeoptimizeFillFrameRuntimeEntry);
+  __ popl(EAX);
+  // Return into the unoptimized frame.
+  __ LeaveFrame();
   __ ret();
 }
 
@@ -649,14 +748,13 @@ void StubCode::GenerateAllocateArrayStub(Assembler* assembler) {
     // EDX: Array length as Smi.
 
     // Store the type argument field.
-    __ StoreIntoObject(EAX,
-                       FieldAddress(EAX, Array::type_arguments_offset()),
-                       ECX);
+    __ StoreIntoObjectNoBarrier(
+        EAX, FieldAddress(EAX, Array::type_arguments_offset()), ECX);
 
     // Set the length field.
-    __ StoreIntoObject(EAX,
-                       FieldAddress(EAX, Array::length_offset()),
-                       EDX);
+    __ StoreIntoObjectNoBarrier(EAX,
+                                FieldAddress(EAX, Array::length_offset()),
+                                EDX);
 
     // EAX: new object start as a tagged pointer.
     // EBX: new object end address.
@@ -665,9 +763,9 @@ void StubCode::GenerateAllocateArrayStub(Assembler* assembler) {
     __ movl(ECX, FieldAddress(CTX, Context::isolate_offset()));
     __ movl(ECX, Address(ECX, Isolate::object_store_offset()));
     __ movl(ECX, Address(ECX, ObjectStore::array_class_offset()));
-    __ StoreIntoObject(EAX,
-                       FieldAddress(EAX, Array::class_offset()),
-                       ECX);
+    __ StoreIntoObjectNoBarrier(EAX,
+                                FieldAddress(EAX, Array::class_offset()),
+                                ECX);
     // Calculate the size tag.
     // EAX: new object start as a tagged pointer.
     // EBX: new object end address.
@@ -990,9 +1088,9 @@ void StubCode::GenerateAllocateContextStub(Assembler* assembler) {
     // EAX: new object.
     // EDX: number of context variables.
     __ LoadObject(EBX, context_class);  // Load up class field of context.
-    __ StoreIntoObject(EAX,
-                       FieldAddress(EAX, Context::class_offset()),
-                       EBX);
+    __ StoreIntoObjectNoBarrier(EAX,
+                                FieldAddress(EAX, Context::class_offset()),
+                                EBX);
     // Calculate the size tag.
     // EAX: new object.
     // EDX: number of context variables.
@@ -1101,6 +1199,19 @@ void StubCode::GenerateAllocationStubForClass(Assembler* assembler,
       PageSpace::IsPageAllocatableSize(instance_size + type_args_size)) {
     Label slow_case;
     Heap* heap = Isolate::Current()->heap();
+    if (FLAG_pretenure) {
+      // Instances of pretenured classes are allocated in old space by the
+      // runtime. The decision changes at every scavenge, read it here.
+      Label not_pretenured;
+      __ cmpl(Address::Absolute(heap->PretenureLengthAddress()),
+              Immediate(cls.index()));
+      __ j(LESS_EQUAL, &not_pretenured, Assembler::kNearJump);
+      __ movl(EAX, Address::Absolute(heap->PretenureTableAddress()));
+      __ cmpl(Address(EAX, Scavenger::pretenure_offset(cls.index())),
+              Immediate(0));
+      __ j(NOT_EQUAL, &slow_case);
+      __ Bind(&not_pretenured);
+    }
     __ movl(EAX, Address::Absolute(heap->TopAddress()));
     __ leal(EBX, Address(EAX, instance_size));
     if (is_cls_parameterized) {
@@ -133,6 +133,59 @@ void StubCode::GeneratePrintStopMessageStub(Assembler* assembler) {
 }
 
 
+// Remember the address of a slot in an old object which was made to refer to
+// a new object.
+static void UpdateStoreBuffer(uword slot) {
+  Isolate::Current()->store_buffer()->AddPointer(slot);
+}
+
+
+// Called from the write barrier emitted by Assembler::StoreIntoObject.
+// Input parameters:
+//   RSP : points to return address.
+//   RSP + 8 : address of the updated slot.
+// Must preserve all registers, except TMP.
+void StubCode::GenerateUpdateStoreBufferStub(Assembler* assembler) {
+  // Preserve caller-saved registers.
+  __ pushq(RAX);
+  __ pushq(RCX);
+  __ pushq(RDX);
+  __ pushq(RSI);
+  __ pushq(RDI);
+  __ pushq(R8);
+  __ pushq(R9);
+  __ pushq(R10);
+
+  __ EnterFrame(0);
+
+  // Load the slot address passed above the saved registers and the return
+  // address.
+  __ movq(RDI, Address(RBP, 10 * kWordSize));
+
+  // Align frame before entering C++ world.
+  if (OS::ActivationFrameAlignment() > 0) {
+    __ andq(RSP, Immediate(~(OS::ActivationFrameAlignment() - 1)));
+  }
+
+  __ movq(RAX, Immediate(reinterpret_cast<uword>(&UpdateStoreBuffer)));
+  __ call(RAX);
+
+  __ LeaveFrame();
+
+  // Restore caller-saved registers.
+  __ popq(R10);
+  __ popq(R9);
+  __ popq(R8);
+  __ popq(RDI);
+  __ popq(RSI);
+  __ popq(RDX);
+  __ popq(RCX);
+  __ popq(RAX);
+
+  __ ret();
+}
+
+
 // Input parameters:
 //   RSP : points to return address.
 //   RSP + 8 : address of return value.
@@ -270,7 +323,8 @@ void StubCode::GenerateFixCallersTargetStub(Assembler* assembler) {
 }
 
 
-// Lookup for [function-name, arg count] in 'functions_map_'.
+// Lookup for [class, function-name, arg count] in the megamorphic cache
+// table of the isolate.
 // Input parameters (to be treated as read only, unless calling to target!):
 //   RBX: ic-data.
 //   R10: arguments descriptor array (num_args is first Smi element).
@@ -308,46 +362,64 @@ static void MegamorphicLookup(Assembler* assembler) {
   __ Bind(&class_in_rax);
   // Class is in RAX.
 
-  Label loop, next_iteration;
-  // Get functions_cache, since it is allocated lazily it maybe null.
-  __ movq(RAX, FieldAddress(RAX, Class::functions_cache_offset()));
-  // Iterate and search for identical name.
-  __ leaq(R12, FieldAddress(RAX, Array::data_offset()));
-
-  // R12 is  pointing into content of functions_map_ array.
-  __ Bind(&loop);
-  __ movq(R13, Address(R12, FunctionsCache::kFunctionName * kWordSize));
-
-  __ cmpq(R13, raw_null);
-  __ j(EQUAL, &not_found, Assembler::kNearJump);
-
-  __ cmpq(R13, FieldAddress(RBX, ICData::target_name_offset()));
-  __ j(NOT_EQUAL, &next_iteration, Assembler::kNearJump);
+  // Compute the byte offset of the first probed entry from the hash of the
+  // function name and the class index, see MegamorphicCacheTable::IndexFor.
+  __ movq(RSI, FieldAddress(RBX, ICData::target_name_offset()));
+  __ movq(RDI, FieldAddress(RSI, String::hash_offset()));
+  __ SmiUntag(RDI);
+  __ movq(R12, FieldAddress(RAX, Class::index_offset()));
+  __ xorq(RDI, R12);
+  __ andq(RDI, Immediate(MegamorphicCacheTable::kMask));
+  __ shlq(RDI, Immediate(MegamorphicCacheTable::kEntrySizeInBytesLog2));
+  // The arguments key is the Smi (total_args << 16) | positional_args.
+  __ movq(RDX, FieldAddress(R10, Array::data_offset()));
+  __ shlq(RDX, Immediate(16));
+  __ movq(R12, FieldAddress(R10, Array::data_offset() + kWordSize));
+  __ addq(RDX, R12);
+  // Load the entries of the megamorphic cache table of the current isolate.
+  __ movq(R13, FieldAddress(CTX, Context::isolate_offset()));
+  __ movq(R13, Address(R13, Isolate::megamorphic_cache_table_offset() +
+                            MegamorphicCacheTable::entries_offset()));
+
+  // RAX: class, RSI: function name, RDX: arguments key.
+  // R13 + RDI: entry to probe.
+  Label found;
+  for (intptr_t i = 0; i < MegamorphicCacheTable::kMaxProbes; i++) {
+    Label next_probe;
+    __ cmpq(RAX, Address(R13, RDI, TIMES_1,
+                         MegamorphicCacheTable::kClass * kWordSize));
+    __ j(NOT_EQUAL, &next_probe, Assembler::kNearJump);
+    __ cmpq(RSI, Address(R13, RDI, TIMES_1,
+                         MegamorphicCacheTable::kFunctionName * kWordSize));
+    __ j(NOT_EQUAL, &next_probe, Assembler::kNearJump);
+    __ cmpq(RDX, Address(R13, RDI, TIMES_1,
+                         MegamorphicCacheTable::kArgumentsKey * kWordSize));
+    __ j(EQUAL, &found);
+    __ Bind(&next_probe);
+    // An empty entry terminates the probe sequence.
+    __ cmpq(Address(R13, RDI, TIMES_1,
+                    MegamorphicCacheTable::kClass * kWordSize),
+            Immediate(0));
+    __ j(EQUAL, &not_found);
+    __ addq(RDI, Immediate(MegamorphicCacheTable::kEntrySizeInBytes));
+    __ andq(RDI, Immediate(MegamorphicCacheTable::kMask <<
+                           MegamorphicCacheTable::kEntrySizeInBytesLog2));
+  }
+  __ jmp(&not_found);
 
-  // Name found, check total argument count and named argument count.
-  __ movq(RAX, FieldAddress(R10, Array::data_offset()));
-  // RAX is total argument count as Smi.
-  __ movq(R13, Address(R12, FunctionsCache::kArgCount * kWordSize));
-  __ cmpq(RAX, R13);  // Compare total argument counts.
-  __ j(NOT_EQUAL, &next_iteration, Assembler::kNearJump);
-  __ subq(RAX, FieldAddress(R10, Array::data_offset() + kWordSize));
-  // RAX is named argument count as Smi.
-  __ movq(R13, Address(R12, FunctionsCache::kNamedArgCount * kWordSize));
-  __ cmpq(RAX, R13);  // Compare named argument counts.
-  __ j(NOT_EQUAL, &next_iteration, Assembler::kNearJump);
-
-  // Argument count matches, jump to target.
+  __ Bind(&found);
+  __ movq(R12, FieldAddress(CTX, Context::isolate_offset()));
+  __ incq(Address(R12, Isolate::megamorphic_cache_table_offset() +
+                       MegamorphicCacheTable::hits_offset()));
+  // Jump to the current code of the target function.
   // R10: arguments descriptor array.
-  __ movq(RBX, Address(R12, FunctionsCache::kFunction * kWordSize));
+  __ movq(RBX, Address(R13, RDI, TIMES_1,
+                       MegamorphicCacheTable::kFunction * kWordSize));
   __ movq(RBX, FieldAddress(RBX, Function::code_offset()));
   __ movq(RBX, FieldAddress(RBX, Code::instructions_offset()));
   __ addq(RBX, Immediate(Instructions::HeaderSize() - kHeapObjectTag));
   __ jmp(RBX);
 
-  __ Bind(&next_iteration);
-  __ AddImmediate(R12, Immediate(FunctionsCache::kNumEntries * kWordSize));
-  __ jmp(&loop, Assembler::kNearJump);
-
   __ Bind(&not_found);
 }
 
@@ -393,8 +465,8 @@ void StubCode::GenerateMegamorphicLookupStub(Assembler* assembler) {
       Immediate(reinterpret_cast<intptr_t>(Object::null()));
 
   MegamorphicLookup(assembler);
-  // Lookup in function_table_ failed, resolve, compile and enter function
-  // into function_table_.
+  // Lookup in the megamorphic cache table failed, resolve, compile and enter
+  // function into the table.
 
   // Create a stub frame as we are pushing some objects on the stack before
   // calling into the runtime.
@@ -574,18 +646,44 @@ void StubCode::GenerateMegamorphicLookupStub(Assembler* assembler) {
 }
 
 
+// Called at a deoptimization point of optimized code, see
+// DeoptimizeCopyFrame and DeoptimizeFillFrame.
+// Stack at this point:
+// TOS + 0: Deoptimization point (return address).
+// TOS + 1: top-of-stack of the optimized frame at the deoptimization point.
+// All registers hold their values at the deoptimization point.
 void StubCode::GenerateDeoptimizeStub(Assembler* assembler) {
   __ Untested("Deoptimize stub");
+  const Immediate raw_null =
+      Immediate(reinterpret_cast<intptr_t>(Object::null()));
   __ EnterFrame(0);
-  // RAX: deoptimization reason id.
-  // Stack at this point:
-  // TOS + 0: Saved EBP of function frame that will be deoptimized. <== EBP
-  // TOS + 1: Deoptimization point (return address), will be patched.
-  // TOS + 2: top-of-stack at deoptimization point (all arguments on stack).
-  __ pushq(RAX);
-  __ CallRuntime(kDeoptimizeRuntimeEntry);
+  // Save the registers, register number r at RBP - (16 - r) * kWordSize,
+  // followed by the XMM registers.
+  for (intptr_t i = kNumberOfCpuRegisters - 1; i >= 0; i--) {
+    __ pushq(static_cast<Register>(i));
+  }
+  __ subq(RSP, Immediate(kNumberOfXmmRegisters * sizeof(double)));
+  for (intptr_t i = 0; i < kNumberOfXmmRegisters; i++) {
+    __ movsd(Address(RSP, i * sizeof(double)), static_cast<XmmRegister>(i));
+  }
+  __ pushq(raw_null);  // Space for the result: size of unoptimized frame.
+  __ CallRuntime(kDeoptimizeCopyFrameRuntimeEntry);
   __ popq(RAX);
   __ LeaveFrame();
+
+  // Replace the optimized frame below its frame pointer with room for the
+  // unoptimized frame, and a stub frame whose return address is set by
+  // DeoptimizeFillFrame.
+  __ movq(RSP, RBP);
+  __ shlq(RAX, Immediate(2));  // Size as Smi times four is size in bytes.
+  __ subq(RSP, RAX);
+  __ pushq(Immediate(0));  // Return address.
+  __ EnterFrame(0);
+  __ pushq(raw_null);  // Space for the result.
+  __ CallRuntime(kDeoptimizeFillFrameRuntimeEntry);
+  __ popq(RAX);
+  // Return into the unoptimized frame.
+  __ LeaveFrame();
   __ ret();
 }
 
@@ -651,18 +749,21 @@ void StubCode::GenerateAllocateArrayStub(Assembler* assembler) {
     // R10: Array length as Smi.
 
     // Store the type argument field.
-    __ StoreIntoObject(RAX,
-                       FieldAddress(RAX, Array::type_arguments_offset()),
-                       RBX);
+    __ StoreIntoObjectNoBarrier(
+        RAX, FieldAddress(RAX, Array::type_arguments_offset()), RBX);
 
     // Set the length field.
-    __ StoreIntoObject(RAX, FieldAddress(RAX, Array::length_offset()), R10);
+    __ StoreIntoObjectNoBarrier(RAX,
+                                FieldAddress(RAX, Array::length_offset()),
+                                R10);
 
     // Store class value for array.
     __ movq(RBX, FieldAddress(CTX, Context::isolate_offset()));
     __ movq(RBX, Address(RBX, Isolate::object_store_offset()));
     __ movq(RBX, Address(RBX, ObjectStore::array_class_offset()));
-    __ StoreIntoObject(RAX, FieldAddress(RAX, Array::class_offset()), RBX);
+    __ StoreIntoObjectNoBarrier(RAX,
+                                FieldAddress(RAX, Array::class_offset()),
+                                RBX);
     // Calculate the size tag.
     // RAX: new object start as a tagged pointer.
     // R12: new object end address.
@@ -986,9 +1087,9 @@ void StubCode::GenerateAllocateContextStub(Assembler* assembler) {
     // RAX: new object.
     // R10: number of context variables.
     __ LoadObject(R13, context_class);  // Load up class field of context.
-    __ StoreIntoObject(RAX,
-                       FieldAddress(RAX, Context::class_offset()),
-                       R13);
+    __ StoreIntoObjectNoBarrier(RAX,
+                                FieldAddress(RAX, Context::class_offset()),
+                                R13);
     // Calculate the size tag.
     // RAX: new object.
     // R10: number of context variables.
@@ -1096,6 +1197,20 @@ void StubCode::GenerateAllocationStubForClass(Assembler* assembler,
       PageSpace::IsPageAllocatableSize(instance_size + type_args_size)) {
     Label slow_case;
     Heap* heap = Isolate::Current()->heap();
+    if (FLAG_pretenure) {
+      // Instances of pretenured classes are allocated in old space by the
+      // runtime. The decision changes at every scavenge, read it here.
+      Label not_pretenured;
+      __ movq(RAX, Immediate(heap->PretenureLengthAddress()));
+      __ cmpq(Address(RAX, 0), Immediate(cls.index()));
+      __ j(LESS_EQUAL, &not_pretenured, Assembler::kNearJump);
+      __ movq(RAX, Immediate(heap->PretenureTableAddress()));
+      __ movq(RAX, Address(RAX, 0));
+      __ cmpq(Address(RAX, Scavenger::pretenure_offset(cls.index())),
+              Immediate(0));
+      __ j(NOT_EQUAL, &slow_case);
+      __ Bind(&not_pretenured);
+    }
     __ movq(RAX, Immediate(heap->TopAddress()));
     __ movq(RAX, Address(RAX, 0));
     __ leaq(RBX, Address(RAX, instance_size));
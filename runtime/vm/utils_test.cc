@@ -121,6 +121,17 @@ UNIT_TEST_CASE(CountOneBits) {
 }
 
 
+UNIT_TEST_CASE(CountTrailingZeros) {
+  EXPECT_EQ(0, Utils::CountTrailingZeros(0x1));
+  EXPECT_EQ(4, Utils::CountTrailingZeros(0x10));
+  EXPECT_EQ(4, Utils::CountTrailingZeros(0x10101010));
+  EXPECT_EQ(16, Utils::CountTrailingZeros(0x10000));
+  EXPECT_EQ(kBitsPerWord - 1,
+            Utils::CountTrailingZeros(static_cast<uword>(1) <<
+                                      (kBitsPerWord - 1)));
+}
+
+
 UNIT_TEST_CASE(IsInt) {
   EXPECT(Utils::IsInt(8, 16));
   EXPECT(Utils::IsInt(8, 127));